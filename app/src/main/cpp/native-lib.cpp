@@ -7,6 +7,17 @@
 #include <string>
 #include <vector>
 #include <mutex>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <list>
+#include <unordered_map>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <zlib.h>
 
 #include <android/log.h>
 
@@ -21,6 +32,8 @@
 #include <dlib/image_processing/generic_image.h>
 #include <dlib/image_processing/frontal_face_detector.h>
 #include <dlib/opencv/cv_image.h>
+#include <dlib/threads.h>
+#include <dlib/rand.h>
 
 #define LOG_TAG "native-lib"
 #define LOGD(...) \
@@ -36,11 +49,14 @@
 #define YUV_420_888 35
 #define PYRAMIDS 3
 #define MAX_FRAME_COUNT 5
+#define CALIBRATION_RUNS 10
+#define STREAM_BUFFER_SIZE (64 * 1024)
+#define DEFAULT_MODEL_BUDGET (256l * 1024 * 1024)
 
 using namespace std;
 
 // global variables:
-dlib::shape_predictor shape_predictor;
+std::shared_ptr<const dlib::shape_predictor> shape_predictor = std::make_shared<dlib::shape_predictor>();
 std::mutex _mutex;
 int imageFormat = NV21;
 
@@ -111,29 +127,906 @@ namespace LK {
 }
 // -------------------------------------------------------------------------------------------------
 
-extern "C"
-JNIEXPORT void JNICALL
-JNI_METHOD(loadModel)(JNIEnv* env, jclass, jstring detectorPath) {
+// -------------------------------------------------------------------------------------------------
+// -- Tree-parallel landmark prediction
+// -------------------------------------------------------------------------------------------------
+namespace Parallel {
+    // variables
+    std::unique_ptr<dlib::thread_pool> pool;
+    std::once_flag poolCreated;
+    bool enabled = false;  // choice for the active model
+
+    /** average time (in microseconds) of a prediction on the given image */
+    template <typename predict_fn>
+    double timePrediction(predict_fn predict) {
+        predict();  // warm-up
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < CALIBRATION_RUNS; ++i)
+            predict();
+        auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double, std::micro>(end - start).count() / CALIBRATION_RUNS;
+    }
+
+    /** time serial and threaded prediction of the model, returns true if threaded is faster */
+    bool calibrate(const dlib::shape_predictor &predictor) {
+        const unsigned cores = std::thread::hardware_concurrency();
+        if (cores <= 1)
+            return false;
+
+        // the calling thread evaluates a block of trees too (models may load on several threads)
+        std::call_once(poolCreated, [cores]() { pool.reset(new dlib::thread_pool(cores - 1)); });
+
+        // time it on an idle pool of the same size: the shared one may be running the live
+        // detection, which would both slow it down and skew the measurement
+        dlib::thread_pool idle(cores - 1);
+
+        // a noisy synthetic frame is enough: the cost doesn't depend on the content
+        dlib::array2d<unsigned char> image(480, 640);
+        dlib::rand rnd;
+        for (long r = 0; r < image.nr(); ++r)
+            for (long c = 0; c < image.nc(); ++c)
+                image[r][c] = rnd.get_random_8bit_number();
+
+        dlib::rectangle region(200, 120, 440, 360);
+
+        double serial = timePrediction([&]() { predictor(image, region); });
+        double threaded = timePrediction([&]() { predictor(image, region, idle); });
+
+        // require a clear win so scheduling noise doesn't flip the choice
+        bool faster = threaded < 0.9 * serial;
+
+        LOGD("JNI: prediction serial %.0f us, threaded %.0f us (%u cores) -> %s", serial, threaded,
+             cores, faster ? "threaded" : "serial");
+        return faster;
+    }
+}
+// -------------------------------------------------------------------------------------------------
+
+// -------------------------------------------------------------------------------------------------
+// -- Single pass model loading: read -> (inflate) -> crc32 -> deserialize
+// -------------------------------------------------------------------------------------------------
+namespace ModelStream {
+
+    /** a source of raw model bytes, returns the number of bytes read (0 at the end, -1 on error) */
+    class Source {
+    public:
+        virtual ~Source() = default;
+        virtual long read(char *buffer, long size) = 0;
+    };
+
+    /** reads from a file descriptor (a file, a pipe or a socket) */
+    class FdSource : public Source {
+    public:
+        explicit FdSource(int fd) : fd(fd) {}
+
+        long read(char *buffer, long size) override {
+            ssize_t count;
+            do {
+                count = ::read(fd, buffer, (size_t) size);
+            } while (count < 0 && errno == EINTR);
+            return count;
+        }
+
+    private:
+        int fd;
+    };
+
+    /** receives every (uncompressed) model byte, e.g. to hash it */
+    class Sink {
+    public:
+        virtual ~Sink() = default;
+        virtual bool update(const char *data, long size) = 0;
+    };
+
+    /** feeds the model bytes to a java.security.MessageDigest, leaving any Java exception pending */
+    class JavaDigestSink : public Sink {
+    public:
+        JavaDigestSink(JNIEnv *env, jobject digest) : env(env), digest(digest) {
+            jclass cls = env->GetObjectClass(digest);
+            updateMethod = env->GetMethodID(cls, "update", "([BII)V");
+            env->DeleteLocalRef(cls);
+            array = env->NewByteArray(STREAM_BUFFER_SIZE);
+        }
+
+        ~JavaDigestSink() override {
+            if (array != nullptr)
+                env->DeleteLocalRef(array);
+        }
+
+        bool update(const char *data, long size) override {
+            if (updateMethod == nullptr || array == nullptr)
+                return false;
+
+            while (size > 0) {
+                const jint count = (jint) std::min<long>(size, STREAM_BUFFER_SIZE);
+                env->SetByteArrayRegion(array, 0, count, reinterpret_cast<const jbyte *>(data));
+                env->CallVoidMethod(digest, updateMethod, array, 0, count);
+                if (env->ExceptionCheck())
+                    return false;
+                data += count;
+                size -= count;
+            }
+            return true;
+        }
+
+    private:
+        JNIEnv *env;
+        jobject digest;
+        jmethodID updateMethod = nullptr;
+        jbyteArray array = nullptr;
+    };
+
+    /**
+     * Decompresses a bzip2 stream (the format the models are published in) pulled from another
+     * source. Blocks are decoded one at a time, so memory use is bounded by the block size of the
+     * stream (at most 900k symbols), and every block is checked against its stored crc.
+     */
+    class Bzip2Source : public Source {
+    public:
+        /** [prefix] holds the first [prefixSize] bytes of the stream, already read from [source] */
+        Bzip2Source(Source &source, const char *prefix, long prefixSize)
+                : source(source), in(prefix, prefix + prefixSize) {
+            in.resize(std::max<long>(prefixSize, STREAM_BUFFER_SIZE));
+            inEnd = prefixSize;
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i << 24;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 0x80000000u) ? (c << 1) ^ 0x04c11db7u : c << 1;
+                crcTable[i] = c;
+            }
+        }
+
+        long read(char *buffer, long size) override {
+            try {
+                if (!started) {
+                    started = true;
+                    if (!startStream())
+                        throw DataError();
+                }
+
+                long count = 0;
+                while (count < size && !finished) {
+                    if (repeat > 0) {
+                        emit(buffer[count++], last);
+                        --repeat;
+                    } else if (used < blockSize) {
+                        tPos = tt[tPos];
+                        const auto b = (uint8_t) (tPos & 0xff);
+                        tPos >>= 8;
+                        ++used;
+                        // after 4 equal bytes comes the number of extra copies of the byte
+                        if (run == 4) {
+                            repeat = b;
+                            run = 0;
+                        } else {
+                            run = (run > 0 && b == last) ? run + 1 : 1;
+                            last = b;
+                            emit(buffer[count++], b);
+                        }
+                    } else {
+                        if (inBlock)
+                            endBlock();
+                        if (!nextBlock())
+                            finished = true;
+                    }
+                }
+                return count;
+
+            } catch (DataError &) {
+                return -1;
+            }
+        }
+
+    private:
+        struct DataError {};
+
+        enum { MAX_GROUPS = 6, MAX_ALPHA_SIZE = 258, MAX_CODE_LEN = 20, GROUP_SIZE = 50,
+               MAX_SELECTORS = 18002 };
+
+        Source &source;
+        std::vector<char> in;
+        long inPos = 0, inEnd = 0;
+        uint64_t bits = 0;
+        int bitCount = 0;
+
+        uint32_t crcTable[256];
+        uint32_t blockCrc = 0, storedBlockCrc = 0, combinedCrc = 0;
+
+        std::vector<uint32_t> tt;  // the block: symbols, then the inverse BWT links
+        long maxBlockSize = 0, blockSize = 0, used = 0;
+        uint32_t tPos = 0;
+        uint8_t last = 0;
+        int run = 0, repeat = 0;
+        bool started = false, inBlock = false, finished = false;
+
+        void emit(char &out, uint8_t b) {
+            out = (char) b;
+            blockCrc = (blockCrc << 8) ^ crcTable[(blockCrc >> 24) ^ b];
+        }
+
+        /** next byte of the compressed stream, -1 at its end */
+        int nextByte() {
+            if (inPos == inEnd) {
+                inEnd = source.read(in.data(), (long) in.size());
+                inPos = 0;
+                if (inEnd < 0)
+                    throw DataError();
+                if (inEnd == 0)
+                    return -1;
+            }
+            return (uint8_t) in[inPos++];
+        }
+
+        uint32_t getBits(int n) {
+            while (bitCount < n) {
+                const int b = nextByte();
+                if (b < 0)
+                    throw DataError();  // truncated
+                bits = (bits << 8) | (uint32_t) b;
+                bitCount += 8;
+            }
+            bitCount -= n;
+            return (uint32_t) (bits >> bitCount) & ((1u << n) - 1);
+        }
+
+        uint32_t getBit() { return getBits(1); }
+
+        /** checks the "BZh1".."BZh9" header, false at the end of the input */
+        bool startStream() {
+            const int b = nextByte();
+            if (b < 0)
+                return false;
+            if (b != 'B' || getBits(8) != 'Z' || getBits(8) != 'h')
+                throw DataError();
+            const uint32_t level = getBits(8);
+            if (level < '1' || level > '9')
+                throw DataError();
+            maxBlockSize = 100000l * (level - '0');
+            tt.resize((size_t) maxBlockSize);
+            combinedCrc = 0;
+            return true;
+        }
+
+        void endBlock() {
+            inBlock = false;
+            blockCrc = ~blockCrc;
+            if (blockCrc != storedBlockCrc)
+                throw DataError();
+            combinedCrc = ((combinedCrc << 1) | (combinedCrc >> 31)) ^ blockCrc;
+        }
+
+        /** decodes the next block, false at the end of the input */
+        bool nextBlock() {
+            const uint32_t magicHi = getBits(24), magicLo = getBits(24);
+            if (magicHi == 0x177245 && magicLo == 0x385090) {
+                // end of stream: check the combined crc, then look for a concatenated stream
+                if (getBits(16) << 16 != (combinedCrc & 0xffff0000u) ||
+                    getBits(16) != (combinedCrc & 0xffff))
+                    throw DataError();
+                bitCount -= bitCount % 8;
+                return startStream() && nextBlock();
+            }
+            if (magicHi != 0x314159 || magicLo != 0x265359)
+                throw DataError();
+
+            storedBlockCrc = getBits(16) << 16;
+            storedBlockCrc |= getBits(16);
+            if (getBit())
+                throw DataError();  // randomized blocks, not written since bzip2 0.9.5
+            const uint32_t origPtr = getBits(24);
+
+            // the bytes used in the block
+            uint8_t seqToUnseq[256];
+            int numInUse = 0;
+            const uint32_t inUse16 = getBits(16);
+            for (int i = 0; i < 16; ++i) {
+                if (inUse16 & (0x8000 >> i)) {
+                    for (int j = 0; j < 16; ++j) {
+                        if (getBit())
+                            seqToUnseq[numInUse++] = (uint8_t) (i * 16 + j);
+                    }
+                }
+            }
+            if (numInUse == 0)
+                throw DataError();
+            const int alphaSize = numInUse + 2;
+
+            // which huffman table codes each group of 50 symbols (move to front encoded)
+            const int numGroups = (int) getBits(3);
+            const int numSelectors = (int) getBits(15);
+            if (numGroups < 2 || numGroups > MAX_GROUPS || numSelectors < 1)
+                throw DataError();
+            std::vector<uint8_t> selectors((size_t) std::min<int>(numSelectors, MAX_SELECTORS));
+            uint8_t groupOrder[MAX_GROUPS];
+            for (int i = 0; i < numGroups; ++i)
+                groupOrder[i] = (uint8_t) i;
+            for (int i = 0; i < numSelectors; ++i) {
+                int j = 0;
+                while (getBit()) {
+                    if (++j >= numGroups)
+                        throw DataError();
+                }
+                const uint8_t group = groupOrder[j];
+                for (; j > 0; --j)
+                    groupOrder[j] = groupOrder[j - 1];
+                groupOrder[0] = group;
+                if (i < MAX_SELECTORS)
+                    selectors[i] = group;  // bzip2 ignores selectors past its maximum too
+            }
+
+            // the code lengths (delta encoded) and the canonical decoding tables
+            int32_t limit[MAX_GROUPS][MAX_CODE_LEN + 1], base[MAX_GROUPS][MAX_CODE_LEN + 2];
+            uint16_t perm[MAX_GROUPS][MAX_ALPHA_SIZE];
+            int minLens[MAX_GROUPS];
+            for (int t = 0; t < numGroups; ++t) {
+                uint8_t length[MAX_ALPHA_SIZE];
+                int len = (int) getBits(5);
+                for (int i = 0; i < alphaSize; ++i) {
+                    for (;;) {
+                        if (len < 1 || len > MAX_CODE_LEN)
+                            throw DataError();
+                        if (!getBit())
+                            break;
+                        len += getBit() ? -1 : 1;
+                    }
+                    length[i] = (uint8_t) len;
+                }
+
+                int minLen = MAX_CODE_LEN, maxLen = 0;
+                for (int i = 0; i < alphaSize; ++i) {
+                    minLen = std::min<int>(minLen, length[i]);
+                    maxLen = std::max<int>(maxLen, length[i]);
+                }
+                int pp = 0;
+                for (int l = minLen; l <= maxLen; ++l)
+                    for (int i = 0; i < alphaSize; ++i)
+                        if (length[i] == l)
+                            perm[t][pp++] = (uint16_t) i;
+
+                // base[l] = number of codes shorter than l, limit[l] = largest code of length l
+                std::fill(base[t], base[t] + MAX_CODE_LEN + 2, 0);
+                for (int i = 0; i < alphaSize; ++i)
+                    ++base[t][length[i] + 1];
+                for (int l = 1; l < MAX_CODE_LEN + 2; ++l)
+                    base[t][l] += base[t][l - 1];
+                std::fill(limit[t], limit[t] + MAX_CODE_LEN + 1, -1);
+                int32_t code = 0;
+                for (int l = minLen; l <= maxLen; ++l) {
+                    code += base[t][l + 1] - base[t][l];
+                    limit[t][l] = code - 1;
+                    code <<= 1;
+                }
+                for (int l = maxLen; l > minLen; --l)
+                    base[t][l] = ((limit[t][l - 1] + 1) << 1) - base[t][l];
+                base[t][minLen] = 0;
+                minLens[t] = minLen;
+            }
+
+            // huffman -> run lengths of the first symbol (RUNA, RUNB) -> move to front
+            const int endOfBlock = numInUse + 1;
+            uint8_t mtf[256];
+            for (int i = 0; i < 256; ++i)
+                mtf[i] = (uint8_t) i;
+            uint32_t counts[256] = {0};
+            long size = 0;
+            int groupIndex = -1, groupLeft = 0;
+
+            auto nextSymbol = [&]() -> int {
+                if (groupLeft == 0) {
+                    if (++groupIndex >= (int) selectors.size())
+                        throw DataError();
+                    groupLeft = GROUP_SIZE;
+                }
+                --groupLeft;
+                const int t = selectors[groupIndex];
+                int len = minLens[t];
+                int32_t code = (int32_t) getBits(len);
+                while (code > limit[t][len]) {
+                    if (++len > MAX_CODE_LEN)
+                        throw DataError();
+                    code = (code << 1) | (int32_t) getBit();
+                }
+                const int32_t index = code - base[t][len];
+                if (index < 0 || index >= alphaSize)
+                    throw DataError();
+                return perm[t][index];
+            };
+
+            int symbol = nextSymbol();
+            while (symbol != endOfBlock) {
+                if (symbol <= 1) {
+                    long runLength = 0;
+                    for (long weight = 1; symbol <= 1; weight <<= 1) {
+                        if (weight > maxBlockSize)
+                            throw DataError();
+                        runLength += weight << symbol;  // RUNA adds weight, RUNB twice that
+                        symbol = nextSymbol();
+                    }
+                    if (runLength > maxBlockSize - size)
+                        throw DataError();
+                    const uint8_t b = seqToUnseq[mtf[0]];
+                    counts[b] += (uint32_t) runLength;
+                    std::fill(tt.begin() + size, tt.begin() + size + runLength, b);
+                    size += runLength;
+                } else {
+                    if (size >= maxBlockSize)
+                        throw DataError();
+                    const int k = symbol - 1;
+                    const uint8_t index = mtf[k];
+                    memmove(mtf + 1, mtf, (size_t) k);
+                    mtf[0] = index;
+                    const uint8_t b = seqToUnseq[index];
+                    ++counts[b];
+                    tt[size++] = b;
+                    symbol = nextSymbol();
+                }
+            }
+            if (origPtr >= (uint32_t) size)
+                throw DataError();
+
+            // inverse BWT: link every position to the next one of the original block
+            uint32_t next[256];
+            uint32_t sum = 0;
+            for (int i = 0; i < 256; ++i) {
+                next[i] = sum;
+                sum += counts[i];
+            }
+            for (long i = 0; i < size; ++i)
+                tt[next[tt[i] & 0xff]++] |= (uint32_t) i << 8;
+
+            tPos = tt[origPtr] >> 8;
+            blockSize = size;
+            used = 0;
+            run = 0;
+            repeat = 0;
+            blockCrc = 0xffffffffu;
+            inBlock = true;
+            return true;
+        }
+    };
+
+    /**
+     * Stream buffer handing the model bytes to dlib. bzip2, gzip and zlib data (detected from the
+     * header) is decompressed on the fly, anything else passes through untouched. A crc32 of the
+     * bytes given to dlib is kept, and they're also handed to the optional [sink], so the model is
+     * checked in the same pass that loads it.
+     */
+    class InflateBuffer : public std::streambuf {
+    public:
+        InflateBuffer(Source &source, Sink *sink) : source(source), sink(sink),
+                                                    in(STREAM_BUFFER_SIZE),
+                                                    out(STREAM_BUFFER_SIZE) {
+            memset(&zs, 0, sizeof(zs));
+            setg(out.data(), out.data(), out.data());
+        }
+
+        ~InflateBuffer() override {
+            if (compressed)
+                inflateEnd(&zs);
+        }
+
+        unsigned long checksum() const { return crc; }
+
+        bool failed() const { return error; }
+
+        /** pass the rest of the source through the checksum */
+        void drain() {
+            while (underflow() != traits_type::eof())
+                setg(eback(), egptr(), egptr());
+        }
+
+    protected:
+        int_type underflow() override {
+            if (gptr() < egptr())
+                return traits_type::to_int_type(*gptr());
+
+            long count = started ? fill() : start();
+            if (count <= 0) {
+                error = error || count < 0;
+                return traits_type::eof();
+            }
+
+            crc = ::crc32(crc, reinterpret_cast<const Bytef *>(out.data()), (uInt) count);
+            if (sink != nullptr && !sink->update(out.data(), count)) {
+                error = true;
+                return traits_type::eof();
+            }
+            setg(out.data(), out.data(), out.data() + count);
+            return traits_type::to_int_type(*gptr());
+        }
+
+    private:
+        Source &source;
+        Sink *sink;
+        std::vector<char> in, out;
+        z_stream zs;
+        std::unique_ptr<Bzip2Source> bzip2;
+        uLong crc = ::crc32(0L, Z_NULL, 0);
+        bool started = false;
+        bool compressed = false;
+        bool finished = false;
+        bool error = false;
+        long pending = 0;  // raw bytes read by start() but not handed out yet
+
+        /** read the first bytes and look for a bzip2 (BZh), gzip (1f 8b) or zlib (78 xx) header */
+        long start() {
+            started = true;
+            // pipes may return fewer bytes than a header needs
+            pending = 0;
+            while (pending < 3) {
+                long count = source.read(in.data() + pending, (long) in.size() - pending);
+                if (count < 0)
+                    return -1;
+                if (count == 0)
+                    break;
+                pending += count;
+            }
+            if (pending == 0)
+                return 0;
+
+            const auto b0 = (unsigned char) in[0];
+            const auto b1 = pending > 1 ? (unsigned char) in[1] : 0;
+            const bool gzip = b0 == 0x1f && b1 == 0x8b;
+            const bool zlib = (b0 & 0x0f) == 8 && ((b0 << 8) | b1) % 31 == 0;
+            const bool bz2 = pending > 2 && b0 == 'B' && b1 == 'Z' && in[2] == 'h';
+
+            if (bz2) {
+                bzip2.reset(new Bzip2Source(source, in.data(), pending));
+            } else if (gzip || zlib) {
+                // 32 + MAX_WBITS: let zlib detect which of the two headers it is
+                if (inflateInit2(&zs, 32 + MAX_WBITS) != Z_OK)
+                    return -1;
+                compressed = true;
+                zs.next_in = reinterpret_cast<Bytef *>(in.data());
+                zs.avail_in = (uInt) pending;
+            } else {
+                memcpy(out.data(), in.data(), (size_t) pending);
+            }
+
+            long count = (bzip2 || compressed) ? fill() : pending;
+            pending = 0;
+            return count;
+        }
+
+        long fill() {
+            if (bzip2)
+                return bzip2->read(out.data(), (long) out.size());
+            if (!compressed)
+                return source.read(out.data(), (long) out.size());
+
+            zs.next_out = reinterpret_cast<Bytef *>(out.data());
+            zs.avail_out = (uInt) out.size();
+
+            while (!finished && zs.avail_out == out.size()) {
+                if (zs.avail_in == 0) {
+                    long count = source.read(in.data(), (long) in.size());
+                    if (count < 0)
+                        return -1;
+                    if (count == 0)
+                        break;  // truncated: deserialize() will complain
+                    zs.next_in = reinterpret_cast<Bytef *>(in.data());
+                    zs.avail_in = (uInt) count;
+                }
+
+                int status = inflate(&zs, Z_NO_FLUSH);
+                if (status == Z_STREAM_END)
+                    finished = true;
+                else if (status != Z_OK && status != Z_BUF_ERROR)
+                    return -1;
+            }
+
+            return (long) (out.size() - zs.avail_out);
+        }
+    };
+
+    /**
+     * deserialize a shape predictor from the source, returns the crc32 of the model bytes (which
+     * are also handed to [sink], if any)
+     */
+    unsigned long load(Source &source, dlib::shape_predictor &predictor, Sink *sink = nullptr) {
+        InflateBuffer buffer(source, sink);
+        std::istream in(&buffer);
+        dlib::deserialize(predictor, in);
+
+        // checksum the whole model, including anything dlib didn't need to read
+        buffer.drain();
+        if (buffer.failed())
+            throw dlib::serialization_error("error while reading the model stream");
+
+        return buffer.checksum();
+    }
+}
+// -------------------------------------------------------------------------------------------------
+
+// -------------------------------------------------------------------------------------------------
+// -- Resident models: LRU cache of loaded predictors under a memory budget
+// -------------------------------------------------------------------------------------------------
+namespace Models {
+    struct Entry {
+        std::shared_ptr<const dlib::shape_predictor> predictor;
+        size_t bytes;
+        bool threaded;  // calibration result
+        std::list<string>::iterator position;  // in the lru list
+    };
+
+    // variables (guarded by _mutex)
+    size_t budget = DEFAULT_MODEL_BUDGET;
+    size_t used = 0;
+    std::list<string> lru;  // keys, most recently used first
+    std::unordered_map<string, Entry> entries;
+    string active;
+
+    /**
+     * memory taken by a predictor: the arrays of its trees, split features, leaf values and pixel
+     * encodings, plus the allocator's bookkeeping for each of them (the model is mostly small
+     * arrays: one per leaf and two per tree)
+     */
+    size_t estimateBytes(const dlib::shape_predictor &predictor) {
+        const size_t allocations = predictor.num_features() + 2 * predictor.num_trees();
+        return dlib::shape_predictor_memory_usage(predictor) + allocations * 2 * sizeof(void *);
+    }
+
+    /** drop the least recently used models until the budget is met, the active one always stays */
+    void evict() {
+        auto it = lru.end();
+        while (used > budget && it != lru.begin()) {
+            --it;
+            if (*it == active)
+                continue;
+
+            auto entry = entries.find(*it);
+            used -= entry->second.bytes;
+            LOGD("JNI: evicting model %s (%zu bytes)", it->c_str(), entry->second.bytes);
+            entries.erase(entry);
+            it = lru.erase(it);
+        }
+    }
+
+    /** add (or replace) a model as the most recently used one */
+    void insert(const string &key, std::shared_ptr<const dlib::shape_predictor> predictor,
+                size_t bytes, bool threaded) {
+        auto found = entries.find(key);
+        if (found != entries.end()) {
+            used -= found->second.bytes;
+            lru.erase(found->second.position);
+            entries.erase(found);
+        }
+
+        lru.push_front(key);
+        entries[key] = Entry{std::move(predictor), bytes, threaded, lru.begin()};
+        used += bytes;
+        evict();
+    }
+
+    /** make a resident model the active one in O(1), returns false if it isn't resident */
+    bool activate(const string &key) {
+        auto found = entries.find(key);
+        if (found == entries.end())
+            return false;
+
+        lru.splice(lru.begin(), lru, found->second.position);
+        shape_predictor = found->second.predictor;
+        Parallel::enabled = found->second.threaded;
+        active = key;
+
+        // cause the later initialization of the tracking
+        LK::isTracking = false;
+
+        // the previously active model may now be over budget
+        evict();
+        return true;
+    }
+
+    /** drop a model, e.g. one that failed verification; one still in use is kept alive by its users */
+    void remove(const string &key) {
+        auto found = entries.find(key);
+        if (found == entries.end())
+            return;
+
+        used -= found->second.bytes;
+        lru.erase(found->second.position);
+        entries.erase(found);
+        if (active == key)
+            active.clear();
+    }
+
+    bool isResident(const string &key) {
+        return entries.find(key) != entries.end();
+    }
+
+    void setBudget(size_t bytes) {
+        budget = bytes;
+        evict();
+    }
+}
+// -------------------------------------------------------------------------------------------------
+
+/** java string to std::string */
+string toString(JNIEnv *env, jstring str) {
+    const char *chars = env->GetStringUTFChars(str, JNI_FALSE);
+    string result(chars);
+    env->ReleaseStringUTFChars(str, chars); //free mem
+    return result;
+}
+
+/**
+ * Adds a freshly loaded model to the resident ones under [key], and activates it if asked to.
+ * Calibration runs before the model is published and before taking the lock, so prefetching
+ * doesn't stall the detection.
+ */
+void registerModel(const string &key, dlib::shape_predictor &&predictor, bool activate) {
+    auto model = std::make_shared<const dlib::shape_predictor>(std::move(predictor));
+
+    // enable the threaded predictor only if it pays off for this model
+    bool threaded = Parallel::calibrate(*model);
+    size_t bytes = Models::estimateBytes(*model);
+
+    lock_guard<mutex> lock(_mutex);
+    Models::insert(key, model, bytes, threaded);
+    if (activate)
+        Models::activate(key);
+
+    LOGD("JNI: model %s resident (%zu bytes, %zu / %zu used)", key.c_str(), bytes, Models::used,
+         Models::budget);
+}
+
+/**
+ * Loads the shape predictor stored at [path] and returns the crc32 of its (uncompressed) bytes.
+ * When [expectedCrc] isn't negative a model with a different checksum is rejected.
+ *
+ * Models downloaded in dlib's old element by element format are re-saved next to the original (as
+ * <path>.bulk) in the bulk-readable format, tagged with the crc32 of the original, so that every
+ * later load of the same verified model reads the faster copy instead.
+ */
+unsigned long loadShapePredictor(const string &path, jlong expectedCrc,
+                                 dlib::shape_predictor &predictor) {
+    const string cachePath = path + ".bulk";
+
+    if (expectedCrc >= 0) {
+        try {
+            std::ifstream in(cachePath, std::ios::binary);
+            if (in) {
+                unsigned long crc;
+                dlib::deserialize(crc, in);
+                if ((jlong) crc == expectedCrc) {
+                    dlib::deserialize(predictor, in);
+                    return crc;
+                }
+                LOGD("JNI: ignoring stale model cache");
+            }
+        } catch (dlib::serialization_error &e) {
+            LOGD("JNI: ignoring bad model cache -> %s", e.what());
+        }
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw dlib::serialization_error("unable to open " + path);
+
+    unsigned long crc;
     try {
-        const char *path = env->GetStringUTFChars(detectorPath, JNI_FALSE);
+        ModelStream::FdSource source(fd);
+        crc = ModelStream::load(source, predictor);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
 
-        _mutex.lock();
-            // cause the later initialization of the tracking
-            LK::isTracking = false;
+    if (expectedCrc >= 0 && (jlong) crc != expectedCrc)
+        throw dlib::serialization_error("model checksum mismatch");
 
-            // load the shape predictor
-            dlib::deserialize(path) >> shape_predictor;
-        _mutex.unlock();
+    try {
+        std::ofstream out(cachePath, std::ios::binary);
+        dlib::serialize(crc, out);
+        dlib::serialize_bulk(predictor, out);
+        out.close();
+        if (!out)
+            throw dlib::serialization_error("error writing " + cachePath);
+    } catch (dlib::serialization_error &e) {
+        LOGD("JNI: unable to write model cache -> %s", e.what());
+        remove(cachePath.c_str());
+    }
+    return crc;
+}
 
-        env->ReleaseStringUTFChars(detectorPath, path); //free mem
+extern "C"
+JNIEXPORT jboolean JNICALL
+JNI_METHOD(loadModel)(JNIEnv* env, jclass, jstring modelKey, jstring detectorPath, jlong expectedCrc,
+                      jboolean activate) {
+    try {
+        const string key = toString(env, modelKey);
+        const string path = toString(env, detectorPath);
+
+        // load the shape predictor
+        auto start = chrono::steady_clock::now();
+        dlib::shape_predictor predictor;
+        unsigned long crc = loadShapePredictor(path, expectedCrc, predictor);
+        auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        LOGD("JNI: model deserialized in %lld ms (crc32 %08lx)", (long long) elapsed.count(), crc);
+
+        registerModel(key, std::move(predictor), activate);
         LOGD("JNI: model loaded");
+        return JNI_TRUE;
 
     } catch (dlib::serialization_error &e) {
         LOGD("JNI: failed to model -> %s", e.what());
+        return JNI_FALSE;
     }
 }
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Deserializes a model from [source] and registers it under [key]. Returns the crc32 of the
+ * (uncompressed) model bytes, or -1 on failure. When [expectedCrc] isn't negative a model with a
+ * different checksum is rejected. The model bytes are also handed to [sink], if any.
+ */
+jlong loadModelFromSource(const string &key, ModelStream::Source &source, jlong expectedCrc,
+                          ModelStream::Sink *sink, bool activate) {
+    try {
+        auto start = chrono::steady_clock::now();
+        dlib::shape_predictor predictor;
+        unsigned long crc = ModelStream::load(source, predictor, sink);
+        auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+        LOGD("JNI: model streamed in %lld ms (crc32 %08lx)", (long long) elapsed.count(), crc);
+
+        if (expectedCrc >= 0 && (jlong) crc != expectedCrc) {
+            LOGD("JNI: model checksum mismatch, expected %08llx", (long long) expectedCrc);
+            return -1;
+        }
+
+        registerModel(key, std::move(predictor), activate);
+        return (jlong) crc;
+
+    } catch (dlib::serialization_error &e) {
+        LOGD("JNI: failed to stream the model -> %s", e.what());
+        return -1;
+    }
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+JNI_METHOD(loadModelFromFd)(JNIEnv* env, jclass, jstring key, jint fd, jlong expectedCrc,
+                            jobject digest, jboolean activate) {
+    ModelStream::FdSource source(fd);
+    if (digest == nullptr)
+        return loadModelFromSource(toString(env, key), source, expectedCrc, nullptr, activate);
+
+    ModelStream::JavaDigestSink sink(env, digest);
+    return loadModelFromSource(toString(env, key), source, expectedCrc, &sink, activate);
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+JNI_METHOD(activateModel)(JNIEnv* env, jclass, jstring key) {
+    lock_guard<mutex> lock(_mutex);
+    return (jboolean) Models::activate(toString(env, key));
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+JNI_METHOD(isModelResident)(JNIEnv* env, jclass, jstring key) {
+    lock_guard<mutex> lock(_mutex);
+    return (jboolean) Models::isResident(toString(env, key));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+JNI_METHOD(unloadModel)(JNIEnv* env, jclass, jstring key) {
+    lock_guard<mutex> lock(_mutex);
+    Models::remove(toString(env, key));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+JNI_METHOD(setModelCacheBudget)(JNIEnv*, jclass, jlong bytes) {
+    lock_guard<mutex> lock(_mutex);
+    Models::setBudget((size_t) std::max<jlong>(bytes, 0));
+}
+//--------------------------------------------------------------------------------------------------
+
 void rotateMat(cv::Mat &mat, int rotation) {
     if (rotation == 90) { // portrait
         LOGD("JNI: rotation 90");
@@ -193,12 +1086,17 @@ JNI_METHOD(detectLandmarks)(JNIEnv* env, jclass, jbyteArray yuvFrame, jint rotat
         // cv::mat to dlib::image
         dlib::cv_image<unsigned char> image(grayMat);
 
-        // detect landmark points
+        // detect landmark points (holding the model, so switching doesn't wait for us)
         _mutex.lock();
-        dlib::rectangle region(left, top, right, bottom);
-        dlib::full_object_detection points = shape_predictor(image, region);
+        auto predictor = shape_predictor;
+        bool threaded = Parallel::enabled;
         _mutex.unlock();
 
+        dlib::rectangle region(left, top, right, bottom);
+        dlib::full_object_detection points = threaded ?
+                                              (*predictor)(image, region, *Parallel::pool) :
+                                              (*predictor)(image, region);
+
         // result
         auto num_points = points.num_parts();
         jsize len = (jsize) (num_points * sizeof(short)); // num_points * 2
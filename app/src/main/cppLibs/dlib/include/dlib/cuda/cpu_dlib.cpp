@@ -9,6 +9,7 @@
 #include "tensor_tools.h"
 #include "../image_transforms/interpolation.h"
 #include "../threads.h"
+#include "../simd.h"
 
 namespace dlib
 {
@@ -2009,6 +2010,1272 @@ namespace dlib
             }
         }
 
+        namespace impl
+        {
+            /*
+                The forward convolution is the product of the filters, one per row, and
+                the img2col() matrix of each sample, one output pixel per column.  Rather
+                than building the whole img2col() matrix, it is made conv_tile_nc columns
+                and conv_kc rows at a time, directly in the packed layout
+                conv_micro_kernel() reads.  So the part being worked on stays in cache and
+                the tiles can be processed in parallel.
+            */
+            const long conv_mr = 6;
+            const long conv_nr = 8;
+            const long conv_tile_nc = 64;
+            const long conv_kc = 256;
+            const long conv_direct_max_filters = 2;
+
+            template <long rows>
+            inline void conv_micro_kernel (
+                const long kc,
+                const float* a,
+                const float* b,
+                float* c,
+                const long ldc,
+                const bool accumulate
+            )
+            /*!
+                requires
+                    - 0 < rows < conv_mr
+                    - a == a conv_mr by kc matrix, stored one column after another.
+                    - b == a kc by conv_nr matrix, stored one row after another.
+                    - c == a rows by conv_nr matrix with rows ldc floats apart.
+                ensures
+                    - Let A be the first rows rows of a.  Then:
+                    - if (accumulate) then
+                        - #c == c + A*b
+                    - else
+                        - #c == A*b
+            !*/
+            {
+                simd8f acc[rows];
+                for (long i = 0; i < rows; ++i)
+                {
+                    if (accumulate)
+                        acc[i].load(c+i*ldc);
+                    else
+                        acc[i] = 0;
+                }
+
+                for (long k = 0; k < kc; ++k, a += conv_mr, b += conv_nr)
+                {
+                    simd8f bb;
+                    bb.load(b);
+                    for (long i = 0; i < rows; ++i)
+                        acc[i] += simd8f(a[i])*bb;
+                }
+
+                for (long i = 0; i < rows; ++i)
+                    acc[i].store(c+i*ldc);
+            }
+
+            inline void conv_micro_kernel_full (
+                const long kc,
+                const float* a,
+                const float* b,
+                float* c,
+                const long ldc,
+                const bool accumulate
+            )
+            /*!
+                ensures
+                    - performs conv_micro_kernel<conv_mr>(kc,a,b,c,ldc,accumulate).  It's
+                      written out by hand since compilers don't reliably keep the
+                      accumulator array of the template in registers.
+            !*/
+            {
+                simd8f c0, c1, c2, c3, c4, c5;
+                if (accumulate)
+                {
+                    c0.load(c);
+                    c1.load(c+ldc);
+                    c2.load(c+2*ldc);
+                    c3.load(c+3*ldc);
+                    c4.load(c+4*ldc);
+                    c5.load(c+5*ldc);
+                }
+                else
+                {
+                    c0 = c1 = c2 = c3 = c4 = c5 = 0;
+                }
+
+                for (long k = 0; k < kc; ++k, a += conv_mr, b += conv_nr)
+                {
+                    simd8f bb;
+                    bb.load(b);
+                    c0 += simd8f(a[0])*bb;
+                    c1 += simd8f(a[1])*bb;
+                    c2 += simd8f(a[2])*bb;
+                    c3 += simd8f(a[3])*bb;
+                    c4 += simd8f(a[4])*bb;
+                    c5 += simd8f(a[5])*bb;
+                }
+
+                c0.store(c);
+                c1.store(c+ldc);
+                c2.store(c+2*ldc);
+                c3.store(c+3*ldc);
+                c4.store(c+4*ldc);
+                c5.store(c+5*ldc);
+            }
+
+            inline void conv_micro_kernel (
+                const long rows,
+                const long kc,
+                const float* a,
+                const float* b,
+                float* c,
+                const long ldc,
+                const bool accumulate
+            )
+            {
+                switch (rows)
+                {
+                    case 1: conv_micro_kernel<1>(kc, a, b, c, ldc, accumulate); break;
+                    case 2: conv_micro_kernel<2>(kc, a, b, c, ldc, accumulate); break;
+                    case 3: conv_micro_kernel<3>(kc, a, b, c, ldc, accumulate); break;
+                    case 4: conv_micro_kernel<4>(kc, a, b, c, ldc, accumulate); break;
+                    case 5: conv_micro_kernel<5>(kc, a, b, c, ldc, accumulate); break;
+                    default: conv_micro_kernel_full(kc, a, b, c, ldc, accumulate); break;
+                }
+            }
+
+            inline void conv_epilogue (
+                float* out,
+                const long n,
+                const float bias,
+                const bool use_relu
+            )
+            /*!
+                ensures
+                    - adds bias to out[0] through out[n-1] and then, if use_relu is true,
+                      clamps them to be >= 0.
+            !*/
+            {
+                const simd8f b(bias), zero(0);
+                long i = 0;
+                for (; i+8 <= n; i += 8)
+                {
+                    simd8f v;
+                    v.load(out+i);
+                    v += b;
+                    if (use_relu)
+                        v = max(v, zero);
+                    v.store(out+i);
+                }
+                for (; i < n; ++i)
+                {
+                    out[i] += bias;
+                    if (use_relu)
+                        out[i] = std::max(out[i], 0.0f);
+                }
+            }
+
+            void conv_direct_row (
+                const float* d,
+                const long data_k,
+                const long data_nr,
+                const long data_nc,
+                const float* f,
+                const long filter_nr,
+                const long filter_nc,
+                const long stride_y,
+                const long padding_y,
+                const long padding_x,
+                const long r,
+                float* out,
+                const long out_nc,
+                const bool add_to_output
+            )
+            /*!
+                requires
+                    - d == the data of one sample
+                    - f == one filter
+                    - The stride in x is 1.
+                ensures
+                    - Computes the r-th row of the output of the filter f on d, out.  That
+                      is, sets out to it or, if add_to_output is true, adds it to out.
+            !*/
+            {
+                if (!add_to_output)
+                    std::fill(out, out+out_nc, 0);
+
+                for (long k = 0; k < data_k; ++k)
+                {
+                    for (long y = 0; y < filter_nr; ++y)
+                    {
+                        const long yy = r*stride_y - padding_y + y;
+                        if (yy < 0 || yy >= data_nr)
+                            continue;
+                        const float* const in = d + (k*data_nr + yy)*data_nc;
+                        for (long x = 0; x < filter_nc; ++x)
+                        {
+                            const float w = f[(k*filter_nr + y)*filter_nc + x];
+                            const float* const src = in + x - padding_x;
+                            const long c_end = std::min(out_nc, data_nc + padding_x - x);
+                            long c = std::max<long>(0, padding_x - x);
+                            const simd8f ww(w);
+                            for (; c+8 <= c_end; c += 8)
+                            {
+                                simd8f o, v;
+                                o.load(out+c);
+                                v.load(src+c);
+                                o += ww*v;
+                                o.store(out+c);
+                            }
+                            for (; c < c_end; ++c)
+                                out[c] += w*src[c];
+                        }
+                    }
+                }
+            }
+
+            void conv_pack_filters (
+                const tensor& filters,
+                std::vector<float>& packed
+            )
+            /*!
+                ensures
+                    - Stores mat(filters) in #packed as blocks of conv_mr rows, each block
+                      stored one column after another.  The last block is padded with
+                      zero rows.
+            !*/
+            {
+                const long m = filters.num_samples();
+                const long k = filters.k()*filters.nr()*filters.nc();
+                const long mblocks = (m+conv_mr-1)/conv_mr;
+                packed.resize(mblocks*conv_mr*k);
+
+                const float* f = filters.host();
+                float* p = &packed[0];
+                for (long mb = 0; mb < mblocks; ++mb)
+                {
+                    for (long kk = 0; kk < k; ++kk)
+                    {
+                        for (long i = 0; i < conv_mr; ++i)
+                        {
+                            const long row = mb*conv_mr + i;
+                            *p++ = row < m ? f[row*k + kk] : 0;
+                        }
+                    }
+                }
+            }
+
+            template <typename T, long interleave = 1>
+            void conv_pack_tile (
+                const T* d,
+                const long data_k,
+                const long data_nr,
+                const long data_nc,
+                const long filter_nr,
+                const long filter_nc,
+                const long stride_y,
+                const long stride_x,
+                const long padding_y,
+                const long padding_x,
+                const long out_nc,
+                const long p0,
+                const long np,
+                const long k0,
+                const long k1,
+                T* packed
+            )
+            /*!
+                requires
+                    - d == the data of one sample
+                    - 0 < np <= conv_tile_nc
+                ensures
+                    - Stores rows k0 to k1-1 and columns p0 to p0+np-1 of the img2col()
+                      matrix of d, transposed so it has one column per output pixel, into
+                      packed.  It is stored as blocks of conv_nr columns, each block stored
+                      one row after another.  The last block is padded with zero columns.
+                    - if (interleave != 1) then
+                        - Each group of interleave rows is stored interleaved instead, so
+                          element j of the group's t-th row lands at index interleave*j+t.
+                          If the rows don't divide into groups evenly, the last group is
+                          padded with zero rows.
+            !*/
+            {
+                (void)data_k;
+                // The top left corner of the window of each output pixel and, for each
+                // block of conv_nr pixels, the range of window positions for which all
+                // the block's pixels are inside the image.
+                long rb[conv_tile_nc], cb[conv_tile_nc], offset[conv_tile_nc];
+                for (long j = 0; j < np; ++j)
+                {
+                    rb[j] = ((p0+j)/out_nc)*stride_y - padding_y;
+                    cb[j] = ((p0+j)%out_nc)*stride_x - padding_x;
+                    offset[j] = rb[j]*data_nc + cb[j];
+                }
+                const long groups = (np+conv_nr-1)/conv_nr;
+                rectangle inside[conv_tile_nc/conv_nr];
+                for (long g = 0; g < groups; ++g)
+                {
+                    if ((g+1)*conv_nr > np)
+                        continue;
+                    rectangle& r = inside[g];
+                    r = rectangle(0, 0, filter_nc-1, filter_nr-1);
+                    for (long j = g*conv_nr; j < (g+1)*conv_nr; ++j)
+                    {
+                        r.left() = std::max(r.left(), -cb[j]);
+                        r.top() = std::max(r.top(), -rb[j]);
+                        r.right() = std::min(r.right(), data_nc-1-cb[j]);
+                        r.bottom() = std::min(r.bottom(), data_nr-1-rb[j]);
+                    }
+                }
+
+                const long kc = (k1-k0+interleave-1)/interleave*interleave;
+                const long filter_size = filter_nr*filter_nc;
+                for (long kk = k0; kk < k1; ++kk)
+                {
+                    const long y = (kk%filter_size)/filter_nc;
+                    const long x = kk%filter_nc;
+                    const T* const dk = d + (kk/filter_size)*data_nr*data_nc;
+                    T* dest = packed + (kk-k0)/interleave*interleave*conv_nr + (kk-k0)%interleave;
+                    for (long g = 0; g < groups; ++g, dest += kc*conv_nr)
+                    {
+                        if (inside[g].contains(x,y))
+                        {
+                            const T* const dkyx = dk + y*data_nc + x;
+                            const long* const off = offset + g*conv_nr;
+                            for (long jj = 0; jj < conv_nr; ++jj)
+                                dest[interleave*jj] = dkyx[off[jj]];
+                            continue;
+                        }
+
+                        for (long j = g*conv_nr, jj = 0; jj < conv_nr; ++j, ++jj)
+                        {
+                            T v = 0;
+                            if (j < np)
+                            {
+                                const long yy = rb[j]+y;
+                                const long xx = cb[j]+x;
+                                if (0 <= yy && yy < data_nr && 0 <= xx && xx < data_nc)
+                                    v = dk[yy*data_nc + xx];
+                            }
+                            dest[interleave*jj] = v;
+                        }
+                    }
+                }
+
+                for (long kk = k1-k0; kk < kc; ++kk)
+                {
+                    T* dest = packed + kk/interleave*interleave*conv_nr + kk%interleave;
+                    for (long g = 0; g < groups; ++g, dest += kc*conv_nr)
+                    {
+                        for (long jj = 0; jj < conv_nr; ++jj)
+                            dest[interleave*jj] = 0;
+                    }
+                }
+            }
+
+            /*
+                3x3 filters with a stride of 1 are done with the Winograd F(2x2,3x3)
+                algorithm instead.  It computes each 2x2 block of output pixels from the
+                4x4 block of input pixels under it as
+                    A'*((G*g*G') .* (B'*d*B))*A
+                where g is the filter and .* multiplies element by element.  That takes
+                16 multiplies per channel and filter instead of the 36 of the direct
+                computation.  Summed over the channels, the element by element products
+                become 16 independent matrix products, one per element of the 4x4
+                blocks, and those are done with conv_micro_kernel().
+            */
+            const long wino_tile_nt = 32;
+            const long wino_kc = 128;
+
+            inline bool can_use_winograd (
+                const tensor& filters,
+                const long stride_y,
+                const long stride_x
+            )
+            {
+                return filters.nr() == 3 && filters.nc() == 3 && stride_y == 1 && stride_x == 1 &&
+                    filters.num_samples() > conv_direct_max_filters;
+            }
+
+            void winograd_transform_filters (
+                const tensor& filters,
+                std::vector<float>& transformed
+            )
+            /*!
+                requires
+                    - filters.nr() == 3 && filters.nc() == 3
+                ensures
+                    - Computes G*g*G' for every filter g.  The 16 elements of the results
+                      are stored as 16 matrices with a row per filter and a column per
+                      channel, each packed like conv_pack_filters() does.
+            !*/
+            {
+                const long M = filters.num_samples();
+                const long K = filters.k();
+                const long mblocks = (M+conv_mr-1)/conv_mr;
+                const long xi_stride = mblocks*conv_mr*K;
+                transformed.assign(16*xi_stride, 0);
+
+                const float* f = filters.host();
+                for (long m = 0; m < M; ++m)
+                {
+                    for (long k = 0; k < K; ++k, f += 9)
+                    {
+                        // G*g, where G == [1 0 0; .5 .5 .5; .5 -.5 .5; 0 0 1]
+                        float t[4][3];
+                        for (long c = 0; c < 3; ++c)
+                        {
+                            t[0][c] = f[c];
+                            t[1][c] = 0.5f*(f[c] + f[3+c] + f[6+c]);
+                            t[2][c] = 0.5f*(f[c] - f[3+c] + f[6+c]);
+                            t[3][c] = f[6+c];
+                        }
+                        float* const dest = &transformed[(m/conv_mr)*conv_mr*K + k*conv_mr + m%conv_mr];
+                        for (long r = 0; r < 4; ++r)
+                        {
+                            dest[(r*4+0)*xi_stride] = t[r][0];
+                            dest[(r*4+1)*xi_stride] = 0.5f*(t[r][0] + t[r][1] + t[r][2]);
+                            dest[(r*4+2)*xi_stride] = 0.5f*(t[r][0] - t[r][1] + t[r][2]);
+                            dest[(r*4+3)*xi_stride] = t[r][2];
+                        }
+                    }
+                }
+            }
+
+            void winograd_transform_data (
+                const float* d,
+                const long data_nr,
+                const long data_nc,
+                const long padding_y,
+                const long padding_x,
+                const long tiles_x,
+                const long t0,
+                const long nt,
+                const long k0,
+                const long k1,
+                float* panels
+            )
+            /*!
+                requires
+                    - d == the data of one sample
+                    - nt % conv_nr == 0
+                ensures
+                    - Computes B'*d*B for the input blocks of the output tiles t0 through
+                      t0+nt-1 and the channels k0 through k1-1.  Element xi of the results
+                      is stored in panels + xi*(k1-k0)*nt, packed like conv_pack_tile()
+                      does.  Tiles past the end of the image are anything.
+            !*/
+            {
+                const long kc = k1-k0;
+                float in[16][conv_nr];
+                for (long k = k0; k < k1; ++k)
+                {
+                    const float* const dk = d + k*data_nr*data_nc;
+                    for (long g = 0; g < nt; g += conv_nr)
+                    {
+                        // Gather the input blocks of conv_nr tiles so we can transform
+                        // them all at once.
+                        for (long j = 0; j < conv_nr; ++j)
+                        {
+                            const long t = t0 + g + j;
+                            const long y0 = 2*(t/tiles_x) - padding_y;
+                            const long x0 = 2*(t%tiles_x) - padding_x;
+                            if (0 <= y0 && y0+4 <= data_nr && 0 <= x0 && x0+4 <= data_nc)
+                            {
+                                const float* const src = dk + y0*data_nc + x0;
+                                for (long r = 0; r < 4; ++r)
+                                    for (long c = 0; c < 4; ++c)
+                                        in[r*4+c][j] = src[r*data_nc + c];
+                            }
+                            else
+                            {
+                                for (long r = 0; r < 4; ++r)
+                                {
+                                    for (long c = 0; c < 4; ++c)
+                                    {
+                                        const long yy = y0+r;
+                                        const long xx = x0+c;
+                                        in[r*4+c][j] = (0 <= yy && yy < data_nr && 0 <= xx && xx < data_nc) ?
+                                            dk[yy*data_nc + xx] : 0;
+                                    }
+                                }
+                            }
+                        }
+
+                        // B'*d, where B' == [1 0 -1 0; 0 1 1 0; 0 -1 1 0; 0 1 0 -1]
+                        simd8f t[4][4];
+                        for (long c = 0; c < 4; ++c)
+                        {
+                            simd8f d0, d1, d2, d3;
+                            d0.load(in[c]);
+                            d1.load(in[4+c]);
+                            d2.load(in[8+c]);
+                            d3.load(in[12+c]);
+                            t[0][c] = d0 - d2;
+                            t[1][c] = d1 + d2;
+                            t[2][c] = d2 - d1;
+                            t[3][c] = d1 - d3;
+                        }
+                        // times B
+                        float* const dest = panels + g*kc + (k-k0)*conv_nr;
+                        const long xi_stride = kc*nt;
+                        for (long r = 0; r < 4; ++r)
+                        {
+                            (t[r][0] - t[r][2]).store(dest + (r*4+0)*xi_stride);
+                            (t[r][1] + t[r][2]).store(dest + (r*4+1)*xi_stride);
+                            (t[r][2] - t[r][1]).store(dest + (r*4+2)*xi_stride);
+                            (t[r][1] - t[r][3]).store(dest + (r*4+3)*xi_stride);
+                        }
+                    }
+                }
+            }
+
+            void winograd_transform_output (
+                const float* prods,
+                const long M,
+                const long nt,
+                const long tiles_x,
+                const long t0,
+                const long num_tiles,
+                float* out,
+                const long out_nr,
+                const long out_nc,
+                const bool add_to_output,
+                const float* biases,
+                const bool use_relu
+            )
+            /*!
+                requires
+                    - prods == the 16 matrix products, each M by nt.
+                    - out == the output of one sample.
+                ensures
+                    - Computes A'*p*A for each tile and filter and stores it in the output
+                      pixels of the tile, or adds it to them if add_to_output is true.
+                      Before that, biases[m] is added to the outputs of the m-th filter,
+                      if biases isn't null, and they are clamped to be >= 0 if use_relu
+                      is true.
+            !*/
+            {
+                const long xi_stride = M*nt;
+                float y[4][conv_nr];
+                for (long m = 0; m < M; ++m)
+                {
+                    float* const outm = out + m*out_nr*out_nc;
+                    for (long g = 0; g < nt && t0+g < num_tiles; g += conv_nr)
+                    {
+                        // A'*p, where A' == [1 1 1 0; 0 1 -1 -1]
+                        const float* const p = prods + m*nt + g;
+                        simd8f s[2][4];
+                        for (long c = 0; c < 4; ++c)
+                        {
+                            simd8f p0, p1, p2, p3;
+                            p0.load(p + (0*4+c)*xi_stride);
+                            p1.load(p + (1*4+c)*xi_stride);
+                            p2.load(p + (2*4+c)*xi_stride);
+                            p3.load(p + (3*4+c)*xi_stride);
+                            s[0][c] = p0 + p1 + p2;
+                            s[1][c] = p1 - p2 - p3;
+                        }
+                        // times A
+                        const simd8f b(biases ? biases[m] : 0), zero(0);
+                        for (long r = 0; r < 2; ++r)
+                        {
+                            simd8f y0 = s[r][0] + s[r][1] + s[r][2];
+                            simd8f y1 = s[r][1] - s[r][2] - s[r][3];
+                            if (biases)
+                            {
+                                y0 += b;
+                                y1 += b;
+                            }
+                            if (use_relu)
+                            {
+                                y0 = max(y0, zero);
+                                y1 = max(y1, zero);
+                            }
+                            y0.store(y[r*2]);
+                            y1.store(y[r*2+1]);
+                        }
+
+                        for (long j = 0; j < conv_nr && t0+g+j < num_tiles; ++j)
+                        {
+                            const long t = t0+g+j;
+                            const long oy = 2*(t/tiles_x);
+                            const long ox = 2*(t%tiles_x);
+                            for (long r = 0; r < 2 && oy+r < out_nr; ++r)
+                            {
+                                for (long c = 0; c < 2 && ox+c < out_nc; ++c)
+                                {
+                                    float& o = outm[(oy+r)*out_nc + ox+c];
+                                    if (add_to_output)
+                                        o += y[r*2+c][j];
+                                    else
+                                        o = y[r*2+c][j];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+            void conv_winograd (
+                const bool add_to_output,
+                tensor& output,
+                const tensor& data,
+                const std::vector<float>& transformed_filters,
+                const long padding_y,
+                const long padding_x,
+                const float* biases,
+                const bool use_relu
+            )
+            /*!
+                requires
+                    - transformed_filters == the output of winograd_transform_filters()
+                      for filters that are 3x3 and the right size for data and output.
+                ensures
+                    - Performs the stride 1 convolution of the filters over data.  The
+                      biases and use_relu are applied as winograd_transform_output()
+                      does.
+            !*/
+            {
+                const long M = output.k();
+                const long K = data.k();
+                const long mblocks = (M+conv_mr-1)/conv_mr;
+                const long filters_xi_stride = mblocks*conv_mr*K;
+                const long out_nr = output.nr();
+                const long out_nc = output.nc();
+                const long tiles_x = (out_nc+1)/2;
+                const long num_tiles = tiles_x*((out_nr+1)/2);
+                const long tile_groups = (num_tiles+wino_tile_nt-1)/wino_tile_nt;
+
+                const float* const d = data.host();
+                float* const out = output.host();
+                const long data_nr = data.nr(), data_nc = data.nc();
+
+                parallel_for_blocked(0, data.num_samples()*tile_groups, [&](long begin, long end)
+                {
+                    std::vector<float> panels(16*std::min(K,wino_kc)*wino_tile_nt);
+                    std::vector<float> prods(16*M*wino_tile_nt);
+                    for (long job = begin; job < end; ++job)
+                    {
+                        const long n = job/tile_groups;
+                        const long t0 = (job%tile_groups)*wino_tile_nt;
+                        for (long k0 = 0; k0 < K; k0 += wino_kc)
+                        {
+                            const long k1 = std::min(K, k0+wino_kc);
+                            const long kc = k1-k0;
+                            winograd_transform_data(d + n*K*data_nr*data_nc, data_nr, data_nc,
+                                padding_y, padding_x, tiles_x, t0, wino_tile_nt, k0, k1, &panels[0]);
+
+                            for (long xi = 0; xi < 16; ++xi)
+                            {
+                                const float* const a = &transformed_filters[xi*filters_xi_stride];
+                                const float* const b = &panels[xi*kc*wino_tile_nt];
+                                float* const c = &prods[xi*M*wino_tile_nt];
+                                for (long mb = 0; mb < mblocks; ++mb)
+                                {
+                                    const long m0 = mb*conv_mr;
+                                    const long mm = std::min(conv_mr, M-m0);
+                                    for (long c0 = 0; c0 < wino_tile_nt; c0 += conv_nr)
+                                    {
+                                        conv_micro_kernel(mm, kc, a + m0*K + k0*conv_mr, b + c0*kc,
+                                            c + m0*wino_tile_nt + c0, wino_tile_nt, k0 != 0);
+                                    }
+                                }
+                            }
+                        }
+                        winograd_transform_output(&prods[0], M, wino_tile_nt, tiles_x, t0,
+                            num_tiles, out + n*M*out_nr*out_nc, out_nr, out_nc, add_to_output, biases, use_relu);
+                    }
+                });
+            }
+
+            /*
+                forward_int8() computes the same product as forward(), but on 8 bit
+                integers.  The filters are quantized with one scale per filter and the data
+                with one scale for the whole tensor, so the products can be summed exactly
+                in 32 bit integers and scaled back to floats at the end.  Data that is
+                never negative, like the output of a relu, is quantized to [0,255] rather
+                than [-127,127], as with the unsigned times signed bytes of VNNI's
+                vpdpbusd.
+
+                The quantized values are stored as 16 bit integers, with each pair of
+                rows of the img2col() matrix interleaved, since that's what the multiply
+                and add instructions take.  On x86, pmaddwd multiplies 16 pairs of 16 bit
+                integers and adds each product to its neighbor, so one instruction does
+                16 multiply-adds where an AVX float multiply does 8, and when compiled
+                for AVX-VNNI, vpdpwssd does the accumulate in the same instruction.  On
+                ARM, vmlal_s16 multiplies and accumulates 4 of them at a time.
+            */
+            const float int8_max = 127;
+
+            inline int16 quantize_value (
+                float v,
+                const float qmin,
+                const float qmax
+            )
+            {
+                v = std::min(std::max(v, qmin), qmax);
+                return static_cast<int16>(v >= 0 ? v+0.5f : v-0.5f);
+            }
+
+            inline void quantize_values (
+                const float* src,
+                const long n,
+                const float scale,
+                const float qmin,
+                const float qmax,
+                int16* dest
+            )
+            /*!
+                ensures
+                    - performs dest[i] = quantize_value(src[i]*scale, qmin, qmax) for all
+                      0 <= i < n, 8 values at a time.
+            !*/
+            {
+                const simd8f s(scale), lo(qmin), hi(qmax), zero(0), pos_half(0.5f), neg_half(-0.5f);
+                int32 temp[8];
+                long i = 0;
+                for (; i+8 <= n; i += 8)
+                {
+                    simd8f v;
+                    v.load(src+i);
+                    v = min(max(v*s, lo), hi);
+                    v += select(v < zero, neg_half, pos_half);
+                    simd8i(v).store(temp);
+                    for (long j = 0; j < 8; ++j)
+                        dest[i+j] = static_cast<int16>(temp[j]);
+                }
+                for (; i < n; ++i)
+                    dest[i] = quantize_value(src[i]*scale, qmin, qmax);
+            }
+
+            inline int32 pack_int16_pair (
+                const int16 low,
+                const int16 high
+            )
+            {
+                return static_cast<int32>(static_cast<uint32>(static_cast<uint16>(low)) |
+                                          (static_cast<uint32>(static_cast<uint16>(high)) << 16));
+            }
+
+            inline void int8_data_range (
+                const float data_min,
+                const float data_max,
+                float& scale,
+                float& qmin,
+                float& qmax
+            )
+            /*!
+                ensures
+                    - Data in [data_min,data_max] should be quantized by dividing it by
+                      #scale and rounding it to an integer in [#qmin,#qmax].
+            !*/
+            {
+                if (data_min >= 0)
+                {
+                    qmin = 0;
+                    qmax = 255;
+                    scale = data_max/qmax;
+                }
+                else
+                {
+                    qmin = -int8_max;
+                    qmax = int8_max;
+                    scale = std::max(-data_min, data_max)/qmax;
+                }
+                if (!(scale > 0))
+                    scale = 1;
+            }
+
+#if defined(DLIB_HAVE_AVX2)
+            inline __m256i int8_multiply_add (
+                const __m256i acc,
+                const __m256i a,
+                const __m256i b
+            )
+            {
+                // VNNI does the multiply, the pairwise add, and the accumulate in one
+                // instruction.
+#if defined(__AVXVNNI__)
+                return _mm256_dpwssd_avx_epi32(acc, a, b);
+#elif defined(__AVX512VNNI__) && defined(__AVX512VL__)
+                return _mm256_dpwssd_epi32(acc, a, b);
+#else
+                return _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+#endif
+            }
+#endif
+
+            template <long rows>
+            inline void int8_micro_kernel (
+                const long kp,
+                const int32* a,
+                const int16* b,
+                int32* c,
+                const long ldc,
+                const bool accumulate
+            )
+            /*!
+                requires
+                    - 0 < rows <= conv_mr
+                    - a == a conv_mr by 2*kp matrix, stored as kp groups of conv_mr
+                      int32s.  The i-th int32 of the p-th group holds the elements of row i
+                      in columns 2p (the low 16 bits) and 2p+1 (the high 16 bits).
+                    - b == a 2*kp by conv_nr matrix, stored as kp groups of 2*conv_nr
+                      int16s.  The p-th group holds rows 2p and 2p+1 interleaved, so its
+                      element 2*j+t is the element of row 2p+t in column j.
+                    - c == a rows by conv_nr matrix with rows ldc int32s apart.
+                ensures
+                    - Let A be the first rows rows of a.  Then:
+                    - if (accumulate) then
+                        - #c == c + A*b
+                    - else
+                        - #c == A*b
+            !*/
+            {
+#if defined(DLIB_HAVE_AVX2)
+                __m256i acc[rows];
+                for (long i = 0; i < rows; ++i)
+                {
+                    if (accumulate)
+                        acc[i] = _mm256_loadu_si256((const __m256i*)(c+i*ldc));
+                    else
+                        acc[i] = _mm256_setzero_si256();
+                }
+
+                for (long p = 0; p < kp; ++p, a += conv_mr, b += 2*conv_nr)
+                {
+                    const __m256i bb = _mm256_loadu_si256((const __m256i*)b);
+                    for (long i = 0; i < rows; ++i)
+                        acc[i] = int8_multiply_add(acc[i], _mm256_set1_epi32(a[i]), bb);
+                }
+
+                for (long i = 0; i < rows; ++i)
+                    _mm256_storeu_si256((__m256i*)(c+i*ldc), acc[i]);
+#elif defined(DLIB_HAVE_SSE2)
+                __m128i lo[rows], hi[rows];
+                for (long i = 0; i < rows; ++i)
+                {
+                    if (accumulate)
+                    {
+                        lo[i] = _mm_loadu_si128((const __m128i*)(c+i*ldc));
+                        hi[i] = _mm_loadu_si128((const __m128i*)(c+i*ldc+4));
+                    }
+                    else
+                    {
+                        lo[i] = hi[i] = _mm_setzero_si128();
+                    }
+                }
+
+                for (long p = 0; p < kp; ++p, a += conv_mr, b += 2*conv_nr)
+                {
+                    const __m128i bl = _mm_loadu_si128((const __m128i*)b);
+                    const __m128i bh = _mm_loadu_si128((const __m128i*)(b+8));
+                    for (long i = 0; i < rows; ++i)
+                    {
+                        const __m128i aa = _mm_set1_epi32(a[i]);
+                        lo[i] = _mm_add_epi32(lo[i], _mm_madd_epi16(aa, bl));
+                        hi[i] = _mm_add_epi32(hi[i], _mm_madd_epi16(aa, bh));
+                    }
+                }
+
+                for (long i = 0; i < rows; ++i)
+                {
+                    _mm_storeu_si128((__m128i*)(c+i*ldc), lo[i]);
+                    _mm_storeu_si128((__m128i*)(c+i*ldc+4), hi[i]);
+                }
+#elif defined(DLIB_HAVE_NEON)
+                int32x4_t lo[rows], hi[rows];
+                for (long i = 0; i < rows; ++i)
+                {
+                    if (accumulate)
+                    {
+                        lo[i] = vld1q_s32(c+i*ldc);
+                        hi[i] = vld1q_s32(c+i*ldc+4);
+                    }
+                    else
+                    {
+                        lo[i] = hi[i] = vdupq_n_s32(0);
+                    }
+                }
+
+                for (long p = 0; p < kp; ++p, a += conv_mr, b += 2*conv_nr)
+                {
+                    // Splits the interleaved rows back apart.
+                    const int16x8x2_t bb = vld2q_s16(b);
+                    for (long i = 0; i < rows; ++i)
+                    {
+                        const int16 a0 = static_cast<int16>(a[i] & 0xFFFF);
+                        const int16 a1 = static_cast<int16>(a[i] >> 16);
+                        lo[i] = vmlal_n_s16(lo[i], vget_low_s16(bb.val[0]), a0);
+                        lo[i] = vmlal_n_s16(lo[i], vget_low_s16(bb.val[1]), a1);
+                        hi[i] = vmlal_n_s16(hi[i], vget_high_s16(bb.val[0]), a0);
+                        hi[i] = vmlal_n_s16(hi[i], vget_high_s16(bb.val[1]), a1);
+                    }
+                }
+
+                for (long i = 0; i < rows; ++i)
+                {
+                    vst1q_s32(c+i*ldc, lo[i]);
+                    vst1q_s32(c+i*ldc+4, hi[i]);
+                }
+#else
+                int32 acc[rows][conv_nr];
+                for (long i = 0; i < rows; ++i)
+                {
+                    for (long j = 0; j < conv_nr; ++j)
+                        acc[i][j] = accumulate ? c[i*ldc+j] : 0;
+                }
+
+                for (long p = 0; p < kp; ++p, a += conv_mr, b += 2*conv_nr)
+                {
+                    for (long i = 0; i < rows; ++i)
+                    {
+                        const int32 a0 = static_cast<int16>(a[i] & 0xFFFF);
+                        const int32 a1 = static_cast<int16>(a[i] >> 16);
+                        for (long j = 0; j < conv_nr; ++j)
+                            acc[i][j] += a0*b[2*j] + a1*b[2*j+1];
+                    }
+                }
+
+                for (long i = 0; i < rows; ++i)
+                {
+                    for (long j = 0; j < conv_nr; ++j)
+                        c[i*ldc+j] = acc[i][j];
+                }
+#endif
+            }
+
+            inline void int8_micro_kernel_full (
+                const long kp,
+                const int32* a,
+                const int16* b,
+                int32* c,
+                const long ldc,
+                const bool accumulate
+            )
+            /*!
+                ensures
+                    - performs int8_micro_kernel<conv_mr>(kp,a,b,c,ldc,accumulate) and then
+                      int8_micro_kernel<conv_mr>(kp,a,b+2*kp*conv_nr,c+conv_nr,ldc,accumulate).
+                      That is, it does two blocks of columns in one pass over a.  The
+                      integer instructions are quick enough that one block of sums
+                      doesn't give the CPU enough independent work, so this is written
+                      out by hand like conv_micro_kernel_full().
+            !*/
+            {
+#if defined(DLIB_HAVE_AVX2)
+                const int16* b2 = b + 2*kp*conv_nr;
+                __m256i c0, c1, c2, c3, c4, c5, d0, d1, d2, d3, d4, d5;
+                if (accumulate)
+                {
+                    c0 = _mm256_loadu_si256((const __m256i*)c);
+                    c1 = _mm256_loadu_si256((const __m256i*)(c+ldc));
+                    c2 = _mm256_loadu_si256((const __m256i*)(c+2*ldc));
+                    c3 = _mm256_loadu_si256((const __m256i*)(c+3*ldc));
+                    c4 = _mm256_loadu_si256((const __m256i*)(c+4*ldc));
+                    c5 = _mm256_loadu_si256((const __m256i*)(c+5*ldc));
+                    d0 = _mm256_loadu_si256((const __m256i*)(c+conv_nr));
+                    d1 = _mm256_loadu_si256((const __m256i*)(c+ldc+conv_nr));
+                    d2 = _mm256_loadu_si256((const __m256i*)(c+2*ldc+conv_nr));
+                    d3 = _mm256_loadu_si256((const __m256i*)(c+3*ldc+conv_nr));
+                    d4 = _mm256_loadu_si256((const __m256i*)(c+4*ldc+conv_nr));
+                    d5 = _mm256_loadu_si256((const __m256i*)(c+5*ldc+conv_nr));
+                }
+                else
+                {
+                    c0 = c1 = c2 = c3 = c4 = c5 = _mm256_setzero_si256();
+                    d0 = d1 = d2 = d3 = d4 = d5 = _mm256_setzero_si256();
+                }
+
+                for (long p = 0; p < kp; ++p, a += conv_mr, b += 2*conv_nr, b2 += 2*conv_nr)
+                {
+                    const __m256i bb = _mm256_loadu_si256((const __m256i*)b);
+                    const __m256i bb2 = _mm256_loadu_si256((const __m256i*)b2);
+                    __m256i aa;
+                    aa = _mm256_set1_epi32(a[0]);
+                    c0 = int8_multiply_add(c0, aa, bb);
+                    d0 = int8_multiply_add(d0, aa, bb2);
+                    aa = _mm256_set1_epi32(a[1]);
+                    c1 = int8_multiply_add(c1, aa, bb);
+                    d1 = int8_multiply_add(d1, aa, bb2);
+                    aa = _mm256_set1_epi32(a[2]);
+                    c2 = int8_multiply_add(c2, aa, bb);
+                    d2 = int8_multiply_add(d2, aa, bb2);
+                    aa = _mm256_set1_epi32(a[3]);
+                    c3 = int8_multiply_add(c3, aa, bb);
+                    d3 = int8_multiply_add(d3, aa, bb2);
+                    aa = _mm256_set1_epi32(a[4]);
+                    c4 = int8_multiply_add(c4, aa, bb);
+                    d4 = int8_multiply_add(d4, aa, bb2);
+                    aa = _mm256_set1_epi32(a[5]);
+                    c5 = int8_multiply_add(c5, aa, bb);
+                    d5 = int8_multiply_add(d5, aa, bb2);
+                }
+
+                _mm256_storeu_si256((__m256i*)c, c0);
+                _mm256_storeu_si256((__m256i*)(c+ldc), c1);
+                _mm256_storeu_si256((__m256i*)(c+2*ldc), c2);
+                _mm256_storeu_si256((__m256i*)(c+3*ldc), c3);
+                _mm256_storeu_si256((__m256i*)(c+4*ldc), c4);
+                _mm256_storeu_si256((__m256i*)(c+5*ldc), c5);
+                _mm256_storeu_si256((__m256i*)(c+conv_nr), d0);
+                _mm256_storeu_si256((__m256i*)(c+ldc+conv_nr), d1);
+                _mm256_storeu_si256((__m256i*)(c+2*ldc+conv_nr), d2);
+                _mm256_storeu_si256((__m256i*)(c+3*ldc+conv_nr), d3);
+                _mm256_storeu_si256((__m256i*)(c+4*ldc+conv_nr), d4);
+                _mm256_storeu_si256((__m256i*)(c+5*ldc+conv_nr), d5);
+#elif defined(DLIB_HAVE_SSE2)
+                // With only 16 registers, each block of columns gets its own pass.
+                const int32* const a_begin = a;
+                for (long blk = 0; blk < 2; ++blk, c += conv_nr)
+                {
+                    a = a_begin;
+                    __m128i l0, l1, l2, l3, l4, l5, h0, h1, h2, h3, h4, h5;
+                    if (accumulate)
+                    {
+                        l0 = _mm_loadu_si128((const __m128i*)c);
+                        l1 = _mm_loadu_si128((const __m128i*)(c+ldc));
+                        l2 = _mm_loadu_si128((const __m128i*)(c+2*ldc));
+                        l3 = _mm_loadu_si128((const __m128i*)(c+3*ldc));
+                        l4 = _mm_loadu_si128((const __m128i*)(c+4*ldc));
+                        l5 = _mm_loadu_si128((const __m128i*)(c+5*ldc));
+                        h0 = _mm_loadu_si128((const __m128i*)(c+4));
+                        h1 = _mm_loadu_si128((const __m128i*)(c+ldc+4));
+                        h2 = _mm_loadu_si128((const __m128i*)(c+2*ldc+4));
+                        h3 = _mm_loadu_si128((const __m128i*)(c+3*ldc+4));
+                        h4 = _mm_loadu_si128((const __m128i*)(c+4*ldc+4));
+                        h5 = _mm_loadu_si128((const __m128i*)(c+5*ldc+4));
+                    }
+                    else
+                    {
+                        l0 = l1 = l2 = l3 = l4 = l5 = _mm_setzero_si128();
+                        h0 = h1 = h2 = h3 = h4 = h5 = _mm_setzero_si128();
+                    }
+
+                    for (long p = 0; p < kp; ++p, a += conv_mr, b += 2*conv_nr)
+                    {
+                        const __m128i bl = _mm_loadu_si128((const __m128i*)b);
+                        const __m128i bh = _mm_loadu_si128((const __m128i*)(b+8));
+                        __m128i aa;
+                        aa = _mm_set1_epi32(a[0]);
+                        l0 = _mm_add_epi32(l0, _mm_madd_epi16(aa, bl));
+                        h0 = _mm_add_epi32(h0, _mm_madd_epi16(aa, bh));
+                        aa = _mm_set1_epi32(a[1]);
+                        l1 = _mm_add_epi32(l1, _mm_madd_epi16(aa, bl));
+                        h1 = _mm_add_epi32(h1, _mm_madd_epi16(aa, bh));
+                        aa = _mm_set1_epi32(a[2]);
+                        l2 = _mm_add_epi32(l2, _mm_madd_epi16(aa, bl));
+                        h2 = _mm_add_epi32(h2, _mm_madd_epi16(aa, bh));
+                        aa = _mm_set1_epi32(a[3]);
+                        l3 = _mm_add_epi32(l3, _mm_madd_epi16(aa, bl));
+                        h3 = _mm_add_epi32(h3, _mm_madd_epi16(aa, bh));
+                        aa = _mm_set1_epi32(a[4]);
+                        l4 = _mm_add_epi32(l4, _mm_madd_epi16(aa, bl));
+                        h4 = _mm_add_epi32(h4, _mm_madd_epi16(aa, bh));
+                        aa = _mm_set1_epi32(a[5]);
+                        l5 = _mm_add_epi32(l5, _mm_madd_epi16(aa, bl));
+                        h5 = _mm_add_epi32(h5, _mm_madd_epi16(aa, bh));
+                    }
+
+                    _mm_storeu_si128((__m128i*)c, l0);
+                    _mm_storeu_si128((__m128i*)(c+ldc), l1);
+                    _mm_storeu_si128((__m128i*)(c+2*ldc), l2);
+                    _mm_storeu_si128((__m128i*)(c+3*ldc), l3);
+                    _mm_storeu_si128((__m128i*)(c+4*ldc), l4);
+                    _mm_storeu_si128((__m128i*)(c+5*ldc), l5);
+                    _mm_storeu_si128((__m128i*)(c+4), h0);
+                    _mm_storeu_si128((__m128i*)(c+ldc+4), h1);
+                    _mm_storeu_si128((__m128i*)(c+2*ldc+4), h2);
+                    _mm_storeu_si128((__m128i*)(c+3*ldc+4), h3);
+                    _mm_storeu_si128((__m128i*)(c+4*ldc+4), h4);
+                    _mm_storeu_si128((__m128i*)(c+5*ldc+4), h5);
+                }
+#else
+                int8_micro_kernel<conv_mr>(kp, a, b, c, ldc, accumulate);
+                int8_micro_kernel<conv_mr>(kp, a, b+2*kp*conv_nr, c+conv_nr, ldc, accumulate);
+#endif
+            }
+
+            inline void int8_micro_kernel (
+                const long rows,
+                const long kp,
+                const int32* a,
+                const int16* b,
+                int32* c,
+                const long ldc,
+                const bool accumulate
+            )
+            {
+                switch (rows)
+                {
+                    case 1: int8_micro_kernel<1>(kp, a, b, c, ldc, accumulate); break;
+                    case 2: int8_micro_kernel<2>(kp, a, b, c, ldc, accumulate); break;
+                    case 3: int8_micro_kernel<3>(kp, a, b, c, ldc, accumulate); break;
+                    case 4: int8_micro_kernel<4>(kp, a, b, c, ldc, accumulate); break;
+                    case 5: int8_micro_kernel<5>(kp, a, b, c, ldc, accumulate); break;
+                    default: int8_micro_kernel<conv_mr>(kp, a, b, c, ldc, accumulate); break;
+                }
+            }
+
+            void int8_pack_rows (
+                const int16* q,
+                const long m,
+                const long k,
+                std::vector<int32>& packed
+            )
+            /*!
+                ensures
+                    - Stores the m by k row major matrix q in #packed as blocks of conv_mr
+                      rows, each block laid out as int8_micro_kernel() wants its a
+                      argument.  The blocks are padded with zeros to a whole number of rows
+                      and pairs of columns.
+            !*/
+            {
+                const long kp = (k+1)/2;
+                const long mblocks = (m+conv_mr-1)/conv_mr;
+                packed.assign(mblocks*conv_mr*kp, 0);
+                for (long i = 0; i < m; ++i)
+                {
+                    const int16* const row = q + i*k;
+                    int32* const dest = &packed[(i/conv_mr)*conv_mr*kp + i%conv_mr];
+                    for (long p = 0; p < kp; ++p)
+                        dest[p*conv_mr] = pack_int16_pair(row[2*p], 2*p+1 < k ? row[2*p+1] : 0);
+                }
+            }
+
+            void int8_unpack_rows (
+                const std::vector<int32>& packed,
+                const long m,
+                const long k,
+                std::vector<int16>& q
+            )
+            /*!
+                ensures
+                    - undoes int8_pack_rows(), storing the m by k matrix in #q.
+            !*/
+            {
+                const long kp = (k+1)/2;
+                q.resize(m*k);
+                for (long i = 0; i < m; ++i)
+                {
+                    const int32* const src = &packed[(i/conv_mr)*conv_mr*kp + i%conv_mr];
+                    for (long j = 0; j < k; ++j)
+                    {
+                        const uint32 pair = static_cast<uint32>(src[(j/2)*conv_mr]);
+                        q[i*k+j] = static_cast<int16>(static_cast<uint16>(j%2 == 0 ? pair : pair>>16));
+                    }
+                }
+            }
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        void int8_weights::quantize (
+            const tensor& weights,
+            bool by_column_
+        )
+        {
+            using namespace impl;
+            const long n = weights.num_samples();
+            const long cols = n != 0 ? weights.size()/n : 0;
+            by_column = by_column_;
+            shape_n = n;
+            shape_k = weights.k();
+            shape_nr = weights.nr();
+            shape_nc = weights.nc();
+            num_vectors = by_column ? cols : n;
+            vector_size = by_column ? n : cols;
+            const long row_stride = by_column ? 1 : cols;
+            const long col_stride = by_column ? cols : 1;
+
+            const float* const w = weights.host();
+            std::vector<int16> q(num_vectors*vector_size);
+            vector_scales.resize(num_vectors);
+            for (long i = 0; i < num_vectors; ++i)
+            {
+                const float* const row = w + i*row_stride;
+                float biggest = 0;
+                for (long j = 0; j < vector_size; ++j)
+                    biggest = std::max(biggest, std::abs(row[j*col_stride]));
+                const float scale = biggest > 0 ? biggest/int8_max : 1;
+                vector_scales[i] = scale;
+                for (long j = 0; j < vector_size; ++j)
+                    q[i*vector_size+j] = quantize_value(row[j*col_stride]/scale, -int8_max, int8_max);
+            }
+            int8_pack_rows(q.data(), num_vectors, vector_size, values);
+        }
+
+        void int8_weights::dequantize (
+            tensor& weights
+        ) const
+        {
+            DLIB_CASSERT(weights.num_samples() == num_samples() && weights.k() == k() &&
+                         weights.nr() == nr() && weights.nc() == nc());
+            std::vector<int16> q;
+            impl::int8_unpack_rows(values, num_vectors, vector_size, q);
+            const long row_stride = by_column ? 1 : vector_size;
+            const long col_stride = by_column ? num_vectors : 1;
+            float* const w = weights.host_write_only();
+            for (long i = 0; i < num_vectors; ++i)
+            {
+                for (long j = 0; j < vector_size; ++j)
+                    w[i*row_stride + j*col_stride] = q[i*vector_size+j]*vector_scales[i];
+            }
+        }
+
+        void serialize(const int8_weights& item, std::ostream& out)
+        {
+            dlib::serialize("int8_weights", out);
+            dlib::serialize(item.shape_n, out);
+            dlib::serialize(item.shape_k, out);
+            dlib::serialize(item.shape_nr, out);
+            dlib::serialize(item.shape_nc, out);
+            dlib::serialize(item.by_column, out);
+            dlib::serialize(item.vector_scales, out);
+            // The values are saved as bytes offset by int8_max, so they don't depend on
+            // whether char is signed.
+            std::vector<int16> q;
+            impl::int8_unpack_rows(item.values, item.num_vectors, item.vector_size, q);
+            std::vector<unsigned char> bytes(q.size());
+            for (size_t i = 0; i < q.size(); ++i)
+                bytes[i] = static_cast<unsigned char>(q[i] + impl::int8_max);
+            dlib::serialize(bytes, out);
+        }
+
+        void deserialize(int8_weights& item, std::istream& in)
+        {
+            std::string version;
+            dlib::deserialize(version, in);
+            if (version != "int8_weights")
+                throw serialization_error("Unexpected version found while deserializing dlib::cpu::int8_weights.");
+            dlib::deserialize(item.shape_n, in);
+            dlib::deserialize(item.shape_k, in);
+            dlib::deserialize(item.shape_nr, in);
+            dlib::deserialize(item.shape_nc, in);
+            dlib::deserialize(item.by_column, in);
+            dlib::deserialize(item.vector_scales, in);
+            std::vector<unsigned char> bytes;
+            dlib::deserialize(bytes, in);
+
+            const long n = item.shape_n;
+            const long size = n*item.shape_k*item.shape_nr*item.shape_nc;
+            if (n < 0 || item.shape_k < 0 || item.shape_nr < 0 || item.shape_nc < 0 ||
+                (size_t)size != bytes.size())
+                throw serialization_error("Invalid shape found while deserializing dlib::cpu::int8_weights.");
+            const long cols = n != 0 ? size/n : 0;
+            item.num_vectors = item.by_column ? cols : n;
+            item.vector_size = item.by_column ? n : cols;
+            if (item.vector_scales.size() != (size_t)item.num_vectors)
+                throw serialization_error("Invalid scales found while deserializing dlib::cpu::int8_weights.");
+
+            std::vector<int16> q(bytes.size());
+            for (size_t i = 0; i < q.size(); ++i)
+            {
+                if (bytes[i] > 2*impl::int8_max)
+                    throw serialization_error("Invalid value found while deserializing dlib::cpu::int8_weights.");
+                q[i] = static_cast<int16>(bytes[i] - impl::int8_max);
+            }
+            impl::int8_pack_rows(q.data(), item.num_vectors, item.vector_size, item.values);
+        }
+
         void tensor_conv::operator() (
             const bool add_to_output,
             resizable_tensor& output,
@@ -2030,6 +3297,46 @@ namespace dlib
             const tensor& data,
             const tensor& filters
         )
+        {
+            forward(add_to_output, output, data, filters, nullptr, false);
+        }
+
+        void tensor_conv::operator() (
+            resizable_tensor& output,
+            const tensor& data,
+            const tensor& filters,
+            const tensor& biases,
+            bool use_relu
+        )
+        {
+            DLIB_CASSERT(last_stride_y > 0 && last_stride_x > 0, "You must call setup() before calling this function.");
+            output.set_size(data.num_samples(),
+                            filters.num_samples(),
+                            1+(data.nr()+2*last_padding_y-filters.nr())/last_stride_y,
+                            1+(data.nc()+2*last_padding_x-filters.nc())/last_stride_x);
+            (*this)(static_cast<tensor&>(output),data,filters,biases,use_relu);
+        }
+
+        void tensor_conv::operator() (
+            tensor& output,
+            const tensor& data,
+            const tensor& filters,
+            const tensor& biases,
+            bool use_relu
+        )
+        {
+            DLIB_CASSERT(biases.size() == (size_t)filters.num_samples());
+            forward(false, output, data, filters, biases.host(), use_relu);
+        }
+
+        void tensor_conv::forward (
+            const bool add_to_output,
+            tensor& output,
+            const tensor& data,
+            const tensor& filters,
+            const float* biases,
+            const bool use_relu
+        )
         {
             DLIB_CASSERT(is_same_object(output,data) == false);
             DLIB_CASSERT(is_same_object(output,filters) == false);
@@ -2046,16 +3353,350 @@ namespace dlib
             DLIB_CASSERT(output.nc() == 1+(data.nc()+2*last_padding_x-filters.nc())/last_stride_x);
 
 
-            matrix<float> temp;
-            for (long n = 0; n < data.num_samples(); ++n)
+            using namespace impl;
+            if (output.size() == 0)
+                return;
+
+            const long M = filters.num_samples();
+            const long K = filters.k()*filters.nr()*filters.nc();
+            const long P = output.nr()*output.nc();
+
+            // With only a few filters, building the img2col() matrix costs more than the
+            // multiplication, so just apply the filters directly, an output row at a time.
+            if (M <= conv_direct_max_filters && last_stride_x == 1)
             {
-                img2col(temp, data, n, filters.nr(), filters.nc(), last_stride_y, last_stride_x, last_padding_y, last_padding_x);
+                const float* const d = data.host();
+                const float* const f = filters.host();
+                float* const out = output.host();
+                const long out_nr = output.nr();
+                parallel_for(0, data.num_samples()*M*out_nr, [&](long i)
+                {
+                    const long r = i%out_nr;
+                    const long m = (i/out_nr)%M;
+                    const long n = i/(out_nr*M);
+                    conv_direct_row(d + n*data.k()*data.nr()*data.nc(), data.k(), data.nr(), data.nc(),
+                        f + m*K, filters.nr(), filters.nc(), last_stride_y, last_padding_y,
+                        last_padding_x, r, out + (n*M + m)*P + r*output.nc(), output.nc(), add_to_output);
+                    if (biases || use_relu)
+                        conv_epilogue(out + (n*M + m)*P + r*output.nc(), output.nc(), biases ? biases[m] : 0, use_relu);
+                });
+                return;
+            }
 
-                if (add_to_output)
-                    output.add_to_sample(n, mat(filters)*trans(temp));
-                else 
-                    output.set_sample(n, mat(filters)*trans(temp));
+            if (can_use_winograd(filters, last_stride_y, last_stride_x))
+            {
+                // The transformed filters are much bigger than the filters and slow to
+                // make, so they are only remade when the filters change.  Any write to
+                // the filters changes their version(), so checking it is enough.
+                const float* const f = filters.host();
+                if (winograd_source != f ||
+                    winograd_source_size != filters.size() ||
+                    winograd_source_num_filters != filters.num_samples() ||
+                    winograd_source_version != filters.version())
+                {
+                    winograd_transform_filters(filters, packed_filters);
+                    winograd_source = f;
+                    winograd_source_size = filters.size();
+                    winograd_source_num_filters = filters.num_samples();
+                    winograd_source_version = filters.version();
+                }
+                conv_winograd(add_to_output, output, data, packed_filters, last_padding_y, last_padding_x,
+                    biases, use_relu);
+                return;
             }
+            winograd_source = nullptr;
+
+            conv_pack_filters(filters, packed_filters);
+
+            // Each job computes the outputs of a group of filters over a tile of output
+            // pixels.  The filters are only split into groups when there aren't enough
+            // tiles to keep all the threads busy.
+            const long mblocks = (M+conv_mr-1)/conv_mr;
+            const long ptiles = (P+conv_tile_nc-1)/conv_tile_nc;
+            const long tiles = data.num_samples()*ptiles;
+            const long min_jobs = 4*(default_thread_pool().num_threads_in_pool()+1);
+            long mblocks_per_group = mblocks;
+            if (tiles < min_jobs)
+                mblocks_per_group = std::max<long>(1, mblocks*tiles/min_jobs);
+            const long mgroups = (mblocks+mblocks_per_group-1)/mblocks_per_group;
+
+            const float* const a = &packed_filters[0];
+            const float* const d = data.host();
+            float* const out = output.host();
+            const long data_k = data.k(), data_nr = data.nr(), data_nc = data.nc();
+            const long filter_nr = filters.nr(), filter_nc = filters.nc();
+            const long out_nc = output.nc();
+
+            parallel_for_blocked(0, tiles*mgroups, [&](long begin, long end)
+            {
+                std::vector<float> packed_tile(conv_tile_nc*std::min(K,conv_kc));
+                float temp[conv_mr*conv_nr];
+                for (long job = begin; job < end; ++job)
+                {
+                    const long tile = job/mgroups;
+                    const long mb_begin = (job%mgroups)*mblocks_per_group;
+                    const long mb_end = std::min(mblocks, mb_begin+mblocks_per_group);
+                    const long n = tile/ptiles;
+                    const long p0 = (tile%ptiles)*conv_tile_nc;
+                    const long np = std::min(conv_tile_nc, P-p0);
+                    const float* const dn = d + n*data_k*data_nr*data_nc;
+                    float* const outn = out + n*M*P;
+
+                    for (long k0 = 0; k0 < K; k0 += conv_kc)
+                    {
+                        const long k1 = std::min(K, k0+conv_kc);
+                        const long kc = k1-k0;
+                        conv_pack_tile(dn, data_k, data_nr, data_nc, filter_nr, filter_nc,
+                            last_stride_y, last_stride_x, last_padding_y, last_padding_x,
+                            out_nc, p0, np, k0, k1, &packed_tile[0]);
+
+                        const bool accumulate = add_to_output || k0 != 0;
+                        for (long mb = mb_begin; mb < mb_end; ++mb)
+                        {
+                            const long m0 = mb*conv_mr;
+                            const long mm = std::min(conv_mr, M-m0);
+                            const float* const ap = a + m0*K + k0*conv_mr;
+                            for (long c0 = 0; c0 < np; c0 += conv_nr)
+                            {
+                                const long nn = std::min(conv_nr, np-c0);
+                                const float* const bp = &packed_tile[c0*kc];
+                                float* const c = outn + m0*P + p0 + c0;
+                                if (nn == conv_nr)
+                                {
+                                    conv_micro_kernel(mm, kc, ap, bp, c, P, accumulate);
+                                    continue;
+                                }
+
+                                // Blocks on the right edge go through temp so we don't
+                                // touch memory outside the output.
+                                for (long i = 0; i < mm; ++i)
+                                    for (long j = 0; j < conv_nr; ++j)
+                                        temp[i*conv_nr+j] = (accumulate && j < nn) ? c[i*P+j] : 0;
+                                conv_micro_kernel(mm, kc, ap, bp, temp, conv_nr, true);
+                                for (long i = 0; i < mm; ++i)
+                                    for (long j = 0; j < nn; ++j)
+                                        c[i*P+j] = temp[i*conv_nr+j];
+                            }
+                        }
+                    }
+
+                    // The tile is finished and still in cache, so this is the time to
+                    // add the biases.
+                    if (biases || use_relu)
+                    {
+                        const long m_end = std::min(M, mb_end*conv_mr);
+                        for (long m = mb_begin*conv_mr; m < m_end; ++m)
+                            conv_epilogue(outn + m*P + p0, np, biases ? biases[m] : 0, use_relu);
+                    }
+                }
+            });
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        void tensor_conv::forward_int8 (
+            resizable_tensor& output,
+            const tensor& data,
+            const int8_weights& filters,
+            const tensor& biases,
+            bool use_relu,
+            float data_min,
+            float data_max
+        )
+        {
+            DLIB_CASSERT(is_same_object(output,data) == false);
+            DLIB_CASSERT(!filters.is_by_column());
+            DLIB_CASSERT(filters.k() == data.k());
+            DLIB_CASSERT(biases.size() == (size_t)filters.num_samples());
+            DLIB_CASSERT(data_min <= data_max);
+            DLIB_CASSERT(last_stride_y > 0 && last_stride_x > 0, "You must call setup() before calling this function.");
+            DLIB_CASSERT(filters.nr() <= data.nr() + 2*last_padding_y,
+                "Filter windows must be small enough to fit into the padded image.");
+            DLIB_CASSERT(filters.nc() <= data.nc() + 2*last_padding_x,
+                "Filter windows must be small enough to fit into the padded image.");
+
+            output.set_size(data.num_samples(),
+                            filters.num_samples(),
+                            1+(data.nr()+2*last_padding_y-filters.nr())/last_stride_y,
+                            1+(data.nc()+2*last_padding_x-filters.nc())/last_stride_x);
+
+            using namespace impl;
+            if (output.size() == 0)
+                return;
+
+            const long M = filters.num_samples();
+            const long K = filters.k()*filters.nr()*filters.nc();
+            const long P = output.nr()*output.nc();
+            const long kp_all = (K+1)/2;
+
+            float scale, qmin, qmax;
+            int8_data_range(data_min, data_max, scale, qmin, qmax);
+            const float inv_scale = 1/scale;
+
+            // The jobs are split up the same way as in forward().
+            const long mblocks = (M+conv_mr-1)/conv_mr;
+            const long ptiles = (P+conv_tile_nc-1)/conv_tile_nc;
+            const long tiles = data.num_samples()*ptiles;
+            const long min_jobs = 4*(default_thread_pool().num_threads_in_pool()+1);
+            long mblocks_per_group = mblocks;
+            if (tiles < min_jobs)
+                mblocks_per_group = std::max<long>(1, mblocks*tiles/min_jobs);
+            const long mgroups = (mblocks+mblocks_per_group-1)/mblocks_per_group;
+
+            // Each element of the data is used by many windows, so it's quantized once
+            // up front rather than as the tiles are packed.
+            int8_data.resize(data.size());
+            int16* const qdata = int8_data.data();
+            const float* const d = data.host();
+            parallel_for_blocked(0, data.size(), [&](long begin, long end)
+            {
+                quantize_values(d+begin, end-begin, inv_scale, qmin, qmax, qdata+begin);
+            });
+
+            const int32* const a = filters.packed();
+            const float* const filter_scales = filters.scales();
+            const float* const b = biases.host();
+            float* const out = output.host();
+            const long data_k = data.k(), data_nr = data.nr(), data_nc = data.nc();
+            const long filter_nr = filters.nr(), filter_nc = filters.nc();
+            const long out_nc = output.nc();
+
+            parallel_for_blocked(0, tiles*mgroups, [&](long begin, long end)
+            {
+                std::vector<int16> packed_tile(conv_tile_nc*(std::min(K,conv_kc)+1));
+                std::vector<int32> sums(mblocks_per_group*conv_mr*conv_tile_nc);
+                for (long job = begin; job < end; ++job)
+                {
+                    const long tile = job/mgroups;
+                    const long mb_begin = (job%mgroups)*mblocks_per_group;
+                    const long mb_end = std::min(mblocks, mb_begin+mblocks_per_group);
+                    const long n = tile/ptiles;
+                    const long p0 = (tile%ptiles)*conv_tile_nc;
+                    const long np = std::min(conv_tile_nc, P-p0);
+                    const long groups = (np+conv_nr-1)/conv_nr;
+                    const int16* const dn = qdata + n*data_k*data_nr*data_nc;
+                    float* const outn = out + n*M*P;
+
+                    for (long k0 = 0; k0 < K; k0 += conv_kc)
+                    {
+                        const long k1 = std::min(K, k0+conv_kc);
+                        const long kp = (k1-k0+1)/2;
+                        conv_pack_tile<int16,2>(dn, data_k, data_nr, data_nc, filter_nr, filter_nc,
+                            last_stride_y, last_stride_x, last_padding_y, last_padding_x,
+                            out_nc, p0, np, k0, k1, &packed_tile[0]);
+
+                        for (long mb = mb_begin; mb < mb_end; ++mb)
+                        {
+                            const long m0 = mb*conv_mr;
+                            const long mm = std::min(conv_mr, M-m0);
+                            const int32* const ap = a + m0*kp_all + (k0/2)*conv_mr;
+                            int32* const c = &sums[(mb-mb_begin)*conv_mr*conv_tile_nc];
+                            long c0 = 0;
+                            if (mm == conv_mr)
+                            {
+                                for (; c0+2*conv_nr <= groups*conv_nr; c0 += 2*conv_nr)
+                                {
+                                    int8_micro_kernel_full(kp, ap, &packed_tile[c0*2*kp], c + c0,
+                                        conv_tile_nc, k0 != 0);
+                                }
+                            }
+                            for (; c0 < np; c0 += conv_nr)
+                            {
+                                int8_micro_kernel(mm, kp, ap, &packed_tile[c0*2*kp], c + c0,
+                                    conv_tile_nc, k0 != 0);
+                            }
+                        }
+                    }
+
+                    // Scale the sums back to floats and add the biases while they are
+                    // still in cache.
+                    const long m_begin = mb_begin*conv_mr;
+                    const long m_end = std::min(M, mb_end*conv_mr);
+                    for (long m = m_begin; m < m_end; ++m)
+                    {
+                        const float s = scale*filter_scales[m];
+                        const int32* const c = &sums[(m-m_begin)*conv_tile_nc];
+                        float* const o = outn + m*P + p0;
+                        long j = 0;
+                        for (; j+8 <= np; j += 8)
+                        {
+                            simd8i ci;
+                            ci.load(c+j);
+                            simd8f v = simd8f(ci)*s + b[m];
+                            if (use_relu)
+                                v = max(v, 0);
+                            v.store(o+j);
+                        }
+                        for (; j < np; ++j)
+                        {
+                            const float v = c[j]*s + b[m];
+                            o[j] = (use_relu && v < 0) ? 0 : v;
+                        }
+                    }
+                }
+            });
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        void gemm_int8::operator() (
+            tensor& dest,
+            const tensor& lhs,
+            const int8_weights& rhs,
+            float lhs_min,
+            float lhs_max
+        )
+        {
+            DLIB_CASSERT(is_same_object(dest,lhs) == false);
+            DLIB_CASSERT(rhs.is_by_column());
+            DLIB_CASSERT(lhs_min <= lhs_max);
+            const long N = lhs.num_samples();
+            const long K = N != 0 ? lhs.size()/N : 0;
+            const long M = rhs.get_num_vectors();
+            DLIB_CASSERT(rhs.num_samples() == K);
+            DLIB_CASSERT(dest.num_samples() == N && dest.size() == (size_t)(N*M));
+
+            using namespace impl;
+            if (dest.size() == 0)
+                return;
+
+            float scale, qmin, qmax;
+            int8_data_range(lhs_min, lhs_max, scale, qmin, qmax);
+            const float inv_scale = 1/scale;
+
+            // Quantize the rows of lhs, which are the columns of the right hand side of
+            // the product int8_micro_kernel() computes, conv_nr at a time.
+            const long kp = (K+1)/2;
+            const long groups = (N+conv_nr-1)/conv_nr;
+            quantized_lhs.assign(groups*kp*2*conv_nr, 0);
+            const float* const l = lhs.host();
+            for (long n = 0; n < N; ++n)
+            {
+                int16* const q = &quantized_lhs[(n/conv_nr)*kp*2*conv_nr + 2*(n%conv_nr)];
+                for (long k = 0; k < K; ++k)
+                    q[(k/2)*2*conv_nr + k%2] = quantize_value(l[n*K+k]*inv_scale, qmin, qmax);
+            }
+
+            const long mblocks = (M+conv_mr-1)/conv_mr;
+            float* const d = dest.host();
+            parallel_for_blocked(0, groups*mblocks, [&](long begin, long end)
+            {
+                int32 c[conv_mr*conv_nr];
+                for (long job = begin; job < end; ++job)
+                {
+                    const long g = job/mblocks;
+                    const long m0 = (job%mblocks)*conv_mr;
+                    const long mm = std::min(conv_mr, M-m0);
+                    int8_micro_kernel(mm, kp, rhs.packed() + m0*kp, &quantized_lhs[g*kp*2*conv_nr],
+                        c, conv_nr, false);
+                    for (long i = 0; i < mm; ++i)
+                    {
+                        const float s = scale*rhs.scales()[m0+i];
+                        for (long j = 0; j < conv_nr && g*conv_nr+j < N; ++j)
+                            d[(g*conv_nr+j)*M + m0+i] = c[i*conv_nr+j]*s;
+                    }
+                }
+            });
         }
 
     // ------------------------------------------------------------------------------------
@@ -8,6 +8,7 @@
 
 #include "tensor.h"
 #include "../geometry/rectangle.h"
+#include "../uintn.h"
 
 namespace dlib
 {
@@ -412,6 +413,68 @@ namespace dlib
 
         };
 
+    // -----------------------------------------------------------------------------------
+
+        class int8_weights
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object holds the weights of a layer rounded to 8 bit integers, in
+                    the packed form tensor_conv::forward_int8() and gemm_int8 multiply
+                    with.  Each weight vector, that is each filter or each column of a
+                    weight matrix, gets its own scale.  The float weights aren't kept, so
+                    this takes half their memory and a quarter of their size on disk.
+            !*/
+        public:
+
+            void quantize (
+                const tensor& weights,
+                bool by_column
+            );
+            /*!
+                ensures
+                    - If by_column then each column of mat(weights) is a weight vector.
+                      Otherwise each sample of weights is.  Each weight vector is rounded
+                      to one of 255 evenly spaced values between -m and m, where m is
+                      its largest absolute value.
+                    - #num_samples(), #k(), #nr() and #nc() are the dimensions of weights.
+            !*/
+
+            void dequantize (
+                tensor& weights
+            ) const;
+            /*!
+                requires
+                    - weights has the dimensions given by num_samples(), k(), nr() and nc()
+                ensures
+                    - #weights holds the rounded weights.
+            !*/
+
+            bool empty() const { return num_vectors == 0; }
+            bool is_by_column() const { return by_column; }
+            long num_samples() const { return shape_n; }
+            long k() const { return shape_k; }
+            long nr() const { return shape_nr; }
+            long nc() const { return shape_nc; }
+            size_t size() const { return num_vectors*vector_size; }
+
+            long get_num_vectors() const { return num_vectors; }
+            long get_vector_size() const { return vector_size; }
+            const int32* packed() const { return values.data(); }
+            const float* scales() const { return vector_scales.data(); }
+
+            friend void serialize(const int8_weights& item, std::ostream& out);
+            friend void deserialize(int8_weights& item, std::istream& in);
+
+        private:
+            long shape_n = 0, shape_k = 0, shape_nr = 0, shape_nc = 0;
+            bool by_column = false;
+            long num_vectors = 0;
+            long vector_size = 0;
+            std::vector<int32> values;
+            std::vector<float> vector_scales;
+        };
+
     // -----------------------------------------------------------------------------------
 
         class tensor_conv
@@ -458,6 +521,51 @@ namespace dlib
                 const tensor& filters
             );
 
+             void operator() (
+                resizable_tensor& output,
+                const tensor& data,
+                const tensor& filters,
+                const tensor& biases,
+                bool use_relu
+            );
+
+             void operator() (
+                tensor& output,
+                const tensor& data,
+                const tensor& filters,
+                const tensor& biases,
+                bool use_relu
+            );
+
+            void setup(
+                const tensor& data,    /* not used but required for interface */
+                const int8_weights& filters,
+                int stride_y,
+                int stride_x,
+                int padding_y,
+                int padding_x
+            ) 
+            {
+                (void)data;    /* silence compiler */
+                DLIB_CASSERT(stride_y > 0 && stride_x > 0);
+                DLIB_CASSERT(0 <= padding_y && padding_y < filters.nr());
+                DLIB_CASSERT(0 <= padding_x && padding_x < filters.nc());
+                last_stride_y = stride_y;
+                last_stride_x = stride_x;
+                last_padding_y = padding_y;
+                last_padding_x = padding_x;            
+            }
+
+            void forward_int8 (
+                resizable_tensor& output,
+                const tensor& data,
+                const int8_weights& filters,
+                const tensor& biases,
+                bool use_relu,
+                float data_min,
+                float data_max
+            );
+
             void get_gradient_for_data (
                 const bool add_to_output,
                 const tensor& gradient_input, 
@@ -474,10 +582,65 @@ namespace dlib
 
         private:
 
+            void forward (
+                const bool add_to_output,
+                tensor& output,
+                const tensor& data,
+                const tensor& filters,
+                const float* biases,
+                const bool use_relu
+            );
+            /*!
+                requires
+                    - if (biases != nullptr || use_relu) then
+                        - add_to_output == false
+                ensures
+                    - Does the work of operator().  Each output of the i-th filter gets
+                      biases[i] added to it, if biases isn't null, and is then clamped to
+                      be >= 0, if use_relu is true.
+            !*/
+
             long last_stride_y = 0;
             long last_stride_x = 0;
             long last_padding_y = 0;
             long last_padding_x = 0;
+
+            // The filters, rearranged for the forward pass.  Kept here so repeated calls
+            // don't allocate.
+            std::vector<float> packed_filters;
+
+            // When packed_filters holds the Winograd transform of some 3x3 filters, these
+            // identify those filters: their memory, shape and tensor::version() at the
+            // time of the transform.  Otherwise winograd_source is null.
+            const float* winograd_source = nullptr;
+            size_t winograd_source_size = 0;
+            long winograd_source_num_filters = 0;
+            uint64 winograd_source_version = 0;
+
+            // The data quantized by forward_int8().  Kept here so repeated calls don't
+            // allocate.
+            std::vector<int16> int8_data;
+        };
+
+    // -----------------------------------------------------------------------------------
+
+        class gemm_int8
+        {
+        public:
+
+            void operator() (
+                tensor& dest,
+                const tensor& lhs,
+                const int8_weights& rhs,
+                float lhs_min,
+                float lhs_max
+            );
+
+        private:
+
+            // The rows of lhs quantized by operator().  Kept here so repeated calls
+            // don't allocate.
+            std::vector<int16> quantized_lhs;
         };
 
     // -----------------------------------------------------------------------------------
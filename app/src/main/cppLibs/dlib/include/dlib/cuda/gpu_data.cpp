@@ -151,6 +151,7 @@ namespace dlib
                 device_in_use = false;
             }
             wait_for_transfer_to_finish();
+            data_version = next_version();
             data_size = 0;
             host_current = true;
             device_current = true;
@@ -168,6 +169,7 @@ namespace dlib
                 device_in_use = false;
             }
             wait_for_transfer_to_finish();
+            data_version = next_version();
             data_size = new_size;
             host_current = true;
             device_current = true;
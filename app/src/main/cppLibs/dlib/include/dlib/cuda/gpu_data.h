@@ -6,6 +6,7 @@
 #include "gpu_data_abstract.h"
 #include <memory>
 #include <cstring>
+#include <atomic>
 #include "cuda_errors.h"
 #include "../serialize.h"
 
@@ -40,7 +41,8 @@ namespace dlib
     public:
 
         gpu_data(
-        ) : data_size(0), host_current(true), device_current(true),have_active_transfer(false),device_in_use(false), the_device_id(0)
+        ) : data_size(0), host_current(true), device_current(true),have_active_transfer(false),device_in_use(false), the_device_id(0),
+            data_version(next_version())
         {
         }
 
@@ -65,6 +67,7 @@ namespace dlib
         {
             if (new_size == 0)
             {
+                data_version = next_version();
                 data_size = 0;
                 host_current = true;
                 device_current = true;
@@ -74,6 +77,7 @@ namespace dlib
             }
             else if (new_size != data_size)
             {
+                data_version = next_version();
                 data_size = new_size;
                 host_current = true;
                 device_current = true;
@@ -93,12 +97,14 @@ namespace dlib
         float* host() 
         {
             copy_to_host();
+            data_version = next_version();
             device_current = false;
             return data_host.get(); 
         }
 
         float* host_write_only() 
         {
+            data_version = next_version();
             host_current = true;
             device_current = false;
             return data_host.get(); 
@@ -120,6 +126,7 @@ namespace dlib
             DLIB_CASSERT(false, "CUDA NOT ENABLED");
 #endif
             copy_to_device();
+            data_version = next_version();
             host_current = false;
             device_in_use = true;
             return data_device.get(); 
@@ -131,6 +138,7 @@ namespace dlib
             DLIB_CASSERT(false, "CUDA NOT ENABLED");
 #endif
             wait_for_transfer_to_finish();
+            data_version = next_version();
             host_current = false;
             device_current = true;
             device_in_use = true;
@@ -145,6 +153,8 @@ namespace dlib
 
         size_t size() const { return data_size; }
 
+        uint64 version() const { return data_version; }
+
         void swap (gpu_data& item)
         {
             std::swap(data_size, item.data_size);
@@ -155,10 +165,20 @@ namespace dlib
             std::swap(data_device, item.data_device);
             std::swap(cuda_stream, item.cuda_stream);
             std::swap(the_device_id, item.the_device_id);
+            std::swap(data_version, item.data_version);
         }
 
     private:
 
+        static uint64 next_version (
+        )
+        {
+            // Shared by all gpu_data objects, so no two writes anywhere get the same
+            // version number.
+            static std::atomic<uint64> counter(0);
+            return ++counter;
+        }
+
 #ifdef DLIB_USE_CUDA
         void copy_to_device() const;
         void copy_to_host() const;
@@ -180,6 +200,7 @@ namespace dlib
         std::shared_ptr<float> data_device;
         std::shared_ptr<void> cuda_stream;
         int the_device_id;
+        uint64 data_version;
     };
 
     inline void serialize(const gpu_data& item, std::ostream& out)
@@ -201,6 +201,20 @@ namespace dlib
                 - returns the number of floats contained in this object.
         !*/
 
+        uint64 version(
+        ) const;
+        /*!
+            ensures
+                - returns a number that changes every time write access to the data is
+                  granted, i.e. by set_size(), the non-const host() and device(),
+                  host_write_only() and device_write_only().  The numbers come from a
+                  single counter shared by all gpu_data objects, so two calls to version()
+                  return the same value only if they were made on the same object with no
+                  write access granted in between.  This lets code that caches something
+                  derived from the data tell whether the cache is still valid without
+                  comparing the data itself.
+        !*/
+
         void swap (
             gpu_data& item
         );
@@ -75,6 +75,8 @@ namespace dlib
 
         int device_id() const { return data().device_id(); }
 
+        uint64 version() const { return data().version(); }
+
         tensor& operator= (float val)
         {
 #ifdef DLIB_USE_CUDA
@@ -343,6 +345,9 @@ namespace dlib
         virtual const any&   annotation() const { return _annotation; }
         virtual any&         annotation() { return _annotation; }
 
+        size_t capacity (
+        ) const { return data_instance.size(); }
+
         void clear(
         )
         {
@@ -217,6 +217,17 @@ namespace dlib
                 - If CUDA is not being used then this function always returns 0.
         !*/
 
+        uint64 version(
+        ) const;
+        /*!
+            ensures
+                - returns the version() of the gpu_data object holding this tensor's
+                  memory.  It changes every time write access to that memory is granted,
+                  so if two calls return the same value then the contents of the tensor
+                  didn't change in between.  For an alias tensor this is the version of
+                  the whole tensor it aliases, so writes anywhere in it change the value.
+        !*/
+
         tensor& operator= (
             float val
         );
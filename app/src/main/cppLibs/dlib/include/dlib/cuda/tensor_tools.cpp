@@ -240,6 +240,27 @@ namespace dlib { namespace tt
 #endif
     }
 
+// ----------------------------------------------------------------------------------------
+
+    void gemm_int8::operator() (
+        tensor& dest,
+        const tensor& lhs,
+        const int8_weights& rhs,
+        float lhs_min,
+        float lhs_max
+    )
+    {
+#ifdef DLIB_USE_CUDA
+        (void)lhs_min;
+        (void)lhs_max;
+        dequantized.set_size(rhs.num_samples(), rhs.k(), rhs.nr(), rhs.nc());
+        rhs.dequantize(dequantized);
+        gemm(0, dest, 1, lhs, false, dequantized, false);
+#else
+        impl(dest, lhs, rhs, lhs_min, lhs_max);
+#endif
+    }
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 
@@ -826,6 +847,64 @@ namespace dlib { namespace tt
 #endif
     }
 
+// ----------------------------------------------------------------------------------------
+
+    void tensor_conv::operator() (
+        resizable_tensor& output,
+        const tensor& data,
+        const tensor& filters,
+        const tensor& biases,
+        bool use_relu
+    )
+    {
+#ifdef DLIB_USE_CUDA
+        impl(false, output, data, filters);
+        tt::add(1, output, 1, biases);
+        if (use_relu)
+            tt::relu(output, output);
+#else
+        impl(output, data, filters, biases, use_relu);
+#endif
+    }
+
+    void tensor_conv::setup(
+        const tensor& data,
+        const int8_weights& filters,
+        int stride_y,
+        int stride_x,
+        int padding_y,
+        int padding_x
+    )
+    {
+#ifdef DLIB_USE_CUDA
+        dequantized.set_size(filters.num_samples(), filters.k(), filters.nr(), filters.nc());
+        impl.setup(data, dequantized, stride_y, stride_x, padding_y, padding_x);
+#else
+        impl.setup(data, filters, stride_y, stride_x, padding_y, padding_x);
+#endif
+    }
+
+    void tensor_conv::forward_int8 (
+        resizable_tensor& output,
+        const tensor& data,
+        const int8_weights& filters,
+        const tensor& biases,
+        bool use_relu,
+        float data_min,
+        float data_max
+    )
+    {
+#ifdef DLIB_USE_CUDA
+        (void)data_min;
+        (void)data_max;
+        dequantized.set_size(filters.num_samples(), filters.k(), filters.nr(), filters.nc());
+        filters.dequantize(dequantized);
+        (*this)(output, data, dequantized, biases, use_relu);
+#else
+        impl.forward_int8(output, data, filters, biases, use_relu, data_min, data_max);
+#endif
+    }
+
 // ----------------------------------------------------------------------------------------
 
     void relu (
@@ -182,6 +182,61 @@ namespace dlib { namespace tt
             - performs: dest = alpha*L*R + beta*mat(dest)
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    typedef cpu::int8_weights int8_weights;
+    /*!
+        An int8_weights object holds the weights of a layer rounded to 8 bit integers, as
+        taken by tensor_conv::forward_int8() and gemm_int8.  Its quantize(weights,
+        by_column) member rounds each sample of weights, or each column of mat(weights)
+        if by_column is true, to one of 255 evenly spaced values between -m and m, where
+        m is the largest absolute value in it.  dequantize(weights) writes the rounded
+        values back to a tensor with the same dimensions.  Only the rounded values are
+        kept, so it takes half the memory of the float weights.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    class gemm_int8
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a functor for multiplying matrices with 8 bit integer arithmetic,
+                like tensor_conv::forward_int8() convolves.  It's an object so that
+                repeated calls reuse its scratch memory.
+        !*/
+    public:
+
+        void operator() (
+            tensor& dest,
+            const tensor& lhs,
+            const int8_weights& rhs,
+            float lhs_min,
+            float lhs_max
+        );
+        /*!
+            requires
+                - dest does not alias the memory of lhs
+                - rhs.is_by_column() == true
+                - Let R be the matrix rhs was quantized from, mat(W) for some tensor W.
+                - mat(lhs).nc() == R.nr()
+                - mat(dest).nr() == mat(lhs).nr() && mat(dest).nc() == R.nc()
+                - lhs_min <= lhs_max
+            ensures
+                - #mat(dest) is about mat(lhs)*R.  lhs is rounded like the data in
+                  tensor_conv::forward_int8(), with lhs_min and lhs_max as the data range,
+                  and multiplied by the rounded columns held in rhs.
+                - The CUDA version dequantizes rhs and does a float gemm().
+        !*/
+
+    private:
+#ifdef DLIB_USE_CUDA
+        resizable_tensor dequantized;
+#else
+        cpu::gemm_int8 impl;
+#endif
+    };
+
 // ----------------------------------------------------------------------------------------
 
     class inv
@@ -985,6 +1040,71 @@ namespace dlib { namespace tt
                 - #output.nc() == 1+(data.nc() + 2*padding_x - filters.nc())/stride_x
         !*/
 
+        void operator() (
+            resizable_tensor& output,
+            const tensor& data,
+            const tensor& filters,
+            const tensor& biases,
+            bool use_relu
+        );
+        /*!
+            requires
+                - setup() has been called.  Specifically, setup() has been called like this:
+                    this->setup(data, filters, stride_y, stride_x, padding_y, padding_x);
+                - is_same_object(output,data) == false
+                - is_same_object(output,filters) == false
+                - filters.k() == data.k()
+                - filters.nr() <= src.nr() + 2*padding_y
+                - filters.nc() <= src.nc() + 2*padding_x
+                - biases.size() == filters.num_samples()
+            ensures
+                - Convolves filters over data, adds biases[i] to the outputs of the i-th
+                  filter and, if use_relu is true, replaces each output value x with
+                  max(0,x).  The results are assigned to #output.  This gives the same
+                  results as calling (*this)(false,output,data,filters), then
+                  add(1,output,1,biases) and relu(output,output), but the CPU version
+                  does it while the output is still in cache instead of making two more
+                  passes over it.
+                - #output.num_samples() == data.num_samples()
+                - #output.k() == filters.num_samples()
+                - #output.nr() == 1+(data.nr() + 2*padding_y - filters.nr())/stride_y
+                - #output.nc() == 1+(data.nc() + 2*padding_x - filters.nc())/stride_x
+        !*/
+
+        void forward_int8 (
+            resizable_tensor& output,
+            const tensor& data,
+            const int8_weights& filters,
+            const tensor& biases,
+            bool use_relu,
+            float data_min,
+            float data_max
+        );
+        /*!
+            requires
+                - filters.is_by_column() == false
+                - setup() has been called.  Specifically, setup() has been called like this:
+                    this->setup(data, filters, stride_y, stride_x, padding_y, padding_x);
+                - Let F be the tensor filters was quantized from.  Then the requirements
+                  of (*this)(output,data,F,biases,use_relu) are met.
+                - data_min <= data_max
+            ensures
+                - Computes about the same thing as (*this)(output,data,F,biases,use_relu),
+                  but with 8 bit integer arithmetic.  That is:
+                    - The filters are the rounded ones held in filters.
+                    - If (data_min >= 0) then data is rounded to one of 256 evenly spaced
+                      values between 0 and data_max.  Otherwise it's rounded to one of 255
+                      evenly spaced values between -m and m, where
+                      m == max(-data_min, data_max).  Values outside the range are clamped
+                      to it.
+                    - The products of the rounded values are summed exactly and then
+                      the biases and relu are applied as floats.
+                - The CPU version is faster than the float convolution, except for 3x3
+                  filters with a stride of 1, which the float convolution does with
+                  Winograd's algorithm.  The CUDA version dequantizes the filters and does
+                  the float convolution.
+        !*/
+
         void get_gradient_for_data (
             const bool add_to_output,
             const tensor& gradient_input, 
@@ -1084,10 +1204,32 @@ namespace dlib { namespace tt
                   the tensors, or store any kind of references to the data or filter
                   tensors. 
         !*/
+
+        void setup(
+            const tensor& data,
+            const int8_weights& filters,
+            int stride_y,
+            int stride_x,
+            int padding_y,
+            int padding_x
+        );
+        /*!
+            requires
+                - filters.is_by_column() == false
+                - filters.k() == data.k()
+                - stride_y > 0
+                - stride_x > 0
+                - 0 <= padding_y < filters.nr()
+                - 0 <= padding_x < filters.nc()
+            ensures
+                - Does the same thing as the setup() above, for calls to forward_int8()
+                  with quantized filters.
+        !*/
        
     private:
 #ifdef DLIB_USE_CUDA
         cuda::tensor_conv impl;
+        resizable_tensor dequantized;
 #else
         cpu::tensor_conv impl;
 #endif
@@ -30,6 +30,8 @@
 #include "cuda/cpu_dlib.h"
 #include "cuda/tensor_tools.h"
 #include "dnn/utilities.h"
+#include "dnn/tiled_detector.h"
+#include "dnn/embedding_extractor.h"
 #include "dnn/validation.h"
 
 #endif // DLIB_DNn_
@@ -16,6 +16,7 @@
 #include <tuple>
 #include <cmath>
 #include <vector>
+#include <limits>
 #include "../cuda/tensor_tools.h"
 #include <type_traits>
 #include "../metaprogramming.h"
@@ -476,6 +477,252 @@ namespace dlib
         return sstack<T>(item.data(), item.size());
     }
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        class activation_arena
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object holds the pool of activation buffers shared by the layers
+                    of a network that enable_activation_reuse() was called on.  Each
+                    computational layer takes a buffer from the pool for its output right
+                    before computing it, and gives the buffer of its input back once no
+                    layer above it can read that input anymore.  So after the first few
+                    forward passes have grown the buffers to the sizes they need, a
+                    forward pass doesn't allocate anything and only a handful of
+                    activations are alive at any time.
+
+                    The steps of a forward pass are numbered by counting the computational
+                    layers in the order they run, so a layer has the same step in every
+                    pass.  An output that is read through a tag is released after the
+                    step that last read it in the previous pass, or at the end of the pass
+                    if there wasn't a previous pass.
+            !*/
+        public:
+
+            long current_step() const { return step; }
+            bool in_forward() const { return depth != 0; }
+
+            void begin_forward(
+                resizable_tensor* previous_output
+            )
+            /*!
+                ensures
+                    - Begins a forward() call.  If it's the outermost one a new pass
+                      starts, and previous_output, the output of the network from the last
+                      pass, is released since it's about to be overwritten anyway.
+                      Otherwise the network would hang on to it while the layers below
+                      compute, which is when the biggest activations are alive.
+            !*/
+            {
+                if (depth++ == 0 && previous_output)
+                    release(*previous_output);
+            }
+
+            void end_forward(
+                const tensor* output
+            )
+            /*!
+                ensures
+                    - Ends the forward() call begun by the matching begin_forward().  If it
+                      was the outermost one the pass is over, so all the outputs still
+                      waiting to be released are released, except output.
+                    - output == nullptr means the pass was aborted by an exception, in
+                      which case nothing is released since we don't know which outputs
+                      are still needed.
+            !*/
+            {
+                if (--depth != 0)
+                    return;
+                if (output)
+                {
+                    for (auto& d : deferred)
+                    {
+                        if (d.second != output)
+                            release(*d.second);
+                    }
+                }
+                deferred.clear();
+                step = 0;
+            }
+
+            void acquire(
+                resizable_tensor& t
+            )
+            {
+                // t still holds its buffer if nothing needed to release it since the last
+                // pass, e.g. because it's the output of the whole network.
+                if (t.size() != 0 || pool.size() == 0)
+                    return;
+                // Hand out the smallest buffer that holds the output this step made in
+                // the last pass, so the big buffers are left for the big outputs.  If
+                // none is big enough, or there was no last pass, hand out the biggest
+                // since it needs to grow the least.
+                const size_t needed = (size_t)step < output_sizes.size() ? output_sizes[step] : 0;
+                size_t best = 0;
+                for (size_t i = 1; i < pool.size(); ++i)
+                {
+                    const size_t cap = pool[i].capacity();
+                    const size_t best_cap = pool[best].capacity();
+                    if (needed != 0 && cap >= needed)
+                    {
+                        if (best_cap < needed || cap < best_cap)
+                            best = i;
+                    }
+                    else if (cap > best_cap && (needed == 0 || best_cap < needed))
+                    {
+                        best = i;
+                    }
+                }
+                t.swap(pool[best]);
+                pool.erase(pool.begin()+best);
+            }
+
+            void release(
+                resizable_tensor& t
+            )
+            {
+                if (t.size() == 0)
+                    return;
+                pool.emplace_back();
+                pool.back().swap(t);
+            }
+
+            void release_after(
+                long last_step,
+                resizable_tensor* t
+            )
+            /*!
+                ensures
+                    - t will be released at the end of step last_step, or at the end of
+                      the pass if last_step < 0.  If t is tagged more than once it's
+                      released after the last of the steps it was given.
+            !*/
+            {
+                if (!t)
+                    return;
+                if (last_step < 0)
+                    last_step = std::numeric_limits<long>::max();
+                for (auto& d : deferred)
+                {
+                    if (d.second == t)
+                    {
+                        d.first = std::max(d.first, last_step);
+                        return;
+                    }
+                }
+                deferred.emplace_back(last_step, t);
+            }
+
+            void end_step(
+                const tensor* output,
+                resizable_tensor* consumed
+            )
+            /*!
+                ensures
+                    - remembers the size of output, the output the layer that just ran
+                      made in a buffer from acquire(), so the next pass can give it the
+                      best fitting buffer.  output == nullptr if the layer didn't acquire
+                      a buffer.
+                    - releases consumed, the output the layer that just ran read and that
+                      nothing else can read, as well as the tagged outputs last read in
+                      this step.  Then moves on to the next step.
+            !*/
+            {
+                if (output)
+                {
+                    if (output_sizes.size() <= (size_t)step)
+                        output_sizes.resize(step+1, 0);
+                    output_sizes[step] = output->size();
+                }
+                if (consumed)
+                    release(*consumed);
+                for (size_t i = 0; i < deferred.size(); )
+                {
+                    if (deferred[i].first == step)
+                    {
+                        release(*deferred[i].second);
+                        deferred.erase(deferred.begin()+i);
+                    }
+                    else
+                    {
+                        ++i;
+                    }
+                }
+                ++step;
+            }
+
+        private:
+
+            std::vector<resizable_tensor> pool;
+            // The size of the output each step acquired a buffer for in the last pass.
+            std::vector<size_t> output_sizes;
+            std::vector<std::pair<long,resizable_tensor*>> deferred;
+            long step = 0;
+            long depth = 0;
+        };
+
+        class activation_arena_ptr
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is the pointer each layer keeps to the activation_arena of its
+                    network.  Copying a network doesn't copy it, since the copy holds its
+                    own outputs and can't share buffers with the original.  Moving a
+                    network does move it though.
+            !*/
+        public:
+            activation_arena_ptr() = default;
+            activation_arena_ptr(const activation_arena_ptr&) {}
+            activation_arena_ptr& operator=(const activation_arena_ptr&) { ptr.reset(); return *this; }
+            activation_arena_ptr(activation_arena_ptr&&) = default;
+            activation_arena_ptr& operator=(activation_arena_ptr&&) = default;
+
+            void reset(const std::shared_ptr<activation_arena>& a) { ptr = a; }
+            activation_arena* get() const { return ptr.get(); }
+            activation_arena* operator->() const { return ptr.get(); }
+            explicit operator bool() const { return ptr != nullptr; }
+
+        private:
+            std::shared_ptr<activation_arena> ptr;
+        };
+
+        class activation_arena_scope
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object brackets a layer's forward() call, so the arena knows when
+                    the outermost forward() call, and with it the pass, is over.
+            !*/
+        public:
+            activation_arena_scope(
+                activation_arena* a,
+                resizable_tensor* previous_output
+            ) : arena(a) { if (arena) arena->begin_forward(previous_output); }
+
+            ~activation_arena_scope() { if (arena) arena->end_forward(output); }
+
+            activation_arena_scope(const activation_arena_scope&) = delete;
+            activation_arena_scope& operator=(const activation_arena_scope&) = delete;
+
+            const tensor& done(
+                const tensor& out
+            )
+            {
+                output = &out;
+                return out;
+            }
+
+        private:
+            activation_arena* arena;
+            const tensor* output = nullptr;
+        };
+
+        class visitor_set_activation_arena;
+    }
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
@@ -637,6 +884,7 @@ namespace dlib
         friend class add_skip_layer;
         template <size_t N, template<typename> class L, typename S>
         friend class repeat;
+        friend class impl::visitor_set_activation_arena;
 
         // Allow copying networks from one to another as long as their corresponding 
         // layers can be constructed from each other.
@@ -789,6 +1037,7 @@ namespace dlib
 
         const tensor& forward(const tensor& x)
         {
+            impl::activation_arena_scope scope(arena.get(), owned_output());
             subnetwork->forward(x);
             const dimpl::subnet_wrapper<subnet_type> wsub(*subnetwork);
             if (!this_layer_setup_called)
@@ -796,13 +1045,25 @@ namespace dlib
                 details.setup(wsub);
                 this_layer_setup_called = true;
             }
-            if (this_layer_operates_inplace())
+            const bool inplace = this_layer_operates_inplace();
+            if (inplace)
+            {
                 impl::call_layer_forward(details, wsub, private_get_output());
+            }
             else
+            {
+                if (arena)
+                    arena->acquire(cached_output);
                 impl::call_layer_forward(details, wsub, cached_output);
+            }
+            // Once this layer has run nothing but a tag can read our input again, so
+            // unless it's tagged its buffer can be used by the layers above us.
+            if (arena)
+                arena->end_step(inplace ? nullptr : &cached_output,
+                                inplace ? nullptr : subnetwork->releasable_output());
 
             gradient_input_is_stale = true;
-            return private_get_output();
+            return scope.done(private_get_output());
         }
 
     private:
@@ -855,6 +1116,7 @@ namespace dlib
         }
         void back_propagate_error(const tensor& x, const tensor& gradient_input)
         {
+            DLIB_CASSERT(!arena, "You can't back propagate through a network that reuses its activation memory. Call disable_activation_reuse() first.");
             dimpl::subnet_wrapper<subnet_type> wsub(*subnetwork);
             params_grad.copy_size(details.get_layer_params());
             impl::call_layer_backward(details, private_get_output(),
@@ -965,6 +1227,26 @@ namespace dlib
             return impl::backward_requires_forward_output(details, *subnetwork);
         }
 
+        resizable_tensor* releasable_output(
+        ) 
+        /*!
+            ensures
+                - returns the tensor holding this layer's output if only the layer on top
+                  of this one can read it, and nullptr otherwise.
+        !*/
+        {
+            return this_layer_operates_inplace() ? subnetwork->releasable_output() : &cached_output;
+        }
+        resizable_tensor* owned_output(
+        ) 
+        /*!
+            ensures
+                - returns the tensor holding this layer's output.
+        !*/
+        {
+            return this_layer_operates_inplace() ? subnetwork->owned_output() : &cached_output;
+        }
+
         void swap(add_layer& item)
         {
             std::swap(subnetwork,item.subnetwork);
@@ -975,6 +1257,7 @@ namespace dlib
             std::swap(x_grad, item.x_grad);
             std::swap(cached_output, item.cached_output);
             std::swap(params_grad, item.params_grad);
+            std::swap(arena, item.arena);
         }
 
 
@@ -995,6 +1278,8 @@ namespace dlib
         // It is here only to prevent it from being reallocated over and over.
         resizable_tensor temp_tensor;
 
+        // Set by enable_activation_reuse().
+        impl::activation_arena_ptr arena;
     };
 
     template <typename T, typename U, typename E>
@@ -1043,6 +1328,7 @@ namespace dlib
         friend class add_skip_layer;
         template <size_t N, template<typename> class L, typename S>
         friend class repeat;
+        friend class impl::visitor_set_activation_arena;
 
         // Allow copying networks from one to another as long as their corresponding 
         // layers can be constructed from each other.
@@ -1168,15 +1454,21 @@ namespace dlib
         {
             DLIB_CASSERT(sample_expansion_factor() != 0, "You must call to_tensor() before this function can be used.");
             DLIB_CASSERT(x.num_samples()%sample_expansion_factor() == 0);
+            impl::activation_arena_scope scope(arena.get(), &cached_output);
             subnet_wrapper wsub(x, grad_final, _sample_expansion_factor);
             if (!this_layer_setup_called)
             {
                 details.setup(wsub);
                 this_layer_setup_called = true;
             }
+            if (arena)
+                arena->acquire(cached_output);
             impl::call_layer_forward(details, wsub, cached_output);
+            // x doesn't belong to the network, so there is nothing to release.
+            if (arena)
+                arena->end_step(&cached_output, nullptr);
             gradient_input_is_stale = true;
-            return private_get_output();
+            return scope.done(private_get_output());
         }
 
     private:
@@ -1216,6 +1508,7 @@ namespace dlib
         }
         void back_propagate_error(const tensor& x, const tensor& gradient_input)
         {
+            DLIB_CASSERT(!arena, "You can't back propagate through a network that reuses its activation memory. Call disable_activation_reuse() first.");
             // make sure grad_final is initialized to 0
             if (!have_same_dimensions(x, grad_final))
                 grad_final.copy_size(x);
@@ -1367,8 +1660,12 @@ namespace dlib
             std::swap(cached_output, item.cached_output); 
             std::swap(grad_final, item.grad_final); 
             std::swap(_sample_expansion_factor, item._sample_expansion_factor); 
+            std::swap(arena, item.arena);
         }
 
+        resizable_tensor* releasable_output() { return &cached_output; }
+        resizable_tensor* owned_output() { return &cached_output; }
+
         subnet_type input_layer;
         LAYER_DETAILS details;
         bool this_layer_setup_called;
@@ -1384,6 +1681,9 @@ namespace dlib
         // member functions.
         resizable_tensor params_grad; 
         resizable_tensor temp_tensor; 
+
+        // Set by enable_activation_reuse().
+        impl::activation_arena_ptr arena;
     };
 
 // ----------------------------------------------------------------------------------------
@@ -1455,10 +1755,19 @@ namespace dlib
 
         const tensor& forward(const tensor& x)
         {
-            return subnetwork.forward(x);
+            impl::activation_arena_scope scope(arena.get(), subnetwork.owned_output());
+            subnetwork.forward(x);
+            if (arena)
+            {
+                // Whatever reads the tagged output does so through this layer, so we
+                // know when it was last read in the previous pass.  Keep it until then.
+                arena->release_after(last_read_step, subnetwork.owned_output());
+                last_read_step = -1;
+            }
+            return scope.done(subnetwork.private_get_output());
         }
 
-        const tensor& get_output() const { return subnetwork.get_output(); }
+        const tensor& get_output() const { note_read(); return subnetwork.get_output(); }
 
         tensor& get_gradient_input() 
         { 
@@ -1540,6 +1849,7 @@ namespace dlib
         friend class add_skip_layer;
         template <size_t N, template<typename> class L, typename S>
         friend class repeat;
+        friend class impl::visitor_set_activation_arena;
 
         // You wouldn't put a tag on a layer if you didn't want to access its forward
         // outputs.  So this is always true.
@@ -1558,12 +1868,27 @@ namespace dlib
         }
 
         tensor& private_get_output() const
-        { return subnetwork.private_get_output(); }
+        { note_read(); return subnetwork.private_get_output(); }
         tensor& private_get_gradient_input() 
         { return subnetwork.private_get_gradient_input(); }
 
+        resizable_tensor* releasable_output() { return nullptr; }
+        resizable_tensor* owned_output() { return subnetwork.owned_output(); }
+
+        void note_read() const
+        {
+            if (arena && arena->in_forward())
+                last_read_step = arena->current_step();
+        }
+
         subnet_type subnetwork;
 
+        // Set by enable_activation_reuse().  last_read_step is the last step that read our
+        // output, in the current pass once forward() has run and in the previous pass
+        // before that.  It's -1 if there was no such step.
+        impl::activation_arena_ptr arena;
+        mutable long last_read_step = -1;
+
         // This member doesn't logically contribute to the state of the object since it is
         // always empty. It's just here so we can have the get_parameter_gradient() methods
         // which have to return something.  So they return this empty tensor.
@@ -1715,11 +2040,16 @@ namespace dlib
 
         const tensor& forward(const tensor& x)
         {
+            impl::activation_arena_scope scope(arena.get(), owned_output());
             subnetwork.forward(x);
             details[details.size()-1].forward(subnetwork.get_output());
+            release_consumed(subnetwork.releasable_output());
             for (long i = details.size()-2; i >= 0; --i)
+            {
                 details[i].forward(details[i+1].get_output());
-            return private_get_output();
+                release_consumed(details[i+1].releasable_output());
+            }
+            return scope.done(private_get_output());
         }
 
     private:
@@ -1839,6 +2169,7 @@ namespace dlib
         friend class add_skip_layer;
         template <size_t N, template<typename> class L, typename S>
         friend class repeat;
+        friend class impl::visitor_set_activation_arena;
 
         bool this_layer_requires_forward_output(
         ) 
@@ -1852,6 +2183,19 @@ namespace dlib
             details[0].disable_output_and_gradient_getters();
         }
 
+        resizable_tensor* releasable_output() { return details[0].releasable_output(); }
+        resizable_tensor* owned_output() { return details[0].owned_output(); }
+
+        void release_consumed (
+            resizable_tensor* t
+        )
+        {
+            // The networks in details only see the output of the network below them as
+            // their input, so they never release it themselves.
+            if (arena && t)
+                arena->release(*t);
+        }
+
 
         std::vector<repeated_layer_type> details; 
         subnet_type subnetwork;
@@ -1859,6 +2203,9 @@ namespace dlib
         // temp_tensor doesn't logically contribute to the state of this class.
         // It is here only to void needing to reallocate it over and over.
         resizable_tensor temp_tensor;
+
+        // Set by enable_activation_reuse().
+        impl::activation_arena_ptr arena;
     };
 
     template <
@@ -2076,6 +2423,7 @@ namespace dlib
         friend class add_skip_layer;
         template <size_t N, template<typename> class L, typename S>
         friend class repeat;
+        friend class impl::visitor_set_activation_arena;
 
         // You woudln't put a tag on a layer if you didn't want to access its forward
         // outputs.  So this is always true.
@@ -2098,6 +2446,11 @@ namespace dlib
         tensor& private_get_gradient_input() 
         { return get_gradient_input(); }
 
+        // Our output is a copy of, or a pointer to, the input of the network, which is
+        // never released.
+        resizable_tensor* releasable_output() { return nullptr; }
+        resizable_tensor* owned_output() { return nullptr; }
+
         void swap(add_tag_layer& item)
         {
             std::swap(input_layer, item.input_layer);
@@ -2771,20 +3124,23 @@ namespace dlib
             forward_iterator iend
         )
         {
+            impl::activation_arena_scope scope(arena.get(), nullptr);
             subnetwork(ibegin,iend);
-            return layer<TAG_TYPE>(subnetwork).get_output();
+            return scope.done(layer<TAG_TYPE>(subnetwork).get_output());
         }
 
         const tensor& operator() (const input_type& x)
         {
+            impl::activation_arena_scope scope(arena.get(), nullptr);
             subnetwork(x);
-            return layer<TAG_TYPE>(subnetwork).get_output();
+            return scope.done(layer<TAG_TYPE>(subnetwork).get_output());
         }
 
         const tensor& forward(const tensor& x)
         {
+            impl::activation_arena_scope scope(arena.get(), nullptr);
             subnetwork.forward(x);
-            return layer<TAG_TYPE>(subnetwork).get_output();
+            return scope.done(layer<TAG_TYPE>(subnetwork).get_output());
         }
 
         const tensor& get_output() const 
@@ -2880,6 +3236,7 @@ namespace dlib
         friend class add_skip_layer;
         template <size_t N, template<typename> class L, typename S>
         friend class repeat;
+        friend class impl::visitor_set_activation_arena;
 
         bool this_layer_requires_forward_output(
         ) { return layer<TAG_TYPE>(subnetwork).this_layer_requires_forward_output(); } 
@@ -2892,8 +3249,15 @@ namespace dlib
         tensor& private_get_gradient_input() 
         { return layer<TAG_TYPE>(subnetwork).private_get_gradient_input(); }
 
+        // Our output belongs to the tag, which decides when it's released.
+        resizable_tensor* releasable_output() { return nullptr; }
+        resizable_tensor* owned_output() { return nullptr; }
+
         subnet_type subnetwork;
 
+        // Set by enable_activation_reuse().
+        impl::activation_arena_ptr arena;
+
         // This member doesn't logically contribute to the state of the object since it is
         // always empty. It's just here so we can have the get_parameter_gradient() methods
         // which have to return something.  So they return this empty tensor.
@@ -3590,6 +3954,87 @@ namespace dlib
         impl::vl_until_tag<0,tag_id>::visit(net, net, v);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        class visitor_set_activation_arena
+        {
+        public:
+
+            explicit visitor_set_activation_arena(
+                const std::shared_ptr<activation_arena>& arena_
+            ) : arena(arena_) {}
+
+            template <typename T, typename U, typename E>
+            void operator()(size_t, add_layer<T,U,E>& l) const 
+            { 
+                l.arena.reset(arena); 
+                set_repeat(l.subnet());
+            }
+
+            template <unsigned long ID, typename U>
+            void operator()(size_t, add_tag_layer<ID,U,typename std::enable_if<is_nonloss_layer_type<U>::value>::type>& l) const 
+            { 
+                l.arena.reset(arena); 
+                l.last_read_step = -1;
+                set_repeat(l.subnet());
+            }
+
+            template <template<typename> class TAG_TYPE, typename U>
+            void operator()(size_t, add_skip_layer<TAG_TYPE,U>& l) const 
+            { 
+                l.arena.reset(arena); 
+                set_repeat(l.subnet());
+            }
+
+            template <typename T, typename U>
+            void operator()(size_t, add_loss_layer<T,U>& l) const { set_repeat(l.subnet()); }
+
+            template <typename T>
+            void operator()(size_t, T&) const {}
+
+            // visit_layers() visits the layers inside a repeat layer but never the repeat
+            // layer itself.  So it's set from the layer above it instead.
+            template <size_t N, template<typename> class L, typename U>
+            void set_repeat(repeat<N,L,U>& l) const 
+            { 
+                l.arena.reset(arena); 
+                set_repeat(l.subnet());
+            }
+
+            template <typename T>
+            void set_repeat(T&) const {}
+
+        private:
+            std::shared_ptr<activation_arena> arena;
+        };
+    }
+
+    template <
+        typename net_type
+        >
+    void enable_activation_reuse(
+        net_type& net
+    )
+    {
+        impl::visitor_set_activation_arena v(std::make_shared<impl::activation_arena>());
+        v.set_repeat(net);
+        visit_layers(net, v);
+    }
+
+    template <
+        typename net_type
+        >
+    void disable_activation_reuse(
+        net_type& net
+    )
+    {
+        impl::visitor_set_activation_arena v(nullptr);
+        v.set_repeat(net);
+        visit_layers(net, v);
+    }
+
 // ----------------------------------------------------------------------------------------
 
 }
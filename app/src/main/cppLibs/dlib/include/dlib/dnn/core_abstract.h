@@ -1655,6 +1655,57 @@ namespace dlib
                 v(layer<i>(net));  // also visits the tag layer itself at the very end.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename net_type
+        >
+    void enable_activation_reuse(
+        net_type& net
+    );
+    /*!
+        requires
+            - net_type is an object of type add_layer, add_loss_layer, add_skip_layer,
+              add_tag_layer, or repeat.
+        ensures
+            - Puts net in an inference mode that uses much less memory.  Normally each
+              layer keeps its output after a forward pass, so a network holds all of its
+              activations at once.  After this call the layers instead share a pool of
+              buffers.  Each layer takes a buffer from the pool for its output right
+              before computing it, and its input's buffer goes back to the pool as soon
+              as no other layer can read that input anymore.  An output read through a
+              tag is kept until the step that last read it in the previous forward pass,
+              or until the end of the pass the first time around.  So once the first
+              few passes have grown the buffers to the sizes they need, forward passes
+              don't allocate any memory and the network holds only as many activations
+              as are alive at the same time.  For a plain chain of layers, such as
+              the mmod face detector, that's about two in total instead of one per layer.
+            - The outputs of the network are the same as without this mode.  However,
+              after a forward pass only the output of the top layer (i.e. the one
+              returned by forward()) is still valid.  The get_output() of the other
+              layers may be empty or hold the output of another layer.
+            - Gradients are never allocated in this mode.  Calling back_propagate_error()
+              is an error until disable_activation_reuse(net) is called.
+            - Copying net, or assigning another network to it, gives a network that
+              doesn't reuse its activations until enable_activation_reuse() is called on
+              it.
+    !*/
+
+    template <
+        typename net_type
+        >
+    void disable_activation_reuse(
+        net_type& net
+    );
+    /*!
+        requires
+            - net_type is an object of type add_layer, add_loss_layer, add_skip_layer,
+              add_tag_layer, or repeat.
+        ensures
+            - Undoes enable_activation_reuse(net).  The buffers in the pool are freed,
+              and from the next forward pass on each layer keeps its own output again.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     struct layer_test_results
@@ -0,0 +1,170 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_DNn_EMBEDDING_EXTRACTOR_H_
+#define DLIB_DNn_EMBEDDING_EXTRACTOR_H_
+
+#include "embedding_extractor_abstract.h"
+#include "core.h"
+#include "../threads/thread_pool_extension.h"
+#include "../threads/parallel_for_extension.h"
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename net_type>
+    class embedding_extractor : noncopyable
+    {
+    public:
+
+        typedef typename net_type::input_type input_type;
+        typedef typename net_type::output_label_type output_label_type;
+
+        explicit embedding_extractor (
+            const net_type& net_,
+            unsigned long batch_size_ = 32
+        ) : net(net_), batch_size(batch_size_), inference_thread(1)
+        {
+            DLIB_CASSERT(batch_size > 0);
+        }
+
+        const net_type& get_net (
+        ) const { return net; }
+
+        unsigned long get_batch_size (
+        ) const { return batch_size; }
+
+        void set_batch_size (
+            unsigned long size
+        )
+        {
+            DLIB_CASSERT(size > 0);
+            batch_size = size;
+        }
+
+        template <typename forward_iterator, typename output_iterator>
+        output_iterator operator() (
+            forward_iterator ibegin,
+            forward_iterator iend,
+            output_iterator out
+        )
+        {
+            // While the network runs on one batch in the inference thread, the next batch
+            // is converted into the other tensor here.
+            std::vector<forward_iterator> items;
+            uint64 task = 0;
+            long cur = 0;
+            try
+            {
+                while (true)
+                {
+                    const bool have_batch = prepare_batch(ibegin, iend, items, x[cur]);
+                    if (task != 0)
+                    {
+                        inference_thread.wait_for_task(task);
+                        task = 0;
+                        out = std::copy(labels[1-cur].begin(), labels[1-cur].end(), out);
+                    }
+                    if (!have_batch)
+                        break;
+
+                    task = inference_thread.add_task(*this, &embedding_extractor::run_batch, cur);
+                    cur = 1-cur;
+                }
+            }
+            catch (...)
+            {
+                // Don't leave the inference thread running on a batch after we are gone.
+                if (task != 0)
+                {
+                    try { inference_thread.wait_for_task(task); } catch (...) {}
+                }
+                throw;
+            }
+            return out;
+        }
+
+        std::vector<output_label_type> operator() (
+            const std::vector<input_type>& data
+        )
+        {
+            std::vector<output_label_type> results;
+            results.reserve(data.size());
+            (*this)(data.begin(), data.end(), std::back_inserter(results));
+            return results;
+        }
+
+    private:
+
+        template <typename forward_iterator>
+        bool prepare_batch (
+            forward_iterator& ibegin,
+            const forward_iterator& iend,
+            std::vector<forward_iterator>& items,
+            resizable_tensor& data
+        )
+        /*!
+            ensures
+                - Converts the next get_batch_size() inputs, or all that are left, into
+                  data and moves ibegin past them.
+                - returns false if there were no inputs left.
+        !*/
+        {
+            items.clear();
+            for (; ibegin != iend && items.size() < batch_size; ++ibegin)
+                items.push_back(ibegin);
+            if (items.size() == 0)
+                return false;
+
+            // The samples are converted one at a time so each can be done by a
+            // different thread.  The first one also tells us the size of a sample.
+            net.to_tensor(items[0], std::next(items[0]), sample);
+            DLIB_CASSERT(sample.num_samples() == 1);
+            const size_t sample_size = sample.size();
+            data.set_size(items.size(), sample.k(), sample.nr(), sample.nc());
+            std::copy(sample.begin(), sample.end(), data.host_write_only());
+
+            float* const dest = data.host();
+            parallel_for_blocked(1, items.size(), [&](long begin, long end)
+            {
+                resizable_tensor temp;
+                for (long i = begin; i < end; ++i)
+                {
+                    net.to_tensor(items[i], std::next(items[i]), temp);
+                    DLIB_CASSERT(temp.size() == sample_size,
+                        "All the inputs given to an embedding_extractor must make tensors of the same size.");
+                    std::copy(temp.begin(), temp.end(), dest + i*sample_size);
+                }
+            });
+            return true;
+        }
+
+        void run_batch (
+            long cur
+        )
+        {
+            net.subnet().forward(x[cur]);
+            labels[cur].resize(x[cur].num_samples());
+            net.loss_details().to_label(x[cur], net.subnet(), labels[cur].begin());
+        }
+
+        net_type net;
+        unsigned long batch_size;
+
+        resizable_tensor x[2];
+        std::vector<output_label_type> labels[2];
+        resizable_tensor sample;
+
+        // Declared last so it is destroyed first, while the tensors it uses still exist.
+        thread_pool inference_thread;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_DNn_EMBEDDING_EXTRACTOR_H_
+
@@ -0,0 +1,123 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_DNn_EMBEDDING_EXTRACTOR_ABSTRACT_H_
+#ifdef DLIB_DNn_EMBEDDING_EXTRACTOR_ABSTRACT_H_
+
+#include "core_abstract.h"
+#include "../threads/thread_pool_extension_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename net_type>
+    class embedding_extractor : noncopyable
+    {
+        /*!
+            REQUIREMENTS ON net_type
+                - net_type is an add_loss_layer object whose loss makes one label per
+                  input, for example a loss_metric network like the face recognition
+                  ResNet in dnn_face_recognition_ex.cpp.
+                - Every input converts to a tensor of the same size, e.g. the network
+                  uses input_rgb_image_sized.
+
+            WHAT THIS OBJECT REPRESENTS
+                This object runs a network over a long stream of inputs, such as the
+                aligned face chips of a photo collection, and gives back their
+                embeddings in the same order.
+
+                The inputs are run in batches of get_batch_size().  While the network
+                runs on one batch in a thread of its own, the next batch is converted
+                into a second input tensor, with the samples spread over the threads of
+                default_thread_pool().  The two input tensors are kept between batches
+                and calls, so no memory is allocated for them once they are big enough
+                (with CUDA this is also pinned host memory, so copies to the device are
+                fast).
+
+                Since the network has a copy of its own, the network given to the
+                constructor can be used by other threads while this object runs.
+
+            THREAD SAFETY
+                An embedding_extractor must not be used by more than one thread at a
+                time.
+        !*/
+
+    public:
+
+        typedef typename net_type::input_type input_type;
+        typedef typename net_type::output_label_type output_label_type;
+
+        explicit embedding_extractor (
+            const net_type& net,
+            unsigned long batch_size = 32
+        );
+        /*!
+            requires
+                - batch_size > 0
+            ensures
+                - #get_net() == a copy of net
+                - #get_batch_size() == batch_size
+        !*/
+
+        const net_type& get_net (
+        ) const;
+        /*!
+            ensures
+                - returns the network this object runs.
+        !*/
+
+        unsigned long get_batch_size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of inputs run through the network at once.
+        !*/
+
+        void set_batch_size (
+            unsigned long size
+        );
+        /*!
+            requires
+                - size > 0
+            ensures
+                - #get_batch_size() == size
+        !*/
+
+        template <typename forward_iterator, typename output_iterator>
+        output_iterator operator() (
+            forward_iterator ibegin,
+            forward_iterator iend,
+            output_iterator out
+        );
+        /*!
+            requires
+                - [ibegin, iend) is an iterator range over input_type objects.
+                - out is an output iterator that output_label_type objects can be
+                  assigned to.
+            ensures
+                - Runs the network on each input in [ibegin, iend) and writes the labels to
+                  out, in the same order as the inputs.  The labels are the same as those
+                  of get_net()(ibegin, iend).
+                - The labels of each batch are written to out as soon as the batch is
+                  done, so the inputs don't all have to be in memory at once.
+                - The inputs of a batch are read by several threads at once, so reading
+                  them through the iterators must be thread safe.
+                - returns out, advanced past the labels it was given.
+        !*/
+
+        std::vector<output_label_type> operator() (
+            const std::vector<input_type>& data
+        );
+        /*!
+            ensures
+                - returns the labels of all the inputs in data, i.e. a vector R such that
+                  R[i] is the label of data[i].
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_DNn_EMBEDDING_EXTRACTOR_ABSTRACT_H_
+
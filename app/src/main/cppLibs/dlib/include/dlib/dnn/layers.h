@@ -59,7 +59,11 @@ namespace dlib
             bias_weight_decay_multiplier(0),
             num_filters_(o.num_outputs),
             padding_y_(_padding_y),
-            padding_x_(_padding_x)
+            padding_x_(_padding_x),
+            use_relu(false),
+            use_int8(false),
+            int8_input_min(0),
+            int8_input_max(0)
         {
             DLIB_CASSERT(num_filters_ > 0);
         }
@@ -107,6 +111,42 @@ namespace dlib
         void set_bias_learning_rate_multiplier(double val) { bias_learning_rate_multiplier = val; }
         void set_bias_weight_decay_multiplier(double val)  { bias_weight_decay_multiplier  = val; }
 
+        bool relu_is_enabled() const { return use_relu; }
+        void enable_relu() { use_relu = true; }
+        void disable_relu() { use_relu = false; }
+
+        bool is_quantized() const { return use_int8; }
+        float get_quantized_input_min() const { return int8_input_min; }
+        float get_quantized_input_max() const { return int8_input_max; }
+        void quantize(float input_min, float input_max)
+        {
+            DLIB_CASSERT(input_min <= input_max);
+            DLIB_CASSERT(params.size() != 0, "You can't quantize a con_ layer before it has been set up.");
+            if (!use_int8)
+            {
+                // Only the quantized filters are kept, so params shrinks to the biases.
+                quantized_filters.quantize(filters(params,0), false);
+                resizable_tensor temp(biases(params,filters.size()));
+                params = std::move(temp);
+            }
+            use_int8 = true;
+            int8_input_min = input_min;
+            int8_input_max = input_max;
+        }
+        void disable_quantization()
+        {
+            if (!use_int8)
+                return;
+            resizable_tensor temp(biases(params,0));
+            params.set_size(filters.size() + biases.size());
+            auto filt = filters(params,0);
+            quantized_filters.dequantize(filt);
+            auto b = biases(params,filters.size());
+            memcpy(b, temp);
+            quantized_filters = tt::int8_weights();
+            use_int8 = false;
+        }
+
         inline dpoint map_input_to_output (
             dpoint p
         ) const
@@ -137,7 +177,12 @@ namespace dlib
             bias_weight_decay_multiplier(item.bias_weight_decay_multiplier),
             num_filters_(item.num_filters_),
             padding_y_(item.padding_y_),
-            padding_x_(item.padding_x_)
+            padding_x_(item.padding_x_),
+            use_relu(item.use_relu),
+            use_int8(item.use_int8),
+            int8_input_min(item.int8_input_min),
+            int8_input_max(item.int8_input_max),
+            quantized_filters(item.quantized_filters)
         {
             // this->conv is non-copyable and basically stateless, so we have to write our
             // own copy to avoid trying to copy it and getting an error.
@@ -162,6 +207,11 @@ namespace dlib
             bias_learning_rate_multiplier = item.bias_learning_rate_multiplier;
             bias_weight_decay_multiplier = item.bias_weight_decay_multiplier;
             num_filters_ = item.num_filters_;
+            use_relu = item.use_relu;
+            use_int8 = item.use_int8;
+            int8_input_min = item.int8_input_min;
+            int8_input_max = item.int8_input_max;
+            quantized_filters = item.quantized_filters;
             return *this;
         }
 
@@ -189,22 +239,43 @@ namespace dlib
         template <typename SUBNET>
         void forward(const SUBNET& sub, resizable_tensor& output)
         {
-            conv.setup(sub.get_output(),
-                       filters(params,0),
-                       _stride_y,
-                       _stride_x,
-                       padding_y_,
-                       padding_x_);
-            conv(false, output,
-                sub.get_output(),
-                filters(params,0));
-
-            tt::add(1,output,1,biases(params,filters.size()));
+            if (use_int8)
+            {
+                conv.setup(sub.get_output(),
+                           quantized_filters,
+                           _stride_y,
+                           _stride_x,
+                           padding_y_,
+                           padding_x_);
+                conv.forward_int8(output,
+                    sub.get_output(),
+                    quantized_filters,
+                    biases(params,0),
+                    use_relu,
+                    int8_input_min,
+                    int8_input_max);
+            }
+            else
+            {
+                conv.setup(sub.get_output(),
+                           filters(params,0),
+                           _stride_y,
+                           _stride_x,
+                           padding_y_,
+                           padding_x_);
+                conv(output,
+                    sub.get_output(),
+                    filters(params,0),
+                    biases(params,filters.size()),
+                    use_relu);
+            }
         } 
 
         template <typename SUBNET>
         void backward(const tensor& gradient_input, SUBNET& sub, tensor& params_grad)
         {
+            DLIB_CASSERT(!use_relu, "You can't train a con_ layer with its relu enabled, call disable_relu() first.");
+            DLIB_CASSERT(!use_int8, "You can't train a quantized con_ layer, call disable_quantization() first.");
             conv.get_gradient_for_data (true, gradient_input, filters(params,0), sub.get_gradient_input());
             // no dpoint computing the parameter gradients if they won't be used.
             if (learning_rate_multiplier != 0)
@@ -221,7 +292,14 @@ namespace dlib
 
         friend void serialize(const con_& item, std::ostream& out)
         {
-            serialize("con_4", out);
+            // Write the oldest format that can hold the layer's state, so layers that
+            // were never fused or quantized can still be read by older code.
+            if (item.use_int8)
+                serialize("con_6", out);
+            else if (item.use_relu)
+                serialize("con_5", out);
+            else
+                serialize("con_4", out);
             serialize(item.params, out);
             serialize(item.num_filters_, out);
             serialize(_nr, out);
@@ -236,6 +314,15 @@ namespace dlib
             serialize(item.weight_decay_multiplier, out);
             serialize(item.bias_learning_rate_multiplier, out);
             serialize(item.bias_weight_decay_multiplier, out);
+            if (item.use_relu || item.use_int8)
+                serialize(item.use_relu, out);
+            if (item.use_int8)
+            {
+                serialize(item.use_int8, out);
+                serialize(item.int8_input_min, out);
+                serialize(item.int8_input_max, out);
+                serialize(item.quantized_filters, out);
+            }
         }
 
         friend void deserialize(con_& item, std::istream& in)
@@ -246,7 +333,7 @@ namespace dlib
             long nc;
             int stride_y;
             int stride_x;
-            if (version == "con_4")
+            if (version == "con_4" || version == "con_5" || version == "con_6")
             {
                 deserialize(item.params, in);
                 deserialize(item.num_filters_, in);
@@ -262,6 +349,24 @@ namespace dlib
                 deserialize(item.weight_decay_multiplier, in);
                 deserialize(item.bias_learning_rate_multiplier, in);
                 deserialize(item.bias_weight_decay_multiplier, in);
+                item.use_relu = false;
+                if (version != "con_4")
+                    deserialize(item.use_relu, in);
+                item.use_int8 = false;
+                item.int8_input_min = 0;
+                item.int8_input_max = 0;
+                item.quantized_filters = tt::int8_weights();
+                if (version == "con_6")
+                {
+                    deserialize(item.use_int8, in);
+                    deserialize(item.int8_input_min, in);
+                    deserialize(item.int8_input_max, in);
+                    deserialize(item.quantized_filters, in);
+                    if (item.params.size() != item.biases.size() ||
+                        (size_t)item.quantized_filters.size() != item.filters.size() ||
+                        item.quantized_filters.num_samples() != item.num_filters_)
+                        throw serialization_error("Wrong quantized filters found while deserializing dlib::con_");
+                }
                 if (item.padding_y_ != _padding_y) throw serialization_error("Wrong padding_y found while deserializing dlib::con_");
                 if (item.padding_x_ != _padding_x) throw serialization_error("Wrong padding_x found while deserializing dlib::con_");
                 if (nr != _nr) throw serialization_error("Wrong nr found while deserializing dlib::con_");
@@ -291,6 +396,10 @@ namespace dlib
             out << " weight_decay_mult="<<item.weight_decay_multiplier;
             out << " bias_learning_rate_mult="<<item.bias_learning_rate_multiplier;
             out << " bias_weight_decay_mult="<<item.bias_weight_decay_multiplier;
+            if (item.use_relu)
+                out << " relu";
+            if (item.use_int8)
+                out << " int8";
             return out;
         }
 
@@ -307,7 +416,9 @@ namespace dlib
                 << " learning_rate_mult='"<<item.learning_rate_multiplier<<"'"
                 << " weight_decay_mult='"<<item.weight_decay_multiplier<<"'"
                 << " bias_learning_rate_mult='"<<item.bias_learning_rate_multiplier<<"'"
-                << " bias_weight_decay_mult='"<<item.bias_weight_decay_multiplier<<"'>\n";
+                << " bias_weight_decay_mult='"<<item.bias_weight_decay_multiplier<<"'"
+                << " use_relu='"<<item.use_relu<<"'"
+                << " int8='"<<item.use_int8<<"'>\n";
             out << mat(item.params);
             out << "</con>";
         }
@@ -329,6 +440,17 @@ namespace dlib
         int padding_y_;
         int padding_x_;
 
+        // Set by fuse_layers() when the relu_ layer after this one was folded into it.
+        bool use_relu;
+
+        // Set by quantize_layers().  The range is the one the inputs were calibrated on.
+        // While it's set the filters are held in quantized_filters and params holds
+        // only the biases.
+        bool use_int8;
+        float int8_input_min;
+        float int8_input_max;
+        tt::int8_weights quantized_filters;
+
     };
 
     template <
@@ -1561,7 +1683,10 @@ namespace dlib
             learning_rate_multiplier(1),
             weight_decay_multiplier(1),
             bias_learning_rate_multiplier(1),
-            bias_weight_decay_multiplier(0)
+            bias_weight_decay_multiplier(0),
+            use_int8(false),
+            int8_input_min(0),
+            int8_input_max(0)
         {}
 
         fc_() : fc_(num_fc_outputs(num_outputs_)) {}
@@ -1593,6 +1718,51 @@ namespace dlib
         fc_bias_mode get_bias_mode (
         ) const { return bias_mode; }
 
+        bool is_quantized() const { return use_int8; }
+        float get_quantized_input_min() const { return int8_input_min; }
+        float get_quantized_input_max() const { return int8_input_max; }
+        void quantize(float input_min, float input_max)
+        {
+            DLIB_CASSERT(input_min <= input_max);
+            DLIB_CASSERT(params.size() != 0, "You can't quantize a fc_ layer before it has been set up.");
+            if (!use_int8)
+            {
+                // Only the quantized weights are kept, so params shrinks to the biases.
+                quantized_weights.quantize(weights(params,0), true);
+                if (bias_mode == FC_HAS_BIAS)
+                {
+                    resizable_tensor temp(biases(params,weights.size()));
+                    params = std::move(temp);
+                }
+                else
+                {
+                    params.clear();
+                }
+            }
+            use_int8 = true;
+            int8_input_min = input_min;
+            int8_input_max = input_max;
+        }
+        void disable_quantization()
+        {
+            if (!use_int8)
+                return;
+            resizable_tensor temp(params);
+            if (bias_mode == FC_HAS_BIAS)
+                params.set_size(num_inputs+1, num_outputs);
+            else
+                params.set_size(num_inputs, num_outputs);
+            auto w = weights(params,0);
+            quantized_weights.dequantize(w);
+            if (bias_mode == FC_HAS_BIAS)
+            {
+                auto b = biases(params,weights.size());
+                memcpy(b, temp);
+            }
+            quantized_weights = tt::int8_weights();
+            use_int8 = false;
+        }
+
         template <typename SUBNET>
         void setup (const SUBNET& sub)
         {
@@ -1622,11 +1792,18 @@ namespace dlib
                 "The size of the input tensor to this fc layer doesn't match the size the fc layer was trained with.");
             output.set_size(sub.get_output().num_samples(), num_outputs);
 
-            auto w = weights(params, 0);
-            tt::gemm(0,output, 1,sub.get_output(),false, w,false);
+            if (use_int8)
+            {
+                qgemm(output, sub.get_output(), quantized_weights, int8_input_min, int8_input_max);
+            }
+            else
+            {
+                auto w = weights(params, 0);
+                tt::gemm(0,output, 1,sub.get_output(),false, w,false);
+            }
             if (bias_mode == FC_HAS_BIAS)
             {
-                auto b = biases(params, weights.size());
+                auto b = biases(params, bias_offset());
                 tt::add(1,output,1,b);
             }
         } 
@@ -1634,6 +1811,7 @@ namespace dlib
         template <typename SUBNET>
         void backward(const tensor& gradient_input, SUBNET& sub, tensor& params_grad)
         {
+            DLIB_CASSERT(!use_int8, "You can't train a quantized fc_ layer, call disable_quantization() first.");
             // no point computing the parameter gradients if they won't be used.
             if (learning_rate_multiplier != 0)
             {
@@ -1656,11 +1834,13 @@ namespace dlib
 
         alias_tensor_instance get_weights()
         {
+            DLIB_CASSERT(!use_int8, "A quantized fc_ layer has no float weights, call disable_quantization() first.");
             return weights(params, 0);
         }
 
         alias_tensor_const_instance get_weights() const
         {
+            DLIB_CASSERT(!use_int8, "A quantized fc_ layer has no float weights, call disable_quantization() first.");
             return weights(params, 0);
         }
 
@@ -1668,14 +1848,14 @@ namespace dlib
         {
             static_assert(bias_mode == FC_HAS_BIAS, "This fc_ layer doesn't have a bias vector "
                 "to be retrieved, as per template parameter 'bias_mode'.");
-            return biases(params, weights.size());
+            return biases(params, bias_offset());
         }
 
         alias_tensor_const_instance get_biases() const
         {
             static_assert(bias_mode == FC_HAS_BIAS, "This fc_ layer doesn't have a bias vector "
                 "to be retrieved, as per template parameter 'bias_mode'.");
-            return biases(params, weights.size());
+            return biases(params, bias_offset());
         }
 
         const tensor& get_layer_params() const { return params; }
@@ -1683,7 +1863,8 @@ namespace dlib
 
         friend void serialize(const fc_& item, std::ostream& out)
         {
-            serialize("fc_2", out);
+            // Only a quantized layer needs the newer format.
+            serialize(std::string(item.use_int8 ? "fc_3" : "fc_2"), out);
             serialize(item.num_outputs, out);
             serialize(item.num_inputs, out);
             serialize(item.params, out);
@@ -1694,13 +1875,20 @@ namespace dlib
             serialize(item.weight_decay_multiplier, out);
             serialize(item.bias_learning_rate_multiplier, out);
             serialize(item.bias_weight_decay_multiplier, out);
+            if (item.use_int8)
+            {
+                serialize(item.use_int8, out);
+                serialize(item.int8_input_min, out);
+                serialize(item.int8_input_max, out);
+                serialize(item.quantized_weights, out);
+            }
         }
 
         friend void deserialize(fc_& item, std::istream& in)
         {
             std::string version;
             deserialize(version, in);
-            if (version != "fc_2")
+            if (version != "fc_2" && version != "fc_3")
                 throw serialization_error("Unexpected version '"+version+"' found while deserializing dlib::fc_.");
 
             deserialize(item.num_outputs, in);
@@ -1715,6 +1903,21 @@ namespace dlib
             deserialize(item.weight_decay_multiplier, in);
             deserialize(item.bias_learning_rate_multiplier, in);
             deserialize(item.bias_weight_decay_multiplier, in);
+            item.use_int8 = false;
+            item.int8_input_min = 0;
+            item.int8_input_max = 0;
+            item.quantized_weights = tt::int8_weights();
+            if (version == "fc_3")
+            {
+                deserialize(item.use_int8, in);
+                deserialize(item.int8_input_min, in);
+                deserialize(item.int8_input_max, in);
+                deserialize(item.quantized_weights, in);
+                if (item.params.size() != (bias_mode == FC_HAS_BIAS ? item.biases.size() : 0) ||
+                    item.quantized_weights.size() != item.weights.size() ||
+                    item.quantized_weights.num_samples() != (long)item.num_inputs)
+                    throw serialization_error("Wrong quantized weights found while deserializing dlib::fc_");
+            }
         }
 
         friend std::ostream& operator<<(std::ostream& out, const fc_& item)
@@ -1737,6 +1940,8 @@ namespace dlib
                 out << " learning_rate_mult="<<item.learning_rate_multiplier;
                 out << " weight_decay_mult="<<item.weight_decay_multiplier;
             }
+            if (item.use_int8)
+                out << " int8";
             return out;
         }
 
@@ -1749,7 +1954,8 @@ namespace dlib
                     << " learning_rate_mult='"<<item.learning_rate_multiplier<<"'"
                     << " weight_decay_mult='"<<item.weight_decay_multiplier<<"'"
                     << " bias_learning_rate_mult='"<<item.bias_learning_rate_multiplier<<"'"
-                    << " bias_weight_decay_mult='"<<item.bias_weight_decay_multiplier<<"'";
+                    << " bias_weight_decay_mult='"<<item.bias_weight_decay_multiplier<<"'"
+                    << " int8='"<<item.use_int8<<"'";
                 out << ">\n";
                 out << mat(item.params);
                 out << "</fc>\n";
@@ -1759,7 +1965,8 @@ namespace dlib
                 out << "<fc_no_bias"
                     << " num_outputs='"<<item.num_outputs<<"'"
                     << " learning_rate_mult='"<<item.learning_rate_multiplier<<"'"
-                    << " weight_decay_mult='"<<item.weight_decay_multiplier<<"'";
+                    << " weight_decay_mult='"<<item.weight_decay_multiplier<<"'"
+                    << " int8='"<<item.use_int8<<"'";
                 out << ">\n";
                 out << mat(item.params);
                 out << "</fc_no_bias>\n";
@@ -1776,6 +1983,17 @@ namespace dlib
         double weight_decay_multiplier;
         double bias_learning_rate_multiplier;
         double bias_weight_decay_multiplier;
+
+        size_t bias_offset() const { return use_int8 ? 0 : weights.size(); }
+
+        // Set by quantize_layers().  The range is the one the inputs were calibrated on.
+        // While it's set the weights are held in quantized_weights and params holds
+        // only the biases.
+        bool use_int8;
+        float int8_input_min;
+        float int8_input_max;
+        tt::int8_weights quantized_weights;
+        tt::gemm_int8 qgemm;
     };
 
     template <
@@ -2009,13 +2227,13 @@ namespace dlib
     {
     public:
         affine_(
-        ) : mode(FC_MODE)
+        ) : mode(FC_MODE), disabled(false)
         {
         }
 
         affine_(
             layer_mode mode_
-        ) : mode(mode_)
+        ) : mode(mode_), disabled(false)
         {
         }
 
@@ -2029,6 +2247,7 @@ namespace dlib
             gamma = item.gamma;
             beta = item.beta;
             mode = bnmode;
+            disabled = false;
 
             params.copy_size(item.params);
 
@@ -2045,6 +2264,18 @@ namespace dlib
 
         layer_mode get_mode() const { return mode; }
 
+        alias_tensor_const_instance get_gamma() const { return gamma(params,0); }
+        alias_tensor_const_instance get_beta() const { return beta(params,gamma.size()); }
+
+        bool is_disabled() const { return disabled; }
+        void disable()
+        {
+            params.clear();
+            gamma = alias_tensor();
+            beta = alias_tensor();
+            disabled = true;
+        }
+
         inline dpoint map_input_to_output (const dpoint& p) const { return p; }
         inline dpoint map_output_to_input (const dpoint& p) const { return p; }
 
@@ -2072,6 +2303,13 @@ namespace dlib
 
         void forward_inplace(const tensor& input, tensor& output)
         {
+            if (disabled)
+            {
+                if (!is_same_object(input, output))
+                    memcpy(output, input);
+                return;
+            }
+
             auto g = gamma(params,0);
             auto b = beta(params,gamma.size());
             if (mode == FC_MODE)
@@ -2086,6 +2324,13 @@ namespace dlib
             tensor& /*params_grad*/
         )
         {
+            if (disabled)
+            {
+                if (!is_same_object(gradient_input, data_grad))
+                    tt::add(1, data_grad, 1, gradient_input);
+                return;
+            }
+
             auto g = gamma(params,0);
             auto b = beta(params,gamma.size());
 
@@ -2111,11 +2356,14 @@ namespace dlib
 
         friend void serialize(const affine_& item, std::ostream& out)
         {
-            serialize("affine_", out);
+            // Only a layer disabled by fuse_layers() needs the newer format.
+            serialize(std::string(item.disabled ? "affine_2" : "affine_"), out);
             serialize(item.params, out);
             serialize(item.gamma, out);
             serialize(item.beta, out);
             serialize((int)item.mode, out);
+            if (item.disabled)
+                serialize(item.disabled, out);
         }
 
         friend void deserialize(affine_& item, std::istream& in)
@@ -2143,7 +2391,7 @@ namespace dlib
                 return;
             }
 
-            if (version != "affine_")
+            if (version != "affine_" && version != "affine_2")
                 throw serialization_error("Unexpected version '"+version+"' found while deserializing dlib::affine_.");
             deserialize(item.params, in);
             deserialize(item.gamma, in);
@@ -2151,11 +2399,16 @@ namespace dlib
             int mode;
             deserialize(mode, in);
             item.mode = (layer_mode)mode;
+            item.disabled = false;
+            if (version == "affine_2")
+                deserialize(item.disabled, in);
         }
 
-        friend std::ostream& operator<<(std::ostream& out, const affine_& )
+        friend std::ostream& operator<<(std::ostream& out, const affine_& item)
         {
             out << "affine";
+            if (item.disabled)
+                out << "\t (disabled)";
             return out;
         }
 
@@ -2178,6 +2431,7 @@ namespace dlib
         resizable_tensor params, empty_params; 
         alias_tensor gamma, beta;
         layer_mode mode;
+        bool disabled;
     };
 
     template <typename SUBNET>
@@ -2512,10 +2766,13 @@ namespace dlib
     class relu_
     {
     public:
-        relu_() 
+        relu_() : disabled(false)
         {
         }
 
+        bool is_disabled() const { return disabled; }
+        void disable() { disabled = true; }
+
         template <typename SUBNET>
         void setup (const SUBNET& /*sub*/)
         {
@@ -2523,6 +2780,12 @@ namespace dlib
 
         void forward_inplace(const tensor& input, tensor& output)
         {
+            if (disabled)
+            {
+                if (!is_same_object(input, output))
+                    memcpy(output, input);
+                return;
+            }
             tt::relu(output, input);
         } 
 
@@ -2533,6 +2796,12 @@ namespace dlib
             tensor& 
         )
         {
+            if (disabled)
+            {
+                if (!is_same_object(gradient_input, data_grad))
+                    tt::add(1, data_grad, 1, gradient_input);
+                return;
+            }
             tt::relu_gradient(data_grad, computed_output, gradient_input);
         }
 
@@ -2542,22 +2811,30 @@ namespace dlib
         const tensor& get_layer_params() const { return params; }
         tensor& get_layer_params() { return params; }
 
-        friend void serialize(const relu_& , std::ostream& out)
+        friend void serialize(const relu_& item, std::ostream& out)
         {
-            serialize("relu_", out);
+            // Only a layer disabled by fuse_layers() needs the newer format.
+            serialize(std::string(item.disabled ? "relu_2" : "relu_"), out);
+            if (item.disabled)
+                serialize(item.disabled, out);
         }
 
-        friend void deserialize(relu_& , std::istream& in)
+        friend void deserialize(relu_& item, std::istream& in)
         {
             std::string version;
             deserialize(version, in);
-            if (version != "relu_")
+            if (version != "relu_" && version != "relu_2")
                 throw serialization_error("Unexpected version '"+version+"' found while deserializing dlib::relu_.");
+            item.disabled = false;
+            if (version == "relu_2")
+                deserialize(item.disabled, in);
         }
 
-        friend std::ostream& operator<<(std::ostream& out, const relu_& )
+        friend std::ostream& operator<<(std::ostream& out, const relu_& item)
         {
             out << "relu";
+            if (item.disabled)
+                out << "\t (disabled)";
             return out;
         }
 
@@ -2568,12 +2845,300 @@ namespace dlib
 
     private:
         resizable_tensor params;
+        bool disabled;
     };
 
 
     template <typename SUBNET>
     using relu = add_layer<relu_, SUBNET>;
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        class visitor_fuse_layers
+        {
+        public:
+
+            template <typename input_layer_type>
+            void operator()(size_t , input_layer_type& ) const
+            {
+                // ignore other layers
+            }
+
+            template <typename T, typename U, typename E>
+            void operator()(size_t , add_layer<T,U,E>& l) const
+            {
+                fuse(l.layer_details(), l.subnet());
+            }
+
+        private:
+
+            template <typename T, typename SUBNET>
+            void fuse(T&, SUBNET&) const
+            {
+                // only the layer patterns below can be fused
+            }
+
+            template <long nf, long nr, long nc, int sy, int sx, int py, int px, typename U, typename E>
+            void fuse(affine_& a, add_layer<con_<nf,nr,nc,sy,sx,py,px>,U,E>& sub) const
+            {
+                con_<nf,nr,nc,sy,sx,py,px>& c = sub.layer_details();
+                tensor& params = c.get_layer_params();
+                if (a.is_disabled() || a.get_mode() != CONV_MODE || c.relu_is_enabled() ||
+                    c.is_quantized() || params.size() == 0)
+                    return;
+
+                // Scale each filter and its bias by gamma, then add beta to the bias.
+                const auto g = a.get_gamma();
+                const auto b = a.get_beta();
+                const long num_filters = c.num_filters();
+                const long filter_size = (params.size()-num_filters)/num_filters;
+                DLIB_CASSERT(g.get().size() == (size_t)num_filters);
+                const float* gp = g.get().host();
+                const float* bp = b.get().host();
+                float* p = params.host();
+                float* biases = p + num_filters*filter_size;
+                for (long i = 0; i < num_filters; ++i)
+                {
+                    for (long j = 0; j < filter_size; ++j)
+                        p[i*filter_size + j] *= gp[i];
+                    biases[i] = biases[i]*gp[i] + bp[i];
+                }
+                a.disable();
+            }
+
+            template <long nf, long nr, long nc, int sy, int sx, int py, int px, typename U, typename E>
+            void fuse(relu_& r, add_layer<con_<nf,nr,nc,sy,sx,py,px>,U,E>& sub) const
+            {
+                if (r.is_disabled())
+                    return;
+                sub.layer_details().enable_relu();
+                r.disable();
+            }
+
+            template <long nf, long nr, long nc, int sy, int sx, int py, int px, typename U, typename E, typename E2>
+            void fuse(relu_& r, add_layer<affine_,add_layer<con_<nf,nr,nc,sy,sx,py,px>,U,E>,E2>& sub) const
+            {
+                // If the affine_ layer has already been folded into the con_ then it
+                // doesn't do anything and the relu_ can be folded in too.
+                if (sub.layer_details().is_disabled())
+                    fuse(r, sub.subnet());
+            }
+        };
+    }
+
+    template <typename net_type>
+    void fuse_layers (
+        net_type& net
+    )
+    {
+        visit_layers_backwards(net, impl::visitor_fuse_layers());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        typedef std::vector<std::pair<float,float>> quantization_ranges;
+
+        class visitor_quantization_ranges
+        {
+        public:
+
+            visitor_quantization_ranges(
+                const tensor& x_,
+                quantization_ranges& ranges_
+            ) : x(x_), ranges(ranges_) {}
+
+            template <typename T>
+            void operator()(size_t , T& ) const
+            {
+                // only con_ and fc_ layers are quantized
+            }
+
+            template <long nf, long nr, long nc, int sy, int sx, int py, int px, typename U, typename E>
+            void operator()(size_t i, add_layer<con_<nf,nr,nc,sy,sx,py,px>,U,E>& l) const
+            {
+                record(i, l.subnet());
+            }
+
+            template <unsigned long no, fc_bias_mode bm, typename U, typename E>
+            void operator()(size_t i, add_layer<fc_<no,bm>,U,E>& l) const
+            {
+                record(i, l.subnet());
+            }
+
+        private:
+
+            template <typename SUBNET>
+            void record(size_t i, const SUBNET& sub) const
+            {
+                record(i, sub, std::integral_constant<bool,is_nonloss_layer_type<SUBNET>::value>());
+            }
+
+            template <typename SUBNET>
+            void record(size_t i, const SUBNET& sub, std::true_type) const
+            {
+                record(i, sub.get_output());
+            }
+
+            void record(size_t , const impl::repeat_input_layer&, std::false_type) const
+            {
+                // The input of the first layer inside a repeat layer isn't kept anywhere,
+                // so these layers are left as they are.
+            }
+
+            template <typename INPUT_LAYER>
+            void record(size_t i, const INPUT_LAYER&, std::false_type) const
+            {
+                // This is the first layer of the network, so its input is x.
+                record(i, x);
+            }
+
+            void record(size_t i, const tensor& t) const
+            {
+                if (t.size() == 0)
+                    return;
+                const float* p = t.host();
+                const auto mm = std::minmax_element(p, p+t.size());
+                ranges[i].first = std::min(ranges[i].first, *mm.first);
+                ranges[i].second = std::max(ranges[i].second, *mm.second);
+            }
+
+            const tensor& x;
+            quantization_ranges& ranges;
+        };
+
+        class visitor_quantize_layers
+        {
+        public:
+
+            // If ranges is null the layers are put back to float.
+            explicit visitor_quantize_layers(
+                const quantization_ranges* ranges_
+            ) : ranges(ranges_) {}
+
+            template <typename T>
+            void operator()(size_t , T& ) const
+            {
+                // only con_ and fc_ layers are quantized
+            }
+
+            template <long nf, long nr, long nc, int sy, int sx, int py, int px, typename U, typename E>
+            void operator()(size_t i, add_layer<con_<nf,nr,nc,sy,sx,py,px>,U,E>& l) const
+            {
+                // With only one or two filters the float code convolves the image
+                // directly, and 3x3 filters with a stride of 1 it does with Winograd's
+                // algorithm.  Both are faster than the int8 kernels.
+                if (l.layer_details().num_filters() <= 2 ||
+                    (l.layer_details().nr() == 3 && l.layer_details().nc() == 3 && sy == 1 && sx == 1))
+                {
+                    l.layer_details().disable_quantization();
+                    return;
+                }
+                quantize(i, l.layer_details());
+            }
+
+            template <unsigned long no, fc_bias_mode bm, typename U, typename E>
+            void operator()(size_t i, add_layer<fc_<no,bm>,U,E>& l) const
+            {
+                quantize(i, l.layer_details());
+            }
+
+        private:
+
+            template <typename layer_type>
+            void quantize(size_t i, layer_type& l) const
+            {
+                // Layers whose input was never seen stay in float.
+                if (ranges && (*ranges)[i].first <= (*ranges)[i].second)
+                    l.quantize((*ranges)[i].first, (*ranges)[i].second);
+                else
+                    l.disable_quantization();
+            }
+
+            const quantization_ranges* ranges;
+        };
+
+        template <typename net_type>
+        net_type& without_loss(net_type& net) { return net; }
+
+        template <typename LOSS_DETAILS, typename SUBNET>
+        SUBNET& without_loss(add_loss_layer<LOSS_DETAILS,SUBNET>& net) { return net.subnet(); }
+    }
+
+    template <
+        typename net_type,
+        typename forward_iterator
+        >
+    void quantize_layers (
+        net_type& net,
+        forward_iterator ibegin,
+        forward_iterator iend
+    )
+    {
+        DLIB_CASSERT(std::distance(ibegin,iend) > 0);
+
+        // Calibrate on the float network, even if it was quantized before.
+        visit_layers(net, impl::visitor_quantize_layers(nullptr));
+
+        impl::quantization_ranges ranges(net_type::num_layers,
+            std::make_pair(std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()));
+        auto& subnet = impl::without_loss(net);
+        resizable_tensor x;
+        for (; ibegin != iend; ++ibegin)
+        {
+            subnet.to_tensor(ibegin, std::next(ibegin), x);
+            subnet.forward(x);
+            visit_layers(net, impl::visitor_quantization_ranges(x, ranges));
+        }
+
+        visit_layers(net, impl::visitor_quantize_layers(&ranges));
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename net_type,
+        typename forward_iterator
+        >
+    matrix<double,1,3> test_quantization (
+        net_type& float_net,
+        net_type& quantized_net,
+        forward_iterator ibegin,
+        forward_iterator iend
+    )
+    {
+        DLIB_CASSERT(std::distance(ibegin,iend) > 0);
+
+        auto& fnet = impl::without_loss(float_net);
+        auto& qnet = impl::without_loss(quantized_net);
+        resizable_tensor x;
+        running_stats<double> rs;
+        double max_rel_error = 0;
+        double max_abs_error = 0;
+        for (; ibegin != iend; ++ibegin)
+        {
+            fnet.to_tensor(ibegin, std::next(ibegin), x);
+            const matrix<float> expected = mat(fnet.forward(x));
+            qnet.to_tensor(ibegin, std::next(ibegin), x);
+            const matrix<float> out = mat(qnet.forward(x));
+            DLIB_CASSERT(expected.size() == out.size());
+
+            const double norm = length(expected);
+            const double err = length(out-expected);
+            const double rel_error = norm != 0 ? err/norm : (err != 0 ? 1 : 0);
+            rs.add(rel_error);
+            max_rel_error = std::max(max_rel_error, rel_error);
+            max_abs_error = std::max<double>(max_abs_error, max(abs(out-expected)));
+        }
+
+        matrix<double,1,3> res;
+        res = rs.mean(), max_rel_error, max_abs_error;
+        return res;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class prelu_
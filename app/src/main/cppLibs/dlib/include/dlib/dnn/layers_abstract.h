@@ -449,6 +449,7 @@ namespace dlib
                 - #get_weight_decay_multiplier()       == 1
                 - #get_bias_learning_rate_multiplier() == 1
                 - #get_bias_weight_decay_multiplier()  == 0
+                - #is_quantized() == false
         !*/
 
         fc_(
@@ -462,6 +463,7 @@ namespace dlib
                 - #get_weight_decay_multiplier()       == 1
                 - #get_bias_learning_rate_multiplier() == 1
                 - #get_bias_weight_decay_multiplier()  == 0
+                - #is_quantized() == false
         !*/
 
         unsigned long get_num_outputs (
@@ -497,6 +499,60 @@ namespace dlib
                   is added to each of the outputs of this layer. 
         !*/
 
+        bool is_quantized(
+        ) const;
+        /*!
+            ensures
+                - returns true if this layer computes its outputs with 8 bit integer
+                  arithmetic instead of floats.  quantize_layers() turns this on.
+                - When quantized, the weights are rounded as described in tt::int8_weights and the
+                  inputs are rounded using get_quantized_input_min() and
+                  get_quantized_input_max() as their range.  Only the rounded weights are
+                  kept, so get_layer_params() holds just the biases and get_weights()
+                  can't be called.
+        !*/
+
+        float get_quantized_input_min(
+        ) const;
+        /*!
+            ensures
+                - returns the smallest input value this layer expects when it's quantized.
+        !*/
+
+        float get_quantized_input_max(
+        ) const;
+        /*!
+            ensures
+                - returns the largest input value this layer expects when it's quantized.
+                  Larger inputs are clamped to it.
+        !*/
+
+        void quantize(
+            float input_min,
+            float input_max
+        );
+        /*!
+            requires
+                - input_min <= input_max
+                - get_layer_params().size() != 0, i.e. the layer has been set up.
+            ensures
+                - #is_quantized() == true
+                - #get_quantized_input_min() == input_min
+                - #get_quantized_input_max() == input_max
+                - If the layer was already quantized only the input range changes.
+                  Otherwise the weights are rounded and the float ones are discarded.
+        !*/
+
+        void disable_quantization(
+        );
+        /*!
+            ensures
+                - #is_quantized() == false
+                - If the layer was quantized, get_layer_params() is rebuilt from the
+                  rounded weights.  So the layer doesn't compute exactly what it did
+                  before it was quantized.
+        !*/
+
         double get_learning_rate_multiplier(
         ) const;  
         /*!
@@ -576,6 +632,8 @@ namespace dlib
         alias_tensor_const_instance get_weights(
         ) const;
         /*!
+            requires
+                - is_quantized() == false
             ensures
                 - returns an alias of get_layer_params(), containing the weights matrix of
                   the fully connected layer.
@@ -591,6 +649,8 @@ namespace dlib
         alias_tensor_instance get_weights(
         );
         /*!
+            requires
+                - is_quantized() == false
             ensures
                 - returns an alias of get_layer_params(), containing the weights matrix of
                   the fully connected layer.
@@ -636,6 +696,7 @@ namespace dlib
         tensor& get_layer_params(); 
         /*!
             These functions are implemented as described in the EXAMPLE_COMPUTATIONAL_LAYER_ interface.
+            Note that backward() requires is_quantized() == false.
         !*/
 
     };
@@ -729,6 +790,8 @@ namespace dlib
                 - #get_weight_decay_multiplier()       == 1
                 - #get_bias_learning_rate_multiplier() == 1
                 - #get_bias_weight_decay_multiplier()  == 0
+                - #relu_is_enabled() == false
+                - #is_quantized() == false
         !*/
 
         con_(
@@ -747,6 +810,8 @@ namespace dlib
                 - #get_weight_decay_multiplier()       == 1
                 - #get_bias_learning_rate_multiplier() == 1
                 - #get_bias_weight_decay_multiplier()  == 0
+                - #relu_is_enabled() == false
+                - #is_quantized() == false
         !*/
 
         long num_filters(
@@ -903,6 +968,83 @@ namespace dlib
                 - #get_bias_weight_decay_multiplier() == val
         !*/
 
+        bool relu_is_enabled(
+        ) const;
+        /*!
+            ensures
+                - returns true if this layer applies f(x)=max(x,0) to its outputs, as
+                  though a relu_ layer came right after it.  fuse_layers() turns this on
+                  when it folds a relu_ layer into this one.  Doing it here is faster
+                  since the outputs are clamped while they are still in cache.
+        !*/
+
+        void enable_relu(
+        );
+        /*!
+            ensures
+                - #relu_is_enabled() == true
+        !*/
+
+        void disable_relu(
+        );
+        /*!
+            ensures
+                - #relu_is_enabled() == false
+        !*/
+
+        bool is_quantized(
+        ) const;
+        /*!
+            ensures
+                - returns true if this layer computes its outputs with 8 bit integer
+                  arithmetic instead of floats.  quantize_layers() turns this on.
+                - When quantized, the filters are rounded as described in tt::int8_weights and the
+                  inputs are rounded using get_quantized_input_min() and
+                  get_quantized_input_max() as their range.  Only the rounded filters are
+                  kept, so get_layer_params() holds just the biases.
+        !*/
+
+        float get_quantized_input_min(
+        ) const;
+        /*!
+            ensures
+                - returns the smallest input value this layer expects when it's quantized.
+        !*/
+
+        float get_quantized_input_max(
+        ) const;
+        /*!
+            ensures
+                - returns the largest input value this layer expects when it's quantized.
+                  Larger inputs are clamped to it.
+        !*/
+
+        void quantize(
+            float input_min,
+            float input_max
+        );
+        /*!
+            requires
+                - input_min <= input_max
+                - get_layer_params().size() != 0, i.e. the layer has been set up.
+            ensures
+                - #is_quantized() == true
+                - #get_quantized_input_min() == input_min
+                - #get_quantized_input_max() == input_max
+                - If the layer was already quantized only the input range changes.
+                  Otherwise the weights are rounded and the float ones are discarded.
+        !*/
+
+        void disable_quantization(
+        );
+        /*!
+            ensures
+                - #is_quantized() == false
+                - If the layer was quantized, get_layer_params() is rebuilt from the
+                  rounded weights.  So the layer doesn't compute exactly what it did
+                  before it was quantized.
+        !*/
+
         template <typename SUBNET> void setup (const SUBNET& sub);
         template <typename SUBNET> void forward(const SUBNET& sub, resizable_tensor& output);
         template <typename SUBNET> void backward(const tensor& gradient_input, SUBNET& sub, tensor& params_grad);
@@ -912,6 +1054,7 @@ namespace dlib
         tensor& get_layer_params(); 
         /*!
             These functions are implemented as described in the EXAMPLE_COMPUTATIONAL_LAYER_ interface.
+            Note that backward() requires relu_is_enabled() == false and is_quantized() == false.
         !*/
 
     };
@@ -1660,6 +1803,7 @@ namespace dlib
         /*!
             ensures
                 - #get_mode() == FC_MODE 
+                - #is_disabled() == false
         !*/
 
         affine_(
@@ -1668,6 +1812,7 @@ namespace dlib
         /*!
             ensures
                 - #get_mode() == mode
+                - #is_disabled() == false
         !*/
 
         template <
@@ -1683,6 +1828,7 @@ namespace dlib
                   finish training a network with bn_ layers because the affine_ layer will
                   execute faster.  
                 - #get_mode() == layer.get_mode()
+                - #is_disabled() == false
         !*/
 
         layer_mode get_mode(
@@ -1692,6 +1838,38 @@ namespace dlib
                 - returns the mode of this layer, either CONV_MODE or FC_MODE.  
         !*/
 
+        alias_tensor_const_instance get_gamma(
+        ) const;
+        /*!
+            ensures
+                - returns the A tensor described above.  If is_disabled() then it's empty.
+        !*/
+
+        alias_tensor_const_instance get_beta(
+        ) const;
+        /*!
+            ensures
+                - returns the B tensor described above.  If is_disabled() then it's empty.
+        !*/
+
+        bool is_disabled(
+        ) const;
+        /*!
+            ensures
+                - returns true if this layer has been disabled.  A disabled layer performs
+                  the identity transformation without touching its input, which is what
+                  fuse_layers() leaves behind once it has folded this layer's
+                  transformation into the preceding con_ layer.
+        !*/
+
+        void disable(
+        );
+        /*!
+            ensures
+                - #is_disabled() == true
+                - Frees the memory used by A and B.
+        !*/
+
         template <typename SUBNET> void setup (const SUBNET& sub);
         void forward_inplace(const tensor& input, tensor& output);
         void backward_inplace(const tensor& computed_output, const tensor& gradient_input, tensor& data_grad, tensor& params_grad);
@@ -2019,6 +2197,26 @@ namespace dlib
 
         relu_(
         );
+        /*!
+            ensures
+                - #is_disabled() == false
+        !*/
+
+        bool is_disabled(
+        ) const;
+        /*!
+            ensures
+                - returns true if this layer has been disabled, in which case it passes its
+                  inputs through unchanged.  fuse_layers() disables the relu_ layers whose
+                  work it moved into the preceding con_ layer.
+        !*/
+
+        void disable(
+        );
+        /*!
+            ensures
+                - #is_disabled() == true
+        !*/
 
         template <typename SUBNET> void setup (const SUBNET& sub);
         void forward_inplace(const tensor& input, tensor& output);
@@ -2037,6 +2235,108 @@ namespace dlib
     template <typename SUBNET>
     using relu = add_layer<relu_, SUBNET>;
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename net_type>
+    void fuse_layers (
+        net_type& net
+    );
+    /*!
+        requires
+            - net_type is an object of type add_layer, add_loss_layer, add_skip_layer, or
+              add_tag_layer.
+        ensures
+            - Folds layers of net into each other so the network does fewer passes over
+              memory when it runs, while computing the same function up to floating point
+              rounding.  In particular:
+                - Each CONV_MODE affine_ layer whose input is a con_ layer is folded into
+                  that con_ layer by scaling its filters and biases.  The affine_ layer is
+                  then disabled.
+                - Each relu_ layer whose input is a con_ layer, or a disabled affine_
+                  layer on top of a con_ layer, is folded into the con_ layer by
+                  enabling its relu (see con_::enable_relu()).  The relu_ layer is then
+                  disabled.
+            - This is meant to be called once on a trained network, e.g. right after
+              deserializing a network whose bn_ layers were converted to affine_ layers.
+              The fused network can be serialized and used as usual, but it can't be
+              trained anymore.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename net_type,
+        typename forward_iterator
+        >
+    void quantize_layers (
+        net_type& net,
+        forward_iterator ibegin,
+        forward_iterator iend
+    );
+    /*!
+        requires
+            - net_type is an object of type add_layer, add_loss_layer, add_skip_layer, or
+              add_tag_layer.
+            - [ibegin, iend) is an iterator range over input_type objects, where
+              input_type is the input type of net.  It must not be empty.
+            - enable_activation_reuse() hasn't been called on net, since the outputs of
+              all the layers are needed.
+        ensures
+            - Makes the con_ and fc_ layers of net compute with 8 bit integers instead of
+              floats, which is faster on a CPU.  This is post training quantization, so
+              it should be called on a trained network, after fuse_layers() if that's
+              used too.
+            - The samples in [ibegin, iend) are a calibration set.  They are run through
+              the float network one at a time, and each con_ and fc_ layer is quantized
+              (see con_::quantize()) with the smallest and largest input it saw as its
+              input range.  So the samples should look like the inputs the network will
+              be used on.  A few dozen are usually enough.
+            - The weights are quantized with one scale per filter or output, so there is
+              no need to calibrate them.  Quantized layers keep only their rounded
+              weights, so their weights take half the memory and a quarter of the space
+              when serialized.
+            - Layers that were already quantized are calibrated as floats again, using
+              their rounded weights.  A layer whose input isn't kept anywhere, i.e. one at
+              the bottom of the block of a repeat layer, stays in float.  So do con_
+              layers with only 1 or 2 filters and con_ layers with 3x3 filters and a
+              stride of 1, since they are faster in float.
+            - The quantized network can be serialized and used as usual, but it can't be
+              trained until disable_quantization() is called on each of its quantized
+              layers.  Use test_quantization() to see how close its outputs are to the
+              float network's.
+    !*/
+
+    template <
+        typename net_type,
+        typename forward_iterator
+        >
+    matrix<double,1,3> test_quantization (
+        net_type& float_net,
+        net_type& quantized_net,
+        forward_iterator ibegin,
+        forward_iterator iend
+    );
+    /*!
+        requires
+            - net_type is an object of type add_layer, add_loss_layer, add_skip_layer, or
+              add_tag_layer.
+            - [ibegin, iend) is an iterator range over input_type objects, where
+              input_type is the input type of net_type.  It must not be empty.
+            - quantized_net is a copy of float_net that has been given to
+              quantize_layers().
+        ensures
+            - Runs the samples in [ibegin, iend) through both networks and compares their
+              outputs.  For a network with a loss layer, the outputs compared are the
+              outputs of the layer below the loss, e.g. the face descriptors of a
+              loss_metric_ network or the detection scores of a loss_mmod_ network.
+            - Let F and Q be the outputs of float_net and quantized_net for one of the
+              samples.  Then this function returns a matrix M such that:
+                - M(0) == the mean over the samples of length(Q-F)/length(F)
+                - M(1) == the largest value of length(Q-F)/length(F)
+                - M(2) == the largest value of max(abs(Q-F))
+              So M(0) is the relative error of the quantized network.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     class prelu_
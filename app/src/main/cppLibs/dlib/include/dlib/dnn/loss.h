@@ -1053,7 +1053,21 @@ namespace dlib
             double adjust_threshold = 0
         ) const
         {
-            const tensor& output_tensor = sub.get_output();
+            to_label(input_tensor, sub, sub.get_output(), iter, adjust_threshold);
+        }
+
+        template <
+            typename SUB_TYPE,
+            typename label_iterator
+            >
+        void to_label (
+            const tensor& input_tensor,
+            const SUB_TYPE& sub,
+            const tensor& output_tensor,
+            label_iterator iter,
+            double adjust_threshold = 0
+        ) const
+        {
             if (options.use_bounding_box_regression)
             {
                 DLIB_CASSERT(output_tensor.k() == (long)options.detector_windows.size()*5);
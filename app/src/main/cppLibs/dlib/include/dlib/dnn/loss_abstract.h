@@ -821,6 +821,27 @@ namespace dlib
                 - R.ignore == false (this value is unused by to_label()).
         !*/
 
+        template <
+            typename SUB_TYPE,
+            typename label_iterator
+            >
+        void to_label (
+            const tensor& input_tensor,
+            const SUB_TYPE& sub,
+            const tensor& output_tensor,
+            label_iterator iter,
+            double adjust_threshold = 0
+        ) const;
+        /*!
+            ensures
+                - This function is identical to to_label(input_tensor, sub, iter,
+                  adjust_threshold) except that output_tensor is used in place of
+                  sub.get_output().  sub is still used to map locations in output_tensor
+                  back to the input image.  This lets the output of a network be computed
+                  some other way, such as in pieces by tiled_detector, and still be turned
+                  into detections the same way.
+        !*/
+
         template <
             typename const_label_iterator,
             typename SUBNET
@@ -0,0 +1,341 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_DNn_TILED_DETECTOR_H_
+#define DLIB_DNn_TILED_DETECTOR_H_
+
+#include "tiled_detector_abstract.h"
+#include "core.h"
+#include "layers.h"
+#include "loss.h"
+#include "../threads/thread_pool_extension.h"
+#include "../threads/parallel_for_extension.h"
+#include <atomic>
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        struct tiling_window
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    The window of one layer along one axis.  Output i of the layer is
+                    computed from inputs i*stride-padding through i*stride-padding+size-1.
+            !*/
+            long size;
+            long stride;
+            long padding;
+        };
+
+        class visitor_tiling_windows
+        {
+        public:
+            visitor_tiling_windows(
+                std::vector<tiling_window>& rows_,
+                std::vector<tiling_window>& cols_
+            ) : rows(rows_), cols(cols_) {}
+
+            template <typename input_layer_type>
+            void operator()(const input_layer_type& )
+            {
+            }
+
+            template <typename T, typename U>
+            void operator()(const add_loss_layer<T,U>& net)
+            {
+                (*this)(net.subnet());
+            }
+
+            template <long nf, long nr, long nc, int sy, int sx, int py, int px, typename U, typename E>
+            void operator()(const add_layer<con_<nf,nr,nc,sy,sx,py,px>,U,E>& net)
+            {
+                static_assert(nr != 0 && nc != 0, "A con_ layer that covers its whole input can't be run in tiles.");
+                (*this)(net.subnet());
+                add(net.layer_details());
+            }
+
+            template <long nr, long nc, int sy, int sx, int py, int px, typename U, typename E>
+            void operator()(const add_layer<max_pool_<nr,nc,sy,sx,py,px>,U,E>& net)
+            {
+                static_assert(nr != 0 && nc != 0, "A max_pool_ layer that covers its whole input can't be run in tiles.");
+                (*this)(net.subnet());
+                add(net.layer_details());
+            }
+
+            template <long nr, long nc, int sy, int sx, int py, int px, typename U, typename E>
+            void operator()(const add_layer<avg_pool_<nr,nc,sy,sx,py,px>,U,E>& net)
+            {
+                static_assert(nr != 0 && nc != 0, "An avg_pool_ layer that covers its whole input can't be run in tiles.");
+                (*this)(net.subnet());
+                add(net.layer_details());
+            }
+
+            // Layers that also read a tagged input, like the ones residual and inception
+            // blocks are made of, would need the windows of both branches.  They map
+            // points like element-wise layers do, so they have to be stopped here or
+            // the other branch would be silently left out.
+            template <template<typename> class tag, typename U, typename E>
+            void operator()(const add_layer<add_prev_<tag>,U,E>& )
+            {
+                static_assert(sizeof(U) != sizeof(U), "An add_prev_ layer can't be run in tiles.");
+            }
+
+            template <template<typename> class tag, typename U, typename E>
+            void operator()(const add_layer<mult_prev_<tag>,U,E>& )
+            {
+                static_assert(sizeof(U) != sizeof(U), "A mult_prev_ layer can't be run in tiles.");
+            }
+
+            template <template<typename> class tag, typename U, typename E>
+            void operator()(const add_layer<scale_<tag>,U,E>& )
+            {
+                static_assert(sizeof(U) != sizeof(U), "A scale_ layer can't be run in tiles.");
+            }
+
+            template <template<typename> class... tags, typename U, typename E>
+            void operator()(const add_layer<concat_<tags...>,U,E>& )
+            {
+                static_assert(sizeof(U) != sizeof(U), "A concat_ layer can't be run in tiles.");
+            }
+
+            template <typename T, typename U, typename E>
+            void operator()(const add_layer<T,U,E>& net)
+            {
+                // Any other layer has to work on each element by itself.
+                DLIB_CASSERT(net.layer_details().map_input_to_output(dpoint(3,5)) == dpoint(3,5),
+                    "Only networks made of con_, max_pool_, avg_pool_, and layers that work element "
+                    "by element can be run in tiles.");
+                (*this)(net.subnet());
+            }
+
+            template <unsigned long ID, typename U, typename E>
+            void operator()(const add_tag_layer<ID,U,E>& net)
+            {
+                (*this)(net.subnet());
+            }
+
+            template <template<typename> class TAG_TYPE, typename U>
+            void operator()(const add_skip_layer<TAG_TYPE,U>& net)
+            {
+                (*this)(layer<TAG_TYPE>(net));
+            }
+
+        private:
+
+            template <typename layer_type>
+            void add(const layer_type& l)
+            {
+                rows.push_back(tiling_window{l.nr(), l.stride_y(), l.padding_y()});
+                cols.push_back(tiling_window{l.nc(), l.stride_x(), l.padding_x()});
+            }
+
+            std::vector<tiling_window>& rows;
+            std::vector<tiling_window>& cols;
+        };
+
+        inline long tiling_output_size (
+            const std::vector<tiling_window>& windows,
+            long size
+        )
+        {
+            for (auto& w : windows)
+                size = 1 + (size + 2*w.padding - w.size)/w.stride;
+            return size;
+        }
+
+        inline long tiling_stride (
+            const std::vector<tiling_window>& windows
+        )
+        {
+            long stride = 1;
+            for (auto& w : windows)
+                stride *= w.stride;
+            return stride;
+        }
+
+        inline void tiling_input_range (
+            const std::vector<tiling_window>& windows,
+            const long input_size,
+            const long first_output,
+            const long last_output,
+            long& first,
+            long& last
+        )
+        /*!
+            ensures
+                - #first and #last are the first and last input needed to compute outputs
+                  first_output through last_output, clipped to the input.  #first is a
+                  multiple of twice the stride of the network.  So every layer sees its
+                  part of the tile at an even offset from where it would on the whole
+                  input, and layers that make their outputs 2x2 at a time, like the
+                  Winograd convolution, group them the same way.
+        !*/
+        {
+            long a = first_output;
+            long b = last_output;
+            for (auto i = windows.rbegin(); i != windows.rend(); ++i)
+            {
+                a = a*i->stride - i->padding;
+                b = b*i->stride - i->padding + i->size - 1;
+            }
+            const long align = 2*tiling_stride(windows);
+            first = std::max(0L, a)/align*align;
+            last = std::min(input_size-1, b);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename net_type>
+    class tiled_detector
+    {
+    public:
+
+        typedef typename net_type::input_type input_type;
+        typedef typename net_type::output_label_type output_label_type;
+
+        explicit tiled_detector (
+            const net_type& net,
+            long tile_size_ = 1024
+        ) : tile_size(tile_size_)
+        {
+            DLIB_CASSERT(tile_size > 0);
+            nets.push_back(net);
+            impl::visitor_tiling_windows visitor(row_windows, col_windows);
+            visitor(nets[0]);
+        }
+
+        const net_type& get_net (
+        ) const { return nets[0]; }
+
+        long get_tile_size (
+        ) const { return tile_size; }
+
+        void set_tile_size (
+            long size
+        )
+        {
+            DLIB_CASSERT(size > 0);
+            tile_size = size;
+        }
+
+        output_label_type operator() (
+            const input_type& img,
+            thread_pool& tp,
+            double adjust_threshold = 0
+        )
+        {
+            nets[0].to_tensor(&img, &img+1, x);
+
+            const long out_nr = impl::tiling_output_size(row_windows, x.nr());
+            const long out_nc = impl::tiling_output_size(col_windows, x.nc());
+            const long stride_y = impl::tiling_stride(row_windows);
+            const long stride_x = impl::tiling_stride(col_windows);
+            DLIB_CASSERT(out_nr > 0 && out_nc > 0, "The image is too small for the network.");
+
+            // Each tile is a block of outputs, which is computed from the part of the
+            // input it needs, so the tiles overlap in the input but not in the output.
+            const long tile_nr = std::max(1L, tile_size/stride_y);
+            const long tile_nc = std::max(1L, tile_size/stride_x);
+            const long tiles_y = (out_nr+tile_nr-1)/tile_nr;
+            const long tiles_x = (out_nc+tile_nc-1)/tile_nc;
+            const long num_tiles = tiles_y*tiles_x;
+            tile_outputs.resize(num_tiles);
+
+            const long num_workers = std::max(1L, std::min<long>(num_tiles, tp.num_threads_in_pool()));
+            while ((long)nets.size() < num_workers)
+                nets.push_back(nets[0]);
+            tile_inputs.resize(num_workers);
+
+            // Read x through a const pointer taken up front.  The non-const host() marks
+            // the tensor as changed, which the workers mustn't all do at once.
+            const float* const src = static_cast<const tensor&>(x).host();
+            std::atomic<long> next_tile(0);
+            parallel_for(tp, 0, num_workers, [&](long worker)
+            {
+                for (long t = next_tile++; t < num_tiles; t = next_tile++)
+                {
+                    const long r0 = (t/tiles_x)*tile_nr;
+                    const long c0 = (t%tiles_x)*tile_nc;
+                    const long r1 = std::min(out_nr, r0+tile_nr)-1;
+                    const long c1 = std::min(out_nc, c0+tile_nc)-1;
+                    long top, bottom, left, right;
+                    impl::tiling_input_range(row_windows, x.nr(), r0, r1, top, bottom);
+                    impl::tiling_input_range(col_windows, x.nc(), c0, c1, left, right);
+
+                    resizable_tensor& in = tile_inputs[worker];
+                    in.set_size(1, x.k(), bottom-top+1, right-left+1);
+                    float* dest = in.host_write_only();
+                    for (long k = 0; k < x.k(); ++k)
+                    {
+                        for (long r = top; r <= bottom; ++r)
+                        {
+                            const float* s = src + (k*x.nr() + r)*x.nc() + left;
+                            dest = std::copy(s, s+in.nc(), dest);
+                        }
+                    }
+
+                    const tensor& out = nets[worker].subnet().forward(in);
+                    const long out_r0 = r0 - top/stride_y;
+                    const long out_c0 = c0 - left/stride_x;
+                    DLIB_CASSERT(out.num_samples() == 1 &&
+                                 out_r0 + r1-r0 < out.nr() && out_c0 + c1-c0 < out.nc());
+
+                    resizable_tensor& result = tile_outputs[t];
+                    result.set_size(1, out.k(), r1-r0+1, c1-c0+1);
+                    const float* o = out.host();
+                    float* d = result.host_write_only();
+                    for (long k = 0; k < out.k(); ++k)
+                    {
+                        for (long r = 0; r < result.nr(); ++r)
+                        {
+                            const float* s = o + (k*out.nr() + out_r0+r)*out.nc() + out_c0;
+                            d = std::copy(s, s+result.nc(), d);
+                        }
+                    }
+                }
+            });
+
+            output.set_size(1, tile_outputs[0].k(), out_nr, out_nc);
+            float* const out = output.host_write_only();
+            for (long t = 0; t < num_tiles; ++t)
+            {
+                const long r0 = (t/tiles_x)*tile_nr;
+                const long c0 = (t%tiles_x)*tile_nc;
+                const tensor& result = tile_outputs[t];
+                const float* s = result.host();
+                for (long k = 0; k < result.k(); ++k)
+                {
+                    for (long r = 0; r < result.nr(); ++r, s += result.nc())
+                        std::copy(s, s+result.nc(), out + (k*out_nr + r0+r)*out_nc + c0);
+                }
+            }
+
+            const net_type& net = nets[0];
+            output_label_type dets;
+            net.loss_details().to_label(x, net.subnet(), output, &dets, adjust_threshold);
+            return dets;
+        }
+
+    private:
+
+        long tile_size;
+        std::vector<net_type> nets;
+        std::vector<impl::tiling_window> row_windows;
+        std::vector<impl::tiling_window> col_windows;
+
+        resizable_tensor x;
+        resizable_tensor output;
+        std::vector<resizable_tensor> tile_inputs;
+        std::vector<resizable_tensor> tile_outputs;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_DNn_TILED_DETECTOR_H_
+
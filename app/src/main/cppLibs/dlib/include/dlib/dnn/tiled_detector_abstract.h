@@ -0,0 +1,129 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_DNn_TILED_DETECTOR_ABSTRACT_H_
+#ifdef DLIB_DNn_TILED_DETECTOR_ABSTRACT_H_
+
+#include "core_abstract.h"
+#include "loss_abstract.h"
+#include "../threads/thread_pool_extension_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename net_type>
+    class tiled_detector
+    {
+        /*!
+            REQUIREMENTS ON net_type
+                - net_type is an add_loss_layer object that uses loss_mmod_, for example
+                  the face detector in dnn_mmod_face_detection_ex.cpp.
+                - Every layer of net_type is a con_, max_pool_, or avg_pool_ layer with a
+                  nonzero filter size, or a layer that works on each element of its input
+                  by itself (e.g. relu_, affine_, bn_), or a tag or skip layer.  So layers
+                  that combine their input with a tagged one, like add_prev_, mult_prev_,
+                  scale_ and concat_, can't be used, and neither can residual blocks made
+                  from them.  Using one is a compile time error.
+
+            WHAT THIS OBJECT REPRESENTS
+                This object runs an MMOD detector on one image by cutting the network's
+                output into tiles and computing each tile from just the part of the
+                input tensor it needs.  The tiles are run in parallel on a thread_pool,
+                each on its own copy of the network, and their outputs are put back
+                together and given to loss_mmod_, which finds the detections and does
+                non-max suppression over the whole image as usual.
+
+                Each tile is given all the input its outputs depend on, so the
+                detections are the same as those of calling the network on the whole
+                image.  That input includes a border of about half the network's
+                receptive field around the tile, which is computed once for each tile
+                it falls in.  So smaller tiles fit better in the CPU cache but do more
+                redundant work.  The face detector in dnn_mmod_face_detection_ex.cpp sees
+                about 190 pixels around each output, and with the default tile size of 1024
+                pixels it does about 10% more work on a 640x480 image than it does on the
+                whole image at once.
+
+                This object is meant for big images, such as the packed pyramid that
+                input_rgb_image_pyramid makes from a camera frame.
+
+            THREAD SAFETY
+                Each tiled_detector holds the copies of the network it runs and scratch
+                space for the tiles, so a tiled_detector must not be used by more than
+                one thread at a time.
+        !*/
+
+    public:
+
+        typedef typename net_type::input_type input_type;
+        typedef typename net_type::output_label_type output_label_type;
+
+        explicit tiled_detector (
+            const net_type& net,
+            long tile_size = 1024
+        );
+        /*!
+            requires
+                - tile_size > 0
+            ensures
+                - #get_net() == a copy of net
+                - #get_tile_size() == tile_size
+        !*/
+
+        const net_type& get_net (
+        ) const;
+        /*!
+            ensures
+                - returns the network this object runs.
+        !*/
+
+        long get_tile_size (
+        ) const;
+        /*!
+            ensures
+                - returns the size of each tile, in pixels of the input tensor.  This is
+                  the size of the part of the input a tile makes outputs for, not counting
+                  the border of extra input it needs.  The tiles used are this size
+                  rounded down to a multiple of the network's stride, and are at least
+                  one output in size.
+        !*/
+
+        void set_tile_size (
+            long size
+        );
+        /*!
+            requires
+                - size > 0
+            ensures
+                - #get_tile_size() == size
+        !*/
+
+        output_label_type operator() (
+            const input_type& img,
+            thread_pool& tp,
+            double adjust_threshold = 0
+        );
+        /*!
+            requires
+                - The network's output for img is at least 1x1.
+            ensures
+                - Runs the network on img, with the tiles spread over the threads in tp,
+                  and returns the detections.  This is the same as
+                  get_net().loss_details().to_label() on the output of the whole image,
+                  i.e. the same as calling get_net() on img with the given
+                  adjust_threshold.
+                - Makes up to tp.num_threads_in_pool() copies of the network the first
+                  time they are needed and keeps them for later calls.  If tp has no
+                  threads all the tiles are run in the calling thread.
+                - The layers already run their own loops on default_thread_pool().  Those
+                  loops run inline when called from one of that pool's threads, so
+                  passing default_thread_pool() as tp avoids running more threads than
+                  there are cores.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_DNn_TILED_DETECTOR_ABSTRACT_H_
+
@@ -21,7 +21,11 @@
 #include "image_processing/scan_fhog_pyramid.h"
 #include "image_processing/shape_predictor.h"
 #include "image_processing/shape_predictor_trainer.h"
+#include "image_processing/shape_predictor_pruning.h"
 #include "image_processing/correlation_tracker.h"
+#include "image_processing/multi_target_tracker.h"
+#include "image_processing/incremental_object_detector.h"
+#include "image_processing/fhog_cascade.h"
 
 #endif // DLIB_IMAGE_PROCESSInG_H_h_
 
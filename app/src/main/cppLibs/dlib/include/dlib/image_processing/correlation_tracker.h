@@ -33,7 +33,9 @@ namespace dlib
             scale_window_size(scale_window_size),
             regularizer_space(regularizer_space), nu_space(nu_space), 
             regularizer_scale(regularizer_scale), nu_scale(nu_scale),
-            scale_pyramid_alpha(scale_pyramid_alpha)
+            scale_pyramid_alpha(scale_pyramid_alpha),
+            space_plan(this->filter_size, this->filter_size),
+            scale_plan(1, this->num_scale_levels)
         {
             // Create the cosine mask used for space filtering.
             mask = make_cosine_mask();
@@ -62,9 +64,10 @@ namespace dlib
 
             B.set_size(0,0);
 
-            point_transform_affine tform = inv(make_chip(img, p, F));
+            point_transform_affine tform = inv(make_chip(img, p, planes));
+            F.resize(planes.size());
             for (unsigned long i = 0; i < F.size(); ++i)
-                fft_inplace(F[i]);
+                space_plan.fftr(planes[i], F[i]);
             make_target_location_image(tform(center(p)), G);
             A.resize(F.size());
             for (unsigned long i = 0; i < F.size(); ++i)
@@ -76,11 +79,12 @@ namespace dlib
             position = p;
 
             // now do the scale space stuff
-            make_scale_space(img, Fs);
+            make_scale_space(img, planes);
+            Fs.resize(planes.size());
             for (unsigned long i = 0; i < Fs.size(); ++i)
-                fft_inplace(Fs[i]);
+                scale_plan.fftr(planes[i], Fs[i]);
             make_scale_target_location_image(get_num_scale_levels()/2, Gs);
-            Bs.set_size(0);
+            Bs.set_size(0,0);
             As.resize(Fs.size());
             for (unsigned long i = 0; i < Fs.size(); ++i)
             {
@@ -131,43 +135,44 @@ namespace dlib
             );
 
 
-            const point_transform_affine tform = make_chip(img, guess, F);
+            const point_transform_affine tform = make_chip(img, guess, planes);
             for (unsigned long i = 0; i < F.size(); ++i)
-                fft_inplace(F[i]);
+                space_plan.fftr(planes[i], F[i]);
 
             // use the current filter to predict the object's location
             G = 0;
             for (unsigned long i = 0; i < F.size(); ++i)
                 G += pointwise_multiply(F[i],conj(A[i]));
-            G = pointwise_multiply(G, reciprocal(B+get_regularizer_space()));
-            ifft_inplace(G);
-            const dlib::vector<double,2> pp = max_point_interpolated(real(G));
+            G = pointwise_multiply(G, reciprocal(B+(float)get_regularizer_space()));
+            space_plan.ifftr(G, response);
+            const dlib::vector<double,2> pp = max_point_interpolated(response);
 
 
             // Compute the peak to side lobe ratio.
             const point p = pp;
             running_stats<double> rs;
             const rectangle peak = centered_rect(p, 8,8);
-            for (long r = 0; r < G.nr(); ++r)
+            for (long r = 0; r < response.nr(); ++r)
             {
-                for (long c = 0; c < G.nc(); ++c)
+                for (long c = 0; c < response.nc(); ++c)
                 {
                     if (!peak.contains(point(c,r)))
-                        rs.add(G(r,c).real());
+                        rs.add(response(r,c));
                 }
             }
-            const double psr = (G(p.y(),p.x()).real()-rs.mean())/rs.stddev();
+            const double psr = (response(p.y(),p.x())-rs.mean())/rs.stddev();
 
             // update the position of the object
             position = translate_rect(guess, tform(pp)-center(guess));
 
             // now update the position filters
             make_target_location_image(pp, G);
-            B *= (1-get_nu_space());
+            const float nu = get_nu_space();
+            B *= (1-nu);
             for (unsigned long i = 0; i < F.size(); ++i)
             {
-                A[i] = get_nu_space()*pointwise_multiply(G, F[i]) + (1-get_nu_space())*A[i];
-                B += get_nu_space()*(squared(real(F[i]))+squared(imag(F[i])));
+                A[i] = nu*pointwise_multiply(G, F[i]) + (1-nu)*A[i];
+                B += nu*(squared(real(F[i]))+squared(imag(F[i])));
             }
 
             return psr;
@@ -182,15 +187,15 @@ namespace dlib
             double psr = update_noscale(img, guess);
 
             // Now predict the scale change
-            make_scale_space(img, Fs);
+            make_scale_space(img, planes);
             for (unsigned long i = 0; i < Fs.size(); ++i)
-                fft_inplace(Fs[i]);
+                scale_plan.fftr(planes[i], Fs[i]);
             Gs = 0;
             for (unsigned long i = 0; i < Fs.size(); ++i)
                 Gs += pointwise_multiply(Fs[i],conj(As[i]));
-            Gs = pointwise_multiply(Gs, reciprocal(Bs+get_regularizer_scale()));
-            ifft_inplace(Gs);
-            const double pos = max_point_interpolated(real(Gs)).y();
+            Gs = pointwise_multiply(Gs, reciprocal(Bs+(float)get_regularizer_scale()));
+            scale_plan.ifftr(Gs, response);
+            const double pos = max_point_interpolated(response).x();
 
             // update the rectangle's scale
             position *= std::pow(get_scale_pyramid_alpha(), pos-(double)get_num_scale_levels()/2);
@@ -199,11 +204,12 @@ namespace dlib
 
             // Now update the scale filters
             make_scale_target_location_image(pos, Gs);
-            Bs *= (1-get_nu_scale());
+            const float nu = get_nu_scale();
+            Bs *= (1-nu);
             for (unsigned long i = 0; i < Fs.size(); ++i)
             {
-                As[i] = get_nu_scale()*pointwise_multiply(Gs, Fs[i]) + (1-get_nu_scale())*As[i];
-                Bs += get_nu_scale()*(squared(real(Fs[i]))+squared(imag(Fs[i])));
+                As[i] = nu*pointwise_multiply(Gs, Fs[i]) + (1-nu)*As[i];
+                Bs += nu*(squared(real(Fs[i]))+squared(imag(Fs[i])));
             }
 
 
@@ -231,7 +237,7 @@ namespace dlib
         template <typename image_type>
         void make_scale_space(
             const image_type& img,
-            std::vector<matrix<std::complex<double>,0,1> >& Fs
+            std::vector<matrix<float> >& Fs
         ) const
         {
             typedef typename image_traits<image_type>::pixel_type pixel_type;
@@ -271,7 +277,8 @@ namespace dlib
             }
 
             // Now copy the hog features into the Fs outputs and also apply the cosine
-            // windowing.
+            // windowing.  Each output is a row vector so it can be transformed with
+            // scale_plan.
             Fs.resize(hogs[0].size()*hogs[0][0].size());
             unsigned long i = 0; 
             for (long r = 0; r < hogs[0][0].nr(); ++r)
@@ -280,7 +287,7 @@ namespace dlib
                 {
                     for (unsigned long j = 0; j < hogs[0].size(); ++j)
                     {
-                        Fs[i].set_size(hogs.size());
+                        Fs[i].set_size(1,hogs.size());
                         for (unsigned long k = 0; k < hogs.size(); ++k)
                         {
                             Fs[i](k) = hogs[k][j][r][c]*scale_cos_mask[k];
@@ -295,7 +302,7 @@ namespace dlib
         point_transform_affine make_chip (
             const image_type& img,
             drectangle p,
-            std::vector<matrix<std::complex<double> > >& chip
+            std::vector<matrix<float> >& chip
         ) const
         {
             typedef typename image_traits<image_type>::pixel_type pixel_type;
@@ -309,55 +316,55 @@ namespace dlib
             dlib::array<array2d<float> > hog;
             extract_fhog_features(temp, hog, 1, 3,3 );
             for (unsigned long i = 0; i < hog.size(); ++i)
-                assign_image(chip[i], pointwise_multiply(matrix_cast<double>(mat(hog[i])), mask));
+                chip[i] = pointwise_multiply(mat(hog[i]), mask);
 
             assign_image(chip[31], temp);
-            assign_image(chip[31], pointwise_multiply(mat(chip[31]), mask)/255.0);
+            chip[31] = pointwise_multiply(chip[31], mask)/255.0f;
 
             return inv(get_mapping_to_chip(details));
         }
 
         void make_target_location_image (
             const dlib::vector<double,2>& p,
-            matrix<std::complex<double> >& g
-        ) const
+            matrix<std::complex<float> >& g
+        )
         {
-            g.set_size(get_filter_size(), get_filter_size());
-            g = 0;
-            rectangle area = centered_rect(p, 21,21).intersect(get_rect(g));
+            response.set_size(get_filter_size(), get_filter_size());
+            response = 0;
+            rectangle area = centered_rect(p, 21,21).intersect(get_rect(response));
             for (long r = area.top(); r <= area.bottom(); ++r)
             {
                 for (long c = area.left(); c <= area.right(); ++c)
                 {
                     double dist = length(point(c,r)-p);
-                    g(r,c) = std::exp(-dist/3.0);
+                    response(r,c) = std::exp(-dist/3.0);
                 }
             }
-            fft_inplace(g);
+            space_plan.fftr(response, g);
             g = conj(g);
         }
 
 
         void make_scale_target_location_image (
             const double scale,
-            matrix<std::complex<double>,0,1>& g
-        ) const
+            matrix<std::complex<float> >& g
+        )
         {
-            g.set_size(get_num_scale_levels());
-            for (long i = 0; i < g.size(); ++i)
+            response.set_size(1, get_num_scale_levels());
+            for (long i = 0; i < response.size(); ++i)
             {
                 double dist = std::pow((i-scale),2.0);
-                g(i) = std::exp(-dist/1.000);
+                response(i) = std::exp(-dist/1.000);
             }
-            fft_inplace(g);
+            scale_plan.fftr(response, g);
             g = conj(g);
         }
 
-        matrix<double> make_cosine_mask (
+        matrix<float> make_cosine_mask (
         ) const
         {
             const long size = get_filter_size();
-            matrix<double> temp(size,size);
+            matrix<float> temp(size,size);
             point cent = center(get_rect(temp));
             for (long r = 0; r < temp.nr(); ++r)
             {
@@ -374,20 +381,25 @@ namespace dlib
         }
 
 
-        std::vector<matrix<std::complex<double> > > A, F;
-        matrix<double> B;
+        // The filters and features are kept in the frequency domain.  Since they are
+        // transforms of real images only the left filter_size/2+1 columns are stored,
+        // and the scale space ones are 1 by num_scale_levels/2+1 row vectors.
+        std::vector<matrix<std::complex<float> > > A, F;
+        matrix<float> B;
 
-        std::vector<matrix<std::complex<double>,0,1> > As, Fs;
-        matrix<double,0,1> Bs;
+        std::vector<matrix<std::complex<float> > > As, Fs;
+        matrix<float> Bs;
         drectangle position;
 
-        matrix<double> mask;
+        matrix<float> mask;
         std::vector<double> scale_cos_mask;
 
-        // G and Gs do not logically contribute to the state of this object.  They are
-        // here just so we can void reallocating them over and over.
-        matrix<std::complex<double> > G;
-        matrix<std::complex<double>,0,1> Gs;
+        // G, Gs, planes, and response do not logically contribute to the state of this
+        // object.  They are here just so we can void reallocating them over and over.
+        matrix<std::complex<float> > G;
+        matrix<std::complex<float> > Gs;
+        std::vector<matrix<float> > planes;
+        matrix<float> response;
 
         unsigned long filter_size;
         unsigned long num_scale_levels;
@@ -397,6 +409,9 @@ namespace dlib
         double regularizer_scale;
         double nu_scale;
         double scale_pyramid_alpha;
+
+        real_fft_plan<float> space_plan;
+        real_fft_plan<float> scale_plan;
     };
 }
 
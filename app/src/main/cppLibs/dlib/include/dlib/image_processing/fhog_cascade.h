@@ -0,0 +1,451 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_FHOG_CASCADE_H_
+#define DLIB_FHOG_CASCADE_H_
+
+#include "fhog_cascade_abstract.h"
+#include "scan_fhog_pyramid.h"
+#include "object_detector.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct fhog_cascade_report
+    {
+        unsigned long num_images = 0;
+        unsigned long num_positive_windows = 0;
+        double fraction_of_windows_scored = 1;
+        double seconds_per_image_without_cascade = 0;
+        double seconds_per_image_with_cascade = 0;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename Feature_extractor_type = default_fhog_feature_extractor
+        >
+    class cascaded_fhog_detector
+    {
+    public:
+
+        typedef Pyramid_type pyramid_type;
+        typedef Feature_extractor_type feature_extractor_type;
+        typedef scan_fhog_pyramid<pyramid_type,feature_extractor_type> scanner_type;
+        typedef object_detector<scanner_type> detector_type;
+
+        cascaded_fhog_detector (
+        ) : num_stage_components(0) {}
+
+        explicit cascaded_fhog_detector (
+            const detector_type& detector_,
+            unsigned long num_stage_components_ = 8
+        ) :
+            detector(detector_),
+            num_stage_components(num_stage_components_)
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(num_stage_components_ > 0,
+                "\t cascaded_fhog_detector::cascaded_fhog_detector()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t num_stage_components_: " << num_stage_components_
+                << "\n\t this: " << this
+                );
+
+            init();
+        }
+
+        cascaded_fhog_detector (
+            const cascaded_fhog_detector& item
+        ) :
+            detector(item.detector),
+            num_stage_components(item.num_stage_components),
+            banks(item.banks)
+        {
+            scanner.copy_configuration(item.scanner);
+        }
+
+        cascaded_fhog_detector& operator= (
+            const cascaded_fhog_detector& item
+        )
+        {
+            if (this == &item)
+                return *this;
+
+            detector = item.detector;
+            num_stage_components = item.num_stage_components;
+            banks = item.banks;
+            scanner.copy_configuration(item.scanner);
+            return *this;
+        }
+
+        const detector_type& get_detector (
+        ) const { return detector; }
+
+        unsigned long num_detectors (
+        ) const { return detector.num_detectors(); }
+
+        unsigned long get_num_stage_components (
+        ) const { return num_stage_components; }
+
+        double get_rejection_threshold (
+            unsigned long idx
+        ) const
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(idx < num_detectors(),
+                "\t double cascaded_fhog_detector::get_rejection_threshold()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t idx:             " << idx
+                << "\n\t num_detectors(): " << num_detectors()
+                << "\n\t this: " << this
+                );
+
+            return banks[idx].get_rejection_threshold();
+        }
+
+        void set_rejection_threshold (
+            unsigned long idx,
+            double thresh
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(idx < num_detectors(),
+                "\t void cascaded_fhog_detector::set_rejection_threshold()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t idx:             " << idx
+                << "\n\t num_detectors(): " << num_detectors()
+                << "\n\t this: " << this
+                );
+
+            banks[idx].set_cascade(num_stage_components, thresh);
+        }
+
+        void disable_cascade (
+        )
+        {
+            for (unsigned long d = 0; d < banks.size(); ++d)
+                banks[d].set_cascade(num_stage_components, -std::numeric_limits<double>::infinity());
+        }
+
+        template <
+            typename image_array_type
+            >
+        fhog_cascade_report calibrate (
+            const image_array_type& images,
+            const double adjust_threshold = 0,
+            const double margin = 0
+        );
+
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<rect_detection>& dets,
+            const double adjust_threshold = 0
+        );
+
+        template <
+            typename image_type
+            >
+        std::vector<rectangle> operator() (
+            const image_type& img,
+            const double adjust_threshold = 0
+        )
+        {
+            std::vector<rect_detection> dets;
+            (*this)(img, dets, adjust_threshold);
+
+            std::vector<rectangle> final_dets(dets.size());
+            for (unsigned long i = 0; i < dets.size(); ++i)
+                final_dets[i] = dets[i].rect;
+            return final_dets;
+        }
+
+        template <typename T, typename U>
+        friend void serialize (
+            const cascaded_fhog_detector<T,U>& item,
+            std::ostream& out
+        );
+
+        template <typename T, typename U>
+        friend void deserialize (
+            cascaded_fhog_detector<T,U>& item,
+            std::istream& in
+        );
+
+    private:
+
+        typedef typename scanner_type::fhog_filterbank fhog_filterbank;
+
+        void init (
+        )
+        {
+            scanner.copy_configuration(detector.get_scanner());
+            banks.clear();
+            for (unsigned long d = 0; d < detector.num_detectors(); ++d)
+                banks.push_back(detector.get_processed_w(d).get_detect_argument());
+            disable_cascade();
+        }
+
+        double get_detection_threshold (
+            unsigned long idx
+        ) const { return detector.get_processed_w(idx).w(scanner.get_num_dimensions()); }
+
+        template <
+            typename image_type
+            >
+        void make_fhog_pyramid (
+            const image_type& img,
+            array<array<array2d<float> > >& feats
+        ) const
+        {
+            impl::create_fhog_pyramid<pyramid_type>(img, scanner.get_feature_extractor(), feats,
+                scanner.get_cell_size(), scanner.get_fhog_window_height(),
+                scanner.get_fhog_window_width(), scanner.get_min_pyramid_layer_width(),
+                scanner.get_min_pyramid_layer_height(), scanner.get_max_pyramid_levels());
+        }
+
+        detector_type detector;
+        unsigned long num_stage_components;
+        // The filters of each of detector's weight vectors, set up to run as a cascade
+        // by scanner.
+        std::vector<fhog_filterbank> banks;
+        scanner_type scanner;
+
+        // Reused by operator() so that repeated calls don't allocate.
+        std::vector<std::pair<double, rectangle> > temp_dets;
+        std::vector<rect_detection> temp_dets_accum;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename T, typename U>
+    void serialize (
+        const cascaded_fhog_detector<T,U>& item,
+        std::ostream& out
+    )
+    {
+        int version = 1;
+        serialize(version, out);
+        serialize(item.detector, out);
+        serialize(item.num_stage_components, out);
+        std::vector<double> thresholds;
+        for (unsigned long d = 0; d < item.num_detectors(); ++d)
+            thresholds.push_back(item.get_rejection_threshold(d));
+        serialize(thresholds, out);
+    }
+
+    template <typename T, typename U>
+    void deserialize (
+        cascaded_fhog_detector<T,U>& item,
+        std::istream& in
+    )
+    {
+        int version = 0;
+        deserialize(version, in);
+        if (version != 1)
+            throw serialization_error("Unexpected version encountered while deserializing a dlib::cascaded_fhog_detector object.");
+
+        deserialize(item.detector, in);
+        deserialize(item.num_stage_components, in);
+        if (item.num_stage_components == 0 && item.num_detectors() != 0)
+            throw serialization_error("A dlib::cascaded_fhog_detector object can't have cascade stages without any filters.");
+        item.init();
+        std::vector<double> thresholds;
+        deserialize(thresholds, in);
+        if (thresholds.size() != item.num_detectors())
+            throw serialization_error("The number of rejection thresholds doesn't match the detector while deserializing a dlib::cascaded_fhog_detector object.");
+        for (unsigned long d = 0; d < thresholds.size(); ++d)
+            item.set_rejection_threshold(d, thresholds[d]);
+    }
+
+// ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+//                      cascaded_fhog_detector member functions
+// ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename Feature_extractor_type
+        >
+    template <
+        typename image_type
+        >
+    void cascaded_fhog_detector<Pyramid_type,Feature_extractor_type>::
+    operator() (
+        const image_type& img,
+        std::vector<rect_detection>& final_dets,
+        const double adjust_threshold
+    )
+    {
+        scanner.load(img);
+        std::vector<std::pair<double, rectangle> >& dets = temp_dets;
+        std::vector<rect_detection>& dets_accum = temp_dets_accum;
+        dets_accum.clear();
+        for (unsigned long d = 0; d < banks.size(); ++d)
+        {
+            const double thresh = get_detection_threshold(d);
+            scanner.detect(banks[d], dets, thresh + adjust_threshold);
+            for (unsigned long j = 0; j < dets.size(); ++j)
+            {
+                rect_detection temp;
+                temp.detection_confidence = dets[j].first-thresh;
+                temp.weight_index = d;
+                temp.rect = dets[j].second;
+                dets_accum.push_back(temp);
+            }
+        }
+
+        // Do non-max suppression the same way object_detector does.
+        final_dets.clear();
+        if (banks.size() > 1)
+            std::sort(dets_accum.rbegin(), dets_accum.rend());
+        const test_box_overlap& boxes_overlap = detector.get_overlap_tester();
+        for (unsigned long i = 0; i < dets_accum.size(); ++i)
+        {
+            bool overlaps = false;
+            for (unsigned long j = 0; j < final_dets.size() && !overlaps; ++j)
+                overlaps = boxes_overlap(final_dets[j].rect, dets_accum[i].rect);
+            if (!overlaps)
+                final_dets.push_back(dets_accum[i]);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename Feature_extractor_type
+        >
+    template <
+        typename image_array_type
+        >
+    fhog_cascade_report cascaded_fhog_detector<Pyramid_type,Feature_extractor_type>::
+    calibrate (
+        const image_array_type& images,
+        const double adjust_threshold,
+        const double margin
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(num_detectors() > 0 && margin >= 0,
+            "\t fhog_cascade_report cascaded_fhog_detector::calibrate()"
+            << "\n\t Invalid inputs were given to this function "
+            << "\n\t num_detectors(): " << num_detectors()
+            << "\n\t margin:          " << margin
+            << "\n\t this: " << this
+            );
+
+        using namespace std::chrono;
+        fhog_cascade_report report;
+        report.num_images = images.size();
+
+        // Find the lowest cheap stage score of any window the full filters accept.  Any
+        // rejection threshold at or below it keeps all of them.  The full scores come
+        // from filtering whole pyramid levels, like get_detector() does, and the scanner
+        // computes bit for bit the same scores for the windows the stage lets through.
+        // So no rounding slack is needed.
+        disable_cascade();
+        std::vector<double> lowest(num_detectors(), std::numeric_limits<double>::infinity());
+        array<array<array2d<float> > > feats;
+        array2d<float> saliency_image, stage_saliency, scratch;
+        for (unsigned long i = 0; i < images.size(); ++i)
+        {
+            make_fhog_pyramid(images[i], feats);
+            for (unsigned long d = 0; d < num_detectors(); ++d)
+            {
+                const double thresh = get_detection_threshold(d) + adjust_threshold;
+                for (unsigned long l = 0; l < feats.size(); ++l)
+                {
+                    if (feats[l][0].size() == 0 || banks[d].get_num_cascade_components() == 0)
+                        continue;
+                    const rectangle area = impl::apply_filters_to_fhog(banks[d], feats[l], saliency_image, scratch);
+                    impl::apply_fhog_cascade_stage(banks[d], feats[l], stage_saliency, scratch);
+                    for (long r = area.top(); r <= area.bottom(); ++r)
+                    {
+                        for (long c = area.left(); c <= area.right(); ++c)
+                        {
+                            if (saliency_image[r][c] >= thresh)
+                            {
+                                ++report.num_positive_windows;
+                                lowest[d] = std::min<double>(lowest[d], stage_saliency[r][c]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Detectors that never fired on the validation images keep scoring every window
+        // since we know nothing about where to cut them.
+        for (unsigned long d = 0; d < num_detectors(); ++d)
+        {
+            if (lowest[d] != std::numeric_limits<double>::infinity())
+                set_rejection_threshold(d, lowest[d] - margin);
+        }
+
+        // Count the windows the calibrated stage lets through.
+        unsigned long num_windows = 0, num_passing = 0;
+        for (unsigned long i = 0; i < images.size(); ++i)
+        {
+            make_fhog_pyramid(images[i], feats);
+            for (unsigned long d = 0; d < num_detectors(); ++d)
+            {
+                for (unsigned long l = 0; l < feats.size(); ++l)
+                {
+                    if (feats[l][0].size() == 0 || banks[d].get_num_cascade_components() == 0)
+                        continue;
+                    const rectangle area = impl::apply_fhog_cascade_stage(banks[d], feats[l], stage_saliency, scratch);
+                    num_windows += area.area();
+                    for (long r = area.top(); r <= area.bottom(); ++r)
+                    {
+                        for (long c = area.left(); c <= area.right(); ++c)
+                        {
+                            if (stage_saliency[r][c] >= banks[d].get_rejection_threshold())
+                                ++num_passing;
+                        }
+                    }
+                }
+            }
+        }
+        if (num_windows != 0)
+            report.fraction_of_windows_scored = (double)num_passing/num_windows;
+
+        // Finally, measure what the cascade buys us on the same images, at the threshold
+        // it was calibrated for.  Both run once beforehand so that neither is timed while
+        // allocating its buffers.
+        detector_type plain(detector);
+        std::vector<rect_detection> dets;
+        if (images.size() != 0)
+        {
+            plain(images[0], dets, adjust_threshold);
+            (*this)(images[0], dets, adjust_threshold);
+        }
+        const auto start = steady_clock::now();
+        for (unsigned long i = 0; i < images.size(); ++i)
+            plain(images[i], dets, adjust_threshold);
+        const auto middle = steady_clock::now();
+        for (unsigned long i = 0; i < images.size(); ++i)
+            (*this)(images[i], dets, adjust_threshold);
+        const auto stop = steady_clock::now();
+
+        if (images.size() != 0)
+        {
+            report.seconds_per_image_without_cascade = duration_cast<duration<double> >(middle-start).count()/images.size();
+            report.seconds_per_image_with_cascade = duration_cast<duration<double> >(stop-middle).count()/images.size();
+        }
+        return report;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_FHOG_CASCADE_H_
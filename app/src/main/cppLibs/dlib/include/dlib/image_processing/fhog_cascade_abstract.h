@@ -0,0 +1,244 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_FHOG_CASCADE_ABSTRACT_H_
+#ifdef DLIB_FHOG_CASCADE_ABSTRACT_H_
+
+#include "object_detector_abstract.h"
+#include "scan_fhog_pyramid_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct fhog_cascade_report
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is what cascaded_fhog_detector::calibrate() returns.  It says
+                how the calibration images were scored with and without the cascade.
+        !*/
+
+        unsigned long num_images = 0;
+        // The number of windows, over all images, pyramid levels and detectors, the
+        // full filters accepted.  The rejection thresholds are chosen so that the cheap
+        // stage keeps every one of them.
+        unsigned long num_positive_windows = 0;
+        // The fraction of the windows that pass the cheap stage at the calibrated
+        // rejection thresholds.  Only the rows holding them get the full filters.
+        double fraction_of_windows_scored = 1;
+        double seconds_per_image_without_cascade = 0;
+        double seconds_per_image_with_cascade = 0;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename Feature_extractor_type = default_fhog_feature_extractor
+        >
+    class cascaded_fhog_detector
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object runs an object_detector built on scan_fhog_pyramid as a two
+                stage cascade.  The first stage scores every window with only the
+                get_num_stage_components() strongest separable filters of each detector,
+                which costs a small part of the full filter bank.  Windows scoring below
+                the detector's rejection threshold are dropped and only the rows holding
+                the rest are filtered with the full filters.  Since most windows of an
+                image contain no object, this skips most of the filtering work.
+
+                The cascade itself is run by scan_fhog_pyramid::detect(), see
+                fhog_filterbank::set_cascade().  This object holds the filter banks set
+                up for it, picks their rejection thresholds and does the non-max
+                suppression the same way get_detector() does.
+
+                The rejection thresholds are picked by calibrate() on a set of validation
+                images, such that no window the full detector accepts on them is
+                rejected.  A detector whose threshold is -infinity, the default, is run
+                without the cascade, giving exactly the output of get_detector().
+
+            THREAD SAFETY
+                operator() keeps its pyramid and filter outputs in *this and reuses them,
+                so that detecting objects in same sized images doesn't allocate.  So it
+                is not safe to call it concurrently on the same object.  Use a copy per
+                thread instead.
+        !*/
+
+    public:
+
+        typedef Pyramid_type pyramid_type;
+        typedef Feature_extractor_type feature_extractor_type;
+        typedef scan_fhog_pyramid<pyramid_type,feature_extractor_type> scanner_type;
+        typedef object_detector<scanner_type> detector_type;
+
+        cascaded_fhog_detector (
+        );
+        /*!
+            ensures
+                - #num_detectors() == 0
+                - #get_num_stage_components() == 0
+        !*/
+
+        explicit cascaded_fhog_detector (
+            const detector_type& detector,
+            unsigned long num_stage_components = 8
+        );
+        /*!
+            requires
+                - num_stage_components > 0
+            ensures
+                - #get_detector() == detector
+                - #get_num_stage_components() == num_stage_components
+                - for all valid i:
+                    - #get_rejection_threshold(i) == -infinity
+                  That is, the cascade is disabled until calibrate() or
+                  set_rejection_threshold() is called.
+        !*/
+
+        const detector_type& get_detector (
+        ) const;
+        /*!
+            ensures
+                - returns the detector this cascade is built from.
+        !*/
+
+        unsigned long num_detectors (
+        ) const;
+        /*!
+            ensures
+                - returns get_detector().num_detectors()
+        !*/
+
+        unsigned long get_num_stage_components (
+        ) const;
+        /*!
+            ensures
+                - returns the number of separable filters, over all the FHOG planes,
+                  each detector's cheap stage uses.
+        !*/
+
+        double get_rejection_threshold (
+            unsigned long idx
+        ) const;
+        /*!
+            requires
+                - idx < num_detectors()
+            ensures
+                - returns the cheap stage score below which the idx-th detector rejects a
+                  window without computing its full score.
+        !*/
+
+        void set_rejection_threshold (
+            unsigned long idx,
+            double thresh
+        );
+        /*!
+            requires
+                - idx < num_detectors()
+            ensures
+                - #get_rejection_threshold(idx) == thresh
+        !*/
+
+        void disable_cascade (
+        );
+        /*!
+            ensures
+                - for all valid i:
+                    - #get_rejection_threshold(i) == -infinity
+        !*/
+
+        template <
+            typename image_array_type
+            >
+        fhog_cascade_report calibrate (
+            const image_array_type& images,
+            const double adjust_threshold = 0,
+            const double margin = 0
+        );
+        /*!
+            requires
+                - image_array_type == an implementation of array/array_kernel_abstract.h
+                  and it must contain image objects which can be accepted by
+                  get_detector().
+                - num_detectors() > 0
+                - margin >= 0
+            ensures
+                - Sets the rejection thresholds from images.  For each detector, the
+                  threshold is the lowest cheap stage score of any window in images whose
+                  full score passes the detector with the given adjust_threshold, minus
+                  margin.  Since (*this)() gives the windows that pass the cheap stage
+                  exactly the score get_detector() gives them, (*this)(images[i], dets, T)
+                  outputs exactly get_detector()(images[i], dets, T) for any T >=
+                  adjust_threshold.  Use a negative adjust_threshold and a positive margin
+                  to leave room for images that weren't seen here.
+                - Detectors that don't accept any window in images get a threshold of
+                  -infinity, so they run without the cascade.
+                - returns a report of how many windows were used and how long detection
+                  took on images with and without the calibrated cascade, both run with
+                  the given adjust_threshold.
+        !*/
+
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<rect_detection>& dets,
+            const double adjust_threshold = 0
+        );
+        /*!
+            requires
+                - img == an object which can be accepted by get_detector()
+            ensures
+                - Performs the same computation as get_detector()(img, dets,
+                  adjust_threshold), except that windows rejected by the cheap stage are
+                  not reported.  The output has the same form and ordering.
+                - Windows that pass the cheap stage get exactly the score get_detector()
+                  gives them.
+                - The memory used is kept in *this and reused by the next call.
+        !*/
+
+        template <
+            typename image_type
+            >
+        std::vector<rectangle> operator() (
+            const image_type& img,
+            const double adjust_threshold = 0
+        );
+        /*!
+            requires
+                - img == an object which can be accepted by get_detector()
+            ensures
+                - Performs the same computation as the operator() above, and returns the
+                  rectangles of the detections.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename T, typename U>
+    void serialize (
+        const cascaded_fhog_detector<T,U>& item,
+        std::ostream& out
+    );
+    /*!
+        provides serialization support.  The rejection thresholds are saved along with
+        the detector.
+    !*/
+
+    template <typename T, typename U>
+    void deserialize (
+        cascaded_fhog_detector<T,U>& item,
+        std::istream& in
+    );
+    /*!
+        provides deserialization support
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_FHOG_CASCADE_ABSTRACT_H_
+
@@ -0,0 +1,684 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_FIXED_POINT_FHOG_H_
+#define DLIB_FIXED_POINT_FHOG_H_
+
+#include "fixed_point_fhog_abstract.h"
+#include "scan_fhog_pyramid.h"
+#include "object_detector.h"
+#include "../uintn.h"
+#include <algorithm>
+#include <cmath>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        // FHOG features are stored as round(value*fixed_point_fhog_scale).  The default
+        // extractor's features are all in [0,1), so 12 fractional bits leave room for the
+        // sign and the filter sums below without overflowing.
+        const float fixed_point_fhog_scale = 4096;
+
+        // The filters are scaled so that the sum of their magnitudes times the largest
+        // feature value fits in an int32 accumulator.
+        const double fixed_point_fhog_accumulator_limit = 2147483647.0;
+
+        struct fixed_point_fhog_filterbank
+        {
+            // true if the separable filters are used, for the same reason
+            // apply_filters_to_fhog() would use them.
+            bool use_separable_filters = false;
+
+            std::vector<matrix<int16> > filters;
+            // multiply an accumulated filter response by this to get back the score
+            float score_scale = 0;
+
+            // Only the row filters are quantized, the column filters are applied in float
+            // to the rescaled output of the row filters.
+            std::vector<std::vector<matrix<int16,0,1> > > row_filters;
+            std::vector<std::vector<float> > row_scales;
+            std::vector<std::vector<matrix<float,0,1> > > col_filters;
+        };
+
+        inline double fixed_point_filter_scale (
+            const double largest,
+            const double total
+        )
+        /*!
+            ensures
+                - returns the largest scale the taps of a filter can be multiplied by and
+                  still fit in int16 and, applied to features in [-1,1], in an int32
+                  accumulator.  largest and total are the largest and the sum of the
+                  magnitudes of the filter's taps.
+        !*/
+        {
+            if (largest == 0)
+                return 1;
+            return std::min(32767/largest, fixed_point_fhog_accumulator_limit/fixed_point_fhog_scale/total);
+        }
+
+        template <long NR, long NC, typename MM, typename L>
+        void quantize_filter (
+            const matrix<float,NR,NC,MM,L>& filter,
+            const double scale,
+            matrix<int16,NR,NC,MM,L>& qfilter
+        )
+        {
+            qfilter.set_size(filter.nr(), filter.nc());
+            for (long r = 0; r < filter.nr(); ++r)
+            {
+                for (long c = 0; c < filter.nc(); ++c)
+                    qfilter(r,c) = (int16)std::floor(filter(r,c)*scale + 0.5);
+            }
+        }
+
+        template <typename fhog_filterbank>
+        fixed_point_fhog_filterbank make_fixed_point_fhog_filterbank (
+            const fhog_filterbank& w
+        )
+        {
+            fixed_point_fhog_filterbank fb;
+            const unsigned long num_separable_filters = w.num_separable_filters();
+            fb.use_separable_filters = !(num_separable_filters > w.filters.size()*std::min(w.filters[0].nr(),w.filters[0].nc())/3.0);
+            if (!fb.use_separable_filters)
+            {
+                // All the planes add up in one accumulator so they share one scale.
+                double largest = 0, total = 0;
+                for (unsigned long i = 0; i < w.filters.size(); ++i)
+                {
+                    largest = std::max<double>(largest, max(abs(w.filters[i])));
+                    total += sum(abs(matrix_cast<double>(w.filters[i])));
+                }
+                const double scale = fixed_point_filter_scale(largest, total);
+
+                fb.score_scale = 1/(scale*fixed_point_fhog_scale);
+                fb.filters.resize(w.filters.size());
+                for (unsigned long i = 0; i < w.filters.size(); ++i)
+                    quantize_filter(w.filters[i], scale, fb.filters[i]);
+            }
+            else
+            {
+                fb.row_filters.resize(w.row_filters.size());
+                fb.row_scales.resize(w.row_filters.size());
+                fb.col_filters = w.col_filters;
+                for (unsigned long i = 0; i < w.row_filters.size(); ++i)
+                {
+                    fb.row_filters[i].resize(w.row_filters[i].size());
+                    for (unsigned long j = 0; j < w.row_filters[i].size(); ++j)
+                    {
+                        const matrix<float,0,1>& row_filter = w.row_filters[i][j];
+                        const double scale = fixed_point_filter_scale(max(abs(row_filter)),
+                            sum(abs(matrix_cast<double>(row_filter))));
+                        quantize_filter(row_filter, scale, fb.row_filters[i][j]);
+                        fb.row_scales[i].push_back(1/(scale*fixed_point_fhog_scale));
+                    }
+                }
+            }
+            return fb;
+        }
+
+        inline void quantize_fhog_level (
+            const array<array2d<float> >& feats,
+            array<array2d<int16> >& qfeats
+        )
+        {
+            qfeats.resize(feats.size());
+            for (unsigned long i = 0; i < feats.size(); ++i)
+            {
+                qfeats[i].set_size(feats[i].nr(), feats[i].nc());
+                const long size = feats[i].size();
+                if (size == 0)
+                    continue;
+                const float* in = &feats[i][0][0];
+                int16* out = &qfeats[i][0][0];
+                for (long j = 0; j < size; ++j)
+                {
+                    const float v = std::floor(in[j]*fixed_point_fhog_scale + 0.5f);
+                    out[j] = (int16)std::max(-32768.0f, std::min(32767.0f, v));
+                }
+            }
+        }
+
+        struct fixed_point_fhog_buffers
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    The memory fixed_point_fhog_detector works in.  Keeping one of these
+                    between detections on images of the same size means the pyramid
+                    images, extractor scratch, feature planes and saliency images don't
+                    have to be allocated again.  The float planes of the level being
+                    quantized are the exception: a single set is resized for each level
+                    so that only one level of float features exists at a time.
+
+                    It is only scratch memory, so a copy starts out empty.
+            !*/
+
+            fixed_point_fhog_buffers() {}
+            fixed_point_fhog_buffers(const fixed_point_fhog_buffers&) {}
+            fixed_point_fhog_buffers& operator= (const fixed_point_fhog_buffers&) { return *this; }
+
+            fhog_pyramid_buffers pyramid;
+            array<array2d<float> > level;
+            array<array<array2d<int16> > > feats;
+            array2d<float> saliency_image;
+            array2d<float> scratch;
+            std::vector<std::pair<double, rectangle> > dets;
+            std::vector<rect_detection> dets_accum;
+        };
+
+        template <
+            typename pyramid_type,
+            typename image_type,
+            typename feature_extractor_type
+            >
+        void create_fixed_point_fhog_pyramid (
+            const image_type& img,
+            const feature_extractor_type& fe,
+            array<array<array2d<int16> > >& feats,
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            unsigned long min_pyramid_layer_width,
+            unsigned long min_pyramid_layer_height,
+            unsigned long max_pyramid_levels,
+            fhog_pyramid_buffers& buffers,
+            array<array2d<float> >& level
+        )
+        /*!
+            ensures
+                - builds the same pyramid as create_fhog_pyramid(), except each level is
+                  quantized as soon as it is extracted into level.  So only one level of
+                  float features exists at a time.
+                - The downsampled images and the extractor scratch are kept in buffers,
+                  one per level, as create_fhog_pyramid() does.
+        !*/
+        {
+            const unsigned long levels = num_fhog_pyramid_levels<pyramid_type>(get_rect(img),
+                min_pyramid_layer_width, min_pyramid_layer_height, max_pyramid_levels);
+            pyramid_type pyr;
+
+            if (feats.max_size() < levels)
+                feats.set_max_size(levels);
+            feats.set_size(levels);
+
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            array<array2d<pixel_type> >& images = buffers.images<pixel_type>();
+            if (images.size() < levels)
+                images.resize(levels);
+            buffers.set_num_levels(levels);
+
+            extract_fhog_level(fe, img, level, cell_size,filter_rows_padding,filter_cols_padding,
+                buffers.extractor_scratch[0]);
+            DLIB_ASSERT(level.size() == fe.get_num_planes(),
+                "Invalid feature extractor used with dlib::fixed_point_fhog_detector.  The output does not have the \n"
+                "indicated number of planes.");
+            quantize_fhog_level(level, feats[0]);
+
+            for (unsigned long i = 1; i < feats.size(); ++i)
+            {
+                if (i == 1)
+                    pyr(img, images[1]);
+                else
+                    pyr(images[i-1], images[i]);
+                extract_fhog_level(fe, images[i], level, cell_size,filter_rows_padding,filter_cols_padding,
+                    buffers.extractor_scratch[i]);
+                quantize_fhog_level(level, feats[i]);
+            }
+        }
+
+        inline void fixed_point_row_filter (
+            const int16* in,
+            const matrix<int16,0,1>& filter,
+            const long width,
+            int32* acc
+        )
+        /*!
+            ensures
+                - for all 0 <= c < width:
+                    - #acc[c] == sum over n of filter(n)*in[c+n]
+        !*/
+        {
+            // Blocks of 16 outputs are accumulated one tap at a time.  The fixed block
+            // size lets the compiler keep the block in SIMD registers and turn the inner
+            // loop into widening multiply-accumulates.
+            const long num_taps = filter.size();
+            const int16* taps = &filter(0);
+            long c = 0;
+            for (; c + 16 <= width; c += 16)
+            {
+                int32 block[16] = {0};
+                for (long n = 0; n < num_taps; ++n)
+                {
+                    const int16 tap = taps[n];
+                    const int16* p = in + c + n;
+                    for (long k = 0; k < 16; ++k)
+                        block[k] += (int32)tap*p[k];
+                }
+                for (long k = 0; k < 16; ++k)
+                    acc[c+k] = block[k];
+            }
+            for (; c < width; ++c)
+            {
+                int32 temp = 0;
+                for (long n = 0; n < num_taps; ++n)
+                    temp += (int32)taps[n]*in[c+n];
+                acc[c] = temp;
+            }
+        }
+
+        inline rectangle apply_fixed_point_filters_to_fhog (
+            const fixed_point_fhog_filterbank& fb,
+            const array<array2d<int16> >& feats,
+            array2d<float>& saliency_image,
+            array2d<float>& scratch
+        )
+        /*!
+            ensures
+                - computes the same saliency image, and returns the same area, as
+                  apply_filters_to_fhog() with the float filters fb was made from, up to
+                  the quantization error.  The pixels outside the returned area are
+                  zero.
+        !*/
+        {
+            const long nr = feats[0].nr();
+            const long nc = feats[0].nc();
+            long fnr, fnc;
+            if (fb.use_separable_filters)
+            {
+                fnr = fnc = 0;
+                for (unsigned long i = 0; i < fb.row_filters.size() && fnr == 0; ++i)
+                {
+                    if (fb.row_filters[i].size() != 0)
+                    {
+                        fnr = fb.col_filters[i][0].size();
+                        fnc = fb.row_filters[i][0].size();
+                    }
+                }
+            }
+            else
+            {
+                fnr = fb.filters[0].nr();
+                fnc = fb.filters[0].nc();
+            }
+            saliency_image.set_size(nr, nc);
+            assign_all_pixels(saliency_image, 0);
+
+            const rectangle area(fnc/2, fnr/2, nc - (fnc-1)/2 - 1, nr - (fnr-1)/2 - 1);
+            if (area.is_empty() || fnr == 0)
+                return area;
+
+            const long width = area.width();
+            std::vector<int32> accumulator(width);
+            int32* acc = &accumulator[0];
+            if (!fb.use_separable_filters)
+            {
+                // Every tap of every plane is accumulated in int32, one output row at a
+                // time.
+                for (long r = area.top(); r <= area.bottom(); ++r)
+                {
+                    std::fill(accumulator.begin(), accumulator.end(), 0);
+                    for (unsigned long i = 0; i < fb.filters.size(); ++i)
+                    {
+                        const matrix<int16>& f = fb.filters[i];
+                        for (long m = 0; m < fnr; ++m)
+                        {
+                            const int16* in = &feats[i][r - fnr/2 + m][0] + area.left() - fnc/2;
+                            for (long n = 0; n < fnc; ++n)
+                            {
+                                const int16 tap = f(m,n);
+                                if (tap == 0)
+                                    continue;
+                                const int16* p = in + n;
+                                for (long c = 0; c < width; ++c)
+                                    acc[c] += (int32)tap*p[c];
+                            }
+                        }
+                    }
+
+                    float* out = &saliency_image[r][0] + area.left();
+                    for (long c = 0; c < width; ++c)
+                        out[c] = acc[c]*fb.score_scale;
+                }
+                return area;
+            }
+
+            // The row filters run on the int16 planes, their output is rescaled to float
+            // and then the column filters are applied the same way
+            // float_spatially_filter_image_separable() does.
+            scratch.set_size(nr, nc);
+            for (unsigned long i = 0; i < fb.row_filters.size(); ++i)
+            {
+                for (unsigned long j = 0; j < fb.row_filters[i].size(); ++j)
+                {
+                    const float row_scale = fb.row_scales[i][j];
+                    for (long r = 0; r < nr; ++r)
+                    {
+                        fixed_point_row_filter(&feats[i][r][0], fb.row_filters[i][j], width, acc);
+                        float* out = &scratch[r][0] + area.left();
+                        for (long c = 0; c < width; ++c)
+                            out[c] = acc[c]*row_scale;
+                    }
+
+                    const matrix<float,0,1>& col_filter = fb.col_filters[i][j];
+                    for (long r = area.top(); r <= area.bottom(); ++r)
+                    {
+                        long c = area.left();
+                        for (; c + 7 <= area.right(); c += 8)
+                        {
+                            simd8f p, p2, p3, temp = 0, temp2 = 0, temp3 = 0;
+                            long m = 0;
+                            for (; m < fnr-2; m += 3)
+                            {
+                                p.load(&scratch[r - fnr/2 + m][c]);
+                                p2.load(&scratch[r - fnr/2 + m+1][c]);
+                                p3.load(&scratch[r - fnr/2 + m+2][c]);
+                                temp += p*col_filter(m);
+                                temp2 += p2*col_filter(m+1);
+                                temp3 += p3*col_filter(m+2);
+                            }
+                            for (; m < fnr; ++m)
+                            {
+                                p.load(&scratch[r - fnr/2 + m][c]);
+                                temp += p*col_filter(m);
+                            }
+                            temp += temp2 + temp3;
+                            p.load(&saliency_image[r][c]);
+                            temp += p;
+                            temp.store(&saliency_image[r][c]);
+                        }
+                        for (; c <= area.right(); ++c)
+                        {
+                            float temp = 0;
+                            for (long m = 0; m < fnr; ++m)
+                                temp += scratch[r - fnr/2 + m][c]*col_filter(m);
+                            saliency_image[r][c] += temp;
+                        }
+                    }
+                }
+            }
+            return area;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename Feature_extractor_type = default_fhog_feature_extractor
+        >
+    class fixed_point_fhog_detector
+    {
+    public:
+
+        typedef Pyramid_type pyramid_type;
+        typedef Feature_extractor_type feature_extractor_type;
+        typedef scan_fhog_pyramid<pyramid_type,feature_extractor_type> scanner_type;
+        typedef object_detector<scanner_type> detector_type;
+
+        fixed_point_fhog_detector (
+        ) : threshold_adjustment(0) {}
+
+        explicit fixed_point_fhog_detector (
+            const detector_type& detector_
+        ) :
+            detector(detector_),
+            threshold_adjustment(0)
+        {
+            init();
+        }
+
+        const detector_type& get_detector (
+        ) const { return detector; }
+
+        unsigned long num_detectors (
+        ) const { return detector.num_detectors(); }
+
+        double get_threshold_adjustment (
+        ) const { return threshold_adjustment; }
+
+        void set_threshold_adjustment (
+            double value
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(value >= 0,
+                "\t void fixed_point_fhog_detector::set_threshold_adjustment()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t value: " << value
+                << "\n\t this:  " << this
+                );
+
+            threshold_adjustment = value;
+        }
+
+        template <
+            typename image_array_type
+            >
+        double calibrate (
+            const image_array_type& images
+        )
+        {
+            const scanner_type& scanner = detector.get_scanner();
+            array<array<array2d<float> > > feats;
+            array<array2d<int16> > qfeats;
+            array2d<float> saliency_image, fixed_saliency_image, scratch;
+            double largest_error = 0;
+            for (unsigned long i = 0; i < images.size(); ++i)
+            {
+                impl::create_fhog_pyramid<pyramid_type>(images[i], scanner.get_feature_extractor(), feats,
+                    scanner.get_cell_size(), scanner.get_fhog_window_height(),
+                    scanner.get_fhog_window_width(), scanner.get_min_pyramid_layer_width(),
+                    scanner.get_min_pyramid_layer_height(), scanner.get_max_pyramid_levels());
+                for (unsigned long l = 0; l < feats.size(); ++l)
+                {
+                    impl::quantize_fhog_level(feats[l], qfeats);
+                    for (unsigned long d = 0; d < num_detectors(); ++d)
+                    {
+                        const rectangle area = impl::apply_filters_to_fhog(
+                            detector.get_processed_w(d).get_detect_argument(), feats[l], saliency_image);
+                        impl::apply_fixed_point_filters_to_fhog(filterbanks[d], qfeats, fixed_saliency_image, scratch);
+                        for (long r = area.top(); r <= area.bottom(); ++r)
+                        {
+                            for (long c = area.left(); c <= area.right(); ++c)
+                            {
+                                const double error = std::abs(fixed_saliency_image[r][c] - saliency_image[r][c]);
+                                largest_error = std::max(largest_error, error);
+                            }
+                        }
+                    }
+                }
+            }
+
+            threshold_adjustment = largest_error;
+            return threshold_adjustment;
+        }
+
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<rect_detection>& final_dets,
+            const double adjust_threshold = 0
+        ) const
+        {
+            impl::fixed_point_fhog_buffers temp;
+            detect(img, final_dets, adjust_threshold, temp);
+        }
+
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<rect_detection>& final_dets,
+            const double adjust_threshold = 0
+        )
+        {
+            detect(img, final_dets, adjust_threshold, buffers);
+        }
+
+        template <
+            typename image_type
+            >
+        std::vector<rectangle> operator() (
+            const image_type& img,
+            const double adjust_threshold = 0
+        ) const
+        {
+            std::vector<rect_detection> dets;
+            (*this)(img, dets, adjust_threshold);
+
+            std::vector<rectangle> final_dets(dets.size());
+            for (unsigned long i = 0; i < dets.size(); ++i)
+                final_dets[i] = dets[i].rect;
+            return final_dets;
+        }
+
+        template <typename T, typename U>
+        friend void serialize (
+            const fixed_point_fhog_detector<T,U>& item,
+            std::ostream& out
+        );
+
+        template <typename T, typename U>
+        friend void deserialize (
+            fixed_point_fhog_detector<T,U>& item,
+            std::istream& in
+        );
+
+    private:
+
+        template <
+            typename image_type
+            >
+        void detect (
+            const image_type& img,
+            std::vector<rect_detection>& final_dets,
+            const double adjust_threshold,
+            impl::fixed_point_fhog_buffers& buf
+        ) const
+        {
+            const scanner_type& scanner = detector.get_scanner();
+            const feature_extractor_type& fe = scanner.get_feature_extractor();
+            const unsigned long det_box_width  = scanner.get_fhog_window_width()  - 2*scanner.get_padding();
+            const unsigned long det_box_height = scanner.get_fhog_window_height() - 2*scanner.get_padding();
+            pyramid_type pyr;
+
+            array<array<array2d<int16> > >& feats = buf.feats;
+            impl::create_fixed_point_fhog_pyramid<pyramid_type>(img, fe, feats,
+                scanner.get_cell_size(), scanner.get_fhog_window_height(),
+                scanner.get_fhog_window_width(), scanner.get_min_pyramid_layer_width(),
+                scanner.get_min_pyramid_layer_height(), scanner.get_max_pyramid_levels(),
+                buf.pyramid, buf.level);
+
+            array2d<float>& saliency_image = buf.saliency_image;
+            std::vector<std::pair<double, rectangle> >& dets = buf.dets;
+            std::vector<rect_detection>& dets_accum = buf.dets_accum;
+            dets_accum.clear();
+            for (unsigned long d = 0; d < detector.num_detectors(); ++d)
+            {
+                const double thresh = detector.get_processed_w(d).w(scanner.get_num_dimensions());
+                // lower the threshold by the quantization error so windows the float
+                // detector accepts aren't lost.
+                const double fixed_thresh = thresh + adjust_threshold - threshold_adjustment;
+
+                dets.clear();
+                for (unsigned long l = 0; l < feats.size(); ++l)
+                {
+                    const rectangle area = impl::apply_fixed_point_filters_to_fhog(filterbanks[d], feats[l], saliency_image, buf.scratch);
+                    for (long r = area.top(); r <= area.bottom(); ++r)
+                    {
+                        for (long c = area.left(); c <= area.right(); ++c)
+                        {
+                            if (saliency_image[r][c] >= fixed_thresh)
+                            {
+                                rectangle rect = fe.feats_to_image(centered_rect(point(c,r),det_box_width,det_box_height),
+                                    scanner.get_cell_size(), scanner.get_fhog_window_height(), scanner.get_fhog_window_width());
+                                rect = pyr.rect_up(rect, l);
+                                dets.push_back(std::make_pair(saliency_image[r][c], rect));
+                            }
+                        }
+                    }
+                }
+                std::sort(dets.rbegin(), dets.rend(), impl::compare_pair_rect);
+
+                for (unsigned long j = 0; j < dets.size(); ++j)
+                {
+                    rect_detection temp;
+                    temp.detection_confidence = dets[j].first-thresh;
+                    temp.weight_index = d;
+                    temp.rect = dets[j].second;
+                    dets_accum.push_back(temp);
+                }
+            }
+
+            // Do non-max suppression the same way object_detector does.
+            final_dets.clear();
+            if (detector.num_detectors() > 1)
+                std::sort(dets_accum.rbegin(), dets_accum.rend());
+            const test_box_overlap& boxes_overlap = detector.get_overlap_tester();
+            for (unsigned long i = 0; i < dets_accum.size(); ++i)
+            {
+                bool overlaps = false;
+                for (unsigned long j = 0; j < final_dets.size() && !overlaps; ++j)
+                    overlaps = boxes_overlap(final_dets[j].rect, dets_accum[i].rect);
+                if (!overlaps)
+                    final_dets.push_back(dets_accum[i]);
+            }
+        }
+
+        void init (
+        )
+        {
+            filterbanks.clear();
+            for (unsigned long d = 0; d < detector.num_detectors(); ++d)
+                filterbanks.push_back(impl::make_fixed_point_fhog_filterbank(detector.get_processed_w(d).get_detect_argument()));
+        }
+
+        detector_type detector;
+        std::vector<impl::fixed_point_fhog_filterbank> filterbanks;
+        double threshold_adjustment;
+        // Reused by the non-const operator().  It isn't part of the detector's state,
+        // so it isn't serialized and copies of the detector start without it.
+        impl::fixed_point_fhog_buffers buffers;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename T, typename U>
+    void serialize (
+        const fixed_point_fhog_detector<T,U>& item,
+        std::ostream& out
+    )
+    {
+        int version = 1;
+        serialize(version, out);
+        serialize(item.detector, out);
+        serialize(item.threshold_adjustment, out);
+    }
+
+    template <typename T, typename U>
+    void deserialize (
+        fixed_point_fhog_detector<T,U>& item,
+        std::istream& in
+    )
+    {
+        int version = 0;
+        deserialize(version, in);
+        if (version != 1)
+            throw serialization_error("Unexpected version encountered while deserializing a dlib::fixed_point_fhog_detector object.");
+
+        deserialize(item.detector, in);
+        deserialize(item.threshold_adjustment, in);
+        item.init();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_FIXED_POINT_FHOG_H_
+
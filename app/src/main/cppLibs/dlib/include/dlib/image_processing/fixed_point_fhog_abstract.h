@@ -0,0 +1,210 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_FIXED_POINT_FHOG_ABSTRACT_H_
+#ifdef DLIB_FIXED_POINT_FHOG_ABSTRACT_H_
+
+#include "object_detector_abstract.h"
+#include "scan_fhog_pyramid_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename Feature_extractor_type = default_fhog_feature_extractor
+        >
+    class fixed_point_fhog_detector
+    {
+        /*!
+            REQUIREMENTS ON Feature_extractor_type
+                Same as for scan_fhog_pyramid.  In addition, the features it outputs must
+                all be in the range [-1, 1], which the default_fhog_feature_extractor's
+                are.
+
+            WHAT THIS OBJECT REPRESENTS
+                This object runs an object_detector built on scan_fhog_pyramid using
+                fixed point arithmetic.  The FHOG feature planes are stored as int16
+                values with 12 fractional bits instead of floats, and each detector's
+                filters are converted to int16 taps, scaled as finely as an int32
+                accumulator allows without overflowing.  The filters are then applied
+                with integer multiply-accumulates.  This halves the memory used by the
+                feature pyramid and the bandwidth used to scan it, and lets the filtering
+                run on the integer SIMD units.
+
+                The scores it computes differ from the ones the float detector computes
+                by a small quantization error.  To avoid losing detections because of
+                it, the detection threshold is lowered by get_threshold_adjustment(),
+                which calibrate() sets to the largest error seen on a set of images.
+
+                Whether this is faster than get_detector() depends on the hardware.  On
+                an x86 machine with only SSE2 it measured slower (190 ms against 150 ms
+                for a 1080p frame), since the widening integer multiplies cost more
+                than float FMAs there.  So it isn't used unless you ask for it: this
+                header is not included by dlib/image_processing.h.  Time both on your
+                target device before switching to it.
+
+            THREAD SAFETY
+                Concurrent calls to the const member functions are safe.
+        !*/
+
+    public:
+
+        typedef Pyramid_type pyramid_type;
+        typedef Feature_extractor_type feature_extractor_type;
+        typedef scan_fhog_pyramid<pyramid_type,feature_extractor_type> scanner_type;
+        typedef object_detector<scanner_type> detector_type;
+
+        fixed_point_fhog_detector (
+        );
+        /*!
+            ensures
+                - #num_detectors() == 0
+                - #get_threshold_adjustment() == 0
+        !*/
+
+        explicit fixed_point_fhog_detector (
+            const detector_type& detector
+        );
+        /*!
+            ensures
+                - #get_detector() == detector
+                - #get_threshold_adjustment() == 0
+        !*/
+
+        const detector_type& get_detector (
+        ) const;
+        /*!
+            ensures
+                - returns the detector whose filters this object runs in fixed point.
+        !*/
+
+        unsigned long num_detectors (
+        ) const;
+        /*!
+            ensures
+                - returns get_detector().num_detectors()
+        !*/
+
+        double get_threshold_adjustment (
+        ) const;
+        /*!
+            ensures
+                - returns how much the detection threshold of every detector is lowered
+                  to make up for the quantization error of the fixed point scores.
+        !*/
+
+        void set_threshold_adjustment (
+            double value
+        );
+        /*!
+            requires
+                - value >= 0
+            ensures
+                - #get_threshold_adjustment() == value
+        !*/
+
+        template <
+            typename image_array_type
+            >
+        double calibrate (
+            const image_array_type& images
+        );
+        /*!
+            requires
+                - image_array_type == an implementation of array/array_kernel_abstract.h
+                  and it must contain image objects which can be accepted by
+                  get_detector().
+            ensures
+                - Scores every window of every image in images with both the float and
+                  the fixed point filters.
+                - #get_threshold_adjustment() == the largest absolute difference between
+                  the two scores of any window.  So no window get_detector() accepts on
+                  these images is rejected by this object.
+                - returns #get_threshold_adjustment()
+        !*/
+
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<rect_detection>& dets,
+            const double adjust_threshold = 0
+        ) const;
+        /*!
+            requires
+                - img == an object which can be accepted by get_detector()
+            ensures
+                - Performs the same computation as get_detector()(img, dets,
+                  adjust_threshold), except that the windows are scored in fixed point and
+                  accepted when their score is at least the detector's threshold plus
+                  adjust_threshold minus get_threshold_adjustment().
+                - The detection_confidence of each detection is its fixed point score
+                  minus the detector's threshold.  So with a non-zero
+                  get_threshold_adjustment(), some may be slightly negative.
+        !*/
+
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<rect_detection>& dets,
+            const double adjust_threshold = 0
+        );
+        /*!
+            requires
+                - img == an object which can be accepted by get_detector()
+            ensures
+                - Performs the same computation as the const operator() above, except
+                  that the pyramid, feature planes and saliency images are kept in *this
+                  and reused by the next call.  So repeated calls on same sized images
+                  don't allocate them again.
+                - Unlike the const version, this modifies *this and so must not be called
+                  concurrently with other uses of the same object.
+        !*/
+
+        template <
+            typename image_type
+            >
+        std::vector<rectangle> operator() (
+            const image_type& img,
+            const double adjust_threshold = 0
+        ) const;
+        /*!
+            requires
+                - img == an object which can be accepted by get_detector()
+            ensures
+                - Performs the same computation as the operator() above, and returns the
+                  rectangles of the detections.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename T, typename U>
+    void serialize (
+        const fixed_point_fhog_detector<T,U>& item,
+        std::ostream& out
+    );
+    /*!
+        provides serialization support.  The fixed point filters are rebuilt from the
+        detector when deserializing.
+    !*/
+
+    template <typename T, typename U>
+    void deserialize (
+        fixed_point_fhog_detector<T,U>& item,
+        std::istream& in
+    );
+    /*!
+        provides deserialization support
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_FIXED_POINT_FHOG_ABSTRACT_H_
+
@@ -0,0 +1,353 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_INCREMENTAL_OBJECT_DETECToR_H_
+#define DLIB_INCREMENTAL_OBJECT_DETECToR_H_
+
+#include "incremental_object_detector_abstract.h"
+#include "scan_fhog_pyramid.h"
+#include "object_detector.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <
+            typename pyramid_type
+            >
+        unsigned long closest_pyramid_level (
+            const rectangle& box,
+            const unsigned long window_width,
+            const unsigned long window_height,
+            const unsigned long max_pyramid_levels
+        )
+        /*!
+            ensures
+                - returns the pyramid level at which box is closest in size to a detection
+                  window of the given dimensions.
+        !*/
+        {
+            pyramid_type pyr;
+            const double window_size = std::sqrt((double)window_width*window_height);
+            unsigned long best_level = 0;
+            double best_error = std::numeric_limits<double>::infinity();
+            for (unsigned long l = 0; l < max_pyramid_levels; ++l)
+            {
+                const drectangle rect = pyr.rect_down(drectangle(box), l);
+                if (rect.width() <= 0 || rect.height() <= 0)
+                    break;
+                const double error = std::abs(std::log(std::sqrt(rect.width()*rect.height())/window_size));
+                // the box only gets smaller as we go up the pyramid
+                if (error >= best_error)
+                    break;
+                best_error = error;
+                best_level = l;
+            }
+            return best_level;
+        }
+
+        template <
+            typename pyramid_type,
+            typename feature_extractor_type,
+            typename image_type
+            >
+        void detect_near (
+            const object_detector<scan_fhog_pyramid<pyramid_type,feature_extractor_type> >& detector,
+            const image_type& img_,
+            const rectangle& prior,
+            const double max_shift,
+            const unsigned long scale_radius,
+            std::vector<rect_detection>& dets,
+            const double adjust_threshold,
+            thread_pool* tp
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(detector.num_detectors() > 0 && !prior.is_empty() && max_shift >= 0,
+                "\t void detect_near()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t detector.num_detectors(): " << detector.num_detectors()
+                << "\n\t prior.is_empty(): " << prior.is_empty()
+                << "\n\t max_shift:        " << max_shift
+                );
+
+            typedef scan_fhog_pyramid<pyramid_type,feature_extractor_type> scanner_type;
+            const scanner_type& scanner = detector.get_scanner();
+            const_image_view<image_type> img(img_);
+            pyramid_type pyr;
+            dets.clear();
+
+            // Only the pyramid levels where an object the size of prior fits the detection
+            // window, give or take scale_radius levels, are worth scoring.
+            const unsigned long level = closest_pyramid_level<pyramid_type>(prior,
+                scanner.get_detection_window_width(), scanner.get_detection_window_height(),
+                scanner.get_max_pyramid_levels());
+            const unsigned long first_level = level > scale_radius ? level-scale_radius : 0;
+            const unsigned long last_level = level + scale_radius;
+
+            // The centers of the detections we accept, in img.
+            const long shift = (long)std::ceil(max_shift*std::max(prior.width(), prior.height()));
+            const rectangle centers = grow_rect(rectangle(center(prior)), shift);
+
+            // The part of img we need features for.  It holds the biggest box we search for,
+            // plus the FHOG border and filter padding, centered anywhere in centers.
+            const long margin = scanner.get_cell_size()*(scanner.get_padding()+2);
+            const drectangle window = pyr.rect_up(drectangle(0, 0,
+                    scanner.get_detection_window_width()-1 + 2*margin,
+                    scanner.get_detection_window_height()-1 + 2*margin), last_level);
+            const rectangle area = grow_rect(centers, (long)std::ceil(window.width()/2),
+                (long)std::ceil(window.height()/2)).intersect(get_rect(img));
+            if (area.is_empty())
+                return;
+
+            array<array<array2d<float> > > feats;
+            impl::create_fhog_pyramid<pyramid_type>(sub_image(img_, area),
+                scanner.get_feature_extractor(), feats, scanner.get_cell_size(),
+                scanner.get_fhog_window_height(), scanner.get_fhog_window_width(),
+                scanner.get_min_pyramid_layer_width(), scanner.get_min_pyramid_layer_height(),
+                std::min(scanner.get_max_pyramid_levels(), last_level+1), tp, first_level);
+
+            const unsigned long det_box_width  = scanner.get_fhog_window_width()  - 2*scanner.get_padding();
+            const unsigned long det_box_height = scanner.get_fhog_window_height() - 2*scanner.get_padding();
+            std::vector<std::pair<double, rectangle> > temp_dets;
+            std::vector<rect_detection> dets_accum;
+            for (unsigned long d = 0; d < detector.num_detectors(); ++d)
+            {
+                const double thresh = detector.get_processed_w(d).w(scanner.get_num_dimensions());
+                impl::detect_from_fhog_pyramid<pyramid_type>(feats, scanner.get_feature_extractor(),
+                    detector.get_processed_w(d).get_detect_argument(), thresh+adjust_threshold,
+                    det_box_height, det_box_width, scanner.get_cell_size(),
+                    scanner.get_fhog_window_height(), scanner.get_fhog_window_width(),
+                    temp_dets, tp);
+
+                for (unsigned long j = 0; j < temp_dets.size(); ++j)
+                {
+                    rect_detection temp;
+                    temp.detection_confidence = temp_dets[j].first-thresh;
+                    temp.weight_index = d;
+                    temp.rect = translate_rect(temp_dets[j].second, area.tl_corner());
+                    if (centers.contains(center(temp.rect)))
+                        dets_accum.push_back(temp);
+                }
+            }
+
+            // Do non-max suppression the same way object_detector does.
+            if (detector.num_detectors() > 1)
+                std::sort(dets_accum.rbegin(), dets_accum.rend());
+            const test_box_overlap& boxes_overlap = detector.get_overlap_tester();
+            for (unsigned long i = 0; i < dets_accum.size(); ++i)
+            {
+                bool overlaps = false;
+                for (unsigned long j = 0; j < dets.size() && !overlaps; ++j)
+                    overlaps = boxes_overlap(dets[j].rect, dets_accum[i].rect);
+                if (!overlaps)
+                    dets.push_back(dets_accum[i]);
+            }
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pyramid_type,
+        typename feature_extractor_type,
+        typename image_type
+        >
+    void detect_near (
+        const object_detector<scan_fhog_pyramid<pyramid_type,feature_extractor_type> >& detector,
+        const image_type& img,
+        const rectangle& prior,
+        const double max_shift,
+        const unsigned long scale_radius,
+        std::vector<rect_detection>& dets,
+        const double adjust_threshold = 0
+    )
+    {
+        impl::detect_near(detector, img, prior, max_shift, scale_radius, dets, adjust_threshold, 0);
+    }
+
+    template <
+        typename pyramid_type,
+        typename feature_extractor_type,
+        typename image_type
+        >
+    void detect_near (
+        const object_detector<scan_fhog_pyramid<pyramid_type,feature_extractor_type> >& detector,
+        const image_type& img,
+        const rectangle& prior,
+        const double max_shift,
+        const unsigned long scale_radius,
+        std::vector<rect_detection>& dets,
+        thread_pool& tp,
+        const double adjust_threshold = 0
+    )
+    {
+        impl::detect_near(detector, img, prior, max_shift, scale_radius, dets, adjust_threshold, &tp);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename Feature_extractor_type = default_fhog_feature_extractor
+        >
+    class incremental_object_detector
+    {
+    public:
+
+        typedef Pyramid_type pyramid_type;
+        typedef Feature_extractor_type feature_extractor_type;
+        typedef object_detector<scan_fhog_pyramid<pyramid_type,feature_extractor_type> > detector_type;
+
+        incremental_object_detector (
+        )
+        {
+            init();
+        }
+
+        explicit incremental_object_detector (
+            const detector_type& detector_
+        ) : detector(detector_)
+        {
+            init();
+        }
+
+        const detector_type& get_detector (
+        ) const { return detector; }
+
+        void set_full_scan_interval (
+            unsigned long num_frames
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(num_frames > 0,
+                "\t void incremental_object_detector::set_full_scan_interval()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t num_frames: " << num_frames
+                << "\n\t this:       " << this
+                );
+
+            full_scan_interval = num_frames;
+        }
+
+        unsigned long get_full_scan_interval (
+        ) const { return full_scan_interval; }
+
+        void set_max_shift (
+            double fraction
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(fraction >= 0,
+                "\t void incremental_object_detector::set_max_shift()"
+                << "\n\t Invalid inputs were given to this function "
+                << "\n\t fraction: " << fraction
+                << "\n\t this:     " << this
+                );
+
+            max_shift = fraction;
+        }
+
+        double get_max_shift (
+        ) const { return max_shift; }
+
+        void set_scale_radius (
+            unsigned long num_levels
+        ) { scale_radius = num_levels; }
+
+        unsigned long get_scale_radius (
+        ) const { return scale_radius; }
+
+        bool has_prior (
+        ) const { return !prior.is_empty(); }
+
+        const rectangle& get_prior (
+        ) const { return prior; }
+
+        bool last_was_full_scan (
+        ) const { return full_scan; }
+
+        void reset (
+        )
+        {
+            prior = rectangle();
+            frames_since_full_scan = 0;
+            full_scan = false;
+        }
+
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<rect_detection>& dets,
+            const double adjust_threshold = 0
+        )
+        {
+            dets.clear();
+            full_scan = false;
+            if (has_prior() && frames_since_full_scan+1 < full_scan_interval)
+            {
+                ++frames_since_full_scan;
+                detect_near(detector, img, prior, max_shift, scale_radius, dets, adjust_threshold);
+            }
+
+            // fall back to scanning the whole image when the object wasn't found near
+            // where it was last seen or when a periodic full scan is due.
+            if (dets.size() == 0)
+            {
+                detector(img, dets, adjust_threshold);
+                frames_since_full_scan = 0;
+                full_scan = true;
+            }
+
+            prior = dets.size() != 0 ? dets[0].rect : rectangle();
+        }
+
+        template <
+            typename image_type
+            >
+        std::vector<rectangle> operator() (
+            const image_type& img,
+            const double adjust_threshold = 0
+        )
+        {
+            std::vector<rect_detection> dets;
+            (*this)(img, dets, adjust_threshold);
+
+            std::vector<rectangle> final_dets(dets.size());
+            for (unsigned long i = 0; i < dets.size(); ++i)
+                final_dets[i] = dets[i].rect;
+            return final_dets;
+        }
+
+    private:
+
+        void init (
+        )
+        {
+            full_scan_interval = 30;
+            max_shift = 0.25;
+            scale_radius = 1;
+            reset();
+        }
+
+        detector_type detector;
+        unsigned long full_scan_interval;
+        double max_shift;
+        unsigned long scale_radius;
+        rectangle prior;
+        unsigned long frames_since_full_scan;
+        bool full_scan;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_INCREMENTAL_OBJECT_DETECToR_H_
+
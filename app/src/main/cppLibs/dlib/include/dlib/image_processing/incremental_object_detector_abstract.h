@@ -0,0 +1,278 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_INCREMENTAL_OBJECT_DETECToR_ABSTRACT_H_
+#ifdef DLIB_INCREMENTAL_OBJECT_DETECToR_ABSTRACT_H_
+
+#include "object_detector_abstract.h"
+#include "scan_fhog_pyramid_abstract.h"
+#include "../threads/thread_pool_extension_abstract.h"
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pyramid_type,
+        typename feature_extractor_type,
+        typename image_type
+        >
+    void detect_near (
+        const object_detector<scan_fhog_pyramid<pyramid_type,feature_extractor_type> >& detector,
+        const image_type& img,
+        const rectangle& prior,
+        const double max_shift,
+        const unsigned long scale_radius,
+        std::vector<rect_detection>& dets,
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h
+            - detector.num_detectors() > 0
+            - prior.is_empty() == false
+            - max_shift >= 0
+        ensures
+            - Runs detector on img, but only looks for objects near prior.  This is meant
+              for video, where an object found in one frame moves and changes scale only
+              a little by the next one.  In particular:
+                - Let L be the pyramid level at which an object the size of prior best
+                  fits the detection window.  Only pyramid levels L-scale_radius through
+                  L+scale_radius are scored.
+                - Only detections whose centers are within max_shift*max(prior.width(),
+                  prior.height()) pixels of center(prior), in each direction, are kept.
+                - FHOG features are computed only for the part of img that such
+                  detections can overlap, not for the whole image.
+            - #dets == the detections found, after the same non-max suppression
+              object_detector::operator() performs.  They are in image coordinates and
+              their detection_confidence and weight_index fields have the same meaning as
+              in object_detector::operator().
+            - Since the image pyramid is built from a crop of img, #dets can differ
+              slightly from what running detector on the whole image would give for the
+              same object.
+            - adjust_threshold has the same meaning as in object_detector::operator().
+    !*/
+
+    template <
+        typename pyramid_type,
+        typename feature_extractor_type,
+        typename image_type
+        >
+    void detect_near (
+        const object_detector<scan_fhog_pyramid<pyramid_type,feature_extractor_type> >& detector,
+        const image_type& img,
+        const rectangle& prior,
+        const double max_shift,
+        const unsigned long scale_radius,
+        std::vector<rect_detection>& dets,
+        thread_pool& tp,
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - The same requirements as the detect_near() above.
+        ensures
+            - Performs the same computation as the detect_near() above, producing
+              identical output, but uses tp to extract the FHOG levels and scan them in
+              parallel.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename Feature_extractor_type = default_fhog_feature_extractor
+        >
+    class incremental_object_detector
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object runs an object_detector on the frames of a video and avoids
+                scanning the whole frame every time.  After an object is found it
+                remembers the strongest detection and, on the following frames, searches
+                only around it with detect_near().  It goes back to scanning the whole
+                frame when:
+                    - the search around the previous detection finds nothing.  The full
+                      scan is then done on that same frame, so losing the object doesn't
+                      cost a frame.
+                    - get_full_scan_interval() frames have gone by since the last full
+                      scan.  This is how new objects entering the frame get picked up.
+                So in steady state most frames cost only a small part of a full scan.
+
+            THREAD SAFETY
+                Instances of this object keep state between frames, so a single
+                instance must not be used by multiple threads at the same time.
+        !*/
+
+    public:
+
+        typedef Pyramid_type pyramid_type;
+        typedef Feature_extractor_type feature_extractor_type;
+        typedef object_detector<scan_fhog_pyramid<pyramid_type,feature_extractor_type> > detector_type;
+
+        incremental_object_detector (
+        );
+        /*!
+            ensures
+                - #get_detector() == a default constructed detector_type
+                - #get_full_scan_interval() == 30
+                - #get_max_shift() == 0.25
+                - #get_scale_radius() == 1
+                - #has_prior() == false
+                - #last_was_full_scan() == false
+        !*/
+
+        explicit incremental_object_detector (
+            const detector_type& detector
+        );
+        /*!
+            ensures
+                - #get_detector() == detector
+                - The other settings have the same values as with the default
+                  constructor.
+        !*/
+
+        const detector_type& get_detector (
+        ) const;
+        /*!
+            ensures
+                - returns the detector this object runs.
+        !*/
+
+        void set_full_scan_interval (
+            unsigned long num_frames
+        );
+        /*!
+            requires
+                - num_frames > 0
+            ensures
+                - #get_full_scan_interval() == num_frames
+        !*/
+
+        unsigned long get_full_scan_interval (
+        ) const;
+        /*!
+            ensures
+                - returns the largest number of frames between two full scans.  That is,
+                  at least one of every get_full_scan_interval() frames is scanned
+                  entirely.  So 1 means every frame gets a full scan.
+        !*/
+
+        void set_max_shift (
+            double fraction
+        );
+        /*!
+            requires
+                - fraction >= 0
+            ensures
+                - #get_max_shift() == fraction
+        !*/
+
+        double get_max_shift (
+        ) const;
+        /*!
+            ensures
+                - returns how far, as a fraction of its size, an object may move between
+                  two frames and still be found by the search around its previous
+                  position.  This is the max_shift argument given to detect_near().
+        !*/
+
+        void set_scale_radius (
+            unsigned long num_levels
+        );
+        /*!
+            ensures
+                - #get_scale_radius() == num_levels
+        !*/
+
+        unsigned long get_scale_radius (
+        ) const;
+        /*!
+            ensures
+                - returns how many pyramid levels above and below the previous
+                  detection's scale are searched.  This is the scale_radius argument given
+                  to detect_near().
+        !*/
+
+        bool has_prior (
+        ) const;
+        /*!
+            ensures
+                - returns true if the last frame given to operator() had a detection in
+                  it, and therefore the next frame may be searched around it.
+        !*/
+
+        const rectangle& get_prior (
+        ) const;
+        /*!
+            requires
+                - has_prior() == true
+            ensures
+                - returns the strongest detection found in the last frame given to
+                  operator().
+        !*/
+
+        bool last_was_full_scan (
+        ) const;
+        /*!
+            ensures
+                - returns true if the last call to operator() scanned the whole frame.
+        !*/
+
+        void reset (
+        );
+        /*!
+            ensures
+                - #has_prior() == false
+                - #last_was_full_scan() == false
+                - The next call to operator() does a full scan.  Call this when the video
+                  source changes.
+        !*/
+
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<rect_detection>& dets,
+            const double adjust_threshold = 0
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h
+            ensures
+                - Finds the objects in img, which is taken to be the next frame of the
+                  video.  Depending on the state of this object, either the whole frame
+                  is scanned with get_detector() or only the area around get_prior() is
+                  searched with detect_near(), as described above.
+                - #dets == the detections found, sorted from most to least confident.
+                - #last_was_full_scan() == true if the whole frame was scanned.
+                - #has_prior() == (#dets.size() != 0)
+                - if (#has_prior()) then
+                    - #get_prior() == #dets[0].rect
+        !*/
+
+        template <
+            typename image_type
+            >
+        std::vector<rectangle> operator() (
+            const image_type& img,
+            const double adjust_threshold = 0
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h
+            ensures
+                - Performs the same computation as the operator() above, and returns the
+                  rectangles of the detections.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_INCREMENTAL_OBJECT_DETECToR_ABSTRACT_H_
+
@@ -0,0 +1,381 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_MULTI_TARGET_TRACKER_H_
+#define DLIB_MULTI_TARGET_TRACKER_H_
+
+#include "multi_target_tracker_abstract.h"
+#include "correlation_tracker.h"
+#include "box_overlap_testing.h"
+#include "../optimization/max_cost_assignment.h"
+#include "../threads/thread_pool_extension.h"
+#include "generic_image.h"
+#include <vector>
+#include <cmath>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct tracked_target
+    {
+        unsigned long id = 0;
+        drectangle rect;
+        double confidence = 0;
+        unsigned long age = 0;
+        unsigned long frames_since_detection = 0;
+        unsigned long missed_detections = 0;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class multi_target_tracker
+    {
+    public:
+
+        multi_target_tracker (
+        )
+        {
+            init();
+        }
+
+        explicit multi_target_tracker (
+            const correlation_tracker& prototype_
+        ) : prototype(prototype_)
+        {
+            init();
+        }
+
+        const correlation_tracker& get_prototype (
+        ) const { return prototype; }
+
+        double get_match_threshold (
+        ) const { return match_threshold; }
+
+        void set_match_threshold (
+            double thresh
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(0 < thresh && thresh <= 1,
+                "\t void multi_target_tracker::set_match_threshold()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t thresh: " << thresh
+            );
+            match_threshold = thresh;
+        }
+
+        double get_max_target_overlap (
+        ) const { return max_target_overlap; }
+
+        void set_max_target_overlap (
+            double overlap
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(0 < overlap && overlap <= 1,
+                "\t void multi_target_tracker::set_max_target_overlap()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t overlap: " << overlap
+            );
+            max_target_overlap = overlap;
+        }
+
+        unsigned long get_max_missed_detections (
+        ) const { return max_missed_detections; }
+
+        void set_max_missed_detections (
+            unsigned long num
+        ) { max_missed_detections = num; }
+
+        double get_min_confidence (
+        ) const { return min_confidence; }
+
+        void set_min_confidence (
+            double conf
+        ) { min_confidence = conf; }
+
+        unsigned long num_targets (
+        ) const { return targets.size(); }
+
+        const std::vector<tracked_target>& get_targets (
+        ) const { return targets; }
+
+        std::vector<unsigned long> get_low_confidence_targets (
+            double thresh
+        ) const
+        {
+            std::vector<unsigned long> ids;
+            for (unsigned long i = 0; i < targets.size(); ++i)
+            {
+                if (targets[i].confidence < thresh)
+                    ids.push_back(targets[i].id);
+            }
+            return ids;
+        }
+
+        void clear (
+        )
+        {
+            targets.clear();
+            trackers.clear();
+        }
+
+        template <typename image_type>
+        void update (
+            const image_type& img
+        )
+        {
+            for (unsigned long i = 0; i < trackers.size(); ++i)
+                update_target(img, i);
+            remove_lost_targets();
+        }
+
+        template <typename image_type>
+        void update (
+            const image_type& img,
+            thread_pool& tp
+        )
+        {
+            for (unsigned long i = 0; i < trackers.size(); ++i)
+                tp.add_task_by_value([&,i](){ update_target(img, i); });
+            tp.wait_for_all_tasks();
+            remove_lost_targets();
+        }
+
+        template <typename image_type>
+        void add_detections (
+            const image_type& img,
+            const std::vector<rectangle>& dets
+        )
+        {
+            add_detections(img, dets, get_rect(img));
+        }
+
+        template <typename image_type>
+        void add_detections (
+            const image_type& img,
+            const std::vector<rectangle>& dets,
+            const rectangle& searched_area
+        )
+        {
+            associate_detections(dets, searched_area);
+            for (unsigned long i = 0; i < to_start.size(); ++i)
+                start_target(img, to_start[i]);
+            remove_missed_targets();
+        }
+
+        template <typename image_type>
+        void add_detections (
+            const image_type& img,
+            const std::vector<rectangle>& dets,
+            const rectangle& searched_area,
+            thread_pool& tp
+        )
+        {
+            associate_detections(dets, searched_area);
+            for (unsigned long i = 0; i < to_start.size(); ++i)
+            {
+                const unsigned long idx = to_start[i];
+                tp.add_task_by_value([&,idx](){ start_target(img, idx); });
+            }
+            tp.wait_for_all_tasks();
+            remove_missed_targets();
+        }
+
+    private:
+
+        void init (
+        )
+        {
+            match_threshold = 0.3;
+            max_target_overlap = 0.6;
+            max_missed_detections = 1;
+            min_confidence = 0;
+            next_id = 0;
+        }
+
+        template <typename image_type>
+        void update_target (
+            const image_type& img,
+            unsigned long i
+        )
+        {
+            tracked_target& t = targets[i];
+            t.confidence = trackers[i].update(img);
+            t.rect = trackers[i].get_position();
+            ++t.age;
+            ++t.frames_since_detection;
+        }
+
+        template <typename image_type>
+        void start_target (
+            const image_type& img,
+            unsigned long i
+        )
+        {
+            trackers[i].start_track(img, targets[i].rect);
+        }
+
+        void associate_detections (
+            const std::vector<rectangle>& dets,
+            const rectangle& searched_area
+        )
+        /*!
+            ensures
+                - Matches dets to the current targets, adds a target for each unmatched
+                  detection, and counts a miss against each unmatched target inside
+                  searched_area.
+                - #to_start == the indices of the targets whose trackers need to be
+                  (re)started on their new rect.
+        !*/
+        {
+            to_start.clear();
+            const unsigned long num_old = targets.size();
+            std::vector<long> assignment(num_old, -1);
+
+            const long size = std::max(num_old, (unsigned long)dets.size());
+            if (num_old != 0 && dets.size() != 0)
+            {
+                // max_cost_assignment() only works with integer matrices, so scale the
+                // overlaps up and round them.
+                cost.set_size(size, size);
+                cost = 0;
+                for (unsigned long i = 0; i < num_old; ++i)
+                {
+                    for (unsigned long j = 0; j < dets.size(); ++j)
+                    {
+                        const double overlap = box_intersection_over_union(targets[i].rect, drectangle(dets[j]));
+                        if (overlap >= match_threshold)
+                            cost(i,j) = std::lround(overlap*1e6);
+                    }
+                }
+                const std::vector<long> temp = max_cost_assignment(cost);
+                for (unsigned long i = 0; i < num_old; ++i)
+                {
+                    if (temp[i] < (long)dets.size() && cost(i,temp[i]) != 0)
+                        assignment[i] = temp[i];
+                }
+            }
+
+            matched.assign(dets.size(), false);
+            for (unsigned long i = 0; i < num_old; ++i)
+            {
+                tracked_target& t = targets[i];
+                if (assignment[i] >= 0)
+                {
+                    matched[assignment[i]] = true;
+                    t.rect = dets[assignment[i]];
+                    t.frames_since_detection = 0;
+                    t.missed_detections = 0;
+                    to_start.push_back(i);
+                }
+                else if (searched_area.contains(center(t.rect)))
+                {
+                    ++t.missed_detections;
+                }
+            }
+
+            for (unsigned long j = 0; j < dets.size(); ++j)
+            {
+                if (matched[j])
+                    continue;
+
+                // make sure requires clause is not broken
+                DLIB_ASSERT(dets[j].is_empty() == false,
+                    "\t void multi_target_tracker::add_detections()"
+                    << "\n\t You can't give an empty rectangle."
+                    << "\n\t j: " << j
+                );
+
+                tracked_target t;
+                t.id = next_id++;
+                t.rect = dets[j];
+                targets.push_back(t);
+                trackers.push_back(prototype);
+                to_start.push_back(targets.size()-1);
+            }
+        }
+
+        void remove_missed_targets (
+        )
+        {
+            unsigned long out = 0;
+            for (unsigned long i = 0; i < targets.size(); ++i)
+            {
+                if (targets[i].missed_detections > max_missed_detections)
+                    continue;
+                keep(i, out++);
+            }
+            targets.resize(out);
+            trackers.resize(out);
+        }
+
+        void remove_lost_targets (
+        )
+        /*!
+            ensures
+                - removes the targets whose confidence fell below min_confidence, as well
+                  as the younger of any two targets that overlap by more than
+                  max_target_overlap, since both are following the same object.
+        !*/
+        {
+            unsigned long out = 0;
+            for (unsigned long i = 0; i < targets.size(); ++i)
+            {
+                if (targets[i].confidence < min_confidence)
+                    continue;
+
+                // Targets are stored in the order they were added, so the ones we
+                // already kept are older than this one.
+                bool duplicate = false;
+                for (unsigned long j = 0; j < out; ++j)
+                {
+                    if (box_intersection_over_union(targets[j].rect, targets[i].rect) > max_target_overlap)
+                    {
+                        duplicate = true;
+                        break;
+                    }
+                }
+                if (duplicate)
+                    continue;
+
+                keep(i, out++);
+            }
+            targets.resize(out);
+            trackers.resize(out);
+        }
+
+        void keep (
+            unsigned long from,
+            unsigned long to
+        )
+        {
+            if (from != to)
+            {
+                targets[to] = targets[from];
+                std::swap(trackers[to], trackers[from]);
+            }
+        }
+
+        correlation_tracker prototype;
+        std::vector<tracked_target> targets;
+        std::vector<correlation_tracker> trackers;
+        unsigned long next_id;
+
+        double match_threshold;
+        double max_target_overlap;
+        unsigned long max_missed_detections;
+        double min_confidence;
+
+        // Scratch space for associate_detections() so repeated calls don't allocate.
+        matrix<long> cost;
+        std::vector<bool> matched;
+        std::vector<unsigned long> to_start;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_MULTI_TARGET_TRACKER_H_
+
@@ -0,0 +1,328 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_MULTI_TARGET_TRACKER_ABSTRACT_H_
+#ifdef DLIB_MULTI_TARGET_TRACKER_ABSTRACT_H_
+
+#include "correlation_tracker_abstract.h"
+#include "../threads/thread_pool_extension_abstract.h"
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct tracked_target
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object describes one of the targets followed by a
+                multi_target_tracker.
+        !*/
+
+        // A number identifying the target.  It stays the same for the whole life of the
+        // target and is never given to another target by the same tracker.
+        unsigned long id = 0;
+
+        // Where the target is in the last image given to the tracker.
+        drectangle rect;
+
+        // The peak to side-lobe ratio returned by the last correlation_tracker::update()
+        // of this target, or 0 if it hasn't been updated since it was detected.  Larger
+        // values mean the tracker is more sure the target is inside rect.
+        double confidence = 0;
+
+        // The number of update() calls since the target was first detected.
+        unsigned long age = 0;
+
+        // The number of update() calls since the target was last matched to a detection.
+        unsigned long frames_since_detection = 0;
+
+        // The number of add_detections() calls in a row, whose searched area contained
+        // the target, that didn't match it to a detection.
+        unsigned long missed_detections = 0;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class multi_target_tracker
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object follows several objects, such as the faces in a group scene,
+                from frame to frame.  It runs one correlation_tracker per target and
+                manages the targets from the output of an object detector, which is
+                meant to be run only every few frames.
+
+                A typical use looks like this:
+                    multi_target_tracker mtt;
+                    for each frame:
+                        if (it's time to run the detector)
+                            mtt.add_detections(frame, detector(frame));
+                        else
+                            mtt.update(frame, tp);
+
+                add_detections() matches the detections to the targets with the
+                Hungarian algorithm, maximizing their total intersection over union.
+                Matched targets are restarted on their detection, so a tracker that
+                drifted is pulled back onto the object.  Unmatched detections become new
+                targets, and targets the detector misses too many times in a row are
+                dropped.  Since each target reports its confidence, the detector can
+                also be run only around the targets that need it, see
+                get_low_confidence_targets().
+
+                Every target's correlation_tracker is a copy of get_prototype(), so the
+                cosine windows and FFT plans are computed only once instead of once per
+                target.
+
+            THREAD SAFETY
+                The thread_pool overloads run each target's tracker in its own task.
+                Apart from that, this object is not thread safe.
+        !*/
+
+    public:
+
+        multi_target_tracker (
+        );
+        /*!
+            ensures
+                - #get_prototype() is a default constructed correlation_tracker.
+                - #num_targets() == 0
+                - #get_match_threshold() == 0.3
+                - #get_max_target_overlap() == 0.6
+                - #get_max_missed_detections() == 1
+                - #get_min_confidence() == 0
+        !*/
+
+        explicit multi_target_tracker (
+            const correlation_tracker& prototype
+        );
+        /*!
+            ensures
+                - #get_prototype() == prototype.  So all the targets are tracked with the
+                  settings of prototype.
+                - The other settings are as for the default constructor.
+        !*/
+
+        const correlation_tracker& get_prototype (
+        ) const;
+        /*!
+            ensures
+                - returns the correlation_tracker every new target's tracker is copied
+                  from before tracking starts.
+        !*/
+
+        double get_match_threshold (
+        ) const;
+        /*!
+            ensures
+                - returns the smallest intersection over union a detection and a target
+                  can have and still be matched by add_detections().
+        !*/
+
+        void set_match_threshold (
+            double thresh
+        );
+        /*!
+            requires
+                - 0 < thresh <= 1
+            ensures
+                - #get_match_threshold() == thresh
+        !*/
+
+        double get_max_target_overlap (
+        ) const;
+        /*!
+            ensures
+                - returns the largest intersection over union two targets can have after
+                  update().  Targets that overlap by more than this have converged on
+                  the same object, so the younger one is removed.
+        !*/
+
+        void set_max_target_overlap (
+            double overlap
+        );
+        /*!
+            requires
+                - 0 < overlap <= 1
+            ensures
+                - #get_max_target_overlap() == overlap
+        !*/
+
+        unsigned long get_max_missed_detections (
+        ) const;
+        /*!
+            ensures
+                - returns the number of times in a row add_detections() can miss a target
+                  before the target is removed.
+        !*/
+
+        void set_max_missed_detections (
+            unsigned long num
+        );
+        /*!
+            ensures
+                - #get_max_missed_detections() == num
+        !*/
+
+        double get_min_confidence (
+        ) const;
+        /*!
+            ensures
+                - returns the confidence below which update() considers a target lost and
+                  removes it.
+        !*/
+
+        void set_min_confidence (
+            double conf
+        );
+        /*!
+            ensures
+                - #get_min_confidence() == conf
+        !*/
+
+        unsigned long num_targets (
+        ) const;
+        /*!
+            ensures
+                - returns get_targets().size()
+        !*/
+
+        const std::vector<tracked_target>& get_targets (
+        ) const;
+        /*!
+            ensures
+                - returns the targets currently being followed, in the order they were
+                  first detected.  So their ids are increasing.
+        !*/
+
+        std::vector<unsigned long> get_low_confidence_targets (
+            double thresh
+        ) const;
+        /*!
+            ensures
+                - returns the ids of the targets whose confidence is less than thresh.
+                  These are the targets it is worth running the detector around, e.g.
+                  with a scan_fhog_pyramid search region.
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - #num_targets() == 0
+                - The settings and the prototype are unchanged, and ids given out from
+                  now on still won't repeat the ids of the removed targets.
+        !*/
+
+        template <
+            typename image_type
+            >
+        void update (
+            const image_type& img
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h
+            ensures
+                - Calls update() on every target's correlation_tracker with img, which
+                  should be the next frame of the video.  Each target's rect and
+                  confidence are set from the results, its age and
+                  frames_since_detection are incremented.
+                - Then removes the targets whose confidence is less than
+                  get_min_confidence() and, of any two targets overlapping by more than
+                  get_max_target_overlap(), the younger one.
+        !*/
+
+        template <
+            typename image_type
+            >
+        void update (
+            const image_type& img,
+            thread_pool& tp
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h
+            ensures
+                - Performs the same computation as update(img), except the targets are
+                  updated in parallel using the threads in tp.  The results are the same.
+        !*/
+
+        template <
+            typename image_type
+            >
+        void add_detections (
+            const image_type& img,
+            const std::vector<rectangle>& dets,
+            const rectangle& searched_area
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h
+                - for all valid i:
+                    - dets[i].is_empty() == false
+            ensures
+                - dets should be the output of an object detector run on img, over
+                  searched_area.
+                - Matches the targets to dets, maximizing the total intersection over
+                  union of the matched pairs.  Pairs that overlap by less than
+                  get_match_threshold() are never matched.
+                - Each matched target's tracker is restarted on img at its detection,
+                  and its rect is set to the detection.  Its frames_since_detection and
+                  missed_detections are reset to 0.
+                - Each unmatched detection becomes a new target with a new id.
+                - Each unmatched target whose center is inside searched_area gets its
+                  missed_detections incremented.  Targets outside searched_area are left
+                  as they are, since the detector didn't look at them.
+                - Targets whose missed_detections is now more than
+                  get_max_missed_detections() are removed.
+        !*/
+
+        template <
+            typename image_type
+            >
+        void add_detections (
+            const image_type& img,
+            const std::vector<rectangle>& dets
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h
+                - for all valid i:
+                    - dets[i].is_empty() == false
+            ensures
+                - performs add_detections(img, dets, get_rect(img)).
+        !*/
+
+        template <
+            typename image_type
+            >
+        void add_detections (
+            const image_type& img,
+            const std::vector<rectangle>& dets,
+            const rectangle& searched_area,
+            thread_pool& tp
+        );
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h
+                - for all valid i:
+                    - dets[i].is_empty() == false
+            ensures
+                - Performs the same computation as add_detections(img, dets,
+                  searched_area), except the trackers are started in parallel using the
+                  threads in tp.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_MULTI_TARGET_TRACKER_ABSTRACT_H_
+
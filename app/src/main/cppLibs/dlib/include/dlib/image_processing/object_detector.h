@@ -8,6 +8,7 @@
 #include <vector>
 #include "box_overlap_testing.h"
 #include "full_object_detection.h"
+#include "../threads/thread_pool_extension.h"
 
 namespace dlib
 {
@@ -177,6 +178,25 @@ namespace dlib
             double adjust_threshold = 0
         );
 
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<rect_detection>& final_dets,
+            thread_pool& tp,
+            double adjust_threshold = 0
+        );
+
+        template <
+            typename image_type
+            >
+        std::vector<rectangle> operator() (
+            const image_type& img,
+            thread_pool& tp,
+            double adjust_threshold = 0
+        );
+
         template <typename T>
         friend void serialize (
             const object_detector<T>& item,
@@ -191,6 +211,24 @@ namespace dlib
 
     private:
 
+        void suppress_overlapping_detections (
+            std::vector<rect_detection>& dets_accum,
+            std::vector<rect_detection>& final_dets
+        ) const
+        {
+            // Do non-max suppression
+            final_dets.clear();
+            if (w.size() > 1)
+                std::sort(dets_accum.rbegin(), dets_accum.rend());
+            for (unsigned long i = 0; i < dets_accum.size(); ++i)
+            {
+                if (overlaps_any_box(final_dets, dets_accum[i].rect))
+                    continue;
+
+                final_dets.push_back(dets_accum[i]);
+            }
+        }
+
         bool overlaps_any_box (
             const std::vector<rect_detection>& rects,
             const dlib::rectangle& rect
@@ -207,6 +245,10 @@ namespace dlib
         test_box_overlap boxes_overlap;
         std::vector<processed_weight_vector<image_scanner_type> > w;
         image_scanner_type scanner;
+
+        // Reused by operator() so that repeated calls don't allocate.
+        std::vector<std::pair<double, rectangle> > temp_dets;
+        std::vector<rect_detection> temp_dets_accum;
     };
 
 // ----------------------------------------------------------------------------------------
@@ -431,8 +473,9 @@ namespace dlib
     ) 
     {
         scanner.load(img);
-        std::vector<std::pair<double, rectangle> > dets;
-        std::vector<rect_detection> dets_accum;
+        std::vector<std::pair<double, rectangle> >& dets = temp_dets;
+        std::vector<rect_detection>& dets_accum = temp_dets_accum;
+        dets_accum.clear();
         for (unsigned long i = 0; i < w.size(); ++i)
         {
             const double thresh = w[i].w(scanner.get_num_dimensions());
@@ -447,17 +490,69 @@ namespace dlib
             }
         }
 
-        // Do non-max suppression
-        final_dets.clear();
-        if (w.size() > 1)
-            std::sort(dets_accum.rbegin(), dets_accum.rend());
-        for (unsigned long i = 0; i < dets_accum.size(); ++i)
-        {
-            if (overlaps_any_box(final_dets, dets_accum[i].rect))
-                continue;
+        suppress_overlapping_detections(dets_accum, final_dets);
+    }
+
+// ----------------------------------------------------------------------------------------
 
-            final_dets.push_back(dets_accum[i]);
+    template <
+        typename image_scanner_type
+        >
+    template <
+        typename image_type
+        >
+    void object_detector<image_scanner_type>::
+    operator() (
+        const image_type& img,
+        std::vector<rect_detection>& final_dets,
+        thread_pool& tp,
+        double adjust_threshold
+    ) 
+    {
+        scanner.load(img, tp);
+        std::vector<std::pair<double, rectangle> >& dets = temp_dets;
+        std::vector<rect_detection>& dets_accum = temp_dets_accum;
+        dets_accum.clear();
+        for (unsigned long i = 0; i < w.size(); ++i)
+        {
+            const double thresh = w[i].w(scanner.get_num_dimensions());
+            scanner.detect(w[i].get_detect_argument(), dets, thresh + adjust_threshold, tp);
+            for (unsigned long j = 0; j < dets.size(); ++j)
+            {
+                rect_detection temp;
+                temp.detection_confidence = dets[j].first-thresh;
+                temp.weight_index = i;
+                temp.rect = dets[j].second;
+                dets_accum.push_back(temp);
+            }
         }
+
+        suppress_overlapping_detections(dets_accum, final_dets);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_scanner_type
+        >
+    template <
+        typename image_type
+        >
+    std::vector<rectangle> object_detector<image_scanner_type>::
+    operator() (
+        const image_type& img,
+        thread_pool& tp,
+        double adjust_threshold
+    ) 
+    {
+        std::vector<rect_detection> dets;
+        (*this)(img,dets,tp,adjust_threshold);
+
+        std::vector<rectangle> final_dets(dets.size());
+        for (unsigned long i = 0; i < dets.size(); ++i)
+            final_dets[i] = dets[i].rect;
+
+        return final_dets;
     }
 
 // ----------------------------------------------------------------------------------------
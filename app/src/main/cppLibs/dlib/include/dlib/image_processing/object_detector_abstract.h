@@ -255,6 +255,13 @@ namespace dlib
                     - #dets[i].detection_confidence >= adjust_threshold
                   This means that, for example, you can obtain the maximum possible number
                   of detections by setting adjust_threshold equal to negative infinity.
+                - The intermediate detection lists are kept between calls.  Together with
+                  a scanner that reuses its own memory, such as scan_fhog_pyramid, this
+                  means calling this function repeatedly on same sized images with the
+                  same dets object doesn't allocate any memory once dets is big enough.
+                  For scan_fhog_pyramid this holds for every pyramid type except
+                  pyramid_down<2> on images whose pixels aren't unsigned char, which
+                  allocates one temporary image per pyramid level.
         !*/
 
         template <
@@ -294,6 +301,47 @@ namespace dlib
                   boxes of all the detections. 
         !*/
 
+        template <
+            typename image_type
+            >
+        void operator() (
+            const image_type& img,
+            std::vector<rect_detection>& dets,
+            thread_pool& tp,
+            double adjust_threshold = 0
+        );
+        /*!
+            requires
+                - img == an object which can be accepted by image_scanner_type::load()
+                - image_scanner_type has load(img,tp) and detect(w,dets,thresh,tp)
+                  overloads which take a thread_pool (e.g. scan_fhog_pyramid).
+            ensures
+                - This function is identical to the operator() above that outputs
+                  rect_detections, except that the scanner uses the threads in tp to
+                  build its features and score the image.  The output is exactly the same
+                  as the single threaded version's, in the same order.  This version
+                  reuses its memory in the same way as the single threaded one does.
+        !*/
+
+        template <
+            typename image_type
+            >
+        std::vector<rectangle> operator() (
+            const image_type& img,
+            thread_pool& tp,
+            double adjust_threshold = 0
+        );
+        /*!
+            requires
+                - img == an object which can be accepted by image_scanner_type::load()
+                - image_scanner_type has load(img,tp) and detect(w,dets,thresh,tp)
+                  overloads which take a thread_pool (e.g. scan_fhog_pyramid).
+            ensures
+                - This function is identical to the above operator() routine, except that
+                  it returns a std::vector<rectangle> which contains just the bounding
+                  boxes of all the detections. 
+        !*/
+
         template <
             typename image_type
             >
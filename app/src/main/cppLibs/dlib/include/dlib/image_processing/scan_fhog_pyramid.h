@@ -9,6 +9,9 @@
 #include "../array.h"
 #include "../array2d.h"
 #include "object_detector.h"
+#include "../threads/thread_pool_extension.h"
+#include <memory>
+#include <limits>
 
 namespace dlib
 {
@@ -52,6 +55,23 @@ namespace dlib
             extract_fhog_features(img,hog,cell_size,filter_rows_padding,filter_cols_padding);
         }
 
+        template <
+            typename image_type
+            >
+        void operator()(
+            const image_type& img, 
+            dlib::array<array2d<float> >& hog, 
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            impl_fhog::fhog_scratch& scratch
+        ) const
+        {
+            // Same as above, but works in scratch so repeated calls on images of the
+            // same size don't allocate anything.
+            impl_fhog::impl_extract_fhog_features(img,hog,cell_size,filter_rows_padding,filter_cols_padding,scratch);
+        }
+
         inline unsigned long get_num_planes (
         ) const
         {
@@ -62,6 +82,105 @@ namespace dlib
     inline void serialize   (const default_fhog_feature_extractor&, std::ostream&) {}
     inline void deserialize (default_fhog_feature_extractor&, std::istream&) {}
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        struct fhog_cascade_stage
+        {
+            // The strongest separable filters of a filter bank.  row_filters[k] and
+            // col_filters[k] filter the FHOG plane planes[k].
+            std::vector<unsigned long> planes;
+            std::vector<matrix<float,0,1> > row_filters, col_filters;
+        };
+
+        class fhog_pyramid_buffers : noncopyable
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    The memory scan_fhog_pyramid works in besides the feature pyramid
+                    itself.  Everything is kept per pyramid level, since the levels all
+                    have different sizes, so that loading and scanning another image of
+                    the same size reuses all of it and doesn't allocate.
+            !*/
+        public:
+
+            // The downsampled images of the pyramid.  Level 0 is the input image itself
+            // so images<T>()[0] is never used.
+            template <typename pixel_type>
+            dlib::array<array2d<pixel_type> >& images (
+            )
+            {
+                typed_images<pixel_type>* temp = dynamic_cast<typed_images<pixel_type>*>(level_images.get());
+                if (temp == 0)
+                {
+                    temp = new typed_images<pixel_type>;
+                    level_images.reset(temp);
+                }
+                return temp->images;
+            }
+
+            void set_num_levels (
+                unsigned long levels
+            )
+            {
+                if (extractor_scratch.size() < levels)
+                    extractor_scratch.resize(levels);
+                if (saliency_images.size() < levels)
+                {
+                    saliency_images.resize(levels);
+                    filter_scratch.resize(levels);
+                    band_saliency_images.resize(levels);
+                    band_scratch.resize(levels);
+                }
+            }
+
+            std::vector<impl_fhog::fhog_scratch> extractor_scratch;
+            dlib::array<array2d<float> > saliency_images;
+            dlib::array<array2d<float> > filter_scratch;
+            // Where a cascade's full filters score the bands of rows its first stage
+            // didn't reject.  The bands of a level all have the same size.
+            dlib::array<array2d<float> > band_saliency_images;
+            dlib::array<array2d<float> > band_scratch;
+
+            // The threaded detect() cuts the pyramid into jobs and gives each its own
+            // output.  The same image and thread pool always make the same jobs.
+            struct detection_job { unsigned long level; long top, bottom; };
+            std::vector<detection_job> detection_jobs;
+            dlib::array<array2d<float> > job_saliency_images;
+            dlib::array<array2d<float> > job_scratch;
+            std::vector<std::vector<std::pair<double, rectangle> > > job_dets;
+
+            void set_num_jobs (
+                unsigned long num_jobs
+            )
+            {
+                if (job_saliency_images.size() < num_jobs)
+                {
+                    job_saliency_images.resize(num_jobs);
+                    job_scratch.resize(num_jobs);
+                }
+                if (job_dets.size() < num_jobs)
+                    job_dets.resize(num_jobs);
+            }
+
+        private:
+
+            struct images_base
+            {
+                virtual ~images_base() {}
+            };
+
+            template <typename pixel_type>
+            struct typed_images : images_base
+            {
+                dlib::array<array2d<pixel_type> > images;
+            };
+
+            std::unique_ptr<images_base> level_images;
+        };
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -92,6 +211,14 @@ namespace dlib
             const image_type& img
         );
 
+        template <
+            typename image_type
+            >
+        void load (
+            const image_type& img,
+            thread_pool& tp
+        );
+
         inline bool is_loaded_with_image (
         ) const;
 
@@ -229,8 +356,74 @@ namespace dlib
                 return num;
             }
 
+            fhog_filterbank (
+            ) : rejection_threshold(-std::numeric_limits<double>::infinity()) {}
+
+            void set_cascade (
+                unsigned long num_components,
+                double rejection_threshold_
+            )
+            {
+                // make sure requires clause is not broken
+                DLIB_ASSERT(num_components > 0,
+                    "\t void fhog_filterbank::set_cascade()"
+                    << "\n\t Invalid inputs were given to this function "
+                    << "\n\t num_components: " << num_components
+                    << "\n\t this: " << this
+                    );
+
+                // Keep the separable filters with the largest singular values, over all
+                // the planes.  Their sum is the best low rank approximation of the
+                // filters we can get from them.  The singular value was split evenly
+                // between the row and column filters.
+                std::vector<std::pair<double, std::pair<unsigned long,unsigned long> > > components;
+                for (unsigned long i = 0; i < row_filters.size(); ++i)
+                {
+                    for (unsigned long j = 0; j < row_filters[i].size(); ++j)
+                    {
+                        const double strength = length(row_filters[i][j])*length(col_filters[i][j]);
+                        components.push_back(std::make_pair(strength, std::make_pair(i,j)));
+                    }
+                }
+                std::sort(components.rbegin(), components.rend());
+                components.resize(std::min<unsigned long>(components.size(), num_components));
+
+                cascade = impl::fhog_cascade_stage();
+                for (unsigned long k = 0; k < components.size(); ++k)
+                {
+                    const unsigned long i = components[k].second.first;
+                    const unsigned long j = components[k].second.second;
+                    cascade.planes.push_back(i);
+                    cascade.row_filters.push_back(row_filters[i][j]);
+                    cascade.col_filters.push_back(col_filters[i][j]);
+                }
+                rejection_threshold = rejection_threshold_;
+            }
+
+            void disable_cascade (
+            )
+            {
+                cascade = impl::fhog_cascade_stage();
+                rejection_threshold = -std::numeric_limits<double>::infinity();
+            }
+
+            unsigned long get_num_cascade_components (
+            ) const { return cascade.planes.size(); }
+
+            double get_rejection_threshold (
+            ) const { return rejection_threshold; }
+
+            bool uses_cascade (
+            ) const 
+            { 
+                return cascade.planes.size() != 0 && 
+                    rejection_threshold != -std::numeric_limits<double>::infinity(); 
+            }
+
             std::vector<matrix<float> > filters;
             std::vector<std::vector<matrix<float,0,1> > > row_filters, col_filters;
+            impl::fhog_cascade_stage cascade;
+            double rejection_threshold;
         };
 
         fhog_filterbank build_fhog_filterbank (
@@ -290,6 +483,26 @@ namespace dlib
             const double thresh
         ) const;
 
+        void detect (
+            const fhog_filterbank& w,
+            std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh
+        );
+
+        void detect (
+            const fhog_filterbank& w,
+            std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh,
+            thread_pool& tp
+        ) const;
+
+        void detect (
+            const fhog_filterbank& w,
+            std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh,
+            thread_pool& tp
+        );
+
 
         void get_feature_vector (
             const full_object_detection& obj,
@@ -385,6 +598,11 @@ namespace dlib
 
         feature_extractor_type fe;
         array<fhog_image> feats;
+        // Scratch memory kept between calls to load() and the non-const detect() so
+        // that scanning a stream of same sized images doesn't allocate.  It is not part
+        // of the scanner's state and so isn't serialized or copied.  The const member
+        // functions never touch it, so they stay safe to call from several threads.
+        impl::fhog_pyramid_buffers buffers;
         int cell_size;
         unsigned long padding; 
         unsigned long window_width;
@@ -412,11 +630,12 @@ namespace dlib
 
     namespace impl
     {
-        template <typename fhog_filterbank>
+        template <typename fhog_filterbank, typename fhog_planes>
         rectangle apply_filters_to_fhog (
             const fhog_filterbank& w,
-            const array<array2d<float> >& feats,
-            array2d<float>& saliency_image
+            const fhog_planes& feats,
+            array2d<float>& saliency_image,
+            array2d<float>& scratch
         )
         {
             const unsigned long num_separable_filters = w.num_separable_filters();
@@ -434,8 +653,9 @@ namespace dlib
             }
             else
             {
-                saliency_image.clear();
-                array2d<float> scratch;
+                // saliency_image isn't cleared since that would free its memory.  The
+                // first filter overwrites it instead of adding to it.
+                bool first = true;
 
                 // find the first filter to apply
                 unsigned long i = 0;
@@ -446,20 +666,76 @@ namespace dlib
                 {
                     for (unsigned long j = 0; j < w.row_filters[i].size(); ++j)
                     {
-                        if (saliency_image.size() == 0)
-                            area = float_spatially_filter_image_separable(feats[i], saliency_image, w.row_filters[i][j], w.col_filters[i][j],scratch,false);
-                        else
-                            area = float_spatially_filter_image_separable(feats[i], saliency_image, w.row_filters[i][j], w.col_filters[i][j],scratch,true);
+                        area = float_spatially_filter_image_separable(feats[i], saliency_image, w.row_filters[i][j], w.col_filters[i][j],scratch,!first);
+                        first = false;
                     }
                 }
-                if (saliency_image.size() == 0)
+                if (first)
                 {
-                    saliency_image.set_size(feats[0].nr(), feats[0].nc());
+                    saliency_image.set_size(num_rows(feats[0]), num_columns(feats[0]));
                     assign_all_pixels(saliency_image, 0);
                 }
             }
             return area;
         }
+
+        template <typename fhog_filterbank, typename fhog_planes>
+        rectangle apply_filters_to_fhog (
+            const fhog_filterbank& w,
+            const fhog_planes& feats,
+            array2d<float>& saliency_image
+        )
+        {
+            array2d<float> scratch;
+            return apply_filters_to_fhog(w, feats, saliency_image, scratch);
+        }
+
+        template <typename fhog_filterbank, typename fhog_planes>
+        rectangle apply_fhog_cascade_stage (
+            const fhog_filterbank& w,
+            const fhog_planes& feats,
+            array2d<float>& saliency_image,
+            array2d<float>& scratch
+        )
+        /*!
+            requires
+                - w.get_num_cascade_components() != 0
+            ensures
+                - filters feats with only the separable filters in w.cascade and returns
+                  the area of saliency_image that holds window scores.
+        !*/
+        {
+            rectangle area;
+            for (unsigned long k = 0; k < w.cascade.planes.size(); ++k)
+            {
+                area = float_spatially_filter_image_separable(feats[w.cascade.planes[k]], saliency_image,
+                    w.cascade.row_filters[k], w.cascade.col_filters[k], scratch, k != 0);
+            }
+            return area;
+        }
+
+        class fhog_band
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    The planes of one level of a FHOG pyramid, restricted to the rows of
+                    rect.  It can be given to apply_filters_to_fhog() in place of the
+                    level, without copying or allocating anything.
+            !*/
+        public:
+            fhog_band (
+                const array<array2d<float> >& feats_,
+                const rectangle& rect_
+            ) : feats(feats_), rect(rect_) {}
+
+            const const_sub_image_proxy<array2d<float> > operator[] (
+                unsigned long i
+            ) const { return sub_image(feats[i], rect); }
+
+        private:
+            const array<array2d<float> >& feats;
+            const rectangle rect;
+        };
     }
 
 // ----------------------------------------------------------------------------------------
@@ -555,6 +831,73 @@ namespace dlib
 
     namespace impl
     {
+        template <
+            typename pyramid_type
+            >
+        unsigned long num_fhog_pyramid_levels (
+            rectangle rect,
+            unsigned long min_pyramid_layer_width,
+            unsigned long min_pyramid_layer_height,
+            unsigned long max_pyramid_levels
+        )
+        {
+            // figure out how many pyramid levels we should be using based on the image size
+            unsigned long levels = 0;
+            pyramid_type pyr;
+            do
+            {
+                rect = pyr.rect_down(rect);
+                ++levels;
+            } while (rect.width() >= min_pyramid_layer_width && rect.height() >= min_pyramid_layer_height &&
+                levels < max_pyramid_levels);
+            return levels;
+        }
+
+        inline void clear_fhog_level (
+            array<array2d<float> >& planes,
+            const unsigned long num_planes
+        )
+        {
+            planes.resize(num_planes);
+            for (unsigned long i = 0; i < planes.size(); ++i)
+                planes[i].clear();
+        }
+
+        template <
+            typename feature_extractor_type,
+            typename image_type
+            >
+        void extract_fhog_level (
+            const feature_extractor_type& fe,
+            const image_type& img,
+            array<array2d<float> >& hog,
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            impl_fhog::fhog_scratch& 
+        )
+        {
+            fe(img, hog, cell_size, filter_rows_padding, filter_cols_padding);
+        }
+
+        template <
+            typename image_type
+            >
+        void extract_fhog_level (
+            const default_fhog_feature_extractor& fe,
+            const image_type& img,
+            array<array2d<float> >& hog,
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            impl_fhog::fhog_scratch& scratch
+        )
+        {
+            // The default extractor can reuse our scratch memory.  Other extractors
+            // don't know about it so they just get called normally.
+            fe(img, hog, cell_size, filter_rows_padding, filter_cols_padding, scratch);
+        }
+
         template <
             typename pyramid_type,
             typename image_type,
@@ -569,48 +912,228 @@ namespace dlib
             int filter_cols_padding,
             unsigned long min_pyramid_layer_width,
             unsigned long min_pyramid_layer_height,
-            unsigned long max_pyramid_levels
+            unsigned long max_pyramid_levels,
+            const unsigned long first_level,
+            fhog_pyramid_buffers& buffers
         )
         {
-            unsigned long levels = 0;
-            rectangle rect = get_rect(img);
-
-            // figure out how many pyramid levels we should be using based on the image size
+            const unsigned long levels = num_fhog_pyramid_levels<pyramid_type>(get_rect(img),
+                min_pyramid_layer_width, min_pyramid_layer_height, max_pyramid_levels);
             pyramid_type pyr;
-            do
-            {
-                rect = pyr.rect_down(rect);
-                ++levels;
-            } while (rect.width() >= min_pyramid_layer_width && rect.height() >= min_pyramid_layer_height &&
-                levels < max_pyramid_levels);
 
             if (feats.max_size() < levels)
                 feats.set_max_size(levels);
             feats.set_size(levels);
 
+            // Each level gets its own downsampled image and scratch memory, so when the
+            // next image has the same size nothing needs to be allocated.
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            array<array2d<pixel_type> >& images = buffers.images<pixel_type>();
+            if (images.size() < levels)
+                images.resize(levels);
+            buffers.set_num_levels(levels);
+
+            // build our feature pyramid.  The levels before first_level are only
+            // downsampled through and get empty feature planes.
+            if (first_level == 0)
+            {
+                extract_fhog_level(fe, img, feats[0], cell_size,filter_rows_padding,filter_cols_padding,
+                    buffers.extractor_scratch[0]);
+                DLIB_ASSERT(feats[0].size() == fe.get_num_planes(), 
+                    "Invalid feature extractor used with dlib::scan_fhog_pyramid.  The output does not have the \n"
+                    "indicated number of planes.");
+            }
+            else
+            {
+                clear_fhog_level(feats[0], fe.get_num_planes());
+            }
 
+            for (unsigned long i = 1; i < feats.size(); ++i)
+            {
+                if (i == 1)
+                    pyr(img, images[1]);
+                else
+                    pyr(images[i-1], images[i]);
+
+                if (i >= first_level)
+                    extract_fhog_level(fe, images[i], feats[i], cell_size,filter_rows_padding,filter_cols_padding,
+                        buffers.extractor_scratch[i]);
+                else
+                    clear_fhog_level(feats[i], fe.get_num_planes());
+            }
+        }
 
-            // build our feature pyramid
-            fe(img, feats[0], cell_size,filter_rows_padding,filter_cols_padding);
-            DLIB_ASSERT(feats[0].size() == fe.get_num_planes(), 
-                "Invalid feature extractor used with dlib::scan_fhog_pyramid.  The output does not have the \n"
-                "indicated number of planes.");
+        template <
+            typename pyramid_type,
+            typename image_type,
+            typename feature_extractor_type
+            >
+        void create_fhog_pyramid (
+            const image_type& img,
+            const feature_extractor_type& fe,
+            array<array<array2d<float> > >& feats,
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            unsigned long min_pyramid_layer_width,
+            unsigned long min_pyramid_layer_height,
+            unsigned long max_pyramid_levels,
+            const unsigned long first_level = 0
+        )
+        {
+            fhog_pyramid_buffers buffers;
+            create_fhog_pyramid<pyramid_type>(img, fe, feats, cell_size, filter_rows_padding,
+                filter_cols_padding, min_pyramid_layer_width, min_pyramid_layer_height,
+                max_pyramid_levels, first_level, buffers);
+        }
+
+        template <
+            typename image_type,
+            typename feature_extractor_type
+            >
+        class fhog_level_extractor
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    The tasks the threaded create_fhog_pyramid() hands to the pool.
+                    extract(i) fills in feats[i].  Queuing a member function with a long
+                    argument doesn't make the pool allocate, unlike queuing a lambda by
+                    value.
+            !*/
+        public:
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+
+            fhog_level_extractor (
+                const image_type& img_,
+                const feature_extractor_type& fe_,
+                array<array<array2d<float> > >& feats_,
+                int cell_size_,
+                int filter_rows_padding_,
+                int filter_cols_padding_,
+                fhog_pyramid_buffers& buffers_
+            ) : img(img_), fe(fe_), feats(feats_), cell_size(cell_size_),
+                filter_rows_padding(filter_rows_padding_), filter_cols_padding(filter_cols_padding_),
+                images(buffers_.images<pixel_type>()), scratch(buffers_.extractor_scratch) {}
+
+            void extract (
+                long i
+            )
+            {
+                if (i == 0)
+                    extract_fhog_level(fe, img, feats[0], cell_size, filter_rows_padding,
+                        filter_cols_padding, scratch[0]);
+                else
+                    extract_fhog_level(fe, images[i], feats[i], cell_size, filter_rows_padding,
+                        filter_cols_padding, scratch[i]);
+            }
+
+        private:
+            const image_type& img;
+            const feature_extractor_type& fe;
+            array<array<array2d<float> > >& feats;
+            const int cell_size;
+            const int filter_rows_padding;
+            const int filter_cols_padding;
+            const array<array2d<pixel_type> >& images;
+            std::vector<impl_fhog::fhog_scratch>& scratch;
+        };
+
+        template <
+            typename pyramid_type,
+            typename image_type,
+            typename feature_extractor_type
+            >
+        void create_fhog_pyramid (
+            const image_type& img,
+            const feature_extractor_type& fe,
+            array<array<array2d<float> > >& feats,
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            unsigned long min_pyramid_layer_width,
+            unsigned long min_pyramid_layer_height,
+            unsigned long max_pyramid_levels,
+            thread_pool& tp,
+            const unsigned long first_level,
+            fhog_pyramid_buffers& buffers
+        )
+        {
+            const unsigned long levels = num_fhog_pyramid_levels<pyramid_type>(get_rect(img),
+                min_pyramid_layer_width, min_pyramid_layer_height, max_pyramid_levels);
+            pyramid_type pyr;
+
+            if (feats.max_size() < levels)
+                feats.set_max_size(levels);
+            feats.set_size(levels);
 
-            if (feats.size() > 1)
+            // The same per level images and scratch memory as the serial version.  Each
+            // task only touches its own level's scratch so they can run concurrently.
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            array<array2d<pixel_type> >& images = buffers.images<pixel_type>();
+            if (images.size() < levels)
+                images.resize(levels);
+            buffers.set_num_levels(levels);
+
+            // The levels only depend on each other through the downsampling, which is cheap
+            // next to the HOG extraction.  So downsample here and hand each level's extraction
+            // to the pool as soon as its image exists.  That also queues the work from the
+            // largest level to the smallest, so the big jobs are never left for last.
+            typedef fhog_level_extractor<image_type,feature_extractor_type> extractor_type;
+            extractor_type extractor(img, fe, feats, cell_size, filter_rows_padding,
+                filter_cols_padding, buffers);
+            if (first_level == 0)
+            {
+                tp.add_task(extractor, &extractor_type::extract, 0);
+            }
+            else
             {
-                typedef typename image_traits<image_type>::pixel_type pixel_type;
-                array2d<pixel_type> temp1, temp2;
-                pyr(img, temp1);
-                fe(temp1, feats[1], cell_size,filter_rows_padding,filter_cols_padding);
-                swap(temp1,temp2);
+                clear_fhog_level(feats[0], fe.get_num_planes());
+            }
+            for (unsigned long i = 1; i < levels; ++i)
+            {
+                if (i == 1)
+                    pyr(img, images[i]);
+                else
+                    pyr(images[i-1], images[i]);
 
-                for (unsigned long i = 2; i < feats.size(); ++i)
+                // the images of skipped levels are only needed to make the next level
+                if (i < first_level)
                 {
-                    pyr(temp2, temp1);
-                    fe(temp1, feats[i], cell_size,filter_rows_padding,filter_cols_padding);
-                    swap(temp1,temp2);
+                    clear_fhog_level(feats[i], fe.get_num_planes());
+                    continue;
                 }
+                tp.add_task(extractor, &extractor_type::extract, i);
             }
+            tp.wait_for_all_tasks();
+
+            DLIB_ASSERT(feats[0].size() == fe.get_num_planes(), 
+                "Invalid feature extractor used with dlib::scan_fhog_pyramid.  The output does not have the \n"
+                "indicated number of planes.");
+        }
+
+        template <
+            typename pyramid_type,
+            typename image_type,
+            typename feature_extractor_type
+            >
+        void create_fhog_pyramid (
+            const image_type& img,
+            const feature_extractor_type& fe,
+            array<array<array2d<float> > >& feats,
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            unsigned long min_pyramid_layer_width,
+            unsigned long min_pyramid_layer_height,
+            unsigned long max_pyramid_levels,
+            thread_pool& tp,
+            const unsigned long first_level = 0
+        )
+        {
+            fhog_pyramid_buffers buffers;
+            create_fhog_pyramid<pyramid_type>(img, fe, feats, cell_size, filter_rows_padding,
+                filter_cols_padding, min_pyramid_layer_width, min_pyramid_layer_height,
+                max_pyramid_levels, tp, first_level, buffers);
         }
     }
 
@@ -632,7 +1155,29 @@ namespace dlib
         compute_fhog_window_size(width,height);
         impl::create_fhog_pyramid<Pyramid_type>(img, fe, feats, cell_size, height,
             width, min_pyramid_layer_width, min_pyramid_layer_height,
-            max_pyramid_levels);
+            max_pyramid_levels, 0, buffers);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    template <
+        typename image_type
+        >
+    void scan_fhog_pyramid<Pyramid_type,feature_extractor_type>::
+    load (
+        const image_type& img,
+        thread_pool& tp
+    )
+    {
+        unsigned long width, height;
+        compute_fhog_window_size(width,height);
+        impl::create_fhog_pyramid<Pyramid_type>(img, fe, feats, cell_size, height,
+            width, min_pyramid_layer_width, min_pyramid_layer_height,
+            max_pyramid_levels, tp, 0, buffers);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -758,6 +1303,86 @@ namespace dlib
             return a.first < b.first;
         }
 
+        template <
+            typename pyramid_type,
+            typename feature_extractor_type,
+            typename fhog_filterbank
+            >
+        void detect_from_fhog_level_with_cascade (
+            const array<array2d<float> >& feats,
+            const feature_extractor_type& fe,
+            const fhog_filterbank& w,
+            const double thresh,
+            const unsigned long det_box_height,
+            const unsigned long det_box_width,
+            const int cell_size,
+            const int filter_rows_padding,
+            const int filter_cols_padding,
+            const unsigned long level,
+            std::vector<std::pair<double, rectangle> >& dets,
+            array2d<float>& stage_saliency,
+            array2d<float>& stage_scratch,
+            array2d<float>& band_saliency,
+            array2d<float>& band_scratch
+        )
+        /*!
+            requires
+                - w.uses_cascade() == true
+            ensures
+                - appends to dets the detections at the given pyramid level whose full
+                  score is >= thresh and whose cascade stage score is >=
+                  w.get_rejection_threshold().  Their scores are exactly the ones
+                  apply_filters_to_fhog(w, feats, ...) gives.
+        !*/
+        {
+            // The cheap stage scores the whole level.  Then the rows holding windows it
+            // doesn't reject are filtered in full, in bands that overhang them by half
+            // the filter height.  Each output row we keep sees exactly the inputs it sees
+            // when the whole level is filtered at once, and the bands span the full
+            // width, so the scores are identical to the ones the plain scan computes.
+            const rectangle area = apply_fhog_cascade_stage(w, feats, stage_saliency, stage_scratch);
+            const double rejection_threshold = w.get_rejection_threshold();
+            const long nr = feats[0].nr();
+            const long nc = feats[0].nc();
+            const long filter_height = w.filters[0].nr();
+            const long band_rows = std::min(nr, 4*filter_height);
+
+            pyramid_type pyr;
+            for (long r = area.top(); r <= area.bottom();)
+            {
+                bool passes = false;
+                for (long c = area.left(); c <= area.right() && !passes; ++c)
+                    passes = stage_saliency[r][c] >= rejection_threshold;
+                if (!passes)
+                {
+                    ++r;
+                    continue;
+                }
+
+                const long top = std::max(0L, std::min(r - filter_height/2, nr - band_rows));
+                const rectangle band_area = translate_rect(apply_filters_to_fhog(w,
+                        fhog_band(feats, rectangle(0, top, nc-1, top+band_rows-1)),
+                        band_saliency, band_scratch), point(0,top)).intersect(area);
+                DLIB_ASSERT(band_area.top() <= r && r <= band_area.bottom(),
+                    "\t The band must hold the row its first window is in.");
+
+                for (; r <= band_area.bottom(); ++r)
+                {
+                    for (long c = area.left(); c <= area.right(); ++c)
+                    {
+                        const float score = band_saliency[r-top][c];
+                        if (stage_saliency[r][c] >= rejection_threshold && score >= thresh)
+                        {
+                            rectangle rect = fe.feats_to_image(centered_rect(point(c,r),det_box_width,det_box_height), 
+                                cell_size, filter_rows_padding, filter_cols_padding);
+                            rect = pyr.rect_up(rect, level);
+                            dets.push_back(std::make_pair(score, rect));
+                        }
+                    }
+                }
+            }
+        }
+
         template <
             typename pyramid_type,
             typename feature_extractor_type,
@@ -773,18 +1398,30 @@ namespace dlib
             const int cell_size,
             const int filter_rows_padding,
             const int filter_cols_padding,
-            std::vector<std::pair<double, rectangle> >& dets
+            std::vector<std::pair<double, rectangle> >& dets,
+            fhog_pyramid_buffers& buffers
         ) 
         {
             dets.clear();
 
-            array2d<float> saliency_image;
             pyramid_type pyr;
+            buffers.set_num_levels(feats.size());
 
             // for all pyramid levels
             for (unsigned long l = 0; l < feats.size(); ++l)
             {
-                const rectangle area = apply_filters_to_fhog(w, feats[l], saliency_image);
+                if (feats[l][0].size() == 0)
+                    continue;
+                array2d<float>& saliency_image = buffers.saliency_images[l];
+                if (w.uses_cascade())
+                {
+                    detect_from_fhog_level_with_cascade<pyramid_type>(feats[l], fe, w, thresh, det_box_height,
+                        det_box_width, cell_size, filter_rows_padding, filter_cols_padding, l,
+                        dets, saliency_image, buffers.filter_scratch[l],
+                        buffers.band_saliency_images[l], buffers.band_scratch[l]);
+                    continue;
+                }
+                const rectangle area = apply_filters_to_fhog(w, feats[l], saliency_image, buffers.filter_scratch[l]);
 
                 // now search the saliency image for any detections
                 for (long r = area.top(); r <= area.bottom(); ++r)
@@ -806,6 +1443,243 @@ namespace dlib
             std::sort(dets.rbegin(), dets.rend(), compare_pair_rect);
         }
 
+        template <
+            typename pyramid_type,
+            typename feature_extractor_type,
+            typename fhog_filterbank
+            >
+        void detect_from_fhog_pyramid (
+            const array<array<array2d<float> > >& feats,
+            const feature_extractor_type& fe,
+            const fhog_filterbank& w,
+            const double thresh,
+            const unsigned long det_box_height,
+            const unsigned long det_box_width,
+            const int cell_size,
+            const int filter_rows_padding,
+            const int filter_cols_padding,
+            std::vector<std::pair<double, rectangle> >& dets
+        ) 
+        {
+            fhog_pyramid_buffers buffers;
+            detect_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh, det_box_height,
+                det_box_width, cell_size, filter_rows_padding, filter_cols_padding, dets, buffers);
+        }
+
+        template <
+            typename pyramid_type,
+            typename feature_extractor_type,
+            typename fhog_filterbank
+            >
+        void detect_from_fhog_rows (
+            const array<array2d<float> >& feats,
+            const feature_extractor_type& fe,
+            const fhog_filterbank& w,
+            const double thresh,
+            const unsigned long det_box_height,
+            const unsigned long det_box_width,
+            const int cell_size,
+            const int filter_rows_padding,
+            const int filter_cols_padding,
+            const unsigned long level,
+            const long top,
+            const long bottom,
+            std::vector<std::pair<double, rectangle> >& dets,
+            array2d<float>& saliency_image,
+            array2d<float>& scratch
+        ) 
+        /*!
+            ensures
+                - #dets == the detections detect_from_fhog_pyramid() finds in rows top
+                  through bottom of the given pyramid level, in the same order.
+                - saliency_image and scratch are the memory the filters are run in.
+        !*/
+        {
+            rectangle area;
+            long row_offset = 0;
+            const long nr = feats[0].nr();
+            const long nc = feats[0].nc();
+            if (top == 0 && bottom == nr-1)
+            {
+                area = apply_filters_to_fhog(w, feats, saliency_image, scratch);
+            }
+            else
+            {
+                // Filter a band that overhangs the rows we own by the filter height, so
+                // every output row we keep sees exactly the same inputs as when the whole
+                // level is filtered at once.
+                const long halo = w.filters[0].nr();
+                const rectangle band(0, std::max(top-halo, 0L), nc-1, std::min(bottom+halo, nr-1));
+                row_offset = band.top();
+                area = translate_rect(apply_filters_to_fhog(w, fhog_band(feats, band), saliency_image, scratch), point(0,row_offset));
+                area = area.intersect(rectangle(0, top, nc-1, bottom));
+            }
+
+            pyramid_type pyr;
+            dets.clear();
+            for (long r = area.top(); r <= area.bottom(); ++r)
+            {
+                for (long c = area.left(); c <= area.right(); ++c)
+                {
+                    const float score = saliency_image[r-row_offset][c];
+                    if (score >= thresh)
+                    {
+                        rectangle rect = fe.feats_to_image(centered_rect(point(c,r),det_box_width,det_box_height), 
+                            cell_size, filter_rows_padding, filter_cols_padding);
+                        rect = pyr.rect_up(rect, level);
+                        dets.push_back(std::make_pair(score, rect));
+                    }
+                }
+            }
+        }
+
+        template <
+            typename pyramid_type,
+            typename feature_extractor_type,
+            typename fhog_filterbank
+            >
+        class fhog_detection_jobs
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    The tasks the threaded detect_from_fhog_pyramid() hands to the pool.
+                    run(i) finds the detections of buffers.detection_jobs[i].  Queuing a
+                    member function with a long argument doesn't make the pool allocate,
+                    unlike queuing a lambda by value.
+            !*/
+        public:
+            fhog_detection_jobs (
+                const array<array<array2d<float> > >& feats_,
+                const feature_extractor_type& fe_,
+                const fhog_filterbank& w_,
+                const double thresh_,
+                const unsigned long det_box_height_,
+                const unsigned long det_box_width_,
+                const int cell_size_,
+                const int filter_rows_padding_,
+                const int filter_cols_padding_,
+                fhog_pyramid_buffers& buffers_
+            ) : feats(feats_), fe(fe_), w(w_), thresh(thresh_), det_box_height(det_box_height_),
+                det_box_width(det_box_width_), cell_size(cell_size_),
+                filter_rows_padding(filter_rows_padding_), filter_cols_padding(filter_cols_padding_),
+                buffers(buffers_) {}
+
+            void run (
+                long i
+            )
+            {
+                const fhog_pyramid_buffers::detection_job& job = buffers.detection_jobs[i];
+                detect_from_fhog_rows<pyramid_type>(feats[job.level], fe, w, thresh, det_box_height,
+                    det_box_width, cell_size, filter_rows_padding, filter_cols_padding, job.level,
+                    job.top, job.bottom, buffers.job_dets[i], buffers.job_saliency_images[i],
+                    buffers.job_scratch[i]);
+            }
+
+        private:
+            const array<array<array2d<float> > >& feats;
+            const feature_extractor_type& fe;
+            const fhog_filterbank& w;
+            const double thresh;
+            const unsigned long det_box_height;
+            const unsigned long det_box_width;
+            const int cell_size;
+            const int filter_rows_padding;
+            const int filter_cols_padding;
+            fhog_pyramid_buffers& buffers;
+        };
+
+        template <
+            typename pyramid_type,
+            typename feature_extractor_type,
+            typename fhog_filterbank
+            >
+        void detect_from_fhog_pyramid (
+            const array<array<array2d<float> > >& feats,
+            const feature_extractor_type& fe,
+            const fhog_filterbank& w,
+            const double thresh,
+            const unsigned long det_box_height,
+            const unsigned long det_box_width,
+            const int cell_size,
+            const int filter_rows_padding,
+            const int filter_cols_padding,
+            std::vector<std::pair<double, rectangle> >& dets,
+            thread_pool& tp,
+            fhog_pyramid_buffers& buffers
+        ) 
+        {
+            dets.clear();
+
+            // Cut the pyramid into jobs of about the same size: small levels are one job
+            // while the big ones are split into bands of rows.  Aim for several jobs per
+            // thread so the pool can balance them.
+            const long halo = w.filters[0].nr();
+            unsigned long total_area = 0;
+            for (unsigned long l = 0; l < feats.size(); ++l)
+                total_area += feats[l][0].size();
+            const unsigned long job_area = std::max<unsigned long>(1, total_area/(4*(tp.num_threads_in_pool()+1)));
+
+            std::vector<fhog_pyramid_buffers::detection_job>& jobs = buffers.detection_jobs;
+            jobs.clear();
+            for (unsigned long l = 0; l < feats.size(); ++l)
+            {
+                const long nr = feats[l][0].nr();
+                if (nr == 0)
+                    continue;
+                // bands much thinner than the filter would mostly filter the overhang
+                long num_bands = std::min<long>((feats[l][0].size()+job_area-1)/job_area, nr/std::max(2*halo,1L));
+                num_bands = std::max(num_bands, 1L);
+                for (long b = 0; b < num_bands; ++b)
+                {
+                    fhog_pyramid_buffers::detection_job j;
+                    j.level = l;
+                    j.top = nr*b/num_bands;
+                    j.bottom = nr*(b+1)/num_bands - 1;
+                    jobs.push_back(j);
+                }
+            }
+            buffers.set_num_jobs(jobs.size());
+
+            // Jobs come out ordered from the largest level to the smallest, which is also a
+            // good order to schedule them in.  Each job has its own output so the final
+            // detections don't depend on how the jobs were scheduled.
+            typedef fhog_detection_jobs<pyramid_type,feature_extractor_type,fhog_filterbank> jobs_type;
+            jobs_type runner(feats, fe, w, thresh, det_box_height, det_box_width, cell_size,
+                filter_rows_padding, filter_cols_padding, buffers);
+            for (unsigned long i = 0; i < jobs.size(); ++i)
+                tp.add_task(runner, &jobs_type::run, i);
+            tp.wait_for_all_tasks();
+
+            for (unsigned long i = 0; i < jobs.size(); ++i)
+                dets.insert(dets.end(), buffers.job_dets[i].begin(), buffers.job_dets[i].end());
+
+            std::sort(dets.rbegin(), dets.rend(), compare_pair_rect);
+        }
+
+        template <
+            typename pyramid_type,
+            typename feature_extractor_type,
+            typename fhog_filterbank
+            >
+        void detect_from_fhog_pyramid (
+            const array<array<array2d<float> > >& feats,
+            const feature_extractor_type& fe,
+            const fhog_filterbank& w,
+            const double thresh,
+            const unsigned long det_box_height,
+            const unsigned long det_box_width,
+            const int cell_size,
+            const int filter_rows_padding,
+            const int filter_cols_padding,
+            std::vector<std::pair<double, rectangle> >& dets,
+            thread_pool& tp
+        ) 
+        {
+            fhog_pyramid_buffers buffers;
+            detect_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh, det_box_height,
+                det_box_width, cell_size, filter_rows_padding, filter_cols_padding, dets, tp, buffers);
+        }
+
         inline bool overlaps_any_box (
             const test_box_overlap& tester,
             const std::vector<rect_detection>& rects,
@@ -851,8 +1725,104 @@ namespace dlib
         unsigned long width, height;
         compute_fhog_window_size(width,height);
 
+        impl::fhog_pyramid_buffers temp;
+        impl::detect_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh,
+            height-2*padding, width-2*padding, cell_size, height, width, dets, temp);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    void scan_fhog_pyramid<Pyramid_type,feature_extractor_type>::
+    detect (
+        const fhog_filterbank& w,
+        std::vector<std::pair<double, rectangle> >& dets,
+        const double thresh
+    ) 
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(is_loaded_with_image() &&
+                    w.get_num_dimensions() == get_num_dimensions(), 
+            "\t void scan_fhog_pyramid::detect()"
+            << "\n\t Invalid inputs were given to this function "
+            << "\n\t is_loaded_with_image(): " << is_loaded_with_image()
+            << "\n\t w.get_num_dimensions(): " << w.get_num_dimensions()
+            << "\n\t get_num_dimensions():   " << get_num_dimensions()
+            << "\n\t this: " << this
+            );
+
+        unsigned long width, height;
+        compute_fhog_window_size(width,height);
+
+        impl::detect_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh,
+            height-2*padding, width-2*padding, cell_size, height, width, dets, buffers);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    void scan_fhog_pyramid<Pyramid_type,feature_extractor_type>::
+    detect (
+        const fhog_filterbank& w,
+        std::vector<std::pair<double, rectangle> >& dets,
+        const double thresh,
+        thread_pool& tp
+    ) const
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(is_loaded_with_image() &&
+                    w.get_num_dimensions() == get_num_dimensions(), 
+            "\t void scan_fhog_pyramid::detect()"
+            << "\n\t Invalid inputs were given to this function "
+            << "\n\t is_loaded_with_image(): " << is_loaded_with_image()
+            << "\n\t w.get_num_dimensions(): " << w.get_num_dimensions()
+            << "\n\t get_num_dimensions():   " << get_num_dimensions()
+            << "\n\t this: " << this
+            );
+
+        unsigned long width, height;
+        compute_fhog_window_size(width,height);
+
         impl::detect_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh,
-            height-2*padding, width-2*padding, cell_size, height, width, dets);
+            height-2*padding, width-2*padding, cell_size, height, width, dets, tp);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename Pyramid_type,
+        typename feature_extractor_type
+        >
+    void scan_fhog_pyramid<Pyramid_type,feature_extractor_type>::
+    detect (
+        const fhog_filterbank& w,
+        std::vector<std::pair<double, rectangle> >& dets,
+        const double thresh,
+        thread_pool& tp
+    ) 
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT(is_loaded_with_image() &&
+                    w.get_num_dimensions() == get_num_dimensions(), 
+            "\t void scan_fhog_pyramid::detect()"
+            << "\n\t Invalid inputs were given to this function "
+            << "\n\t is_loaded_with_image(): " << is_loaded_with_image()
+            << "\n\t w.get_num_dimensions(): " << w.get_num_dimensions()
+            << "\n\t get_num_dimensions():   " << get_num_dimensions()
+            << "\n\t this: " << this
+            );
+
+        unsigned long width, height;
+        compute_fhog_window_size(width,height);
+
+        impl::detect_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh,
+            height-2*padding, width-2*padding, cell_size, height, width, dets, tp, buffers);
     }
 
 // ----------------------------------------------------------------------------------------
@@ -1216,108 +2186,199 @@ namespace dlib
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 
-    template <
-        typename pyramid_type,
-        typename image_type
-        >
-    void evaluate_detectors (
-        const std::vector<object_detector<scan_fhog_pyramid<pyramid_type> > >& detectors,
-        const image_type& img,
-        std::vector<rect_detection>& dets,
-        const double adjust_threshold = 0
-    )
+    namespace impl
     {
-        typedef scan_fhog_pyramid<pyramid_type> scanner_type;
-
-        dets.clear();
-        if (detectors.size() == 0)
-            return;
-
-        const unsigned long cell_size = detectors[0].get_scanner().get_cell_size();
-
-        // Find the maximum sized filters and also most extreme pyramiding settings used.
-        unsigned long max_filter_width = 0;
-        unsigned long max_filter_height = 0;
-        unsigned long min_pyramid_layer_width = std::numeric_limits<unsigned long>::max();
-        unsigned long min_pyramid_layer_height = std::numeric_limits<unsigned long>::max();
-        unsigned long max_pyramid_levels = 0;
-        bool all_cell_sizes_the_same = true;
-        for (unsigned long i = 0; i < detectors.size(); ++i)
+        template <
+            typename pyramid_type,
+            typename image_type,
+            typename feature_extractor_type
+            >
+        void create_fhog_pyramid (
+            const image_type& img,
+            const feature_extractor_type& fe,
+            array<array<array2d<float> > >& feats,
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding,
+            unsigned long min_pyramid_layer_width,
+            unsigned long min_pyramid_layer_height,
+            unsigned long max_pyramid_levels,
+            thread_pool* tp,
+            const unsigned long first_level = 0
+        )
         {
-            const scanner_type& scanner = detectors[i].get_scanner();
-            max_filter_width = std::max(max_filter_width, scanner.get_fhog_window_width());
-            max_filter_height = std::max(max_filter_height, scanner.get_fhog_window_height());
-            max_pyramid_levels = std::max(max_pyramid_levels, scanner.get_max_pyramid_levels());
-            min_pyramid_layer_width = std::min(min_pyramid_layer_width, scanner.get_min_pyramid_layer_width());
-            min_pyramid_layer_height = std::min(min_pyramid_layer_height, scanner.get_min_pyramid_layer_height());
-            if (cell_size != scanner.get_cell_size())
-                all_cell_sizes_the_same = false;
+            if (tp)
+                create_fhog_pyramid<pyramid_type>(img, fe, feats, cell_size, filter_rows_padding,
+                    filter_cols_padding, min_pyramid_layer_width, min_pyramid_layer_height,
+                    max_pyramid_levels, *tp, first_level);
+            else
+                create_fhog_pyramid<pyramid_type>(img, fe, feats, cell_size, filter_rows_padding,
+                    filter_cols_padding, min_pyramid_layer_width, min_pyramid_layer_height,
+                    max_pyramid_levels, first_level);
         }
 
-        std::vector<rect_detection> dets_accum;
-        // Do to the HOG feature extraction to make the fhog pyramid.  Again, note that we
-        // are making a pyramid that will work with any of the detectors.  But only if all
-        // the cell sizes are the same.  If they aren't then we have to calculate the
-        // pyramid for each detector individually.
-        array<array<array2d<float> > > feats;
-        if (all_cell_sizes_the_same)
+        template <
+            typename pyramid_type,
+            typename feature_extractor_type,
+            typename fhog_filterbank
+            >
+        void detect_from_fhog_pyramid (
+            const array<array<array2d<float> > >& feats,
+            const feature_extractor_type& fe,
+            const fhog_filterbank& w,
+            const double thresh,
+            const unsigned long det_box_height,
+            const unsigned long det_box_width,
+            const int cell_size,
+            const int filter_rows_padding,
+            const int filter_cols_padding,
+            std::vector<std::pair<double, rectangle> >& dets,
+            thread_pool* tp
+        ) 
         {
-            impl::create_fhog_pyramid<pyramid_type>(img,
-                detectors[0].get_scanner().get_feature_extractor(), feats, cell_size,
-                max_filter_height, max_filter_width, min_pyramid_layer_width,
-                min_pyramid_layer_height, max_pyramid_levels);
+            if (tp)
+                detect_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh, det_box_height,
+                    det_box_width, cell_size, filter_rows_padding, filter_cols_padding, dets, *tp);
+            else
+                detect_from_fhog_pyramid<pyramid_type>(feats, fe, w, thresh, det_box_height,
+                    det_box_width, cell_size, filter_rows_padding, filter_cols_padding, dets);
         }
 
-        std::vector<std::pair<double, rectangle> > temp_dets;
-        for (unsigned long i = 0; i < detectors.size(); ++i)
+        template <
+            typename pyramid_type,
+            typename image_type
+            >
+        void evaluate_detectors (
+            const std::vector<object_detector<scan_fhog_pyramid<pyramid_type> > >& detectors,
+            const image_type& img,
+            std::vector<rect_detection>& dets,
+            const double adjust_threshold,
+            thread_pool* tp
+        )
         {
-            const scanner_type& scanner = detectors[i].get_scanner();
-            if (!all_cell_sizes_the_same)
+            typedef scan_fhog_pyramid<pyramid_type> scanner_type;
+
+            dets.clear();
+            if (detectors.size() == 0)
+                return;
+
+            const unsigned long cell_size = detectors[0].get_scanner().get_cell_size();
+
+            // Find the maximum sized filters and also most extreme pyramiding settings used.
+            unsigned long max_filter_width = 0;
+            unsigned long max_filter_height = 0;
+            unsigned long min_pyramid_layer_width = std::numeric_limits<unsigned long>::max();
+            unsigned long min_pyramid_layer_height = std::numeric_limits<unsigned long>::max();
+            unsigned long max_pyramid_levels = 0;
+            bool all_cell_sizes_the_same = true;
+            for (unsigned long i = 0; i < detectors.size(); ++i)
+            {
+                const scanner_type& scanner = detectors[i].get_scanner();
+                max_filter_width = std::max(max_filter_width, scanner.get_fhog_window_width());
+                max_filter_height = std::max(max_filter_height, scanner.get_fhog_window_height());
+                max_pyramid_levels = std::max(max_pyramid_levels, scanner.get_max_pyramid_levels());
+                min_pyramid_layer_width = std::min(min_pyramid_layer_width, scanner.get_min_pyramid_layer_width());
+                min_pyramid_layer_height = std::min(min_pyramid_layer_height, scanner.get_min_pyramid_layer_height());
+                if (cell_size != scanner.get_cell_size())
+                    all_cell_sizes_the_same = false;
+            }
+
+            std::vector<rect_detection> dets_accum;
+            // Do to the HOG feature extraction to make the fhog pyramid.  Again, note that we
+            // are making a pyramid that will work with any of the detectors.  But only if all
+            // the cell sizes are the same.  If they aren't then we have to calculate the
+            // pyramid for each detector individually.
+            array<array<array2d<float> > > feats;
+            if (all_cell_sizes_the_same)
             {
                 impl::create_fhog_pyramid<pyramid_type>(img,
-                    scanner.get_feature_extractor(), feats, scanner.get_cell_size(),
+                    detectors[0].get_scanner().get_feature_extractor(), feats, cell_size,
                     max_filter_height, max_filter_width, min_pyramid_layer_width,
-                    min_pyramid_layer_height, max_pyramid_levels);
+                    min_pyramid_layer_height, max_pyramid_levels, tp);
             }
 
-            const unsigned long det_box_width  = scanner.get_fhog_window_width()  - 2*scanner.get_padding();
-            const unsigned long det_box_height = scanner.get_fhog_window_height() - 2*scanner.get_padding();
-            // A single detector object might itself have multiple weight vectors in it. So
-            // we need to evaluate all of them.
-            for (unsigned d = 0; d < detectors[i].num_detectors(); ++d)
+            std::vector<std::pair<double, rectangle> > temp_dets;
+            for (unsigned long i = 0; i < detectors.size(); ++i)
             {
-                const double thresh = detectors[i].get_processed_w(d).w(scanner.get_num_dimensions());
-
-                impl::detect_from_fhog_pyramid<pyramid_type>(feats, scanner.get_feature_extractor(),
-                    detectors[i].get_processed_w(d).get_detect_argument(), thresh+adjust_threshold,
-                    det_box_height, det_box_width, cell_size, max_filter_height,
-                    max_filter_width, temp_dets);
+                const scanner_type& scanner = detectors[i].get_scanner();
+                if (!all_cell_sizes_the_same)
+                {
+                    impl::create_fhog_pyramid<pyramid_type>(img,
+                        scanner.get_feature_extractor(), feats, scanner.get_cell_size(),
+                        max_filter_height, max_filter_width, min_pyramid_layer_width,
+                        min_pyramid_layer_height, max_pyramid_levels, tp);
+                }
 
-                for (unsigned long j = 0; j < temp_dets.size(); ++j)
+                const unsigned long det_box_width  = scanner.get_fhog_window_width()  - 2*scanner.get_padding();
+                const unsigned long det_box_height = scanner.get_fhog_window_height() - 2*scanner.get_padding();
+                // A single detector object might itself have multiple weight vectors in it. So
+                // we need to evaluate all of them.
+                for (unsigned d = 0; d < detectors[i].num_detectors(); ++d)
                 {
-                    rect_detection temp;
-                    temp.detection_confidence = temp_dets[j].first-thresh;
-                    temp.weight_index = i;
-                    temp.rect = temp_dets[j].second;
-                    dets_accum.push_back(temp);
+                    const double thresh = detectors[i].get_processed_w(d).w(scanner.get_num_dimensions());
+
+                    impl::detect_from_fhog_pyramid<pyramid_type>(feats, scanner.get_feature_extractor(),
+                        detectors[i].get_processed_w(d).get_detect_argument(), thresh+adjust_threshold,
+                        det_box_height, det_box_width, cell_size, max_filter_height,
+                        max_filter_width, temp_dets, tp);
+
+                    for (unsigned long j = 0; j < temp_dets.size(); ++j)
+                    {
+                        rect_detection temp;
+                        temp.detection_confidence = temp_dets[j].first-thresh;
+                        temp.weight_index = i;
+                        temp.rect = temp_dets[j].second;
+                        dets_accum.push_back(temp);
+                    }
                 }
             }
-        }
 
 
-        // Do non-max suppression
-        if (detectors.size() > 1)
-            std::sort(dets_accum.rbegin(), dets_accum.rend());
-        for (unsigned long i = 0; i < dets_accum.size(); ++i)
-        {
-            const test_box_overlap tester = detectors[dets_accum[i].weight_index].get_overlap_tester();
-            if (impl::overlaps_any_box(tester, dets, dets_accum[i]))
-                continue;
+            // Do non-max suppression
+            if (detectors.size() > 1)
+                std::sort(dets_accum.rbegin(), dets_accum.rend());
+            for (unsigned long i = 0; i < dets_accum.size(); ++i)
+            {
+                const test_box_overlap tester = detectors[dets_accum[i].weight_index].get_overlap_tester();
+                if (impl::overlaps_any_box(tester, dets, dets_accum[i]))
+                    continue;
 
-            dets.push_back(dets_accum[i]);
+                dets.push_back(dets_accum[i]);
+            }
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename pyramid_type,
+        typename image_type
+        >
+    void evaluate_detectors (
+        const std::vector<object_detector<scan_fhog_pyramid<pyramid_type> > >& detectors,
+        const image_type& img,
+        std::vector<rect_detection>& dets,
+        const double adjust_threshold = 0
+    )
+    {
+        impl::evaluate_detectors(detectors, img, dets, adjust_threshold, 0);
+    }
+
+    template <
+        typename pyramid_type,
+        typename image_type
+        >
+    void evaluate_detectors (
+        const std::vector<object_detector<scan_fhog_pyramid<pyramid_type> > >& detectors,
+        const image_type& img,
+        std::vector<rect_detection>& dets,
+        thread_pool& tp,
+        const double adjust_threshold = 0
+    )
+    {
+        impl::evaluate_detectors(detectors, img, dets, adjust_threshold, &tp);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -1339,6 +2400,26 @@ namespace dlib
         return out_dets;
     }
 
+    template <
+        typename Pyramid_type,
+        typename image_type
+        >
+    std::vector<rectangle> evaluate_detectors (
+        const std::vector<object_detector<scan_fhog_pyramid<Pyramid_type> > >& detectors,
+        const image_type& img,
+        thread_pool& tp,
+        const double adjust_threshold = 0
+    )
+    {
+        std::vector<rectangle> out_dets;
+        std::vector<rect_detection> dets;
+        evaluate_detectors(detectors, img, dets, tp, adjust_threshold);
+        out_dets.reserve(dets.size());
+        for (unsigned long i = 0; i < dets.size(); ++i)
+            out_dets.push_back(dets[i].rect);
+        return out_dets;
+    }
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 
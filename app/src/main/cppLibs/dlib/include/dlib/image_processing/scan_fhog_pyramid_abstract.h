@@ -276,6 +276,34 @@ namespace dlib
                 - #is_loaded_with_image() == true
                 - This object is ready to run a classifier over img to detect object
                   locations.  Call detect() to do this.
+                - The memory used to build the pyramid is kept and reused by the next
+                  call.  So with the default_fhog_feature_extractor, loading an image of
+                  the same size as the previous one doesn't allocate any memory.  The
+                  exception is pyramid_down<2> on images that don't contain unsigned char
+                  pixels, which allocates one temporary image per pyramid level.
+        !*/
+
+        template <
+            typename image_type
+            >
+        void load (
+            const image_type& img,
+            thread_pool& tp
+        );
+        /*!
+            requires
+                - image_type == is an implementation of array2d/array2d_kernel_abstract.h
+                - img contains some kind of pixel type. 
+                  (i.e. pixel_traits<typename image_type::type> is defined)
+            ensures
+                - performs load(img) except that the HOG features of the pyramid levels are
+                  computed in parallel by the threads in tp.  The resulting HOG pyramid is
+                  identical to the one load(img) makes.
+                - The calling thread builds the downsampled images while the pool extracts
+                  the features, largest level first.
+                - Builds the pyramid in the same memory load(img) uses and keeps, so the
+                  same images load(img) doesn't allocate for don't make this allocate
+                  either.  The tasks are queued without allocating.
         !*/
 
         const feature_extractor_type& get_feature_extractor(
@@ -547,6 +575,64 @@ namespace dlib
                     - returns the number of separable filters necessary to represent all
                       the filters in get_filters().
             !*/
+
+            fhog_filterbank(
+            );
+            /*!
+                ensures
+                    - #get_num_cascade_components() == 0
+                    - #get_rejection_threshold() == -infinity
+            !*/
+
+            void set_cascade (
+                unsigned long num_components,
+                double rejection_threshold
+            );
+            /*!
+                requires
+                    - num_components > 0
+                ensures
+                    - Makes detect() run these filters as a two stage cascade.  The first
+                      stage scores every window with only the num_components separable
+                      filters that have the largest singular values, over all the planes.
+                      Windows whose first stage score is < rejection_threshold are
+                      dropped, and only the rows of the pyramid holding the other windows
+                      are filtered with the full filters.
+                    - #get_num_cascade_components() == min(num_components, num_separable_filters())
+                    - #get_rejection_threshold() == rejection_threshold
+            !*/
+
+            void disable_cascade (
+            );
+            /*!
+                ensures
+                    - #get_num_cascade_components() == 0
+                    - #get_rejection_threshold() == -infinity
+            !*/
+
+            unsigned long get_num_cascade_components (
+            ) const;
+            /*!
+                ensures
+                    - returns the number of separable filters the first stage of the
+                      cascade uses.
+            !*/
+
+            double get_rejection_threshold (
+            ) const;
+            /*!
+                ensures
+                    - returns the first stage score below which detect() drops a window.
+            !*/
+
+            bool uses_cascade (
+            ) const;
+            /*!
+                ensures
+                    - returns true if get_num_cascade_components() != 0 and
+                      get_rejection_threshold() != -infinity.  That is, if detect() runs
+                      these filters as a cascade.
+            !*/
         };
 
         void detect (
@@ -576,6 +662,68 @@ namespace dlib
                   get_num_dimensions() are used.
                 - Note that no form of non-max suppression is performed.  If a window has a score >= thresh
                   then it is reported in #dets.
+                - If w.uses_cascade() == true then windows whose cascade first stage score is
+                  < w.get_rejection_threshold() aren't reported either.  The windows that are
+                  reported get exactly the score they get when w doesn't use a cascade.
+        !*/
+
+        void detect (
+            const fhog_filterbank& w,
+            std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh
+        );
+        /*!
+            requires
+                - w.get_num_dimensions() == get_num_dimensions()
+                - is_loaded_with_image() == true
+            ensures
+                - performs the same computation as the const detect(w, dets, thresh)
+                  above, except that the saliency images are kept in *this and reused by
+                  the next call.  So repeated calls on same sized images don't allocate
+                  memory beyond what #dets needs.  object_detector calls this version.
+                - Unlike the const version, this modifies *this and so must not be called
+                  concurrently with other uses of the same object.
+        !*/
+
+        void detect (
+            const fhog_filterbank& w,
+            std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh,
+            thread_pool& tp
+        ) const;
+        /*!
+            requires
+                - w.get_num_dimensions() == get_num_dimensions()
+                - is_loaded_with_image() == true
+            ensures
+                - performs detect(w, dets, thresh) except that the filters are scored by
+                  the threads in tp.  The pyramid is cut into jobs of similar area, small
+                  levels whole and big levels as bands of rows, so the work stays balanced
+                  across the threads.
+                - #dets is exactly what detect(w, dets, thresh) outputs, in the same order,
+                  regardless of the number of threads in tp.  The exception is that this
+                  function ignores w's cascade.  It always scores every window with the
+                  full filters.
+        !*/
+
+        void detect (
+            const fhog_filterbank& w,
+            std::vector<std::pair<double, rectangle> >& dets,
+            const double thresh,
+            thread_pool& tp
+        );
+        /*!
+            requires
+                - w.get_num_dimensions() == get_num_dimensions()
+                - is_loaded_with_image() == true
+            ensures
+                - performs the same computation as the const detect(w, dets, thresh, tp)
+                  above, except that the jobs, their saliency images and their detection
+                  lists are kept in *this and reused by the next call.  So repeated calls
+                  on same sized images don't allocate memory beyond what #dets needs.
+                  object_detector calls this version.
+                - Unlike the const version, this modifies *this and so must not be called
+                  concurrently with other uses of the same object.
         !*/
 
         void detect (
@@ -750,6 +898,49 @@ namespace dlib
               requiring a mutex lock.
     !*/
 
+    template <
+        typename pyramid_type,
+        typename image_type
+        >
+    void evaluate_detectors (
+        const std::vector<object_detector<scan_fhog_pyramid<pyramid_type>>>& detectors,
+        const image_type& img,
+        std::vector<rect_detection>& dets,
+        thread_pool& tp,
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - image_type == is an implementation of array2d/array2d_kernel_abstract.h
+            - img contains some kind of pixel type. 
+              (i.e. pixel_traits<typename image_type::type> is defined)
+        ensures
+            - performs evaluate_detectors(detectors, img, dets, adjust_threshold) except
+              that the HOG pyramid is built and scanned using the threads in tp (see
+              scan_fhog_pyramid::load(img,tp) and scan_fhog_pyramid::detect(w,dets,thresh,tp)).
+              The output is identical to the single threaded version.
+    !*/
+
+    template <
+        typename pyramid_type,
+        typename image_type
+        >
+    std::vector<rectangle> evaluate_detectors (
+        const std::vector<object_detector<scan_fhog_pyramid<pyramid_type>>>& detectors,
+        const image_type& img,
+        thread_pool& tp,
+        const double adjust_threshold = 0
+    );
+    /*!
+        requires
+            - image_type == is an implementation of array2d/array2d_kernel_abstract.h
+            - img contains some kind of pixel type. 
+              (i.e. pixel_traits<typename image_type::type> is defined)
+        ensures
+            - This function just calls the above evaluate_detectors() routine and copies
+              the output dets into a vector<rectangle> object and returns it.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     template <
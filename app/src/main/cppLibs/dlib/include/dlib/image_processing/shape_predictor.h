@@ -10,6 +10,8 @@
 #include "../geometry.h"
 #include "../pixel.h"
 #include "../statistics.h"
+#include "../threads/thread_pool_extension.h"
+#include "../simd.h"
 #include <utility>
 
 namespace dlib
@@ -21,8 +23,10 @@ namespace dlib
     {
         struct split_feature
         {
-            unsigned long idx1;
-            unsigned long idx2;
+            // These are fixed size types so that a vector of split_features can be
+            // serialized as a single pod block.
+            uint32 idx1;
+            uint32 idx2;
             float thresh;
 
             friend inline void serialize (const split_feature& item, std::ostream& out)
@@ -232,6 +236,84 @@ namespace dlib
             return find_affine_transform(from_points, to_points);
         }
 
+    // ------------------------------------------------------------------------------------
+
+        struct packed_pixel_encoding
+        {
+            /*!
+                This is the shape relative encoding of one cascade level's feature pixels
+                (see create_shape_relative_encoding()) stored as a structure of arrays so
+                that extract_feature_pixel_values() can process several pixels at once.
+                For all valid i, pixel i has anchor anchor_idx[i] and delta
+                (delta_x[i], delta_y[i]).
+            !*/
+            std::vector<int32> anchor_idx;
+            std::vector<float> delta_x;
+            std::vector<float> delta_y;
+        };
+
+        inline void pack_shape_relative_encoding (
+            const std::vector<unsigned long>& anchor_idx,
+            const std::vector<dlib::vector<float,2> >& deltas,
+            packed_pixel_encoding& packed
+        )
+        /*!
+            requires
+                - anchor_idx.size() == deltas.size()
+            ensures
+                - #packed contains the same encoding as anchor_idx and deltas.
+        !*/
+        {
+            packed.anchor_idx.assign(anchor_idx.begin(), anchor_idx.end());
+            packed.delta_x.resize(deltas.size());
+            packed.delta_y.resize(deltas.size());
+            for (unsigned long i = 0; i < deltas.size(); ++i)
+            {
+                packed.delta_x[i] = deltas[i].x();
+                packed.delta_y[i] = deltas[i].y();
+            }
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        inline void find_feature_pixel_mapping (
+            const rectangle& rect,
+            const matrix<float,0,1>& current_shape,
+            const matrix<float,0,1>& reference_shape,
+            matrix<float,2,2>& tform,
+            std::vector<float>& anchor_x,
+            std::vector<float>& anchor_y
+        )
+        /*!
+            requires
+                - current_shape.size() == reference_shape.size()
+                - reference_shape.size()%2 == 0
+            ensures
+                - Folds the transform from reference_shape to current_shape and the
+                  transform from normalized shape space into the pixels of rect into a
+                  single mapping.  That is, the pixel identified by anchor index j and
+                  delta d is located at round(tform*d + (anchor_x[j]-0.5, anchor_y[j]-0.5)).
+                - The 0.5 is folded into the anchors so a pixel coordinate can be found by
+                  truncating tform*d + (anchor_x[j], anchor_y[j]) once it is known to be
+                  non-negative.
+                - #anchor_x.size() == #anchor_y.size() == reference_shape.size()/2
+        !*/
+        {
+            const point_transform_affine tform_to_img = unnormalizing_tform(rect);
+            const matrix<double,2,2> shape_tform = find_tform_between_shapes(reference_shape, current_shape).get_m();
+            tform = matrix_cast<float>(tform_to_img.get_m()*shape_tform);
+
+            const unsigned long num_parts = current_shape.size()/2;
+            anchor_x.resize(num_parts);
+            anchor_y.resize(num_parts);
+            for (unsigned long j = 0; j < num_parts; ++j)
+            {
+                const dlib::vector<double,2> p = tform_to_img(location(current_shape, j));
+                anchor_x[j] = p.x() + 0.5;
+                anchor_y[j] = p.y() + 0.5;
+            }
+        }
+
     // ------------------------------------------------------------------------------------
 
         template <typename image_type, typename feature_type>
@@ -261,25 +343,212 @@ namespace dlib
                       current_shape rather than reference_shape.
         !*/
         {
-            const matrix<float,2,2> tform = matrix_cast<float>(find_tform_between_shapes(reference_shape, current_shape).get_m());
-            const point_transform_affine tform_to_img = unnormalizing_tform(rect);
+            matrix<float,2,2> tform;
+            std::vector<float> anchor_x, anchor_y;
+            find_feature_pixel_mapping(rect, current_shape, reference_shape, tform, anchor_x, anchor_y);
 
-            const rectangle area = get_rect(img_);
+            const float width = num_columns(img_);
+            const float height = num_rows(img_);
 
             const_image_view<image_type> img(img_);
             feature_pixel_values.resize(reference_pixel_deltas.size());
             for (unsigned long i = 0; i < feature_pixel_values.size(); ++i)
             {
-                // Compute the point in the current shape corresponding to the i-th pixel and
-                // then map it from the normalized shape space into pixel space.
-                point p = tform_to_img(tform*reference_pixel_deltas[i] + location(current_shape, reference_pixel_anchor_idx[i]));
-                if (area.contains(p))
-                    feature_pixel_values[i] = get_pixel_intensity(img[p.y()][p.x()]);
+                const dlib::vector<float,2>& d = reference_pixel_deltas[i];
+                const unsigned long a = reference_pixel_anchor_idx[i];
+                const float x = tform(0,0)*d.x() + tform(0,1)*d.y() + anchor_x[a];
+                const float y = tform(1,0)*d.x() + tform(1,1)*d.y() + anchor_y[a];
+                if (0 <= x && x < width && 0 <= y && y < height)
+                    feature_pixel_values[i] = get_pixel_intensity(img[(long)y][(long)x]);
+                else
+                    feature_pixel_values[i] = 0;
+            }
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        template <typename image_type>
+        void extract_packed_feature_pixel_values (
+            const image_type& img_,
+            const matrix<float,2,2>& tform,
+            const std::vector<float>& anchor_x,
+            const std::vector<float>& anchor_y,
+            const packed_pixel_encoding& pixels,
+            std::vector<float>& feature_pixel_values,
+            const std::false_type&
+        )
+        {
+            const float width = num_columns(img_);
+            const float height = num_rows(img_);
+
+            const_image_view<image_type> img(img_);
+            feature_pixel_values.resize(pixels.anchor_idx.size());
+            for (unsigned long i = 0; i < feature_pixel_values.size(); ++i)
+            {
+                const int32 a = pixels.anchor_idx[i];
+                const float x = tform(0,0)*pixels.delta_x[i] + tform(0,1)*pixels.delta_y[i] + anchor_x[a];
+                const float y = tform(1,0)*pixels.delta_x[i] + tform(1,1)*pixels.delta_y[i] + anchor_y[a];
+                if (0 <= x && x < width && 0 <= y && y < height)
+                    feature_pixel_values[i] = get_pixel_intensity(img[(long)y][(long)x]);
                 else
                     feature_pixel_values[i] = 0;
             }
         }
 
+        template <typename image_type>
+        void extract_packed_feature_pixel_values (
+            const image_type& img,
+            const matrix<float,2,2>& tform,
+            const std::vector<float>& anchor_x,
+            const std::vector<float>& anchor_y,
+            const packed_pixel_encoding& pixels,
+            std::vector<float>& feature_pixel_values,
+            const std::true_type&
+        )
+        {
+            // This is the unsigned char version.  It maps 8 pixels at a time into the
+            // image, clamps them into the image rather than branching on them, and then
+            // reads the pixels with plain loads from the computed offsets.
+            const long nr = num_rows(img);
+            const long nc = num_columns(img);
+            const unsigned char* data = static_cast<const unsigned char*>(image_data(img));
+            const long row_stride = width_step(img);
+
+            const unsigned long num = pixels.anchor_idx.size();
+            feature_pixel_values.resize(num);
+            if (nr == 0 || nc == 0)
+            {
+                std::fill(feature_pixel_values.begin(), feature_pixel_values.end(), 0);
+                return;
+            }
+
+            const simd8f m00(tform(0,0)), m01(tform(0,1)), m10(tform(1,0)), m11(tform(1,1));
+            const simd8f zero(0), one(1);
+            const simd8f width((float)nc), height((float)nr);
+            const simd8f last_col((float)(nc-1)), last_row((float)(nr-1));
+            const simd8i stride(row_stride);
+
+            int32 offsets[8];
+            float inside[8];
+            const int32* anchors = &pixels.anchor_idx[0];
+            const float* ax = &anchor_x[0];
+            const float* ay = &anchor_y[0];
+
+            unsigned long i = 0;
+            for (; i + 8 <= num; i += 8)
+            {
+                const int32* a = anchors + i;
+                simd8f dx, dy;
+                dx.load(&pixels.delta_x[i]);
+                dy.load(&pixels.delta_y[i]);
+                const simd8f x = m00*dx + m01*dy + simd8f(ax[a[0]],ax[a[1]],ax[a[2]],ax[a[3]],
+                                                          ax[a[4]],ax[a[5]],ax[a[6]],ax[a[7]]);
+                const simd8f y = m10*dx + m11*dy + simd8f(ay[a[0]],ay[a[1]],ay[a[2]],ay[a[3]],
+                                                          ay[a[4]],ay[a[5]],ay[a[6]],ay[a[7]]);
+
+                // Pixels outside the image read as 0, just like in the scalar version.
+                const simd8f mask = select(x >= zero, one, zero)*select(x < width, one, zero)*
+                                    select(y >= zero, one, zero)*select(y < height, one, zero);
+                mask.store(inside);
+
+                const simd8i col(min(max(x, zero), last_col));
+                const simd8i row(min(max(y, zero), last_row));
+                (row*stride + col).store(offsets);
+
+                float* out = &feature_pixel_values[i];
+                for (int k = 0; k < 8; ++k)
+                    out[k] = inside[k]*data[offsets[k]];
+            }
+
+            for (; i < num; ++i)
+            {
+                const int32 a = anchors[i];
+                const float x = tform(0,0)*pixels.delta_x[i] + tform(0,1)*pixels.delta_y[i] + ax[a];
+                const float y = tform(1,0)*pixels.delta_x[i] + tform(1,1)*pixels.delta_y[i] + ay[a];
+                if (0 <= x && x < nc && 0 <= y && y < nr)
+                    feature_pixel_values[i] = data[(long)y*row_stride + (long)x];
+                else
+                    feature_pixel_values[i] = 0;
+            }
+        }
+
+        template <typename image_type>
+        void extract_feature_pixel_values (
+            const image_type& img,
+            const rectangle& rect,
+            const matrix<float,0,1>& current_shape,
+            const matrix<float,0,1>& reference_shape,
+            const packed_pixel_encoding& pixels,
+            std::vector<float>& feature_pixel_values
+        )
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h 
+                - current_shape.size() == reference_shape.size()
+                - reference_shape.size()%2 == 0
+                - max(mat(pixels.anchor_idx)) < reference_shape.size()/2
+            ensures
+                - performs the same computation as the version of
+                  extract_feature_pixel_values() that takes the anchors and deltas as
+                  separate vectors.  For unsigned char images the pixels are processed 8
+                  at a time with SIMD instructions.
+        !*/
+        {
+            matrix<float,2,2> tform;
+            std::vector<float> anchor_x, anchor_y;
+            find_feature_pixel_mapping(rect, current_shape, reference_shape, tform, anchor_x, anchor_y);
+
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            extract_packed_feature_pixel_values(img, tform, anchor_x, anchor_y, pixels, feature_pixel_values,
+                std::integral_constant<bool,is_same_type<pixel_type,unsigned char>::value>());
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        class tree_block_evaluator
+        {
+            /*!
+                This object evaluates a contiguous block of the trees in one cascade level
+                and sums their outputs into a partial shape update.  It is the work unit
+                used by shape_predictor when it spreads a cascade level over a thread_pool.
+            !*/
+        public:
+            tree_block_evaluator (
+                const std::vector<regression_tree>& forest_,
+                const std::vector<float>& feature_pixel_values_,
+                std::vector<matrix<float,0,1> >& partials_
+            ) : forest(forest_), feature_pixel_values(feature_pixel_values_), partials(partials_) {}
+
+            void evaluate_block (
+                long block
+            )
+            /*!
+                requires
+                    - 0 <= block < partials.size()
+                ensures
+                    - #partials[block] == the sum of the outputs of the block-th group of
+                      trees, where the trees in forest are split into partials.size()
+                      contiguous groups of nearly equal size.
+            !*/
+            {
+                const unsigned long num_blocks = partials.size();
+                const unsigned long begin = forest.size()*block/num_blocks;
+                const unsigned long end = forest.size()*(block+1)/num_blocks;
+
+                matrix<float,0,1>& partial = partials[block];
+                partial = 0;
+                unsigned long leaf_idx;
+                for (unsigned long i = begin; i < end; ++i)
+                    partial += forest[i](feature_pixel_values, leaf_idx);
+            }
+
+        private:
+            const std::vector<regression_tree>& forest;
+            const std::vector<float>& feature_pixel_values;
+            std::vector<matrix<float,0,1> >& partials;
+        };
+
     } // end namespace impl
 
 // ----------------------------------------------------------------------------------------
@@ -317,6 +586,7 @@ namespace dlib
             // their representations relative to the initial shape now and save it.
             for (unsigned long i = 0; i < pixel_coordinates.size(); ++i)
                 impl::create_shape_relative_encoding(initial_shape, pixel_coordinates[i], anchor_idx[i], deltas[i]);
+            pack_pixel_encodings();
         }
 
         unsigned long num_parts (
@@ -325,6 +595,15 @@ namespace dlib
             return initial_shape.size()/2;
         }
 
+        unsigned long num_trees (
+        ) const
+        {
+            unsigned long num = 0;
+            for (unsigned long iter = 0; iter < forests.size(); ++iter)
+                num += forests[iter].size();
+            return num;
+        }
+
         unsigned long num_features (
         ) const
         {
@@ -347,7 +626,7 @@ namespace dlib
             for (unsigned long iter = 0; iter < forests.size(); ++iter)
             {
                 extract_feature_pixel_values(img, rect, current_shape, initial_shape,
-                                             anchor_idx[iter], deltas[iter], feature_pixel_values);
+                                             packed_pixels[iter], feature_pixel_values);
                 unsigned long leaf_idx;
                 // evaluate all the trees at this level of the cascade.
                 for (unsigned long i = 0; i < forests[iter].size(); ++i)
@@ -362,6 +641,56 @@ namespace dlib
             return full_object_detection(rect, parts);
         }
 
+        template <typename image_type>
+        full_object_detection operator()(
+            const image_type& img,
+            const rectangle& rect,
+            thread_pool& tp,
+            unsigned long min_trees_per_thread = 32
+        ) const
+        {
+            using namespace impl;
+            matrix<float,0,1> current_shape = initial_shape;
+            std::vector<float> feature_pixel_values;
+            std::vector<matrix<float,0,1> > partials;
+            for (unsigned long iter = 0; iter < forests.size(); ++iter)
+            {
+                extract_feature_pixel_values(img, rect, current_shape, initial_shape,
+                                             packed_pixels[iter], feature_pixel_values);
+
+                // The calling thread takes one block of trees itself, so there are at most
+                // num_threads_in_pool()+1 blocks.  Don't bother splitting a level that is
+                // too small to pay for the task hand-off.
+                const unsigned long num_blocks = std::min<unsigned long>(tp.num_threads_in_pool()+1,
+                    forests[iter].size()/std::max<unsigned long>(min_trees_per_thread,1));
+                if (num_blocks <= 1)
+                {
+                    unsigned long leaf_idx;
+                    for (unsigned long i = 0; i < forests[iter].size(); ++i)
+                        current_shape += forests[iter][i](feature_pixel_values, leaf_idx);
+                    continue;
+                }
+
+                partials.resize(num_blocks);
+                tree_block_evaluator evaluator(forests[iter], feature_pixel_values, partials);
+                for (unsigned long b = 1; b < num_blocks; ++b)
+                    tp.add_task(evaluator, &tree_block_evaluator::evaluate_block, b);
+                evaluator.evaluate_block(0);
+                tp.wait_for_all_tasks();
+
+                // Reduce in block order so the result doesn't depend on thread timing.
+                for (unsigned long b = 0; b < num_blocks; ++b)
+                    current_shape += partials[b];
+            }
+
+            // convert the current_shape into a full_object_detection
+            const point_transform_affine tform_to_img = unnormalizing_tform(rect);
+            std::vector<point> parts(current_shape.size()/2);
+            for (unsigned long i = 0; i < parts.size(); ++i)
+                parts[i] = tform_to_img(location(current_shape, i));
+            return full_object_detection(rect, parts);
+        }
+
         template <typename image_type, typename T, typename U>
         full_object_detection operator()(
             const image_type& img,
@@ -377,7 +706,7 @@ namespace dlib
             for (unsigned long iter = 0; iter < forests.size(); ++iter)
             {
                 extract_feature_pixel_values(img, rect, current_shape, initial_shape,
-                                             anchor_idx[iter], deltas[iter], feature_pixel_values);
+                                             packed_pixels[iter], feature_pixel_values);
                 // evaluate all the trees at this level of the cascade.
                 for (unsigned long i = 0; i < forests[iter].size(); ++i)
                 {
@@ -399,13 +728,93 @@ namespace dlib
 
         friend void serialize (const shape_predictor& item, std::ostream& out);
 
+        friend void serialize_bulk (const shape_predictor& item, std::ostream& out);
+
         friend void deserialize (shape_predictor& item, std::istream& in);
 
+        friend shape_predictor extract_part_subset (
+            const shape_predictor& sp,
+            const std::vector<unsigned long>& parts
+        );
+
+        friend size_t shape_predictor_memory_usage (
+            const shape_predictor& sp
+        );
+
+        friend std::vector<std::vector<double> > shape_predictor_tree_contributions (
+            const shape_predictor& sp
+        );
+
+        friend shape_predictor prune_shape_predictor_trees (
+            const shape_predictor& sp,
+            double fraction_kept
+        );
+
+        friend shape_predictor truncate_shape_predictor_trees (
+            const shape_predictor& sp,
+            unsigned long depth
+        );
+
     private:
         matrix<float,0,1> initial_shape;
         std::vector<std::vector<impl::regression_tree> > forests;
         std::vector<std::vector<unsigned long> > anchor_idx; 
         std::vector<std::vector<dlib::vector<float,2> > > deltas;
+
+        // anchor_idx and deltas again, in the layout used by operator().  These are
+        // not serialized but rebuilt from anchor_idx and deltas by pack_pixel_encodings().
+        std::vector<impl::packed_pixel_encoding> packed_pixels;
+
+        void check_model (
+        ) const
+        /*!
+            ensures
+                - throws serialization_error unless the model meets the requirements of
+                  the shape_predictor constructor, so that operator() never indexes past
+                  the end of an array.
+        !*/
+        {
+            const unsigned long num_parts = initial_shape.size()/2;
+            if (initial_shape.size()%2 != 0 || anchor_idx.size() != forests.size() || deltas.size() != forests.size())
+                throw serialization_error("Inconsistent sizes found while deserializing dlib::shape_predictor.");
+            for (unsigned long iter = 0; iter < forests.size(); ++iter)
+            {
+                const unsigned long num_pixels = anchor_idx[iter].size();
+                if (deltas[iter].size() != num_pixels)
+                    throw serialization_error("Inconsistent sizes found while deserializing dlib::shape_predictor.");
+                for (unsigned long i = 0; i < num_pixels; ++i)
+                {
+                    if (anchor_idx[iter][i] >= num_parts)
+                        throw serialization_error("Invalid anchor index found while deserializing dlib::shape_predictor.");
+                }
+                for (unsigned long t = 0; t < forests[iter].size(); ++t)
+                {
+                    const impl::regression_tree& tree = forests[iter][t];
+                    const unsigned long num_leaves = tree.leaf_values.size();
+                    // a full binary tree with splits.size() internal nodes
+                    if (num_leaves != tree.splits.size()+1 || (num_leaves & (num_leaves-1)) != 0)
+                        throw serialization_error("Invalid tree found while deserializing dlib::shape_predictor.");
+                    for (unsigned long i = 0; i < tree.splits.size(); ++i)
+                    {
+                        if (tree.splits[i].idx1 >= num_pixels || tree.splits[i].idx2 >= num_pixels)
+                            throw serialization_error("Invalid split feature found while deserializing dlib::shape_predictor.");
+                    }
+                    for (unsigned long i = 0; i < num_leaves; ++i)
+                    {
+                        if (tree.leaf_values[i].size() != initial_shape.size())
+                            throw serialization_error("Inconsistent sizes found while deserializing dlib::shape_predictor.");
+                    }
+                }
+            }
+        }
+
+        void pack_pixel_encodings (
+        )
+        {
+            packed_pixels.resize(anchor_idx.size());
+            for (unsigned long i = 0; i < anchor_idx.size(); ++i)
+                impl::pack_shape_relative_encoding(anchor_idx[i], deltas[i], packed_pixels[i]);
+        }
     };
 
     inline void serialize (const shape_predictor& item, std::ostream& out)
@@ -418,16 +827,330 @@ namespace dlib
         dlib::serialize(item.deltas, out);
     }
 
+    inline void serialize_bulk (const shape_predictor& item, std::ostream& out)
+    {
+        static_assert(sizeof(impl::split_feature) == 3*sizeof(uint32) && std::numeric_limits<float>::is_iec559,
+            "shape_predictor serialization assumes 12 byte split_features and IEEE 754 floats.");
+
+        // Version 3 stores each cascade level as a few pod blocks, which load with one
+        // bulk read each rather than the element by element encoding used by version 1:
+        // the sizes of its trees, then all their splits, all their leaf values and the
+        // pixel encodings.  Going level by level keeps the temporary arrays small.
+        int version = 3;
+        dlib::serialize(version, out);
+        dlib::serialize(item.initial_shape, out);
+
+        const unsigned long num_cascades = item.forests.size();
+        dlib::serialize(num_cascades, out);
+        std::vector<uint32> tree_sizes, anchors;
+        std::vector<impl::split_feature> splits;
+        std::vector<float> leaf_values, deltas;
+        for (unsigned long iter = 0; iter < num_cascades; ++iter)
+        {
+            const std::vector<impl::regression_tree>& forest = item.forests[iter];
+            tree_sizes.clear();
+            splits.clear();
+            leaf_values.clear();
+            for (unsigned long i = 0; i < forest.size(); ++i)
+            {
+                tree_sizes.push_back(forest[i].splits.size());
+                tree_sizes.push_back(forest[i].leaf_values.size());
+                splits.insert(splits.end(), forest[i].splits.begin(), forest[i].splits.end());
+                for (unsigned long j = 0; j < forest[i].leaf_values.size(); ++j)
+                {
+                    const matrix<float,0,1>& leaf = forest[i].leaf_values[j];
+                    DLIB_CASSERT(leaf.size() == item.initial_shape.size());
+                    leaf_values.insert(leaf_values.end(), leaf.begin(), leaf.end());
+                }
+            }
+            serialize_pod_block(tree_sizes, out);
+            serialize_pod_block<uint32>(splits, out);
+            serialize_pod_block(leaf_values, out);
+
+            anchors.assign(item.anchor_idx[iter].begin(), item.anchor_idx[iter].end());
+            deltas.resize(item.deltas[iter].size()*2);
+            for (unsigned long i = 0; i < item.deltas[iter].size(); ++i)
+            {
+                deltas[2*i]   = item.deltas[iter][i].x();
+                deltas[2*i+1] = item.deltas[iter][i].y();
+            }
+            serialize_pod_block(anchors, out);
+            serialize_pod_block(deltas, out);
+        }
+    }
+
     inline void deserialize (shape_predictor& item, std::istream& in)
     {
         int version = 0;
         dlib::deserialize(version, in);
-        if (version != 1)
+        if (version < 1 || version > 3)
             throw serialization_error("Unexpected version found while deserializing dlib::shape_predictor.");
+
         dlib::deserialize(item.initial_shape, in);
-        dlib::deserialize(item.forests, in);
-        dlib::deserialize(item.anchor_idx, in);
-        dlib::deserialize(item.deltas, in);
+        const unsigned long leaf_size = item.initial_shape.size();
+
+        if (version == 1)
+        {
+            dlib::deserialize(item.forests, in);
+            dlib::deserialize(item.anchor_idx, in);
+            dlib::deserialize(item.deltas, in);
+        }
+        else if (version == 2)
+        {
+            // Version 2 stored every tree on its own: its splits, then each of its
+            // leaf values, as separate pod blocks.
+            unsigned long num_cascades;
+            dlib::deserialize(num_cascades, in);
+            item.forests.resize(num_cascades);
+            item.anchor_idx.resize(num_cascades);
+            item.deltas.resize(num_cascades);
+            std::vector<uint32> anchors;
+            std::vector<float> deltas;
+            for (unsigned long iter = 0; iter < num_cascades; ++iter)
+            {
+                std::vector<impl::regression_tree>& forest = item.forests[iter];
+                unsigned long num_trees;
+                dlib::deserialize(num_trees, in);
+                forest.resize(num_trees);
+                for (unsigned long i = 0; i < num_trees; ++i)
+                {
+                    deserialize_pod_block<uint32>(forest[i].splits, in);
+                    unsigned long num_leaves;
+                    dlib::deserialize(num_leaves, in);
+                    if (num_leaves != forest[i].splits.size()+1)
+                        throw serialization_error("Inconsistent sizes found while deserializing dlib::shape_predictor.");
+                    forest[i].leaf_values.resize(num_leaves);
+                    for (unsigned long j = 0; j < num_leaves; ++j)
+                    {
+                        matrix<float,0,1>& leaf = forest[i].leaf_values[j];
+                        leaf.set_size(leaf_size);
+                        deserialize_pod_block(leaf.size() == 0 ? 0 : &leaf(0), leaf.size(), in);
+                    }
+                }
+
+                deserialize_pod_block(anchors, in);
+                deserialize_pod_block(deltas, in);
+                if (deltas.size() != 2*anchors.size())
+                    throw serialization_error("Inconsistent sizes found while deserializing dlib::shape_predictor.");
+                item.anchor_idx[iter].assign(anchors.begin(), anchors.end());
+                item.deltas[iter].resize(anchors.size());
+                for (unsigned long i = 0; i < anchors.size(); ++i)
+                    item.deltas[iter][i] = dlib::vector<float,2>(deltas[2*i], deltas[2*i+1]);
+            }
+        }
+        else
+        {
+            unsigned long num_cascades;
+            dlib::deserialize(num_cascades, in);
+            item.forests.resize(num_cascades);
+            item.anchor_idx.resize(num_cascades);
+            item.deltas.resize(num_cascades);
+            std::vector<uint32> tree_sizes, anchors;
+            std::vector<impl::split_feature> splits;
+            std::vector<float> leaf_values, deltas;
+            for (unsigned long iter = 0; iter < num_cascades; ++iter)
+            {
+                deserialize_pod_block(tree_sizes, in);
+                deserialize_pod_block<uint32>(splits, in);
+                deserialize_pod_block(leaf_values, in);
+                deserialize_pod_block(anchors, in);
+                deserialize_pod_block(deltas, in);
+
+                // Check that the blocks agree with each other before splitting them up.
+                // The tree shapes themselves are checked by check_model() below.
+                unsigned long num_splits = 0, num_leaves = 0;
+                for (unsigned long i = 0; i+1 < tree_sizes.size(); i += 2)
+                {
+                    num_splits += tree_sizes[i];
+                    num_leaves += tree_sizes[i+1];
+                }
+                if (tree_sizes.size()%2 != 0 || splits.size() != num_splits ||
+                    leaf_values.size() != num_leaves*leaf_size || deltas.size() != 2*anchors.size())
+                {
+                    throw serialization_error("Inconsistent sizes found while deserializing dlib::shape_predictor.");
+                }
+
+                std::vector<impl::regression_tree>& forest = item.forests[iter];
+                forest.resize(tree_sizes.size()/2);
+                const impl::split_feature* split = splits.data();
+                const float* leaf = leaf_values.data();
+                for (unsigned long i = 0; i < forest.size(); ++i)
+                {
+                    forest[i].splits.assign(split, split + tree_sizes[2*i]);
+                    split += tree_sizes[2*i];
+                    forest[i].leaf_values.resize(tree_sizes[2*i+1]);
+                    for (unsigned long j = 0; j < forest[i].leaf_values.size(); ++j, leaf += leaf_size)
+                    {
+                        forest[i].leaf_values[j].set_size(leaf_size);
+                        std::copy(leaf, leaf + leaf_size, forest[i].leaf_values[j].begin());
+                    }
+                }
+
+                item.anchor_idx[iter].assign(anchors.begin(), anchors.end());
+                item.deltas[iter].resize(anchors.size());
+                for (unsigned long i = 0; i < anchors.size(); ++i)
+                    item.deltas[iter][i] = dlib::vector<float,2>(deltas[2*i], deltas[2*i+1]);
+            }
+        }
+
+        item.check_model();
+        item.pack_pixel_encodings();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline size_t shape_predictor_memory_usage (
+        const shape_predictor& sp
+    )
+    {
+        using namespace impl;
+        size_t bytes = sp.initial_shape.size()*sizeof(float);
+        bytes += sp.forests.capacity()*sizeof(std::vector<regression_tree>);
+        for (unsigned long iter = 0; iter < sp.forests.size(); ++iter)
+        {
+            bytes += sp.forests[iter].capacity()*sizeof(regression_tree);
+            for (unsigned long i = 0; i < sp.forests[iter].size(); ++i)
+            {
+                const regression_tree& tree = sp.forests[iter][i];
+                bytes += tree.splits.capacity()*sizeof(split_feature);
+                bytes += tree.leaf_values.capacity()*sizeof(matrix<float,0,1>);
+                for (unsigned long j = 0; j < tree.leaf_values.size(); ++j)
+                    bytes += tree.leaf_values[j].size()*sizeof(float);
+            }
+        }
+
+        bytes += sp.anchor_idx.capacity()*sizeof(std::vector<unsigned long>);
+        for (unsigned long iter = 0; iter < sp.anchor_idx.size(); ++iter)
+            bytes += sp.anchor_idx[iter].capacity()*sizeof(unsigned long);
+        bytes += sp.deltas.capacity()*sizeof(std::vector<dlib::vector<float,2> >);
+        for (unsigned long iter = 0; iter < sp.deltas.size(); ++iter)
+            bytes += sp.deltas[iter].capacity()*sizeof(dlib::vector<float,2>);
+        bytes += sp.packed_pixels.capacity()*sizeof(packed_pixel_encoding);
+        for (unsigned long iter = 0; iter < sp.packed_pixels.size(); ++iter)
+        {
+            const packed_pixel_encoding& packed = sp.packed_pixels[iter];
+            bytes += packed.anchor_idx.capacity()*sizeof(int32);
+            bytes += packed.delta_x.capacity()*sizeof(float);
+            bytes += packed.delta_y.capacity()*sizeof(float);
+        }
+        return bytes;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline shape_predictor extract_part_subset (
+        const shape_predictor& sp,
+        const std::vector<unsigned long>& parts
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_CASSERT(parts.size() > 0,
+            "\t shape_predictor extract_part_subset()"
+            << "\n\t You must select at least one part."
+        );
+        for (unsigned long k = 0; k < parts.size(); ++k)
+        {
+            DLIB_CASSERT(parts[k] < sp.num_parts(),
+                "\t shape_predictor extract_part_subset()"
+                << "\n\t Invalid part index given to this function."
+                << "\n\t parts["<<k<<"]:      " << parts[k]
+                << "\n\t sp.num_parts(): " << sp.num_parts()
+            );
+        }
+
+        using namespace impl;
+        shape_predictor result;
+
+        result.initial_shape.set_size(parts.size()*2);
+        std::vector<long> new_part_idx(sp.num_parts(), -1);
+        for (unsigned long k = 0; k < parts.size(); ++k)
+        {
+            result.initial_shape(2*k)   = sp.initial_shape(2*parts[k]);
+            result.initial_shape(2*k+1) = sp.initial_shape(2*parts[k]+1);
+            new_part_idx[parts[k]] = k;
+        }
+
+        const unsigned long num_cascades = sp.forests.size();
+        result.forests.resize(num_cascades);
+        result.anchor_idx.resize(num_cascades);
+        result.deltas.resize(num_cascades);
+        for (unsigned long iter = 0; iter < num_cascades; ++iter)
+        {
+            // Keep only the leaf components of the selected parts.  A tree whose kept
+            // components are all zero no longer does anything so it is dropped.
+            std::vector<regression_tree>& forest = result.forests[iter];
+            for (unsigned long i = 0; i < sp.forests[iter].size(); ++i)
+            {
+                const regression_tree& tree = sp.forests[iter][i];
+                regression_tree new_tree;
+                new_tree.splits = tree.splits;
+                new_tree.leaf_values.resize(tree.leaf_values.size());
+                bool is_zero = true;
+                for (unsigned long j = 0; j < tree.leaf_values.size(); ++j)
+                {
+                    matrix<float,0,1>& leaf = new_tree.leaf_values[j];
+                    leaf.set_size(parts.size()*2);
+                    for (unsigned long k = 0; k < parts.size(); ++k)
+                    {
+                        leaf(2*k)   = tree.leaf_values[j](2*parts[k]);
+                        leaf(2*k+1) = tree.leaf_values[j](2*parts[k]+1);
+                    }
+                    if (max(abs(leaf)) != 0)
+                        is_zero = false;
+                }
+                if (!is_zero)
+                    forest.push_back(new_tree);
+            }
+
+            // Now drop the feature pixels no remaining split looks at and renumber the
+            // splits to match.
+            const std::vector<unsigned long>& old_anchor_idx = sp.anchor_idx[iter];
+            const std::vector<dlib::vector<float,2> >& old_deltas = sp.deltas[iter];
+            std::vector<long> new_pixel_idx(old_anchor_idx.size(), -1);
+            for (unsigned long i = 0; i < forest.size(); ++i)
+            {
+                for (unsigned long j = 0; j < forest[i].splits.size(); ++j)
+                {
+                    new_pixel_idx[forest[i].splits[j].idx1] = 0;
+                    new_pixel_idx[forest[i].splits[j].idx2] = 0;
+                }
+            }
+
+            for (unsigned long i = 0; i < old_anchor_idx.size(); ++i)
+            {
+                if (new_pixel_idx[i] == -1)
+                    continue;
+                new_pixel_idx[i] = result.anchor_idx[iter].size();
+
+                const long anchor = new_part_idx[old_anchor_idx[i]];
+                if (anchor != -1)
+                {
+                    result.anchor_idx[iter].push_back(anchor);
+                    result.deltas[iter].push_back(old_deltas[i]);
+                }
+                else
+                {
+                    // The pixel's anchor was dropped, so attach it to the nearest kept
+                    // part at the same location in the initial shape.
+                    const dlib::vector<float,2> pixel = location(sp.initial_shape, old_anchor_idx[i]) + old_deltas[i];
+                    const unsigned long new_anchor = nearest_shape_point(result.initial_shape, pixel);
+                    result.anchor_idx[iter].push_back(new_anchor);
+                    result.deltas[iter].push_back(pixel - location(result.initial_shape, new_anchor));
+                }
+            }
+
+            for (unsigned long i = 0; i < forest.size(); ++i)
+            {
+                for (unsigned long j = 0; j < forest[i].splits.size(); ++j)
+                {
+                    forest[i].splits[j].idx1 = new_pixel_idx[forest[i].splits[j].idx1];
+                    forest[i].splits[j].idx2 = new_pixel_idx[forest[i].splits[j].idx2];
+                }
+            }
+        }
+
+        result.pack_pixel_encodings();
+        return result;
     }
 
 // ----------------------------------------------------------------------------------------
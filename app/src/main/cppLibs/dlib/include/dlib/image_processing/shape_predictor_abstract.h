@@ -7,6 +7,7 @@
 #include "../matrix.h"
 #include "../geometry.h"
 #include "../pixel.h"
+#include "../threads/thread_pool_extension_abstract.h"
 
 namespace dlib
 {
@@ -52,6 +53,14 @@ namespace dlib
                 - returns the number of parts in the shapes predicted by this object.
         !*/
 
+        unsigned long num_trees (
+        ) const;
+        /*!
+            ensures
+                - returns the total number of regression trees in all the cascade levels
+                  of this object.
+        !*/
+
         unsigned long num_features (
         ) const;
         /*!
@@ -111,12 +120,101 @@ namespace dlib
                   where the 3d argument is discarded.
         !*/
 
+        template <typename image_type>
+        full_object_detection operator()(
+            const image_type& img,
+            const rectangle& rect,
+            thread_pool& tp,
+            unsigned long min_trees_per_thread = 32
+        ) const;
+        /*!
+            requires
+                - image_type == an image object that implements the interface defined in
+                  dlib/image_processing/generic_image.h 
+            ensures
+                - Computes the same shape prediction as (*this)(img, rect), except that the
+                  trees within each cascade level are split into contiguous blocks that are
+                  evaluated concurrently by the calling thread and the threads in tp.  Each
+                  block sums its tree outputs into a private partial shape and the partials
+                  are added to the current shape, in block order, at the end of the level.
+                  Since this changes the order of the floating point additions the output
+                  may differ from (*this)(img, rect) by a rounding error.
+                - A cascade level is only split if it contains at least
+                  2*min_trees_per_thread trees, and no block contains fewer than
+                  min_trees_per_thread trees.  Levels that are too small to be worth
+                  splitting are evaluated serially on the calling thread.
+                - Handing work to tp is not free, so whether this is faster than the single
+                  threaded version depends on the model size and the hardware.  You should
+                  time both on your target device and pick the faster one.
+        !*/
+
     };
 
     void serialize (const shape_predictor& item, std::ostream& out);
     void deserialize (shape_predictor& item, std::istream& in);
     /*!
         provides serialization support
+
+        serialize() writes version 1 of the format, the one every version of dlib can
+        read.  deserialize() reads versions 1, 2 and 3, and throws serialization_error
+        if the stored trees, split features or pixel encodings don't fit together.
+    !*/
+
+    void serialize_bulk (
+        const shape_predictor& item,
+        std::ostream& out
+    );
+    /*!
+        ensures
+            - writes item to out in version 3 of the format, which stores the split
+              features, leaf values and pixel encodings of each cascade level as one pod
+              block each (see serialize_pod_block()).  So a model is read with a few bulk
+              reads per level however many trees it has, which is much faster than
+              reading version 1.
+            - Only deserialize() from this or a later version of dlib can read the
+              result, so use this for caches and files your own program reads back.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    size_t shape_predictor_memory_usage (
+        const shape_predictor& sp
+    );
+    /*!
+        ensures
+            - returns the number of bytes of heap memory held by sp's regression trees,
+              split features, leaf values and feature pixel encodings.  This counts the
+              memory reserved by each of those arrays but not the allocator's own
+              bookkeeping, so it is a lower bound on what sp really takes.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    shape_predictor extract_part_subset (
+        const shape_predictor& sp,
+        const std::vector<unsigned long>& parts
+    );
+    /*!
+        requires
+            - parts.size() > 0
+            - for all valid k:
+                - parts[k] < sp.num_parts()
+        ensures
+            - Returns a shape_predictor that only predicts the given parts of sp, without
+              any retraining.  That is, if SUB is the returned object then:
+                - SUB.num_parts() == parts.size()
+                - SUB(img,rect).part(k) approximates sp(img,rect).part(parts[k])
+            - The returned predictor is smaller and faster than sp because:
+                - the leaf values only store the components of the kept parts.
+                - trees whose leaf values are zero for all the kept parts are removed.
+                - feature pixels that no remaining tree looks at are removed.
+            - Feature pixels anchored to a dropped part are re-anchored to the nearest kept
+              part of the initial shape.  Moreover, the alignment between the current and
+              initial shapes is computed from the kept parts only.  These are the only
+              reasons the output isn't exactly sp's output for the kept parts, so the
+              approximation is better the more parts you keep.  In particular, if parts
+              lists every part of sp in order (i.e. parts[k] == k) then SUB outputs
+              exactly what sp does.
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -0,0 +1,302 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_SHAPE_PREDICToR_PRUNING_H_
+#define DLIB_SHAPE_PREDICToR_PRUNING_H_
+
+#include "shape_predictor_pruning_abstract.h"
+#include "shape_predictor.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        inline double tree_contribution (
+            const regression_tree& tree
+        )
+        /*!
+            ensures
+                - returns the root mean square length of the leaf values of tree.  That is,
+                  how far, on average, evaluating the tree moves the shape.
+        !*/
+        {
+            double sum = 0;
+            for (unsigned long i = 0; i < tree.leaf_values.size(); ++i)
+                sum += length_squared(tree.leaf_values[i]);
+            return tree.leaf_values.size() == 0 ? 0 : std::sqrt(sum/tree.leaf_values.size());
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline std::vector<std::vector<double> > shape_predictor_tree_contributions (
+        const shape_predictor& sp
+    )
+    {
+        std::vector<std::vector<double> > contributions(sp.forests.size());
+        for (unsigned long iter = 0; iter < sp.forests.size(); ++iter)
+            for (unsigned long i = 0; i < sp.forests[iter].size(); ++i)
+                contributions[iter].push_back(impl::tree_contribution(sp.forests[iter][i]));
+        return contributions;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline shape_predictor prune_shape_predictor_trees (
+        const shape_predictor& sp,
+        double fraction_kept
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_CASSERT(0 <= fraction_kept && fraction_kept <= 1,
+            "\t shape_predictor prune_shape_predictor_trees()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t fraction_kept: " << fraction_kept
+        );
+
+        using namespace impl;
+
+        // Rank every tree in the model by how much it moves the shape and find the
+        // smallest contribution we still keep.
+        const std::vector<std::vector<double> > contributions = shape_predictor_tree_contributions(sp);
+        std::vector<double> all_contributions;
+        for (unsigned long iter = 0; iter < contributions.size(); ++iter)
+            all_contributions.insert(all_contributions.end(), contributions[iter].begin(), contributions[iter].end());
+
+        const unsigned long num_kept = static_cast<unsigned long>(std::round(fraction_kept*all_contributions.size()));
+        shape_predictor result;
+        result.initial_shape = sp.initial_shape;
+        if (num_kept == 0)
+            return result;
+
+        std::sort(all_contributions.begin(), all_contributions.end(), std::greater<double>());
+        const double min_contribution = all_contributions[num_kept-1];
+        // Trees tied with the cutoff are kept until we have num_kept of them.
+        unsigned long num_ties = std::count(all_contributions.begin(), all_contributions.begin()+num_kept, min_contribution);
+
+        for (unsigned long iter = 0; iter < sp.forests.size(); ++iter)
+        {
+            std::vector<regression_tree> forest;
+            for (unsigned long i = 0; i < sp.forests[iter].size(); ++i)
+            {
+                const double contribution = contributions[iter][i];
+                if (contribution > min_contribution)
+                {
+                    forest.push_back(sp.forests[iter][i]);
+                }
+                else if (contribution == min_contribution && num_ties > 0)
+                {
+                    forest.push_back(sp.forests[iter][i]);
+                    --num_ties;
+                }
+            }
+
+            // A cascade level without trees can't change the shape, so drop it along
+            // with its feature pixels.
+            if (forest.size() == 0)
+                continue;
+
+            result.forests.push_back(forest);
+            result.anchor_idx.push_back(sp.anchor_idx[iter]);
+            result.deltas.push_back(sp.deltas[iter]);
+        }
+
+        result.pack_pixel_encodings();
+        return result;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline shape_predictor truncate_shape_predictor_trees (
+        const shape_predictor& sp,
+        unsigned long depth
+    )
+    {
+        // A tree that deep couldn't have been trained anyway, and 1UL<<depth must not
+        // overflow.
+        DLIB_CASSERT(depth < 32,
+            "\t shape_predictor truncate_shape_predictor_trees()"
+            << "\n\t Invalid tree depth given."
+            << "\n\t depth: " << depth
+        );
+        using namespace impl;
+        shape_predictor result = sp;
+        const unsigned long num_leaves = 1UL<<depth;
+        for (unsigned long iter = 0; iter < result.forests.size(); ++iter)
+        {
+            for (unsigned long i = 0; i < result.forests[iter].size(); ++i)
+            {
+                regression_tree& tree = result.forests[iter][i];
+                if (tree.leaf_values.size() <= num_leaves)
+                    continue;
+
+                // The nodes are stored breadth first, so the top depth levels of the tree
+                // are the first num_leaves-1 splits and each node at the new bottom level
+                // is the root of a contiguous run of the old leaves.  Without the training
+                // data we don't know how many samples went to each old leaf, so the new
+                // leaf value is the plain average of the leaves below it.
+                const unsigned long run = tree.leaf_values.size()/num_leaves;
+                std::vector<matrix<float,0,1> > leaf_values(num_leaves);
+                for (unsigned long j = 0; j < num_leaves; ++j)
+                {
+                    leaf_values[j] = tree.leaf_values[j*run];
+                    for (unsigned long k = 1; k < run; ++k)
+                        leaf_values[j] += tree.leaf_values[j*run+k];
+                    leaf_values[j] /= run;
+                }
+                tree.splits.resize(num_leaves-1);
+                tree.leaf_values.swap(leaf_values);
+            }
+        }
+        return result;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    struct shape_predictor_pruning_result
+    {
+        double fraction_kept = 1;
+        unsigned long tree_depth = 0;
+        unsigned long num_trees = 0;
+        unsigned long model_bytes = 0;
+        double seconds_per_face = 0;
+        double mean_error = 0;
+        bool pareto_optimal = false;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_array
+        >
+    std::vector<shape_predictor_pruning_result> evaluate_shape_predictor_pruning (
+        const shape_predictor& sp,
+        const image_array& images,
+        const std::vector<std::vector<full_object_detection> >& objects,
+        const std::vector<std::vector<double> >& scales,
+        const std::vector<double>& fractions_kept,
+        const std::vector<unsigned long>& tree_depths
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_CASSERT(images.size() == objects.size() && fractions_kept.size() > 0 && tree_depths.size() > 0,
+            "\t std::vector<shape_predictor_pruning_result> evaluate_shape_predictor_pruning()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t images.size():         " << images.size()
+            << "\n\t objects.size():        " << objects.size()
+            << "\n\t fractions_kept.size(): " << fractions_kept.size()
+            << "\n\t tree_depths.size():    " << tree_depths.size()
+        );
+
+        using namespace std::chrono;
+        unsigned long num_faces = 0;
+        for (unsigned long i = 0; i < objects.size(); ++i)
+            num_faces += objects[i].size();
+
+        std::vector<shape_predictor_pruning_result> results;
+        for (unsigned long d = 0; d < tree_depths.size(); ++d)
+        {
+            const shape_predictor truncated = truncate_shape_predictor_trees(sp, tree_depths[d]);
+            for (unsigned long f = 0; f < fractions_kept.size(); ++f)
+            {
+                const shape_predictor candidate = prune_shape_predictor_trees(truncated, fractions_kept[f]);
+
+                shape_predictor_pruning_result result;
+                result.fraction_kept = fractions_kept[f];
+                result.tree_depth = tree_depths[d];
+                result.num_trees = candidate.num_trees();
+
+                std::ostringstream sout;
+                serialize(candidate, sout);
+                result.model_bytes = sout.str().size();
+
+                const auto start = steady_clock::now();
+                result.mean_error = test_shape_predictor(candidate, images, objects, scales);
+                const auto stop = steady_clock::now();
+                if (num_faces != 0)
+                    result.seconds_per_face = duration_cast<duration<double> >(stop-start).count()/num_faces;
+
+                results.push_back(result);
+            }
+        }
+
+        // A candidate is Pareto optimal if no other candidate is at least as good in
+        // size, speed, and error while being strictly better in one of them.
+        for (unsigned long i = 0; i < results.size(); ++i)
+        {
+            results[i].pareto_optimal = true;
+            for (unsigned long j = 0; j < results.size() && results[i].pareto_optimal; ++j)
+            {
+                const shape_predictor_pruning_result& a = results[i];
+                const shape_predictor_pruning_result& b = results[j];
+                if (b.model_bytes <= a.model_bytes && b.seconds_per_face <= a.seconds_per_face &&
+                    b.mean_error <= a.mean_error &&
+                    (b.model_bytes < a.model_bytes || b.seconds_per_face < a.seconds_per_face ||
+                     b.mean_error < a.mean_error))
+                {
+                    results[i].pareto_optimal = false;
+                }
+            }
+        }
+
+        return results;
+    }
+
+    template <
+        typename image_array
+        >
+    std::vector<shape_predictor_pruning_result> evaluate_shape_predictor_pruning (
+        const shape_predictor& sp,
+        const image_array& images,
+        const std::vector<std::vector<full_object_detection> >& objects,
+        const std::vector<double>& fractions_kept,
+        const std::vector<unsigned long>& tree_depths
+    )
+    {
+        std::vector<std::vector<double> > no_scales;
+        return evaluate_shape_predictor_pruning(sp, images, objects, no_scales, fractions_kept, tree_depths);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline void print_shape_predictor_pruning_report (
+        const std::vector<shape_predictor_pruning_result>& results,
+        std::ostream& out
+    )
+    {
+        out << std::setw(9)  << "kept"
+            << std::setw(7)  << "depth"
+            << std::setw(8)  << "trees"
+            << std::setw(12) << "bytes"
+            << std::setw(12) << "us/face"
+            << std::setw(12) << "mean error"
+            << std::setw(8)  << "pareto" << "\n";
+
+        const std::ios::fmtflags flags = out.flags();
+        const std::streamsize precision = out.precision();
+        out << std::fixed;
+        for (unsigned long i = 0; i < results.size(); ++i)
+        {
+            out << std::setw(9)  << std::setprecision(3) << results[i].fraction_kept
+                << std::setw(7)  << results[i].tree_depth
+                << std::setw(8)  << results[i].num_trees
+                << std::setw(12) << results[i].model_bytes
+                << std::setw(12) << std::setprecision(1) << results[i].seconds_per_face*1e6
+                << std::setw(12) << std::setprecision(4) << results[i].mean_error
+                << std::setw(8)  << (results[i].pareto_optimal ? "*" : "") << "\n";
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_SHAPE_PREDICToR_PRUNING_H_
@@ -0,0 +1,156 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_SHAPE_PREDICToR_PRUNING_ABSTRACT_H_
+#ifdef DLIB_SHAPE_PREDICToR_PRUNING_ABSTRACT_H_
+
+#include "shape_predictor_abstract.h"
+#include <iostream>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    std::vector<std::vector<double> > shape_predictor_tree_contributions (
+        const shape_predictor& sp
+    );
+    /*!
+        ensures
+            - Returns a measure of how much each tree in sp contributes to the predicted
+              shapes.  In particular, returns a vector C such that:
+                - C.size() == the number of cascade levels in sp
+                - C[i].size() == the number of trees in the i-th cascade level
+                - C[i][j] == the root mean square length of the leaf vectors of the j-th
+                  tree of the i-th cascade level.  That is, the typical distance, in
+                  normalized shape coordinates, that the tree moves the shape.
+            - The sum of C[i] can be used to rank whole cascade levels in the same way.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    shape_predictor prune_shape_predictor_trees (
+        const shape_predictor& sp,
+        double fraction_kept
+    );
+    /*!
+        requires
+            - 0 <= fraction_kept <= 1
+        ensures
+            - Returns a copy of sp that contains only the round(fraction_kept*sp.num_trees())
+              trees with the largest contributions, as measured by
+              shape_predictor_tree_contributions().  Trees are ranked over the whole model,
+              so late cascade levels, whose trees make small corrections, lose their trees
+              first.
+            - Cascade levels that are left without any trees are removed entirely, which
+              also removes the cost of extracting their feature pixels.
+            - The remaining trees are not refit.
+            - #num_parts() == sp.num_parts()
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    shape_predictor truncate_shape_predictor_trees (
+        const shape_predictor& sp,
+        unsigned long depth
+    );
+    /*!
+        requires
+            - depth < 32
+        ensures
+            - Returns a copy of sp where every tree deeper than depth has been cut down to
+              depth levels of splits.  The value of each new leaf is the average of the
+              leaves that were below it in the original tree.
+            - Trees that are no deeper than depth are left unchanged.  So if depth is at
+              least the depth of the trees in sp then the returned object is equivalent
+              to sp.
+            - #num_parts() == sp.num_parts()
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    struct shape_predictor_pruning_result
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object records how one pruned version of a shape_predictor performed
+                in evaluate_shape_predictor_pruning().
+        !*/
+
+        double fraction_kept = 1;       // the argument given to prune_shape_predictor_trees()
+        unsigned long tree_depth = 0;   // the argument given to truncate_shape_predictor_trees()
+        unsigned long num_trees = 0;    // the number of trees in the pruned model
+        unsigned long model_bytes = 0;  // the size of the serialized pruned model
+        double seconds_per_face = 0;    // the average time to predict one shape
+        double mean_error = 0;          // the output of test_shape_predictor()
+        bool pareto_optimal = false;    // true if no other result is at least as good in
+                                        // model_bytes, seconds_per_face, and mean_error
+                                        // while being strictly better in one of them.
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_array
+        >
+    std::vector<shape_predictor_pruning_result> evaluate_shape_predictor_pruning (
+        const shape_predictor& sp,
+        const image_array& images,
+        const std::vector<std::vector<full_object_detection> >& objects,
+        const std::vector<std::vector<double> >& scales,
+        const std::vector<double>& fractions_kept,
+        const std::vector<unsigned long>& tree_depths
+    );
+    /*!
+        requires
+            - the requirements of test_shape_predictor(sp, images, objects, scales) are met.
+            - fractions_kept.size() > 0
+            - tree_depths.size() > 0
+            - for all valid i:
+                - 0 <= fractions_kept[i] <= 1
+        ensures
+            - For each depth D in tree_depths and each fraction F in fractions_kept, this
+              function builds the candidate model
+                prune_shape_predictor_trees(truncate_shape_predictor_trees(sp, D), F)
+              and measures its serialized size, the time test_shape_predictor() takes per
+              face, and the error reported by test_shape_predictor(candidate, images,
+              objects, scales).  The results are returned, one per candidate, with the
+              Pareto optimal candidates flagged.
+            - images and objects should be a held-out set, not the set sp was trained on.
+            - The timings are measured on the calling thread, so run this on the device
+              you want to pick a model for.
+    !*/
+
+    template <
+        typename image_array
+        >
+    std::vector<shape_predictor_pruning_result> evaluate_shape_predictor_pruning (
+        const shape_predictor& sp,
+        const image_array& images,
+        const std::vector<std::vector<full_object_detection> >& objects,
+        const std::vector<double>& fractions_kept,
+        const std::vector<unsigned long>& tree_depths
+    );
+    /*!
+        ensures
+            - returns evaluate_shape_predictor_pruning(sp, images, objects, no_scales,
+              fractions_kept, tree_depths) where no_scales is an empty vector.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    void print_shape_predictor_pruning_report (
+        const std::vector<shape_predictor_pruning_result>& results,
+        std::ostream& out
+    );
+    /*!
+        ensures
+            - Writes results to out as a table with one row per candidate, giving the
+              fraction of trees kept, the tree depth, the number of trees, the model size
+              in bytes, the prediction time in microseconds per face, the mean error, and
+              a * on the Pareto optimal rows.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_SHAPE_PREDICToR_PRUNING_ABSTRACT_H_
@@ -12,6 +12,7 @@
 #include "draw.h"
 #include "interpolation.h"
 #include "../simd.h"
+#include <vector>
 
 namespace dlib
 {
@@ -20,6 +21,25 @@ namespace dlib
 
     namespace impl_fhog
     {
+        struct fhog_scratch
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    The temporary buffers impl_extract_fhog_features() works in.  Keeping
+                    one of these around between calls on images of the same size means
+                    none of them has to be allocated again.
+            !*/
+
+            array2d<matrix<float,18,1> > hist;
+            array2d<float> norm;
+
+            // used by the 8-bit grayscale populate_hist()
+            std::vector<int32> ixp, len;
+            std::vector<float> vx0, vx1;
+            std::vector<int16> grad_x, grad_y;
+            std::vector<unsigned char> bin;
+        };
+
         template <typename image_type, typename T>
         inline typename dlib::enable_if_c<pixel_traits<typename image_type::pixel_type>::rgb>::type get_gradient (
             const int r,
@@ -390,6 +410,19 @@ namespace dlib
             hog[o][y][x] = value;
         }
 
+        template <typename T, typename mm1, typename mm2>
+        void clear_hog (
+            dlib::array<array2d<T,mm1>,mm2>& hog
+        )
+        {
+            // Keep the 31 planes, just empty, so a caller reusing hog doesn't have to
+            // allocate them again.
+            const int num_hog_bands = 27+4;
+            hog.resize(num_hog_bands);
+            for (int i = 0; i < num_hog_bands; ++i)
+                hog[i].set_size(0,0);
+        }
+
         template <typename T, typename mm1, typename mm2>
         void init_hog (
             dlib::array<array2d<T,mm1>,mm2>& hog,
@@ -445,6 +478,14 @@ namespace dlib
             hog[y][x](o) = value;
         }
 
+        template <typename T, typename mm>
+        void clear_hog (
+            array2d<matrix<T,31,1>,mm>& hog
+        )
+        {
+            hog.clear();
+        }
+
         template <typename T, typename mm>
         void init_hog (
             array2d<matrix<T,31,1>,mm>& hog,
@@ -535,7 +576,7 @@ namespace dlib
 
             if (img.nr() <= 2 || img.nc() <= 2)
             {
-                hog.clear();
+                clear_hog(hog);
                 return;
             }
 
@@ -693,6 +734,354 @@ namespace dlib
             }
         }
 
+    // ------------------------------------------------------------------------------------
+
+        inline simd8f snap_to_orientation (
+            const simd8f& grad_x,
+            const simd8f& grad_y,
+            const matrix<float,2,1>* directions
+        )
+        {
+            // snap each gradient to one of 18 orientations and return the bin indices
+            simd8f best_dot = 0;
+            simd8f best_o = 0;
+            for (int o = 0; o < 9; o++)
+            {
+                simd8f dot = grad_x*directions[o](0) + grad_y*directions[o](1);
+                simd8f_bool cmp = dot>best_dot;
+                best_dot = select(cmp, dot, best_dot);
+                dot *= -1;
+                best_o = select(cmp, o, best_o);
+
+                cmp = dot > best_dot;
+                best_dot = select(cmp, dot, best_dot);
+                best_o = select(cmp, o + 9, best_o);
+            }
+            return best_o;
+        }
+
+        template <typename image_type>
+        inline void add_pixel_to_hist (
+            const image_type& img,
+            array2d<matrix<float,18,1> >& hist,
+            const matrix<float,2,1>* directions,
+            const int cell_size,
+            const int y,
+            const int x,
+            const int iyp,
+            const float vy0,
+            const float vy1
+        )
+        {
+            matrix<float, 2, 1> grad;
+            float v;
+            get_gradient(y,x,img,grad,v);
+
+            // snap to one of 18 orientations
+            float best_dot = 0;
+            int best_o = 0;
+            for (int o = 0; o < 9; o++) 
+            {
+                const float dot = dlib::dot(directions[o], grad);
+                if (dot > best_dot) 
+                {
+                    best_dot = dot;
+                    best_o = o;
+                } 
+                else if (-dot > best_dot) 
+                {
+                    best_dot = -dot;
+                    best_o = o+9;
+                }
+            }
+
+            v = std::sqrt(v);
+            // add to 4 histograms around pixel using bilinear interpolation
+            const float xp = ((double)x + 0.5) / (double)cell_size - 0.5;
+            const int ixp = (int)std::floor(xp);
+            const float vx0 = xp - ixp;
+            const float vx1 = 1.0 - vx0;
+
+            hist[iyp+1][ixp+1](best_o) += vy1*vx1*v;
+            hist[iyp+1+1][ixp+1](best_o) += vy0*vx1*v;
+            hist[iyp+1][ixp+1+1](best_o) += vy1*vx0*v;
+            hist[iyp+1+1][ixp+1+1](best_o) += vy0*vx0*v;
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        template <typename image_type>
+        typename disable_if<is_same_type<typename image_type::pixel_type,unsigned char> >::type populate_hist (
+            const image_type& img,
+            array2d<matrix<float,18,1> >& hist,
+            const matrix<float,2,1>* directions,
+            const int cell_size,
+            const int visible_nr,
+            const int visible_nc,
+            fhog_scratch&
+        )
+        {
+            for (int y = 1; y < visible_nr; y++) 
+            {
+                const float yp = ((float)y+0.5)/(float)cell_size - 0.5;
+                const int iyp = (int)std::floor(yp);
+                const float vy0 = yp - iyp;
+                const float vy1 = 1.0 - vy0;
+                int x;
+                for (x = 1; x < visible_nc - 7; x += 8)
+                {
+                    simd8f xx(x, x + 1, x + 2, x + 3, x + 4, x + 5, x + 6, x + 7);
+                    // v will be the length of the gradient vectors.
+                    simd8f grad_x, grad_y, v;
+                    get_gradient(y, x, img, grad_x, grad_y, v);
+
+                    // We will use bilinear interpolation to add into the histogram bins.
+                    // So first we precompute the values needed to determine how much each
+                    // pixel votes into each bin.
+                    simd8f xp = (xx + 0.5) / (float)cell_size + 0.5;
+                    simd8i ixp = simd8i(xp);
+                    simd8f vx0 = xp - ixp;
+                    simd8f vx1 = 1.0f - vx0;
+
+                    v = sqrt(v);
+
+                    // Now snap the gradient to one of 18 orientations
+                    simd8f best_o = snap_to_orientation(grad_x, grad_y, directions);
+
+
+                    // Add the gradient magnitude, v, to 4 histograms around pixel using
+                    // bilinear interpolation.
+                    vx1 *= v;
+                    vx0 *= v;
+                    // The amounts for each bin
+                    simd8f v11 = vy1*vx1;
+                    simd8f v01 = vy0*vx1;
+                    simd8f v10 = vy1*vx0;
+                    simd8f v00 = vy0*vx0;
+
+                    int32 _best_o[8]; simd8i(best_o).store(_best_o);
+                    int32 _ixp[8];    ixp.store(_ixp);
+                    float _v11[8];    v11.store(_v11);
+                    float _v01[8];    v01.store(_v01);
+                    float _v10[8];    v10.store(_v10);
+                    float _v00[8];    v00.store(_v00);
+
+                    hist[iyp + 1][_ixp[0]](_best_o[0]) += _v11[0];
+                    hist[iyp + 1 + 1][_ixp[0]](_best_o[0]) += _v01[0];
+                    hist[iyp + 1][_ixp[0] + 1](_best_o[0]) += _v10[0];
+                    hist[iyp + 1 + 1][_ixp[0] + 1](_best_o[0]) += _v00[0];
+
+                    hist[iyp + 1][_ixp[1]](_best_o[1]) += _v11[1];
+                    hist[iyp + 1 + 1][_ixp[1]](_best_o[1]) += _v01[1];
+                    hist[iyp + 1][_ixp[1] + 1](_best_o[1]) += _v10[1];
+                    hist[iyp + 1 + 1][_ixp[1] + 1](_best_o[1]) += _v00[1];
+
+                    hist[iyp + 1][_ixp[2]](_best_o[2]) += _v11[2];
+                    hist[iyp + 1 + 1][_ixp[2]](_best_o[2]) += _v01[2];
+                    hist[iyp + 1][_ixp[2] + 1](_best_o[2]) += _v10[2];
+                    hist[iyp + 1 + 1][_ixp[2] + 1](_best_o[2]) += _v00[2];
+
+                    hist[iyp + 1][_ixp[3]](_best_o[3]) += _v11[3];
+                    hist[iyp + 1 + 1][_ixp[3]](_best_o[3]) += _v01[3];
+                    hist[iyp + 1][_ixp[3] + 1](_best_o[3]) += _v10[3];
+                    hist[iyp + 1 + 1][_ixp[3] + 1](_best_o[3]) += _v00[3];
+
+                    hist[iyp + 1][_ixp[4]](_best_o[4]) += _v11[4];
+                    hist[iyp + 1 + 1][_ixp[4]](_best_o[4]) += _v01[4];
+                    hist[iyp + 1][_ixp[4] + 1](_best_o[4]) += _v10[4];
+                    hist[iyp + 1 + 1][_ixp[4] + 1](_best_o[4]) += _v00[4];
+
+                    hist[iyp + 1][_ixp[5]](_best_o[5]) += _v11[5];
+                    hist[iyp + 1 + 1][_ixp[5]](_best_o[5]) += _v01[5];
+                    hist[iyp + 1][_ixp[5] + 1](_best_o[5]) += _v10[5];
+                    hist[iyp + 1 + 1][_ixp[5] + 1](_best_o[5]) += _v00[5];
+
+                    hist[iyp + 1][_ixp[6]](_best_o[6]) += _v11[6];
+                    hist[iyp + 1 + 1][_ixp[6]](_best_o[6]) += _v01[6];
+                    hist[iyp + 1][_ixp[6] + 1](_best_o[6]) += _v10[6];
+                    hist[iyp + 1 + 1][_ixp[6] + 1](_best_o[6]) += _v00[6];
+
+                    hist[iyp + 1][_ixp[7]](_best_o[7]) += _v11[7];
+                    hist[iyp + 1 + 1][_ixp[7]](_best_o[7]) += _v01[7];
+                    hist[iyp + 1][_ixp[7] + 1](_best_o[7]) += _v10[7];
+                    hist[iyp + 1 + 1][_ixp[7] + 1](_best_o[7]) += _v00[7];
+                }
+                // Now process the right columns that don't fit into simd registers.
+                for (; x < visible_nc; x++) 
+                    add_pixel_to_hist(img, hist, directions, cell_size, y, x, iyp, vy0, vy1);
+            }
+        }
+
+    // ------------------------------------------------------------------------------------
+
+        inline std::vector<unsigned char> make_u8_orientation_table (
+        )
+        {
+            matrix<float,2,1> directions[9];
+            directions[0] =  1.0000, 0.0000; 
+            directions[1] =  0.9397, 0.3420;
+            directions[2] =  0.7660, 0.6428;
+            directions[3] =  0.500,  0.8660;
+            directions[4] =  0.1736, 0.9848;
+            directions[5] = -0.1736, 0.9848;
+            directions[6] = -0.5000, 0.8660;
+            directions[7] = -0.7660, 0.6428;
+            directions[8] = -0.9397, 0.3420;
+
+            std::vector<unsigned char> table(256*511);
+            for (int gy = 0; gy < 256; ++gy)
+            {
+                for (int gx = -255; gx <= 255; gx += 8)
+                {
+                    const simd8f grad_x(gx, gx+1, gx+2, gx+3, gx+4, gx+5, gx+6, gx+7);
+                    const simd8f grad_y(gy);
+                    int32 best_o[8]; simd8i(snap_to_orientation(grad_x, grad_y, directions)).store(best_o);
+                    for (int i = 0; i < 8 && gx+i <= 255; ++i)
+                        table[gy*511 + gx+i+255] = best_o[i];
+                }
+            }
+            return table;
+        }
+
+        inline const unsigned char* u8_orientation_table (
+        )
+        /*!
+            ensures
+                - returns a 256x511 row major table T such that, for an integer gradient
+                  (gx,gy) with gy >= 0 and -255 <= gx <= 255, T[gy*511 + gx+255] is the
+                  orientation bin snap_to_orientation() assigns to it.  The bins of
+                  gradients with gy < 0 are those of (-gx,-gy) with o and o+9 swapped.
+        !*/
+        {
+            static const std::vector<unsigned char> table = make_u8_orientation_table();
+            return &table[0];
+        }
+
+        template <typename image_type>
+        typename enable_if<is_same_type<typename image_type::pixel_type,unsigned char> >::type populate_hist (
+            const image_type& img,
+            array2d<matrix<float,18,1> >& hist,
+            const matrix<float,2,1>* directions,
+            const int cell_size,
+            const int visible_nr,
+            const int visible_nc,
+            fhog_scratch& scratch
+        )
+        {
+            /*
+                This is the same computation as the generic populate_hist() above,
+                specialized for 8-bit grayscale images.  The gradients of a whole row are
+                computed with 16 bit integer arithmetic, which compilers turn into 16 pixel
+                wide SSE2/NEON instructions, and the orientation bins are read out of
+                u8_orientation_table() instead of being found with 18 dot products per
+                pixel.  The bilinear weights, the gradient magnitudes and the order in which
+                votes are added into hist are computed exactly as in the generic version, so
+                the two produce bit for bit identical histograms.
+            */
+            const unsigned char* const orientation = u8_orientation_table();
+
+            // The generic version handles the columns in [1,x_end) 8 at a time with simd8f
+            // and the remaining ones with add_pixel_to_hist().  The bilinear weights of the
+            // 8 wide columns don't depend on the row so we compute them once up front.
+            int x_end = 1;
+            while (x_end < visible_nc - 7)
+                x_end += 8;
+
+            std::vector<int32>& ixp = scratch.ixp;
+            std::vector<float>& vx0 = scratch.vx0;
+            std::vector<float>& vx1 = scratch.vx1;
+            ixp.resize(x_end);
+            vx0.resize(x_end);
+            vx1.resize(x_end);
+            for (int x = 1; x < x_end; x += 8)
+            {
+                simd8f xx(x, x + 1, x + 2, x + 3, x + 4, x + 5, x + 6, x + 7);
+                simd8f xp = (xx + 0.5) / (float)cell_size + 0.5;
+                simd8i ixp8 = simd8i(xp);
+                simd8f vx08 = xp - ixp8;
+                simd8f vx18 = 1.0f - vx08;
+                ixp8.store(&ixp[x]);
+                vx08.store(&vx0[x]);
+                vx18.store(&vx1[x]);
+            }
+
+            std::vector<int16>& grad_x = scratch.grad_x;
+            std::vector<int16>& grad_y = scratch.grad_y;
+            std::vector<int32>& len = scratch.len;
+            std::vector<unsigned char>& bin = scratch.bin;
+            grad_x.resize(x_end);
+            grad_y.resize(x_end);
+            len.resize(x_end);
+            bin.resize(x_end);
+            for (int y = 1; y < visible_nr; y++) 
+            {
+                const float yp = ((float)y+0.5)/(float)cell_size - 0.5;
+                const int iyp = (int)std::floor(yp);
+                const float vy0 = yp - iyp;
+                const float vy1 = 1.0 - vy0;
+
+                const unsigned char* const above = &img[y-1][0];
+                const unsigned char* const row = &img[y][0];
+                const unsigned char* const below = &img[y+1][0];
+                for (int x = 1; x < x_end; ++x)
+                {
+                    grad_x[x] = (int16)row[x+1] - (int16)row[x-1];
+                    grad_y[x] = (int16)below[x] - (int16)above[x];
+                }
+                for (int x = 1; x < x_end; ++x)
+                {
+                    const int gx = grad_x[x];
+                    const int gy = grad_y[x];
+                    len[x] = gx*gx + gy*gy;
+                    if (gy >= 0)
+                    {
+                        bin[x] = orientation[gy*511 + gx+255];
+                    }
+                    else
+                    {
+                        const unsigned char o = orientation[-gy*511 - gx+255];
+                        bin[x] = o < 9 ? o+9 : o-9;
+                    }
+                }
+
+                int x;
+                for (x = 1; x < x_end; x += 8)
+                {
+                    simd8i len8;
+                    len8.load(&len[x]);
+                    const simd8f v = sqrt(simd8f(len8));
+
+                    simd8f wx0, wx1;
+                    wx0.load(&vx0[x]);
+                    wx1.load(&vx1[x]);
+                    wx1 *= v;
+                    wx0 *= v;
+                    // The amounts for each bin
+                    simd8f v11 = vy1*wx1;
+                    simd8f v01 = vy0*wx1;
+                    simd8f v10 = vy1*wx0;
+                    simd8f v00 = vy0*wx0;
+
+                    float _v11[8];    v11.store(_v11);
+                    float _v01[8];    v01.store(_v01);
+                    float _v10[8];    v10.store(_v10);
+                    float _v00[8];    v00.store(_v00);
+
+                    for (int i = 0; i < 8; ++i)
+                    {
+                        const int o = bin[x+i];
+                        const int c = ixp[x+i];
+                        hist[iyp + 1][c](o) += _v11[i];
+                        hist[iyp + 1 + 1][c](o) += _v01[i];
+                        hist[iyp + 1][c + 1](o) += _v10[i];
+                        hist[iyp + 1 + 1][c + 1](o) += _v00[i];
+                    }
+                }
+                for (; x < visible_nc; x++) 
+                    add_pixel_to_hist(img, hist, directions, cell_size, y, x, iyp, vy0, vy1);
+            }
+        }
+
     // ------------------------------------------------------------------------------------
 
         template <
@@ -704,7 +1093,8 @@ namespace dlib
             out_type& hog, 
             int cell_size,
             int filter_rows_padding,
-            int filter_cols_padding
+            int filter_cols_padding,
+            fhog_scratch& scratch
         ) 
         {
             const_image_view<image_type> img(img_);
@@ -782,7 +1172,7 @@ namespace dlib
 
             if (cells_nr == 0 || cells_nc == 0)
             {
-                hog.clear();
+                clear_hog(hog);
                 return;
             }
 
@@ -790,7 +1180,8 @@ namespace dlib
             // edge) so we can avoid needing to do boundary checks when indexing into it
             // later on.  So some statements assign to the boundary but those values are
             // never used.
-            array2d<matrix<float,18,1> > hist(cells_nr+2, cells_nc+2);
+            array2d<matrix<float,18,1> >& hist = scratch.hist;
+            hist.set_size(cells_nr+2, cells_nc+2);
             for (long r = 0; r < hist.nr(); ++r)
             {
                 for (long c = 0; c < hist.nc(); ++c)
@@ -799,7 +1190,8 @@ namespace dlib
                 }
             }
 
-            array2d<float> norm(cells_nr, cells_nc);
+            array2d<float>& norm = scratch.norm;
+            norm.set_size(cells_nr, cells_nc);
             assign_all_pixels(norm, 0);
 
             // memory for HOG features
@@ -807,7 +1199,7 @@ namespace dlib
             const int hog_nc = std::max(cells_nc-2, 0);
             if (hog_nr == 0 || hog_nc == 0)
             {
-                hog.clear();
+                clear_hog(hog);
                 return;
             }
             const int padding_rows_offset = (filter_rows_padding-1)/2;
@@ -818,142 +1210,7 @@ namespace dlib
             const int visible_nc = std::min((long)cells_nc*cell_size,img.nc())-1;
 
             // First populate the gradient histograms
-            for (int y = 1; y < visible_nr; y++) 
-            {
-                const float yp = ((float)y+0.5)/(float)cell_size - 0.5;
-                const int iyp = (int)std::floor(yp);
-                const float vy0 = yp - iyp;
-                const float vy1 = 1.0 - vy0;
-                int x;
-                for (x = 1; x < visible_nc - 7; x += 8)
-                {
-                    simd8f xx(x, x + 1, x + 2, x + 3, x + 4, x + 5, x + 6, x + 7);
-                    // v will be the length of the gradient vectors.
-                    simd8f grad_x, grad_y, v;
-                    get_gradient(y, x, img, grad_x, grad_y, v);
-
-                    // We will use bilinear interpolation to add into the histogram bins.
-                    // So first we precompute the values needed to determine how much each
-                    // pixel votes into each bin.
-                    simd8f xp = (xx + 0.5) / (float)cell_size + 0.5;
-                    simd8i ixp = simd8i(xp);
-                    simd8f vx0 = xp - ixp;
-                    simd8f vx1 = 1.0f - vx0;
-
-                    v = sqrt(v);
-
-                    // Now snap the gradient to one of 18 orientations
-                    simd8f best_dot = 0;
-                    simd8f best_o = 0;
-                    for (int o = 0; o < 9; o++)
-                    {
-                        simd8f dot = grad_x*directions[o](0) + grad_y*directions[o](1);
-                        simd8f_bool cmp = dot>best_dot;
-                        best_dot = select(cmp, dot, best_dot);
-                        dot *= -1;
-                        best_o = select(cmp, o, best_o);
-
-                        cmp = dot > best_dot;
-                        best_dot = select(cmp, dot, best_dot);
-                        best_o = select(cmp, o + 9, best_o);
-                    }
-
-
-                    // Add the gradient magnitude, v, to 4 histograms around pixel using
-                    // bilinear interpolation.
-                    vx1 *= v;
-                    vx0 *= v;
-                    // The amounts for each bin
-                    simd8f v11 = vy1*vx1;
-                    simd8f v01 = vy0*vx1;
-                    simd8f v10 = vy1*vx0;
-                    simd8f v00 = vy0*vx0;
-
-                    int32 _best_o[8]; simd8i(best_o).store(_best_o);
-                    int32 _ixp[8];    ixp.store(_ixp);
-                    float _v11[8];    v11.store(_v11);
-                    float _v01[8];    v01.store(_v01);
-                    float _v10[8];    v10.store(_v10);
-                    float _v00[8];    v00.store(_v00);
-
-                    hist[iyp + 1][_ixp[0]](_best_o[0]) += _v11[0];
-                    hist[iyp + 1 + 1][_ixp[0]](_best_o[0]) += _v01[0];
-                    hist[iyp + 1][_ixp[0] + 1](_best_o[0]) += _v10[0];
-                    hist[iyp + 1 + 1][_ixp[0] + 1](_best_o[0]) += _v00[0];
-
-                    hist[iyp + 1][_ixp[1]](_best_o[1]) += _v11[1];
-                    hist[iyp + 1 + 1][_ixp[1]](_best_o[1]) += _v01[1];
-                    hist[iyp + 1][_ixp[1] + 1](_best_o[1]) += _v10[1];
-                    hist[iyp + 1 + 1][_ixp[1] + 1](_best_o[1]) += _v00[1];
-
-                    hist[iyp + 1][_ixp[2]](_best_o[2]) += _v11[2];
-                    hist[iyp + 1 + 1][_ixp[2]](_best_o[2]) += _v01[2];
-                    hist[iyp + 1][_ixp[2] + 1](_best_o[2]) += _v10[2];
-                    hist[iyp + 1 + 1][_ixp[2] + 1](_best_o[2]) += _v00[2];
-
-                    hist[iyp + 1][_ixp[3]](_best_o[3]) += _v11[3];
-                    hist[iyp + 1 + 1][_ixp[3]](_best_o[3]) += _v01[3];
-                    hist[iyp + 1][_ixp[3] + 1](_best_o[3]) += _v10[3];
-                    hist[iyp + 1 + 1][_ixp[3] + 1](_best_o[3]) += _v00[3];
-
-                    hist[iyp + 1][_ixp[4]](_best_o[4]) += _v11[4];
-                    hist[iyp + 1 + 1][_ixp[4]](_best_o[4]) += _v01[4];
-                    hist[iyp + 1][_ixp[4] + 1](_best_o[4]) += _v10[4];
-                    hist[iyp + 1 + 1][_ixp[4] + 1](_best_o[4]) += _v00[4];
-
-                    hist[iyp + 1][_ixp[5]](_best_o[5]) += _v11[5];
-                    hist[iyp + 1 + 1][_ixp[5]](_best_o[5]) += _v01[5];
-                    hist[iyp + 1][_ixp[5] + 1](_best_o[5]) += _v10[5];
-                    hist[iyp + 1 + 1][_ixp[5] + 1](_best_o[5]) += _v00[5];
-
-                    hist[iyp + 1][_ixp[6]](_best_o[6]) += _v11[6];
-                    hist[iyp + 1 + 1][_ixp[6]](_best_o[6]) += _v01[6];
-                    hist[iyp + 1][_ixp[6] + 1](_best_o[6]) += _v10[6];
-                    hist[iyp + 1 + 1][_ixp[6] + 1](_best_o[6]) += _v00[6];
-
-                    hist[iyp + 1][_ixp[7]](_best_o[7]) += _v11[7];
-                    hist[iyp + 1 + 1][_ixp[7]](_best_o[7]) += _v01[7];
-                    hist[iyp + 1][_ixp[7] + 1](_best_o[7]) += _v10[7];
-                    hist[iyp + 1 + 1][_ixp[7] + 1](_best_o[7]) += _v00[7];
-                }
-                // Now process the right columns that don't fit into simd registers.
-                for (; x < visible_nc; x++) 
-                {
-                    matrix<float, 2, 1> grad;
-                    float v;
-                    get_gradient(y,x,img,grad,v);
-
-                    // snap to one of 18 orientations
-                    float best_dot = 0;
-                    int best_o = 0;
-                    for (int o = 0; o < 9; o++) 
-                    {
-                        const float dot = dlib::dot(directions[o], grad);
-                        if (dot > best_dot) 
-                        {
-                            best_dot = dot;
-                            best_o = o;
-                        } 
-                        else if (-dot > best_dot) 
-                        {
-                            best_dot = -dot;
-                            best_o = o+9;
-                        }
-                    }
-
-                    v = std::sqrt(v);
-                    // add to 4 histograms around pixel using bilinear interpolation
-                    const float xp = ((double)x + 0.5) / (double)cell_size - 0.5;
-                    const int ixp = (int)std::floor(xp);
-                    const float vx0 = xp - ixp;
-                    const float vx1 = 1.0 - vx0;
-
-                    hist[iyp+1][ixp+1](best_o) += vy1*vx1*v;
-                    hist[iyp+1+1][ixp+1](best_o) += vy0*vx1*v;
-                    hist[iyp+1][ixp+1+1](best_o) += vy1*vx0*v;
-                    hist[iyp+1+1][ixp+1+1](best_o) += vy0*vx0*v;
-                }
-            }
+            populate_hist(img, hist, directions, cell_size, visible_nr, visible_nc, scratch);
 
             // compute energy in each block by summing over orientations
             for (int r = 0; r < cells_nr; ++r)
@@ -1045,6 +1302,24 @@ namespace dlib
             }
         }
 
+    // ------------------------------------------------------------------------------------
+
+        template <
+            typename image_type, 
+            typename out_type
+            >
+        void impl_extract_fhog_features(
+            const image_type& img, 
+            out_type& hog, 
+            int cell_size,
+            int filter_rows_padding,
+            int filter_cols_padding
+        ) 
+        {
+            fhog_scratch scratch;
+            impl_extract_fhog_features(img, hog, cell_size, filter_rows_padding, filter_cols_padding, scratch);
+        }
+
     // ------------------------------------------------------------------------------------
 
         inline void create_fhog_bar_images (
@@ -70,6 +70,9 @@ namespace dlib
             - for all valid r and c:
                 - #hog[r][c] == the FHOG vector describing the cell centered at the pixel location 
                   fhog_to_image(point(c,r),cell_size,filter_rows_padding,filter_cols_padding) in img.
+            - When img contains unsigned char pixels and cell_size > 1 a specialized 8-bit
+              grayscale implementation is used.  It outputs exactly the same features as
+              the generic implementation would for the same pixel values, only faster.
     !*/
 
 // ----------------------------------------------------------------------------------------
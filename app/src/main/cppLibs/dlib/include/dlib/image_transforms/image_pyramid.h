@@ -8,6 +8,7 @@
 #include "../array2d.h"
 #include "../geometry.h"
 #include "spatial_filtering.h"
+#include "../simd.h"
 
 namespace dlib
 {
@@ -237,13 +238,23 @@ namespace dlib
                 typedef typename image_traits<U>::pixel_type U_pix;
                 const static bool value = pixel_traits<T_pix>::rgb && pixel_traits<U_pix>::rgb;
             };
+
+            template <typename T, typename U>
+            struct both_images_8bit_grayscale
+            {
+                typedef typename image_traits<T>::pixel_type T_pix;
+                typedef typename image_traits<U>::pixel_type U_pix;
+                const static bool value = is_same_type<T_pix,unsigned char>::value &&
+                                          is_same_type<U_pix,unsigned char>::value;
+            };
         public:
 
             template <
                 typename in_image_type,
                 typename out_image_type
                 >
-            typename disable_if<both_images_rgb<in_image_type,out_image_type> >::type operator() (
+            typename disable_if_c<both_images_rgb<in_image_type,out_image_type>::value ||
+                                  both_images_8bit_grayscale<in_image_type,out_image_type>::value>::type operator() (
                 const in_image_type& original_,
                 out_image_type& down_
             ) const
@@ -329,6 +340,102 @@ namespace dlib
 
             }
 
+            template <
+                typename in_image_type,
+                typename out_image_type
+                >
+            typename enable_if<both_images_8bit_grayscale<in_image_type,out_image_type> >::type operator() (
+                const in_image_type& original_,
+                out_image_type& down_
+            ) const
+            {
+                // make sure requires clause is not broken
+                DLIB_ASSERT( is_same_object(original_, down_) == false, 
+                            "\t void pyramid_down_2_1::operator()"
+                            << "\n\t is_same_object(original_, down_): " << is_same_object(original_, down_) 
+                            << "\n\t this:                           " << this
+                            );
+
+                const_image_view<in_image_type> original(original_);
+                image_view<out_image_type> down(down_);
+
+                if (original.nr() <= 8 || original.nc() <= 8)
+                {
+                    down.clear();
+                    return;
+                }
+
+                down.set_size((original.nr()-3)/2, (original.nc()-3)/2);
+
+                // This is the same filter as above, but applied with 16 bit integer SIMD
+                // instructions.  The filter is applied to the columns first and then to the
+                // rows, and a filtered pixel is at most 255*256, so the output is identical
+                // to the generic version.  The image is processed in strips of output
+                // columns narrow enough for the intermediate rows to fit on the stack.
+                const long strip_size = 256;
+                uint16 col_filtered[2*strip_size+3];
+                uint16 row_filtered[2*strip_size];
+                for (long dr = 0; dr < down.nr(); ++dr)
+                {
+                    const unsigned char* in0 = &original[2*dr][0];
+                    const unsigned char* in1 = &original[2*dr+1][0];
+                    const unsigned char* in2 = &original[2*dr+2][0];
+                    const unsigned char* in3 = &original[2*dr+3][0];
+                    const unsigned char* in4 = &original[2*dr+4][0];
+                    unsigned char* out = &down[dr][0];
+
+                    for (long c = 0; c < down.nc(); c += strip_size)
+                    {
+                        const long num_out = std::min(strip_size, down.nc()-c);
+                        const long num_in = 2*num_out+3;
+                        const long oc = 2*c;
+
+                        // apply column filter
+                        long i = 0;
+                        for (; i+8 <= num_in; i += 8)
+                        {
+                            simd8us p0, p1, p2, p3, p4;
+                            p0.load(in0+oc+i);
+                            p1.load(in1+oc+i);
+                            p2.load(in2+oc+i);
+                            p3.load(in3+oc+i);
+                            p4.load(in4+oc+i);
+                            simd8us temp = p0 + p4 + ((p1+p3)<<2) + (p2<<2) + (p2<<1);
+                            temp.store(col_filtered+i);
+                        }
+                        for (; i < num_in; ++i)
+                        {
+                            col_filtered[i] = in0[oc+i] + 4*(in1[oc+i]+in3[oc+i]) + 
+                                              6*in2[oc+i] + in4[oc+i];
+                        }
+
+                        // apply row filter at every column, then keep every other one
+                        const long num_row = 2*num_out-1;
+                        i = 0;
+                        for (; i+8 <= num_row; i += 8)
+                        {
+                            simd8us p0, p1, p2, p3, p4;
+                            p0.load(col_filtered+i);
+                            p1.load(col_filtered+i+1);
+                            p2.load(col_filtered+i+2);
+                            p3.load(col_filtered+i+3);
+                            p4.load(col_filtered+i+4);
+                            simd8us temp = p0 + p4 + ((p1+p3)<<2) + (p2<<2) + (p2<<1);
+                            temp = temp>>8;
+                            temp.store(row_filtered+i);
+                        }
+                        for (; i < num_row; ++i)
+                        {
+                            row_filtered[i] = (col_filtered[i] + 4*(col_filtered[i+1]+col_filtered[i+3]) +
+                                               6*col_filtered[i+2] + col_filtered[i+4])>>8;
+                        }
+
+                        for (long k = 0; k < num_out; ++k)
+                            out[c+k] = static_cast<unsigned char>(row_filtered[2*k]);
+                    }
+                }
+            }
+
         private:
             struct rgbptype 
             {
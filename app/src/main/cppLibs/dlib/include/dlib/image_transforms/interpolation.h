@@ -794,11 +794,24 @@ namespace dlib
         const static bool value = is_same_type<ptype1, ptype2>::value;
     };
 
+    template <
+        typename image_type1,
+        typename image_type2
+        >
+    struct images_are_8bit_grayscale
+    {
+        typedef typename image_traits<image_type1>::pixel_type ptype1;
+        typedef typename image_traits<image_type2>::pixel_type ptype2;
+        const static bool value = is_same_type<ptype1, unsigned char>::value &&
+                                  is_same_type<ptype2, unsigned char>::value;
+    };
+
     template <
         typename image_type,
         typename image_type2
         >
-    typename enable_if_c<is_grayscale_image<image_type>::value && is_grayscale_image<image_type2>::value && images_have_same_pixel_types<image_type,image_type2>::value>::type 
+    typename enable_if_c<is_grayscale_image<image_type>::value && is_grayscale_image<image_type2>::value && images_have_same_pixel_types<image_type,image_type2>::value &&
+                         !images_are_8bit_grayscale<image_type,image_type2>::value>::type 
     resize_image (
         const image_type& in_img_,
         image_type2& out_img_,
@@ -893,6 +906,108 @@ namespace dlib
         }
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type1,
+        typename image_type2
+        >
+    typename enable_if<images_are_8bit_grayscale<image_type1,image_type2> >::type 
+    resize_image (
+        const image_type1& in_img_,
+        image_type2& out_img_,
+        interpolate_bilinear
+    )
+    {
+        // make sure requires clause is not broken
+        DLIB_ASSERT( is_same_object(in_img_, out_img_) == false ,
+            "\t void resize_image()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t is_same_object(in_img_, out_img_):  " << is_same_object(in_img_, out_img_)
+            );
+
+        const_image_view<image_type1> in_img(in_img_);
+        image_view<image_type2> out_img(out_img_);
+
+        if (out_img.size() == 0 || in_img.size() == 0)
+            return;
+
+        // This version uses fixed point weights.  The vertical weights have 8 fractional
+        // bits, so blending two rows of 8 bit pixels fits in 16 bits and is done with
+        // SIMD instructions over a whole strip of input columns.  The horizontal weights
+        // have 14 fractional bits and are applied with 32 bit integers.  The output
+        // differs from the floating point versions by at most 1.  The image is processed
+        // in strips of output columns, so the column positions and weights are computed
+        // once per strip and the blended rows fit on the stack.
+        const long max_strip_in = 1024;
+        const long max_strip_out = 256;
+        uint16 blended[max_strip_in];
+        int32 lefts[max_strip_out];
+        int32 rights[max_strip_out];
+        uint32 right_weights[max_strip_out];
+
+        const double x_scale = (in_img.nc()-1)/(double)std::max<long>((out_img.nc()-1),1);
+        const double y_scale = (in_img.nr()-1)/(double)std::max<long>((out_img.nr()-1),1);
+        double x = -x_scale;
+        long c = 0;
+        while (c < out_img.nc())
+        {
+            // Find the output columns of this strip and the input columns they read.
+            long num_out = 0;
+            long first_in = 0;
+            for (; c+num_out < out_img.nc() && num_out < max_strip_out; ++num_out)
+            {
+                const double next_x = x + x_scale;
+                const long left = static_cast<long>(std::floor(next_x));
+                if (num_out == 0)
+                    first_in = left;
+                else if (left+1 - first_in >= max_strip_in)
+                    break;
+                x = next_x;
+                lefts[num_out] = left - first_in;
+                rights[num_out] = std::min(left+1, in_img.nc()-1) - first_in;
+                right_weights[num_out] = static_cast<uint32>((x - left)*16384 + 0.5);
+            }
+            const long num_in = rights[num_out-1] + 1;
+
+            double y = -y_scale;
+            for (long r = 0; r < out_img.nr(); ++r)
+            {
+                y += y_scale;
+                const long top    = static_cast<long>(std::floor(y));
+                const long bottom = std::min(top+1, in_img.nr()-1);
+                const uint16 bottom_weight = static_cast<uint16>((y - top)*256 + 0.5);
+                const unsigned char* top_row = &in_img[top][0] + first_in;
+                const unsigned char* bottom_row = &in_img[bottom][0] + first_in;
+                unsigned char* out = &out_img[r][0] + c;
+
+                // blend the top and bottom rows
+                const simd8us _bottom_weight = bottom_weight;
+                const simd8us _top_weight = 256 - bottom_weight;
+                long i = 0;
+                for (; i+8 <= num_in; i += 8)
+                {
+                    simd8us t, b;
+                    t.load(top_row+i);
+                    b.load(bottom_row+i);
+                    simd8us temp = t*_top_weight + b*_bottom_weight;
+                    temp.store(blended+i);
+                }
+                for (; i < num_in; ++i)
+                    blended[i] = (256-bottom_weight)*top_row[i] + bottom_weight*bottom_row[i];
+
+                // then interpolate between the columns
+                for (long k = 0; k < num_out; ++k)
+                {
+                    const uint32 temp = (16384-right_weights[k])*blended[lefts[k]] + 
+                                        right_weights[k]*blended[rights[k]];
+                    out[k] = static_cast<unsigned char>(temp>>22);
+                }
+            }
+            c += num_out;
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -1850,6 +1965,111 @@ namespace dlib
                 }
             }
         }
+
+        template <
+            typename image_type,
+            typename pyramid_image_type
+            >
+        void plan_image_chips (
+            const image_type& img,
+            const std::vector<chip_details>& chip_locations,
+            rectangle& bounding_box,
+            dlib::array<pyramid_image_type>& levels,
+            std::vector<long>& chip_levels,
+            std::vector<point_transform_affine>& transforms
+        )
+        /*!
+            ensures
+                - Works out how extract_image_chips() gets each chip.  For all valid i:
+                    - if (#chip_levels[i] == -2) then
+                        - chip i has no rotation or scaling, so it is just a copy of
+                          chip_locations[i].rect in img.
+                    - else
+                        - chip i is made by sampling #transforms[i](p) for each chip pixel
+                          p from sub_image(img,#bounding_box) if #chip_levels[i] == -1,
+                          and from #levels[#chip_levels[i]] otherwise.
+        !*/
+        {
+            pyramid_down<2> pyr;
+            long max_depth = 0;
+            // If the chip is supposed to be much smaller than the source subwindow then you
+            // can't just extract it using bilinear interpolation since at a high enough
+            // downsampling amount it would effectively turn into nearest neighbor
+            // interpolation.  So we use an image pyramid to make sure the interpolation is
+            // fast but also high quality.  The first thing we do is figure out how deep the
+            // image pyramid needs to be.
+            bounding_box = rectangle();
+            for (unsigned long i = 0; i < chip_locations.size(); ++i)
+            {
+                long depth = 0;
+                double grow = 2;
+                drectangle rect = pyr.rect_down(chip_locations[i].rect);
+                while (rect.area() > chip_locations[i].size())
+                {
+                    rect = pyr.rect_down(rect);
+                    ++depth;
+                    // We drop the image size by a factor of 2 each iteration and then assume a
+                    // border of 2 pixels is needed to avoid any border effects of the crop.
+                    grow = grow*2 + 2;
+                }
+                drectangle rot_rect;
+                const vector<double,2> cent = center(chip_locations[i].rect);
+                rot_rect += rotate_point<double>(cent,chip_locations[i].rect.tl_corner(),chip_locations[i].angle);
+                rot_rect += rotate_point<double>(cent,chip_locations[i].rect.tr_corner(),chip_locations[i].angle);
+                rot_rect += rotate_point<double>(cent,chip_locations[i].rect.bl_corner(),chip_locations[i].angle);
+                rot_rect += rotate_point<double>(cent,chip_locations[i].rect.br_corner(),chip_locations[i].angle);
+                bounding_box += grow_rect(rot_rect, grow).intersect(get_rect(img));
+                max_depth = std::max(depth,max_depth);
+            }
+            //std::cout << "max_depth: " << max_depth << std::endl;
+            //std::cout << "crop amount: " << bounding_box.area()/(double)get_rect(img).area() << std::endl;
+
+            // now make an image pyramid
+            levels.resize(max_depth);
+            if (levels.size() != 0)
+                pyr(sub_image(img,bounding_box),levels[0]);
+            for (unsigned long i = 1; i < levels.size(); ++i)
+                pyr(levels[i-1],levels[i]);
+
+            std::vector<dlib::vector<double,2> > from, to;
+
+            // now work out how to get each chip
+            chip_levels.resize(chip_locations.size());
+            transforms.resize(chip_locations.size());
+            for (unsigned long i = 0; i < chip_locations.size(); ++i)
+            {
+                // If the chip doesn't have any rotation or scaling then use the basic version
+                // of chip extraction that just does a fast copy.
+                if (chip_locations[i].angle == 0 && 
+                    chip_locations[i].rows == chip_locations[i].rect.height() &&
+                    chip_locations[i].cols == chip_locations[i].rect.width())
+                {
+                    chip_levels[i] = -2;
+                }
+                else
+                {
+                    // figure out which level in the pyramid to use to extract the chip
+                    int level = -1;
+                    drectangle rect = translate_rect(chip_locations[i].rect, -bounding_box.tl_corner());
+                    while (pyr.rect_down(rect).area() > chip_locations[i].size())
+                    {
+                        ++level;
+                        rect = pyr.rect_down(rect);
+                    }
+                    chip_levels[i] = level;
+
+                    // find the appropriate transformation that maps from the chip to the input
+                    // image
+                    const rectangle chip_rect(chip_locations[i].cols, chip_locations[i].rows);
+                    from.clear();
+                    to.clear();
+                    from.push_back(chip_rect.tl_corner());  to.push_back(rotate_point<double>(center(rect),rect.tl_corner(),chip_locations[i].angle));
+                    from.push_back(chip_rect.tr_corner());  to.push_back(rotate_point<double>(center(rect),rect.tr_corner(),chip_locations[i].angle));
+                    from.push_back(chip_rect.bl_corner());  to.push_back(rotate_point<double>(center(rect),rect.bl_corner(),chip_locations[i].angle));
+                    transforms[i] = find_affine_transform(from,to);
+                }
+            }
+        }
     }
 
 // ----------------------------------------------------------------------------------------
@@ -1880,88 +2100,27 @@ namespace dlib
         }
 #endif 
 
-        pyramid_down<2> pyr;
-        long max_depth = 0;
-        // If the chip is supposed to be much smaller than the source subwindow then you
-        // can't just extract it using bilinear interpolation since at a high enough
-        // downsampling amount it would effectively turn into nearest neighbor
-        // interpolation.  So we use an image pyramid to make sure the interpolation is
-        // fast but also high quality.  The first thing we do is figure out how deep the
-        // image pyramid needs to be.
         rectangle bounding_box;
-        for (unsigned long i = 0; i < chip_locations.size(); ++i)
-        {
-            long depth = 0;
-            double grow = 2;
-            drectangle rect = pyr.rect_down(chip_locations[i].rect);
-            while (rect.area() > chip_locations[i].size())
-            {
-                rect = pyr.rect_down(rect);
-                ++depth;
-                // We drop the image size by a factor of 2 each iteration and then assume a
-                // border of 2 pixels is needed to avoid any border effects of the crop.
-                grow = grow*2 + 2;
-            }
-            drectangle rot_rect;
-            const vector<double,2> cent = center(chip_locations[i].rect);
-            rot_rect += rotate_point<double>(cent,chip_locations[i].rect.tl_corner(),chip_locations[i].angle);
-            rot_rect += rotate_point<double>(cent,chip_locations[i].rect.tr_corner(),chip_locations[i].angle);
-            rot_rect += rotate_point<double>(cent,chip_locations[i].rect.bl_corner(),chip_locations[i].angle);
-            rot_rect += rotate_point<double>(cent,chip_locations[i].rect.br_corner(),chip_locations[i].angle);
-            bounding_box += grow_rect(rot_rect, grow).intersect(get_rect(img));
-            max_depth = std::max(depth,max_depth);
-        }
-        //std::cout << "max_depth: " << max_depth << std::endl;
-        //std::cout << "crop amount: " << bounding_box.area()/(double)get_rect(img).area() << std::endl;
-
-        // now make an image pyramid
-        dlib::array<array2d<typename image_traits<image_type1>::pixel_type> > levels(max_depth);
-        if (levels.size() != 0)
-            pyr(sub_image(img,bounding_box),levels[0]);
-        for (unsigned long i = 1; i < levels.size(); ++i)
-            pyr(levels[i-1],levels[i]);
-
-        std::vector<dlib::vector<double,2> > from, to;
+        dlib::array<array2d<typename image_traits<image_type1>::pixel_type> > levels;
+        std::vector<long> chip_levels;
+        std::vector<point_transform_affine> transforms;
+        impl::plan_image_chips(img, chip_locations, bounding_box, levels, chip_levels, transforms);
 
         // now pull out the chips
         chips.resize(chip_locations.size());
         for (unsigned long i = 0; i < chips.size(); ++i)
         {
-            // If the chip doesn't have any rotation or scaling then use the basic version
-            // of chip extraction that just does a fast copy.
-            if (chip_locations[i].angle == 0 && 
-                chip_locations[i].rows == chip_locations[i].rect.height() &&
-                chip_locations[i].cols == chip_locations[i].rect.width())
+            if (chip_levels[i] == -2)
             {
                 impl::basic_extract_image_chip(img, chip_locations[i].rect, chips[i]);
             }
             else
             {
                 set_image_size(chips[i], chip_locations[i].rows, chip_locations[i].cols);
-
-                // figure out which level in the pyramid to use to extract the chip
-                int level = -1;
-                drectangle rect = translate_rect(chip_locations[i].rect, -bounding_box.tl_corner());
-                while (pyr.rect_down(rect).area() > chip_locations[i].size())
-                {
-                    ++level;
-                    rect = pyr.rect_down(rect);
-                }
-
-                // find the appropriate transformation that maps from the chip to the input
-                // image
-                from.clear();
-                to.clear();
-                from.push_back(get_rect(chips[i]).tl_corner());  to.push_back(rotate_point<double>(center(rect),rect.tl_corner(),chip_locations[i].angle));
-                from.push_back(get_rect(chips[i]).tr_corner());  to.push_back(rotate_point<double>(center(rect),rect.tr_corner(),chip_locations[i].angle));
-                from.push_back(get_rect(chips[i]).bl_corner());  to.push_back(rotate_point<double>(center(rect),rect.bl_corner(),chip_locations[i].angle));
-                point_transform_affine trns = find_affine_transform(from,to);
-
-                // now extract the actual chip
-                if (level == -1)
-                    transform_image(sub_image(img,bounding_box),chips[i],interp,trns);
+                if (chip_levels[i] == -1)
+                    transform_image(sub_image(img,bounding_box),chips[i],interp,transforms[i]);
                 else
-                    transform_image(levels[level],chips[i],interp,trns);
+                    transform_image(levels[chip_levels[i]],chips[i],interp,transforms[i]);
             }
         }
     }
@@ -2027,6 +2186,310 @@ namespace dlib
         extract_image_chip(img, location, chip, interpolate_bilinear());
     }
 
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        template <typename pixel_type>
+        struct is_chip_sampling_pixel
+        {
+            const static bool value = is_same_type<pixel_type,unsigned char>::value ||
+                                      is_same_type<pixel_type,rgb_pixel>::value;
+        };
+
+        template <long K>
+        void sample_bilinear_chip_row (
+            const unsigned char* data,
+            const long nr,
+            const long nc,
+            const long step,
+            const double x0,
+            const double y0,
+            const double dx,
+            const double dy,
+            const long cols,
+            unsigned char* out
+        )
+        /*!
+            requires
+                - data points to an nr by nc image of pixels with K unsigned char channels
+                  each, with rows step bytes apart.
+            ensures
+                - for all c in [0, cols) and k in [0, K):
+                    - out[c*K+k] == channel k of the image bilinearly interpolated at
+                      (x0 + c*dx, y0 + c*dy), rounded down, or 0 if that point isn't
+                      surrounded by 4 pixels of the image.  This is what
+                      interpolate_bilinear does, except that the arithmetic is done in
+                      float, so the result can be 1 less and points right at the edge of
+                      the image can go either way.
+        !*/
+        {
+            const simd8f lane(0,1,2,3,4,5,6,7);
+            const simd8f _x0 = (float)x0, _y0 = (float)y0, _dx = (float)dx, _dy = (float)dy;
+            int32 ix[8], iy[8];
+            float wx[8], wy[8];
+            float tl[K][8], tr[K][8], bl[K][8], br[K][8];
+            int32 result[8];
+            for (long c = 0; c < cols; c += 8)
+            {
+                const simd8f cc = simd8f((float)c) + lane;
+                const simd8f sx = _x0 + cc*_dx;
+                const simd8f sy = _y0 + cc*_dy;
+                const simd8f left = floor(sx);
+                const simd8f top = floor(sy);
+                simd8i(left).store(ix);
+                simd8i(top).store(iy);
+                (sx-left).store(wx);
+                (sy-top).store(wy);
+
+                // Gather the 4 pixels around each point.  A point without all 4 of them
+                // gets 0, like the pixels outside the image in transform_image().
+                const long n = std::min<long>(8, cols-c);
+                for (long j = 0; j < 8; ++j)
+                {
+                    if (j < n && ix[j] >= 0 && iy[j] >= 0 && ix[j] < nc-1 && iy[j] < nr-1)
+                    {
+                        const unsigned char* p = data + iy[j]*step + ix[j]*K;
+                        for (long k = 0; k < K; ++k)
+                        {
+                            tl[k][j] = p[k];
+                            tr[k][j] = p[K+k];
+                            bl[k][j] = p[step+k];
+                            br[k][j] = p[step+K+k];
+                        }
+                    }
+                    else
+                    {
+                        for (long k = 0; k < K; ++k)
+                            tl[k][j] = tr[k][j] = bl[k][j] = br[k][j] = 0;
+                    }
+                }
+
+                simd8f _wx, _wy;
+                _wx.load(wx);
+                _wy.load(wy);
+                for (long k = 0; k < K; ++k)
+                {
+                    simd8f a, b, d, e;
+                    a.load(tl[k]);
+                    b.load(tr[k]);
+                    d.load(bl[k]);
+                    e.load(br[k]);
+                    const simd8f t = a + _wx*(b-a);
+                    const simd8f u = d + _wx*(e-d);
+                    simd8i(t + _wy*(u-t)).store(result);
+                    for (long j = 0; j < n; ++j)
+                        out[(c+j)*K+k] = static_cast<unsigned char>(result[j]);
+                }
+            }
+        }
+
+        template <
+            typename image_type,
+            typename row_writer_type
+            >
+        void sample_bilinear_chip (
+            const image_type& img,
+            const point_transform_affine& trns,
+            const long rows,
+            const long cols,
+            row_writer_type&& write_row
+        )
+        /*!
+            requires
+                - image_type contains unsigned char or rgb_pixel pixels.
+            ensures
+                - Samples the chip of the given size whose pixel p is at trns(p) in img,
+                  the way transform_image() with interpolate_bilinear does, and calls
+                  write_row(r, data) for each row r of it.  data holds the cols pixels of
+                  the row as unsigned char channel values.
+        !*/
+        {
+            typedef typename image_traits<image_type>::pixel_type pixel_type;
+            const long K = pixel_traits<pixel_type>::num;
+            const unsigned char* data = static_cast<const unsigned char*>(image_data(img));
+            const matrix<double,2,2>& m = trns.get_m();
+            const dlib::vector<double,2>& b = trns.get_b();
+
+            std::vector<unsigned char> row(cols*K);
+            for (long r = 0; r < rows; ++r)
+            {
+                // Position of the first pixel of the row, the others are dx, dy apart.
+                const double x0 = m(0,1)*r + b.x();
+                const double y0 = m(1,1)*r + b.y();
+                sample_bilinear_chip_row<K>(data, num_rows(img), num_columns(img), width_step(img),
+                    x0, y0, m(0,0), m(1,0), cols, row.data());
+                write_row(r, row.data());
+            }
+        }
+
+        template <
+            typename image_type1,
+            typename image_type2
+            >
+        typename enable_if<is_chip_sampling_pixel<typename image_traits<image_type1>::pixel_type> >::type
+        sample_image_chip (
+            const image_type1& img,
+            const point_transform_affine& trns,
+            image_type2& chip
+        )
+        {
+            typedef typename image_traits<image_type1>::pixel_type pixel_type;
+            image_view<image_type2> vchip(chip);
+            sample_bilinear_chip(img, trns, vchip.nr(), vchip.nc(),
+                [&](long r, const unsigned char* data)
+                {
+                    const pixel_type* p = reinterpret_cast<const pixel_type*>(data);
+                    for (long c = 0; c < vchip.nc(); ++c)
+                        assign_pixel(vchip[r][c], p[c]);
+                });
+        }
+
+        template <
+            typename image_type1,
+            typename image_type2
+            >
+        typename disable_if<is_chip_sampling_pixel<typename image_traits<image_type1>::pixel_type> >::type
+        sample_image_chip (
+            const image_type1& img,
+            const point_transform_affine& trns,
+            image_type2& chip
+        )
+        {
+            transform_image(img, chip, interpolate_bilinear(), trns);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type1,
+        typename image_type2
+        >
+    void extract_image_chips (
+        const image_type1& img,
+        const std::vector<chip_details>& chip_locations,
+        dlib::array<image_type2>& chips,
+        thread_pool& tp
+    )
+    {
+        for (unsigned long i = 0; i < chip_locations.size(); ++i)
+        {
+            DLIB_ASSERT(chip_locations[i].size() != 0 &&
+                        chip_locations[i].rect.is_empty() == false,
+                "\t void extract_image_chips()"
+                << "\n\t Invalid inputs were given to this function."
+                << "\n\t chip_locations["<<i<<"].size():            " << chip_locations[i].size()
+                << "\n\t chip_locations["<<i<<"].rect.is_empty(): " << chip_locations[i].rect.is_empty()
+            );
+        }
+
+        rectangle bounding_box;
+        dlib::array<array2d<typename image_traits<image_type1>::pixel_type> > levels;
+        std::vector<long> chip_levels;
+        std::vector<point_transform_affine> transforms;
+        impl::plan_image_chips(img, chip_locations, bounding_box, levels, chip_levels, transforms);
+
+        chips.resize(chip_locations.size());
+        const auto cropped = sub_image(img, bounding_box);
+        parallel_for(tp, 0, chips.size(), [&](long i)
+        {
+            if (chip_levels[i] == -2)
+            {
+                impl::basic_extract_image_chip(img, chip_locations[i].rect, chips[i]);
+            }
+            else
+            {
+                set_image_size(chips[i], chip_locations[i].rows, chip_locations[i].cols);
+                if (chip_levels[i] == -1)
+                    impl::sample_image_chip(cropped, transforms[i], chips[i]);
+                else
+                    impl::sample_image_chip(levels[chip_levels[i]], transforms[i], chips[i]);
+            }
+        });
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void extract_image_chip_planes (
+        const image_type& img,
+        const std::vector<chip_details>& chip_locations,
+        float* planes,
+        thread_pool& tp,
+        const std::vector<float>& channel_offsets = std::vector<float>(),
+        const float scale = 1
+    )
+    {
+        typedef typename image_traits<image_type>::pixel_type pixel_type;
+        COMPILE_TIME_ASSERT(impl::is_chip_sampling_pixel<pixel_type>::value);
+        const long K = pixel_traits<pixel_type>::num;
+        DLIB_CASSERT(channel_offsets.size() == 0 || channel_offsets.size() == (unsigned long)K,
+            "\t void extract_image_chip_planes()"
+            << "\n\t channel_offsets must have one value for each channel of the image."
+            << "\n\t channel_offsets.size(): " << channel_offsets.size()
+        );
+        for (unsigned long i = 0; i < chip_locations.size(); ++i)
+        {
+            DLIB_CASSERT(chip_locations[i].size() != 0 &&
+                         chip_locations[i].rect.is_empty() == false &&
+                         chip_locations[i].rows == chip_locations[0].rows &&
+                         chip_locations[i].cols == chip_locations[0].cols,
+                "\t void extract_image_chip_planes()"
+                << "\n\t All the chips must have the same nonzero size."
+                << "\n\t chip_locations["<<i<<"].rows: " << chip_locations[i].rows
+                << "\n\t chip_locations["<<i<<"].cols: " << chip_locations[i].cols
+            );
+        }
+        if (chip_locations.size() == 0)
+            return;
+
+        rectangle bounding_box;
+        dlib::array<array2d<pixel_type> > levels;
+        std::vector<long> chip_levels;
+        std::vector<point_transform_affine> transforms;
+        impl::plan_image_chips(img, chip_locations, bounding_box, levels, chip_levels, transforms);
+
+        const long rows = chip_locations[0].rows;
+        const long cols = chip_locations[0].cols;
+        float offsets[3] = {0, 0, 0};
+        for (unsigned long k = 0; k < channel_offsets.size(); ++k)
+            offsets[k] = channel_offsets[k];
+
+        const auto cropped = sub_image(img, bounding_box);
+        parallel_for(tp, 0, chip_locations.size(), [&](long i)
+        {
+            float* const chip_planes = planes + i*K*rows*cols;
+            auto write_row = [&](long r, const unsigned char* data)
+            {
+                for (long k = 0; k < K; ++k)
+                {
+                    float* dest = chip_planes + (k*rows + r)*cols;
+                    for (long c = 0; c < cols; ++c)
+                        dest[c] = (data[c*K+k] - offsets[k])*scale;
+                }
+            };
+
+            if (chip_levels[i] == -2)
+            {
+                array2d<pixel_type> chip;
+                impl::basic_extract_image_chip(img, chip_locations[i].rect, chip);
+                for (long r = 0; r < rows; ++r)
+                    write_row(r, reinterpret_cast<const unsigned char*>(&chip[r][0]));
+            }
+            else if (chip_levels[i] == -1)
+            {
+                impl::sample_bilinear_chip(cropped, transforms[i], rows, cols, write_row);
+            }
+            else
+            {
+                impl::sample_bilinear_chip(levels[chip_levels[i]], transforms[i], rows, cols, write_row);
+            }
+        });
+    }
+
 // ----------------------------------------------------------------------------------------
 
     inline chip_details get_face_chip_details (
@@ -413,6 +413,9 @@ namespace dlib
                 - #out_img.nr() == out_img.nr()
                 - #out_img.nc() == out_img.nc()
             - Uses the bilinear interpolation to perform the necessary pixel interpolation.
+            - If both images contain unsigned char pixels then the interpolation is done
+              with fixed point SIMD arithmetic.  The output pixels may differ by 1 from
+              the exact bilinear interpolation, rounded down.
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -1254,6 +1257,84 @@ namespace dlib
               above-defined extract_image_chip() function using bilinear interpolation.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type1,
+        typename image_type2
+        >
+    void extract_image_chips (
+        const image_type1& img,
+        const std::vector<chip_details>& chip_locations,
+        dlib::array<image_type2>& chips,
+        thread_pool& tp
+    );
+    /*!
+        requires
+            - image_type1 == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - image_type2 == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - pixel_traits<typename image_traits<image_type1>::pixel_type>::has_alpha == false
+            - for all valid i: 
+                - chip_locations[i].rect.is_empty() == false
+                - chip_locations[i].size() != 0
+        ensures
+            - This function is a faster version of extract_image_chips(img, chip_locations,
+              chips) for extracting many chips, like all the faces found in an image.  The
+              chips are extracted in parallel by the threads in tp.
+            - If img contains unsigned char or rgb_pixel pixels then the chips are sampled
+              with SIMD instructions.  This computes the bilinear interpolation in float
+              rather than double, so a pixel of #chips can be 1 less than the pixel made
+              by extract_image_chips(img, chip_locations, chips), and pixels within a tiny
+              fraction of a pixel of the edge of img can come out as 0 in one and not the
+              other.  Images of other pixel types give exactly the same chips.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename image_type
+        >
+    void extract_image_chip_planes (
+        const image_type& img,
+        const std::vector<chip_details>& chip_locations,
+        float* planes,
+        thread_pool& tp,
+        const std::vector<float>& channel_offsets = std::vector<float>(),
+        const float scale = 1
+    );
+    /*!
+        requires
+            - image_type == an image object that implements the interface defined in
+              dlib/image_processing/generic_image.h 
+            - image_type contains unsigned char or rgb_pixel pixels.  Let K be the number
+              of channels of these pixels, i.e. 1 or 3.
+            - for all valid i: 
+                - chip_locations[i].rect.is_empty() == false
+                - chip_locations[i].size() != 0
+                - chip_locations[i].rows == chip_locations[0].rows
+                - chip_locations[i].cols == chip_locations[0].cols
+            - planes points to chip_locations.size()*K*chip_locations[0].size() floats.
+            - channel_offsets.size() == 0 or K
+        ensures
+            - Extracts the same chips as extract_image_chips(img, chip_locations, chips,
+              tp) and writes them to planes in the layout of a dlib::tensor, one K channel
+              sample per chip.  That is, if NR and NC are the size of the chips, then for
+              all valid i, k, r and c:
+                - planes[((i*K + k)*NR + r)*NC + c] == (channel k of chips[i][r][c] -
+                  channel_offsets[k])*scale
+              where channel_offsets[k] is taken to be 0 if channel_offsets is empty, and
+              the channels of an rgb_pixel are red, green and blue in that order.
+            - The chips never exist as images, so this is faster than extracting them and
+              then converting them.  For example, with channel_offsets == {122.782,
+              117.001, 104.298} and scale == 1/256 the planes are what
+              input_rgb_image_sized::to_tensor() makes from the chips, so a dnn input
+              tensor can be filled directly with:
+                x.set_size(chip_locations.size(), 3, NR, NC);
+                extract_image_chip_planes(img, chip_locations, x.host(), tp, {122.782, 117.001, 104.298}, 1/256.0f);
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -7,6 +7,7 @@
 #include "lsh/projection_hash.h"
 #include "lsh/create_random_projection_hash.h"
 #include "lsh/hashes.h"
+#include "lsh/lsh_index.h"
 
 
 #endif // DLIB_LSh_
@@ -0,0 +1,678 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_LSH_INDEx_Hh_
+#define DLIB_LSH_INDEx_Hh_
+
+#include "lsh_index_abstract.h"
+#include "create_random_projection_hash.h"
+#include "../matrix.h"
+#include "../rand.h"
+#include "../simd.h"
+#include "../serialize.h"
+#include "../uintn.h"
+#include "../threads/parallel_for_extension.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class lsh_index
+    {
+    public:
+
+        lsh_index (
+        ) {}
+
+        template <typename vector_type>
+        void build (
+            const vector_type& samples,
+            unsigned long num_tables = 8,
+            unsigned long num_bits = 0
+        )
+        {
+            DLIB_CASSERT(samples.size() > 1 && num_tables > 0 && num_bits <= 24);
+            for (unsigned long i = 0; i < samples.size(); ++i)
+            {
+                DLIB_CASSERT(is_col_vector(samples[i]) && samples[i].size() > 0 &&
+                    samples[i].size() == samples[0].size(),
+                    "All the samples given to lsh_index::build() must be column vectors of the same size.");
+            }
+
+            if (num_bits == 0)
+            {
+                // Aim for around 16 samples in each bucket.
+                num_bits = 1;
+                while (num_bits < 20 && (16UL<<num_bits) < samples.size())
+                    ++num_bits;
+            }
+
+            *this = lsh_index();
+            dims = samples[0].size();
+            tables = num_tables;
+            bits = num_bits;
+
+            // Each table is a projection_hash made by create_random_projection_hash() from
+            // up to max_training_samples of the samples, evenly spaced.
+            const unsigned long max_training_samples = 10000;
+            const unsigned long step = (samples.size()+max_training_samples-1)/max_training_samples;
+            std::vector<matrix<double,0,1>> training;
+            for (unsigned long i = 0; i < samples.size(); i += step)
+                training.push_back(matrix_cast<double>(samples[i]));
+            if (training.size() < 2)
+                training.push_back(matrix_cast<double>(samples[samples.size()-1]));
+
+            dlib::rand rnd;
+            proj.resize(tables*bits*dims);
+            offsets.resize(tables*bits);
+            for (unsigned long t = 0; t < tables; ++t)
+            {
+                const projection_hash h = create_random_projection_hash(training, bits, rnd);
+                for (unsigned long i = 0; i < bits; ++i)
+                {
+                    for (unsigned long j = 0; j < dims; ++j)
+                        proj[(t*bits+i)*dims+j] = h.get_projection_matrix()(i,j);
+                    offsets[t*bits+i] = h.get_offset_matrix()(i);
+                }
+            }
+
+            data.resize(samples.size()*dims);
+            for (unsigned long i = 0; i < samples.size(); ++i)
+            {
+                for (unsigned long j = 0; j < dims; ++j)
+                    data[i*dims+j] = samples[i](j);
+            }
+            num_samples = samples.size();
+
+            pending_codes.resize(num_samples*tables);
+            parallel_for(0, num_samples, [&](long i)
+            {
+                hash(&data[i*dims], &pending_codes[i*tables]);
+            });
+            starts.assign(tables*(num_buckets()+1), 0);
+            merge_pending();
+            num_probes = 8*tables;
+        }
+
+        unsigned long size (
+        ) const { return num_samples; }
+
+        unsigned long dimensions (
+        ) const { return dims; }
+
+        unsigned long num_tables (
+        ) const { return tables; }
+
+        unsigned long num_bits (
+        ) const { return bits; }
+
+        unsigned long get_num_probes (
+        ) const { return num_probes; }
+
+        void set_num_probes (
+            unsigned long probes
+        )
+        {
+            DLIB_CASSERT(probes >= num_tables());
+            num_probes = probes;
+        }
+
+        bool is_attached (
+        ) const { return mapped_data != nullptr; }
+
+        template <typename EXP>
+        unsigned long add (
+            const matrix_exp<EXP>& sample
+        )
+        {
+            DLIB_CASSERT(size() > 0 && is_col_vector(sample) && sample.size() == (long)dimensions());
+            detach();
+
+            data.resize((num_samples+1)*dims);
+            for (unsigned long j = 0; j < dims; ++j)
+                data[num_samples*dims+j] = sample(j);
+            pending_codes.resize(pending_codes.size()+tables);
+            hash(&data[num_samples*dims], &pending_codes[pending_codes.size()-tables]);
+            ++num_samples;
+
+            // The samples added since the buckets were last built are checked one by one
+            // by each query, so the buckets are rebuilt once there are a fair number.
+            if (num_samples-num_bucketed > std::max<unsigned long>(256, num_bucketed/64))
+                merge_pending();
+            return num_samples-1;
+        }
+
+        matrix<float,0,1> get_sample (
+            unsigned long idx
+        ) const
+        {
+            DLIB_ASSERT(idx < size());
+            return mat(samples_ptr()+idx*dims, dims);
+        }
+
+        template <typename EXP>
+        void find_nearest (
+            const matrix_exp<EXP>& query,
+            unsigned long k,
+            std::vector<std::pair<double,unsigned long>>& results
+        ) const
+        {
+            DLIB_CASSERT(size() > 0 && is_col_vector(query) && query.size() == (long)dimensions());
+
+            std::vector<float> q(dims);
+            for (unsigned long j = 0; j < dims; ++j)
+                q[j] = query(j);
+
+            std::vector<unsigned long> candidates;
+            probe(q.data(), candidates);
+            for (unsigned long i = num_bucketed; i < num_samples; ++i)
+                candidates.push_back(i);
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+            results.clear();
+            results.reserve(candidates.size());
+            const float* const samples = samples_ptr();
+            for (auto i : candidates)
+                results.push_back(std::make_pair(squared_distance(q.data(), samples+i*dims), i));
+
+            k = std::min<unsigned long>(k, results.size());
+            std::partial_sort(results.begin(), results.begin()+k, results.end());
+            results.resize(k);
+            for (auto& r : results)
+                r.first = std::sqrt(r.first);
+        }
+
+        void attach (
+            const void* buffer,
+            size_t buffer_size
+        )
+        {
+            header h;
+            DLIB_CASSERT(buffer_size >= sizeof(h));
+            std::memcpy(&h, buffer, sizeof(h));
+            check_header(h, "lsh_index::attach()");
+            DLIB_CASSERT(valid_sizes(h), "The lsh_index given to lsh_index::attach() is corrupt.");
+            DLIB_CASSERT(buffer_size >= file_size(h),
+                "The buffer given to lsh_index::attach() is smaller than the index in it.");
+
+            const char* p = static_cast<const char*>(buffer) + sizeof(h);
+            const float* const new_proj = reinterpret_cast<const float*>(p);
+            p += (size_t)h.tables*h.bits*h.dims*sizeof(float);
+            const float* const new_offsets = reinterpret_cast<const float*>(p);
+            p += (size_t)h.tables*h.bits*sizeof(float);
+            const float* const new_data = reinterpret_cast<const float*>(p);
+            p += h.num_samples*h.dims*sizeof(float);
+            const uint32* const new_starts = reinterpret_cast<const uint32*>(p);
+            p += (size_t)h.tables*(((size_t)1<<h.bits)+1)*sizeof(uint32);
+            const uint32* const new_entries = reinterpret_cast<const uint32*>(p);
+            DLIB_CASSERT(valid_buckets(h, new_starts, new_entries),
+                "The lsh_index given to lsh_index::attach() is corrupt.");
+
+            *this = lsh_index();
+            set_sizes(h);
+            mapped_proj = new_proj;
+            mapped_offsets = new_offsets;
+            mapped_data = new_data;
+            mapped_starts = new_starts;
+            mapped_entries = new_entries;
+        }
+
+        friend void serialize (
+            const lsh_index& item,
+            std::ostream& out
+        )
+        {
+            header h;
+            item.fill_header(h);
+
+            std::vector<uint32> starts, entries;
+            item.merged_buckets(starts, entries);
+
+            out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+            out.write(reinterpret_cast<const char*>(item.proj_ptr()), item.proj_size()*sizeof(float));
+            out.write(reinterpret_cast<const char*>(item.offsets_ptr()), item.offsets_size()*sizeof(float));
+            out.write(reinterpret_cast<const char*>(item.samples_ptr()), item.num_samples*item.dims*sizeof(float));
+            out.write(reinterpret_cast<const char*>(starts.data()), starts.size()*sizeof(uint32));
+            out.write(reinterpret_cast<const char*>(entries.data()), entries.size()*sizeof(uint32));
+            if (!out)
+                throw serialization_error("Error serializing object of type lsh_index");
+        }
+
+        friend void deserialize (
+            lsh_index& item,
+            std::istream& in
+        )
+        {
+            header h;
+            in.read(reinterpret_cast<char*>(&h), sizeof(h));
+            if (!in)
+                throw serialization_error("Error deserializing object of type lsh_index");
+            if (std::memcmp(h.magic, "dlib_lsh", 8) != 0 || h.version != 1 || h.byte_order != 0x01020304)
+                throw serialization_error("Unexpected version found while deserializing dlib::lsh_index.");
+            if (!valid_sizes(h))
+                throw serialization_error("Corrupt header found while deserializing dlib::lsh_index.");
+
+            lsh_index temp;
+            temp.set_sizes(h);
+            temp.proj.resize(temp.proj_size());
+            temp.offsets.resize(temp.offsets_size());
+            temp.data.resize(temp.num_samples*temp.dims);
+            temp.starts.resize(temp.starts_size());
+            temp.entries.resize(temp.num_samples*temp.tables);
+            in.read(reinterpret_cast<char*>(temp.proj.data()), temp.proj.size()*sizeof(float));
+            in.read(reinterpret_cast<char*>(temp.offsets.data()), temp.offsets.size()*sizeof(float));
+            in.read(reinterpret_cast<char*>(temp.data.data()), temp.data.size()*sizeof(float));
+            in.read(reinterpret_cast<char*>(temp.starts.data()), temp.starts.size()*sizeof(uint32));
+            in.read(reinterpret_cast<char*>(temp.entries.data()), temp.entries.size()*sizeof(uint32));
+            if (!in)
+                throw serialization_error("Error deserializing object of type lsh_index");
+            if (!valid_buckets(h, temp.starts.data(), temp.entries.data()))
+                throw serialization_error("Corrupt buckets found while deserializing dlib::lsh_index.");
+            item = std::move(temp);
+        }
+
+    private:
+
+        struct header
+        {
+            char magic[8];
+            uint32 version;
+            uint32 byte_order;
+            uint64 num_samples;
+            uint32 dims;
+            uint32 tables;
+            uint32 bits;
+            uint32 num_probes;
+            char unused[24];
+        };
+
+        void fill_header (
+            header& h
+        ) const
+        {
+            std::memset(&h, 0, sizeof(h));
+            std::memcpy(h.magic, "dlib_lsh", 8);
+            h.version = 1;
+            h.byte_order = 0x01020304;
+            h.num_samples = num_samples;
+            h.dims = dims;
+            h.tables = tables;
+            h.bits = bits;
+            h.num_probes = num_probes;
+        }
+
+        static void check_header (
+            const header& h,
+            const char* where
+        )
+        {
+            DLIB_CASSERT(std::memcmp(h.magic, "dlib_lsh", 8) == 0 && h.version == 1,
+                where << " was not given an lsh_index.");
+            DLIB_CASSERT(h.byte_order == 0x01020304,
+                where << " was given an lsh_index saved on a machine with a different byte order.");
+        }
+
+        static bool valid_sizes (
+            const header& h
+        )
+        /*!
+            ensures
+                - returns true if the sizes in h are ones build() could have made, and
+                  small enough that file_size(h) doesn't overflow.
+        !*/
+        {
+            if (h.num_samples < 2 || h.num_samples > std::numeric_limits<uint32>::max() ||
+                h.dims == 0 || h.tables == 0 || h.bits == 0 || h.bits > 24 ||
+                h.num_probes < h.tables)
+                return false;
+            // Each of the three terms of file_size() is kept well below the largest
+            // size_t, so their sum can't overflow either.
+            const uint64 limit = std::numeric_limits<size_t>::max()/32;
+            const uint64 rows = (uint64)h.tables*h.bits;
+            return (uint64)h.dims+1 <= limit/rows &&
+                (uint64)h.dims+h.tables <= limit/h.num_samples &&
+                (uint64)h.tables*((1UL<<h.bits)+1) <= limit;
+        }
+
+        static bool valid_buckets (
+            const header& h,
+            const uint32* starts,
+            const uint32* entries
+        )
+        /*!
+            requires
+                - valid_sizes(h)
+                - starts and entries are the arrays of the index h is the header of.
+            ensures
+                - returns true if, in each table, the buckets split the entries in order
+                  and the entries are all sample indices.  So probe() won't read outside
+                  the arrays.
+        !*/
+        {
+            const size_t nb = (size_t)1<<h.bits;
+            for (size_t t = 0; t < h.tables; ++t)
+            {
+                const uint32* const s = starts + t*(nb+1);
+                if (s[0] != 0 || s[nb] != h.num_samples)
+                    return false;
+                for (size_t b = 0; b < nb; ++b)
+                {
+                    if (s[b] > s[b+1])
+                        return false;
+                }
+            }
+            const size_t num_entries = h.num_samples*h.tables;
+            for (size_t i = 0; i < num_entries; ++i)
+            {
+                if (entries[i] >= h.num_samples)
+                    return false;
+            }
+            return true;
+        }
+
+        static size_t file_size (
+            const header& h
+        )
+        {
+            const size_t nb = (size_t)1<<h.bits;
+            return sizeof(h) + sizeof(float)*((size_t)h.tables*h.bits*((size_t)h.dims+1) + h.num_samples*h.dims) +
+                sizeof(uint32)*(h.tables*(nb+1) + h.num_samples*h.tables);
+        }
+
+        void set_sizes (
+            const header& h
+        )
+        {
+            dims = h.dims;
+            tables = h.tables;
+            bits = h.bits;
+            num_probes = h.num_probes;
+            num_samples = h.num_samples;
+            num_bucketed = h.num_samples;
+        }
+
+        unsigned long num_buckets (
+        ) const { return 1UL<<bits; }
+
+        size_t proj_size () const { return tables*bits*dims; }
+        size_t offsets_size () const { return tables*bits; }
+        size_t starts_size () const { return tables*(num_buckets()+1); }
+
+        const float* proj_ptr () const { return mapped_data ? mapped_proj : proj.data(); }
+        const float* offsets_ptr () const { return mapped_data ? mapped_offsets : offsets.data(); }
+        const float* samples_ptr () const { return mapped_data ? mapped_data : data.data(); }
+        const uint32* starts_ptr () const { return mapped_data ? mapped_starts : starts.data(); }
+        const uint32* entries_ptr () const { return mapped_data ? mapped_entries : entries.data(); }
+
+        void detach (
+        )
+        /*!
+            ensures
+                - copies an attached index into memory this object owns, so it can be
+                  changed.
+        !*/
+        {
+            if (!mapped_data)
+                return;
+            proj.assign(mapped_proj, mapped_proj+proj_size());
+            offsets.assign(mapped_offsets, mapped_offsets+offsets_size());
+            data.assign(mapped_data, mapped_data+num_samples*dims);
+            starts.assign(mapped_starts, mapped_starts+starts_size());
+            entries.assign(mapped_entries, mapped_entries+num_bucketed*tables);
+            mapped_proj = mapped_offsets = mapped_data = nullptr;
+            mapped_starts = mapped_entries = nullptr;
+        }
+
+        static float dot_product (
+            const float* a,
+            const float* b,
+            unsigned long n
+        )
+        {
+            simd8f acc(0.0f);
+            unsigned long j = 0;
+            for (; j+8 <= n; j += 8)
+            {
+                simd8f x, y;
+                x.load(a+j);
+                y.load(b+j);
+                acc += x*y;
+            }
+            float s = sum(acc);
+            for (; j < n; ++j)
+                s += a[j]*b[j];
+            return s;
+        }
+
+        float squared_distance (
+            const float* a,
+            const float* b
+        ) const
+        {
+            simd8f acc(0.0f);
+            unsigned long j = 0;
+            for (; j+8 <= dims; j += 8)
+            {
+                simd8f x, y;
+                x.load(a+j);
+                y.load(b+j);
+                const simd8f d = x-y;
+                acc += d*d;
+            }
+            float s = sum(acc);
+            for (; j < dims; ++j)
+                s += (a[j]-b[j])*(a[j]-b[j]);
+            return s;
+        }
+
+        void project (
+            const float* sample,
+            float* margins
+        ) const
+        /*!
+            ensures
+                - #margins[t*num_bits()+i] == the value whose sign is bit i of the hash of
+                  sample in table t.
+        !*/
+        {
+            const float* const p = proj_ptr();
+            const float* const o = offsets_ptr();
+            for (unsigned long r = 0; r < tables*bits; ++r)
+                margins[r] = dot_product(p+r*dims, sample, dims) + o[r];
+        }
+
+        uint32 code (
+            const float* margins
+        ) const
+        {
+            // The same bit order as projection_hash, the first row is the high bit.
+            uint32 h = 0;
+            for (unsigned long i = 0; i < bits; ++i)
+                h = (h<<1) | (margins[i] > 0 ? 1 : 0);
+            return h;
+        }
+
+        void hash (
+            const float* sample,
+            uint32* codes
+        ) const
+        {
+            std::vector<float> margins(tables*bits);
+            project(sample, margins.data());
+            for (unsigned long t = 0; t < tables; ++t)
+                codes[t] = code(&margins[t*bits]);
+        }
+
+        void merged_buckets (
+            std::vector<uint32>& new_starts,
+            std::vector<uint32>& new_entries
+        ) const
+        /*!
+            ensures
+                - makes the buckets for all the samples out of the current buckets and
+                  pending_codes.  Bucket b of table t holds the samples
+                  #new_entries[t*size() + #new_starts[t*(num_buckets()+1)+b]] through the
+                  one before #new_starts[t*(num_buckets()+1)+b+1], in order.
+        !*/
+        {
+            const unsigned long nb = num_buckets();
+            const uint32* const old_starts = starts_ptr();
+            const uint32* const old_entries = entries_ptr();
+            const unsigned long num_pending = num_samples-num_bucketed;
+            new_starts.assign(tables*(nb+1), 0);
+            new_entries.resize(num_samples*tables);
+            for (unsigned long t = 0; t < tables; ++t)
+            {
+                const uint32* os = old_starts + t*(nb+1);
+                const uint32* oe = old_entries + t*num_bucketed;
+                uint32* ns = &new_starts[t*(nb+1)];
+                uint32* ne = &new_entries[t*num_samples];
+
+                for (unsigned long i = 0; i < num_pending; ++i)
+                    ++ns[pending_codes[i*tables+t]+1];
+                for (unsigned long b = 0; b < nb; ++b)
+                    ns[b+1] += ns[b] + os[b+1]-os[b];
+
+                std::vector<uint32> fill(ns, ns+nb);
+                for (unsigned long b = 0; b < nb; ++b)
+                {
+                    std::copy(oe+os[b], oe+os[b+1], ne+fill[b]);
+                    fill[b] += os[b+1]-os[b];
+                }
+                for (unsigned long i = 0; i < num_pending; ++i)
+                    ne[fill[pending_codes[i*tables+t]]++] = num_bucketed+i;
+            }
+        }
+
+        void merge_pending (
+        )
+        {
+            std::vector<uint32> new_starts, new_entries;
+            merged_buckets(new_starts, new_entries);
+            starts.swap(new_starts);
+            entries.swap(new_entries);
+            pending_codes.clear();
+            num_bucketed = num_samples;
+        }
+
+        void probe (
+            const float* q,
+            std::vector<unsigned long>& candidates
+        ) const
+        /*!
+            ensures
+                - Adds to candidates the samples in the get_num_probes() buckets most likely
+                  to hold the neighbors of q.  These are the buckets of q in each table,
+                  followed by the buckets whose hashes differ from those of q in the bits
+                  where q is closest to the hyperplanes, in order of the sum of the squared
+                  distances to the hyperplanes that have to be crossed to get there.  This
+                  is the query directed multi-probe LSH of Lv et al.
+                  "Multi-Probe LSH: Efficient Indexing for High-Dimensional Similarity
+                  Search".
+        !*/
+        {
+            std::vector<float> margins(tables*bits);
+            project(q, margins.data());
+
+            // For each table, the bits sorted by how close q is to their hyperplane.
+            std::vector<unsigned long> order(tables*bits);
+            std::vector<float> score(tables*bits);
+            std::vector<uint32> home(tables);
+            for (unsigned long t = 0; t < tables; ++t)
+            {
+                const float* m = &margins[t*bits];
+                home[t] = code(m);
+                unsigned long* o = &order[t*bits];
+                for (unsigned long i = 0; i < bits; ++i)
+                    o[i] = i;
+                std::sort(o, o+bits, [m](unsigned long a, unsigned long b) { return std::abs(m[a]) < std::abs(m[b]); });
+                for (unsigned long i = 0; i < bits; ++i)
+                    score[t*bits+i] = m[o[i]]*m[o[i]];
+            }
+
+            const unsigned long nb = num_buckets();
+            const uint32* const bucket_starts = starts_ptr();
+            const uint32* const bucket_entries = entries_ptr();
+            auto add_bucket = [&](unsigned long t, uint32 b)
+            {
+                const uint32* s = bucket_starts + t*(nb+1);
+                const uint32* e = bucket_entries + t*num_bucketed;
+                candidates.insert(candidates.end(), e+s[b], e+s[b+1]);
+            };
+
+            // A set of bits to flip is a mask over the sorted bits of a table.  Each set
+            // is made from a smaller one by moving its last bit one place along or by
+            // adding the bit after it, so every set is reached exactly once.
+            struct perturbation
+            {
+                float score;
+                unsigned long table;
+                uint32 mask;
+                unsigned long last;
+                bool operator< (const perturbation& item) const { return score > item.score; }
+            };
+            std::priority_queue<perturbation> heap;
+            for (unsigned long t = 0; t < tables; ++t)
+            {
+                add_bucket(t, home[t]);
+                heap.push(perturbation{score[t*bits], t, 1, 0});
+            }
+
+            for (unsigned long n = tables; n < num_probes && !heap.empty(); ++n)
+            {
+                const perturbation p = heap.top();
+                heap.pop();
+
+                uint32 b = home[p.table];
+                for (unsigned long i = 0; i <= p.last; ++i)
+                {
+                    if (p.mask & (1u<<i))
+                        b ^= 1u<<(bits-1-order[p.table*bits+i]);
+                }
+                add_bucket(p.table, b);
+
+                if (p.last+1 < bits)
+                {
+                    const float* s = &score[p.table*bits];
+                    const uint32 moved = (p.mask & ~(1u<<p.last)) | (1u<<(p.last+1));
+                    heap.push(perturbation{p.score - s[p.last] + s[p.last+1], p.table, moved, p.last+1});
+                    heap.push(perturbation{p.score + s[p.last+1], p.table, p.mask | (1u<<(p.last+1)), p.last+1});
+                }
+            }
+        }
+
+        unsigned long dims = 0;
+        unsigned long tables = 0;
+        unsigned long bits = 0;
+        unsigned long num_probes = 0;
+        unsigned long num_samples = 0;
+        // The samples before this one are in the buckets, the rest are in pending_codes.
+        unsigned long num_bucketed = 0;
+
+        std::vector<float> proj;
+        std::vector<float> offsets;
+        std::vector<float> data;
+        std::vector<uint32> starts;
+        std::vector<uint32> entries;
+        std::vector<uint32> pending_codes;
+
+        // When attach() is used these point into the caller's buffer instead.
+        const float* mapped_proj = nullptr;
+        const float* mapped_offsets = nullptr;
+        const float* mapped_data = nullptr;
+        const uint32* mapped_starts = nullptr;
+        const uint32* mapped_entries = nullptr;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_LSH_INDEx_Hh_
+
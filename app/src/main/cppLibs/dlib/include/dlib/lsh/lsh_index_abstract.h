@@ -0,0 +1,237 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#undef DLIB_LSH_INDEx_ABSTRACT_Hh_
+#ifdef DLIB_LSH_INDEx_ABSTRACT_Hh_
+
+#include "create_random_projection_hash_abstract.h"
+#include "../matrix.h"
+#include "../serialize.h"
+#include <vector>
+
+namespace dlib
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class lsh_index
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object finds the approximate nearest neighbors, by Euclidean distance,
+                of a query among a large set of vectors such as the 128D face descriptors
+                made by dnn_face_recognition_ex.cpp.
+
+                It keeps num_tables() hash tables.  The hash of each table is a
+                projection_hash of num_bits() bits made by create_random_projection_hash()
+                from the samples.  A query looks at get_num_probes() buckets in all: its
+                own bucket in each table and then the buckets that differ from those in
+                the bits where the query is closest to the hyperplanes of the hash (the
+                query directed multi-probe LSH of Lv et al. "Multi-Probe LSH: Efficient
+                Indexing for High-Dimensional Similarity Search").  The samples in those
+                buckets are compared to the query and the closest are returned.  More
+                probes find more of the true neighbors but take longer.
+
+                The buckets and samples are kept in flat arrays, which serialize() writes
+                out as they are.  So an index saved to a file can be memory mapped and
+                used with attach() without reading it in.
+
+            THREAD SAFETY
+                The const members of this object can be called concurrently from multiple
+                threads, however, any operation that modifies the state of an instance of
+                this object must serialize access to that instance.
+        !*/
+
+    public:
+
+        lsh_index (
+        );
+        /*!
+            ensures
+                - #size() == 0
+                - #dimensions() == 0
+                - #is_attached() == false
+        !*/
+
+        template <typename vector_type>
+        void build (
+            const vector_type& samples,
+            unsigned long num_tables = 8,
+            unsigned long num_bits = 0
+        );
+        /*!
+            requires
+                - vector_type is a std::vector or dlib::array of column vectors (dlib::matrix
+                  objects) of float or double.
+                - samples.size() > 1
+                - All the samples have the same nonzero size.
+                - num_tables > 0
+                - num_bits <= 24
+            ensures
+                - Makes an index of the given samples.  The hashes are made from up to
+                  10000 of the samples, so they should be a good sample of the vectors
+                  that will be added and queried later on.
+                - #size() == samples.size()
+                - #dimensions() == samples[0].size()
+                - #num_tables() == num_tables
+                - if (num_bits == 0) then
+                    - #num_bits() is chosen so that there are around 16 samples in each
+                      bucket.
+                - else
+                    - #num_bits() == num_bits
+                - #get_num_probes() == 8*num_tables
+                - #is_attached() == false
+                - for all valid i: #get_sample(i) == samples[i]
+        !*/
+
+        unsigned long size (
+        ) const;
+        /*!
+            ensures
+                - returns the number of samples in this index.
+        !*/
+
+        unsigned long dimensions (
+        ) const;
+        /*!
+            ensures
+                - returns the size of the samples in this index.
+        !*/
+
+        unsigned long num_tables (
+        ) const;
+        /*!
+            ensures
+                - returns the number of hash tables.
+        !*/
+
+        unsigned long num_bits (
+        ) const;
+        /*!
+            ensures
+                - returns the number of bits in the hash of each table.  So each table has
+                  pow(2, num_bits()) buckets.
+        !*/
+
+        unsigned long get_num_probes (
+        ) const;
+        /*!
+            ensures
+                - returns the number of buckets, over all the tables, that find_nearest()
+                  looks in.
+        !*/
+
+        void set_num_probes (
+            unsigned long probes
+        );
+        /*!
+            requires
+                - probes >= num_tables()
+            ensures
+                - #get_num_probes() == probes
+        !*/
+
+        bool is_attached (
+        ) const;
+        /*!
+            ensures
+                - returns true if this object uses a buffer given to attach() rather than
+                  memory of its own.
+        !*/
+
+        template <typename EXP>
+        unsigned long add (
+            const matrix_exp<EXP>& sample
+        );
+        /*!
+            requires
+                - size() > 0
+                - is_col_vector(sample) == true
+                - sample.size() == dimensions()
+            ensures
+                - Adds sample to this index, using the hashes made by build().
+                - #size() == size() + 1
+                - #get_sample(size()) == sample
+                - returns size(), the index of sample.
+                - The new samples are put in the buckets a few hundred at a time (or 1/64th
+                  of size() at a time for big indexes), until then they are compared to
+                  every query.
+                - #is_attached() == false.  That is, if this object was attached to a
+                  buffer, the index is first copied into memory of its own.
+        !*/
+
+        matrix<float,0,1> get_sample (
+            unsigned long idx
+        ) const;
+        /*!
+            requires
+                - idx < size()
+            ensures
+                - returns the idx-th sample.
+        !*/
+
+        template <typename EXP>
+        void find_nearest (
+            const matrix_exp<EXP>& query,
+            unsigned long k,
+            std::vector<std::pair<double,unsigned long>>& results
+        ) const;
+        /*!
+            requires
+                - size() > 0
+                - is_col_vector(query) == true
+                - query.size() == dimensions()
+            ensures
+                - Finds the samples closest to query among those in the buckets it looks
+                  in.  These are the approximate k nearest neighbors of query.
+                - #results.size() <= k
+                - for all valid i:
+                    - #results[i].first == length(query - get_sample(#results[i].second))
+                - #results is sorted so that the closest sample comes first.
+        !*/
+
+        void attach (
+            const void* buffer,
+            size_t buffer_size
+        );
+        /*!
+            requires
+                - buffer points to buffer_size bytes holding an lsh_index written by
+                  serialize(), such as a memory mapped file, aligned to 4 bytes.
+                - buffer stays valid and unchanged as long as this object uses it, i.e.
+                  until it is changed by add(), build(), assignment or deserialize().
+            ensures
+                - This object becomes the index in buffer, without copying it.
+                - #is_attached() == true
+            throws
+                - dlib::fatal_error if buffer doesn't hold an lsh_index, if it was saved
+                  on a machine with a different byte order, or if it's truncated or
+                  corrupt.  The header and the bucket arrays are checked, so a damaged
+                  buffer can't make find_nearest() read outside of it, but the samples
+                  and hash functions are used as they are.
+        !*/
+    };
+
+    void serialize (
+        const lsh_index& item,
+        std::ostream& out
+    );
+    /*!
+        provides serialization support.  The index is written as a 64 byte header
+        followed by its arrays, in the byte order of this machine, so that attach() can
+        use it where it is.
+    !*/
+
+    void deserialize (
+        lsh_index& item,
+        std::istream& in
+    );
+    /*!
+        provides deserialization support.  Throws serialization_error if in holds a
+        truncated or corrupt index, checking it the same way attach() does.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_LSH_INDEx_ABSTRACT_Hh_
+
@@ -7,6 +7,8 @@
 #include "matrix_utilities.h"
 #include "../hash.h"
 #include "../algs.h"
+#include "../numeric_constants.h"
+#include <vector>
 
 #ifdef DLIB_USE_MKL_FFT
 #include <mkl_dfti.h>
@@ -132,19 +134,19 @@ namespace dlib
                 {
                     const int nxtlt = 0x1 << p;
                     data[p].reserve(nxtlt*7);
-                    const T twopi = 6.2831853071795865; /* 2.0 * pi */
-                    const T scale = twopi/(nxtlt*8.0);
+                    // Each factor is computed directly in long double rather than as a
+                    // power of the first one, so float transforms don't pick up the
+                    // rounding error of the products.
+                    const long double twopi = 6.2831853071795864769L; /* 2.0 * pi */
+                    const long double scale = twopi/(nxtlt*8.0L);
                     std::complex<T> cs[7];
                     for (int j = 0; j < nxtlt; ++j)
                     {
-                        const T arg = j*scale;
-                        cs[0] = std::complex<T>(std::cos(arg),std::sin(arg));
-                        cs[1] = cs[0]*cs[0];
-                        cs[2] = cs[1]*cs[0];
-                        cs[3] = cs[1]*cs[1];
-                        cs[4] = cs[2]*cs[1];
-                        cs[5] = cs[2]*cs[2];
-                        cs[6] = cs[3]*cs[2];
+                        for (int k = 0; k < 7; ++k)
+                        {
+                            const long double arg = (k+1)*j*scale;
+                            cs[k] = std::complex<T>(std::cos(arg),std::sin(arg));
+                        }
                         data[p].insert(data[p].end(), cs, cs+7);
                     }
                 }
@@ -221,12 +223,12 @@ namespace dlib
 
     // ------------------------------------------------------------------------------------
 
-        template <typename T, long NR, long NC, typename MM, typename layout>
-        void fft1d_inplace(matrix<std::complex<T>,NR,NC,MM,layout>& data, bool do_backward_fft, twiddles<T>& cs)
+        template <typename T>
+        void fft1d_inplace(std::complex<T>* const b, const long size, bool do_backward_fft, twiddles<T>& cs)
         /*!
             requires
-                - is_vector(data) == true
-                - is_power_of_two(data.size()) == true
+                - b points to an array of size elements
+                - is_power_of_two(size) == true
             ensures
                 - This routine replaces the input std::complex<double> vector by its finite
                   discrete complex fourier transform if do_backward_fft==true.  It replaces
@@ -240,17 +242,16 @@ namespace dlib
         {
             COMPILE_TIME_ASSERT((is_same_type<double,T>::value || is_same_type<float,T>::value || is_same_type<long double,T>::value ));
 
-            if (data.size() == 0)
+            if (size == 0)
                 return;
 
-            std::complex<T>* const b = &data(0);
             int L[16],L1,L2,L3,L4,L5,L6,L7,L8,L9,L10,L11,L12,L13,L14,L15;
             int j1,j2,j3,j4,j5,j6,j7,j8,j9,j10,j11,j12,j13,j14;
             int j, ij, ji;
             int n2pow, n8pow, nthpo, ipass, nxtlt, length;
 
-            n2pow = fastlog2(data.size());
-            nthpo = data.size();
+            n2pow = fastlog2(size);
+            nthpo = size;
 
             n8pow = n2pow/3;
 
@@ -316,13 +317,28 @@ namespace dlib
             // unscramble outputs
             if(!do_backward_fft) 
             {
-                for(long i=1, j=data.size()-1; i<data.size()/2; i++,j--)
+                for(long i=1, j=size-1; i<size/2; i++,j--)
                 {
                     swap(b[j], b[i]);
                 }
             }
         }
 
+        template <typename T, long NR, long NC, typename MM, typename layout>
+        void fft1d_inplace(matrix<std::complex<T>,NR,NC,MM,layout>& data, bool do_backward_fft, twiddles<T>& cs)
+        /*!
+            requires
+                - is_vector(data) == true
+                - is_power_of_two(data.size()) == true
+            ensures
+                - performs the above fft1d_inplace() on the elements of data.
+        !*/
+        {
+            if (data.size() == 0)
+                return;
+            fft1d_inplace(&data(0), data.size(), do_backward_fft, cs);
+        }
+
     // ------------------------------------------------------------------------------------
 
         template < typename T, long NR, long NC, typename MM, typename L >
@@ -541,6 +557,227 @@ namespace dlib
         impl::fft2d_inplace(data, true);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename T>
+    class real_fft_plan
+    {
+        /*!
+            This object computes the 2D FFT of real matrices of one fixed size.  Since
+            the transform of a real matrix is Hermitian, only its first nc/2+1 columns are
+            computed.  Each row is packed into a complex vector of half its length which
+            is transformed and then split into the spectrum of the row, so the row pass
+            does half the work of a complex FFT.  The twiddle factors of both passes are
+            computed once, when the plan is made, and reused by every call.
+        !*/
+    public:
+
+        real_fft_plan (
+        ) : rows(0), cols(0) {}
+
+        real_fft_plan (
+            long nr_,
+            long nc_
+        ) : rows(nr_), cols(nc_)
+        {
+            COMPILE_TIME_ASSERT((is_same_type<double,T>::value || is_same_type<float,T>::value || is_same_type<long double,T>::value ));
+            // make sure requires clause is not broken
+            DLIB_CASSERT(nr_ > 0 && nc_ > 1 && is_power_of_two(nr_) && is_power_of_two(nc_),
+                "\t real_fft_plan::real_fft_plan(nr,nc)"
+                << "\n\t The number of rows and columns must be powers of two and nc must be at least 2."
+                << "\n\t nr: "<< nr_
+                << "\n\t nc: "<< nc_
+                );
+
+            const long half = cols/2;
+            row_twiddles.resize(half);
+            for (long k = 0; k < half; ++k)
+            {
+                const double arg = -2*pi*k/cols;
+                row_twiddles[k] = std::complex<T>(std::cos(arg), std::sin(arg));
+            }
+            col_buff.resize(rows);
+
+            // Fill the R8TX twiddle caches now rather than on the first call.
+            for (long p = impl::fastlog2(half) - 3; p >= 0; p -= 3)
+                cs.get_twiddles(p);
+            for (long p = impl::fastlog2(rows) - 3; p >= 0; p -= 3)
+                cs.get_twiddles(p);
+        }
+
+        long nr (
+        ) const { return rows; }
+
+        long nc (
+        ) const { return cols; }
+
+        void fftr (
+            const matrix<T>& data,
+            matrix<std::complex<T> >& out
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(data.nr() == nr() && data.nc() == nc(),
+                "\t void real_fft_plan::fftr(data, out)"
+                << "\n\t The input matrix must have the size of the plan."
+                << "\n\t data.nr(): "<< data.nr()
+                << "\n\t data.nc(): "<< data.nc()
+                << "\n\t nr():      "<< nr()
+                << "\n\t nc():      "<< nc()
+                );
+
+            const long half = cols/2;
+            out.set_size(rows, half+1);
+            for (long r = 0; r < rows; ++r)
+            {
+                const T* in = &data(r,0);
+                std::complex<T>* z = &out(r,0);
+                for (long k = 0; k < half; ++k)
+                    z[k] = std::complex<T>(in[2*k], in[2*k+1]);
+                impl::fft1d_inplace(z, half, false, cs);
+
+                // z holds the transform of the even samples plus i times the transform
+                // of the odd ones.  Split it and merge the two into the row's spectrum.
+                const std::complex<T> z0 = z[0];
+                z[0] = std::complex<T>(z0.real()+z0.imag(), 0);
+                z[half] = std::complex<T>(z0.real()-z0.imag(), 0);
+                for (long k = 1, j = half-1; k <= j; ++k, --j)
+                {
+                    const std::complex<T> a = z[k];
+                    const std::complex<T> b = std::conj(z[j]);
+                    const std::complex<T> e = (a+b)*T(0.5);
+                    const std::complex<T> d = (a-b)*T(0.5);
+                    const std::complex<T> o(d.imag(), -d.real());
+                    const std::complex<T> wo = row_twiddles[k]*o;
+                    z[k] = e + wo;
+                    z[j] = std::conj(e - wo);
+                }
+            }
+
+            if (rows > 1)
+            {
+                for (long c = 0; c <= half; ++c)
+                {
+                    for (long r = 0; r < rows; ++r)
+                        col_buff[r] = out(r,c);
+                    impl::fft1d_inplace(&col_buff[0], rows, false, cs);
+                    for (long r = 0; r < rows; ++r)
+                        out(r,c) = col_buff[r];
+                }
+            }
+        }
+
+        void ifftr (
+            const matrix<std::complex<T> >& data,
+            matrix<T>& out
+        )
+        {
+            // make sure requires clause is not broken
+            DLIB_ASSERT(data.nr() == nr() && data.nc() == nc()/2+1,
+                "\t void real_fft_plan::ifftr(data, out)"
+                << "\n\t The input matrix must be the size of the half spectrum of the plan."
+                << "\n\t data.nr(): "<< data.nr()
+                << "\n\t data.nc(): "<< data.nc()
+                << "\n\t nr():      "<< nr()
+                << "\n\t nc():      "<< nc()
+                );
+
+            const long half = cols/2;
+            temp = data;
+            if (rows > 1)
+            {
+                for (long c = 0; c <= half; ++c)
+                {
+                    for (long r = 0; r < rows; ++r)
+                        col_buff[r] = temp(r,c);
+                    impl::fft1d_inplace(&col_buff[0], rows, true, cs);
+                    for (long r = 0; r < rows; ++r)
+                        temp(r,c) = col_buff[r];
+                }
+            }
+
+            out.set_size(rows, cols);
+            const T scale = T(1)/(half*rows);
+            for (long r = 0; r < rows; ++r)
+            {
+                // Undo the split done by fftr(), giving back the transform of the even
+                // samples plus i times the transform of the odd ones.
+                std::complex<T>* z = &temp(r,0);
+                const std::complex<T> x0 = z[0];
+                const std::complex<T> xh = std::conj(z[half]);
+                z[0] = (x0+xh)*T(0.5) + std::complex<T>(0,0.5)*(x0-xh);
+                for (long k = 1, j = half-1; k <= j; ++k, --j)
+                {
+                    const std::complex<T> a = z[k];
+                    const std::complex<T> b = std::conj(z[j]);
+                    const std::complex<T> e = (a+b)*T(0.5);
+                    const std::complex<T> o = (a-b)*std::conj(row_twiddles[k])*T(0.5);
+                    z[k] = e + std::complex<T>(-o.imag(), o.real());
+                    z[j] = std::conj(e) + std::complex<T>(o.imag(), o.real());
+                }
+                impl::fft1d_inplace(z, half, true, cs);
+
+                T* o = &out(r,0);
+                for (long k = 0; k < half; ++k)
+                {
+                    o[2*k] = z[k].real()*scale;
+                    o[2*k+1] = z[k].imag()*scale;
+                }
+            }
+        }
+
+    private:
+
+        long rows;
+        long cols;
+        impl::twiddles<T> cs;
+        std::vector<std::complex<T> > row_twiddles;
+        std::vector<std::complex<T> > col_buff;
+        matrix<std::complex<T> > temp;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename EXP>
+    matrix<std::complex<typename EXP::type> > fftr (const matrix_exp<EXP>& data)
+    {
+        typedef typename EXP::type T;
+        // make sure requires clause is not broken
+        DLIB_CASSERT(data.nr() > 0 && data.nc() > 1 && is_power_of_two(data.nr()) && is_power_of_two(data.nc()),
+            "\t matrix fftr(data)"
+            << "\n\t The number of rows and columns must be powers of two and nc must be at least 2."
+            << "\n\t data.nr(): "<< data.nr()
+            << "\n\t data.nc(): "<< data.nc()
+            );
+
+        const matrix<T> temp(data);
+        matrix<std::complex<T> > out;
+        real_fft_plan<T> plan(data.nr(), data.nc());
+        plan.fftr(temp, out);
+        return out;
+    }
+
+    template <typename EXP>
+    matrix<typename EXP::type::value_type> ifftr (const matrix_exp<EXP>& data)
+    {
+        // You have to give a complex matrix
+        COMPILE_TIME_ASSERT(is_complex<typename EXP::type>::value);
+        typedef typename EXP::type::value_type T;
+        // make sure requires clause is not broken
+        DLIB_CASSERT(data.nr() > 0 && data.nc() > 1 && is_power_of_two(data.nr()) && is_power_of_two(data.nc()-1),
+            "\t matrix ifftr(data)"
+            << "\n\t data must have a power of two number of rows and 2^k+1 columns."
+            << "\n\t data.nr(): "<< data.nr()
+            << "\n\t data.nc(): "<< data.nc()
+            );
+
+        const matrix<std::complex<T> > temp(data);
+        matrix<T> out;
+        real_fft_plan<T> plan(data.nr(), 2*(data.nc()-1));
+        plan.ifftr(temp, out);
+        return out;
+    }
+
 // ----------------------------------------------------------------------------------------
 
     /*
@@ -0,0 +1,241 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+#ifndef DLIB_sIMD8US_Hh_
+#define DLIB_sIMD8US_Hh_
+
+#include "simd_check.h"
+#include "../uintn.h"
+
+namespace dlib
+{
+
+    /*
+        simd8us holds 8 uint16 values.  It is meant for fixed point image processing on
+        8 bit pixels, so besides loading and storing uint16 values it can load 8 bytes
+        zero extended to 16 bits and store its values as 8 bytes, saturated to 0..255.
+        All arithmetic wraps around modulo 2^16.
+    */
+
+#ifdef DLIB_HAVE_SSE2
+    class simd8us
+    {
+    public:
+        typedef uint16 type;
+
+        inline simd8us() {}
+        inline simd8us(uint16 f) { x = _mm_set1_epi16((short)f); }
+        inline simd8us(const __m128i& val):x(val) {}
+
+        inline simd8us& operator=(const __m128i& val)
+        {
+            x = val;
+            return *this;
+        }
+
+        inline operator __m128i() const { return x; }
+
+        inline void load_aligned(const type* ptr)  { x = _mm_load_si128((const __m128i*)ptr); }
+        inline void store_aligned(type* ptr) const { _mm_store_si128((__m128i*)ptr, x); }
+        inline void load(const type* ptr)          { x = _mm_loadu_si128((const __m128i*)ptr); }
+        inline void store(type* ptr)         const { _mm_storeu_si128((__m128i*)ptr, x); }
+
+        inline void load(const uint8* ptr)
+        {
+            x = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)ptr), _mm_setzero_si128());
+        }
+        inline void store(uint8* ptr) const
+        {
+            // _mm_packus_epi16() takes its inputs as signed, so clamp them to 255 first.
+            const __m128i temp = _mm_sub_epi16(x, _mm_subs_epu16(x, _mm_set1_epi16(255)));
+            _mm_storel_epi64((__m128i*)ptr, _mm_packus_epi16(temp, temp));
+        }
+
+        inline unsigned int size() const { return 8; }
+        inline uint16 operator[](unsigned int idx) const
+        {
+            uint16 temp[8];
+            store(temp);
+            return temp[idx];
+        }
+
+    private:
+        __m128i x;
+    };
+
+#elif defined(DLIB_HAVE_NEON)
+
+    class simd8us
+    {
+    public:
+        typedef uint16 type;
+
+        inline simd8us() {}
+        inline simd8us(uint16 f) { x = vdupq_n_u16(f); }
+        inline simd8us(const uint16x8_t& val):x(val) {}
+
+        inline simd8us& operator=(const uint16x8_t& val)
+        {
+            x = val;
+            return *this;
+        }
+
+        inline operator uint16x8_t() const { return x; }
+
+        inline void load_aligned(const type* ptr)  { x = vld1q_u16(ptr); }
+        inline void store_aligned(type* ptr) const { vst1q_u16(ptr, x); }
+        inline void load(const type* ptr)          { x = vld1q_u16(ptr); }
+        inline void store(type* ptr)         const { vst1q_u16(ptr, x); }
+
+        inline void load(const uint8* ptr)  { x = vmovl_u8(vld1_u8(ptr)); }
+        inline void store(uint8* ptr) const { vst1_u8(ptr, vqmovn_u16(x)); }
+
+        inline unsigned int size() const { return 8; }
+        inline uint16 operator[](unsigned int idx) const
+        {
+            uint16 temp[8];
+            store(temp);
+            return temp[idx];
+        }
+
+    private:
+        uint16x8_t x;
+    };
+
+#else
+
+    class simd8us
+    {
+    public:
+        typedef uint16 type;
+
+        inline simd8us() {}
+        inline simd8us(uint16 f) { for (int i = 0; i < 8; ++i) x[i] = f; }
+
+        inline void load_aligned(const type* ptr)  { load(ptr); }
+        inline void store_aligned(type* ptr) const { store(ptr); }
+        inline void load(const type* ptr)          { for (int i = 0; i < 8; ++i) x[i] = ptr[i]; }
+        inline void store(type* ptr)         const { for (int i = 0; i < 8; ++i) ptr[i] = x[i]; }
+
+        inline void load(const uint8* ptr)  { for (int i = 0; i < 8; ++i) x[i] = ptr[i]; }
+        inline void store(uint8* ptr) const
+        {
+            for (int i = 0; i < 8; ++i)
+                ptr[i] = x[i] > 255 ? 255 : x[i];
+        }
+
+        inline unsigned int size() const { return 8; }
+        inline uint16 operator[](unsigned int idx) const { return x[idx]; }
+        inline uint16& operator[](unsigned int idx) { return x[idx]; }
+
+    private:
+        uint16 x[8];
+    };
+#endif
+
+// ----------------------------------------------------------------------------------------
+
+    inline std::ostream& operator<<(std::ostream& out, const simd8us& item)
+    {
+        uint16 temp[8];
+        item.store(temp);
+        out << "(";
+        for (int i = 0; i < 8; ++i)
+            out << temp[i] << (i < 7 ? ", " : ")");
+        return out;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    inline simd8us operator+ (const simd8us& lhs, const simd8us& rhs)
+    {
+#ifdef DLIB_HAVE_SSE2
+        return _mm_add_epi16(lhs, rhs);
+#elif defined(DLIB_HAVE_NEON)
+        return vaddq_u16(lhs, rhs);
+#else
+        simd8us temp;
+        for (int i = 0; i < 8; ++i)
+            temp[i] = lhs[i]+rhs[i];
+        return temp;
+#endif
+    }
+    inline simd8us& operator+= (simd8us& lhs, const simd8us& rhs)
+    { return lhs = lhs + rhs; return lhs;}
+
+// ----------------------------------------------------------------------------------------
+
+    inline simd8us operator- (const simd8us& lhs, const simd8us& rhs)
+    {
+#ifdef DLIB_HAVE_SSE2
+        return _mm_sub_epi16(lhs, rhs);
+#elif defined(DLIB_HAVE_NEON)
+        return vsubq_u16(lhs, rhs);
+#else
+        simd8us temp;
+        for (int i = 0; i < 8; ++i)
+            temp[i] = lhs[i]-rhs[i];
+        return temp;
+#endif
+    }
+    inline simd8us& operator-= (simd8us& lhs, const simd8us& rhs)
+    { return lhs = lhs - rhs; return lhs;}
+
+// ----------------------------------------------------------------------------------------
+
+    inline simd8us operator* (const simd8us& lhs, const simd8us& rhs)
+    {
+#ifdef DLIB_HAVE_SSE2
+        return _mm_mullo_epi16(lhs, rhs);
+#elif defined(DLIB_HAVE_NEON)
+        return vmulq_u16(lhs, rhs);
+#else
+        simd8us temp;
+        for (int i = 0; i < 8; ++i)
+            temp[i] = lhs[i]*rhs[i];
+        return temp;
+#endif
+    }
+    inline simd8us& operator*= (simd8us& lhs, const simd8us& rhs)
+    { return lhs = lhs * rhs; return lhs;}
+
+// ----------------------------------------------------------------------------------------
+
+    inline simd8us operator<< (const simd8us& lhs, const int& rhs)
+    {
+#ifdef DLIB_HAVE_SSE2
+        return _mm_sll_epi16(lhs,_mm_cvtsi32_si128(rhs));
+#elif defined(DLIB_HAVE_NEON)
+        return vshlq_u16(lhs, vdupq_n_s16(rhs));
+#else
+        simd8us temp;
+        for (int i = 0; i < 8; ++i)
+            temp[i] = lhs[i]<<rhs;
+        return temp;
+#endif
+    }
+    inline simd8us& operator<<= (simd8us& lhs, const int& rhs)
+    { return lhs = lhs << rhs; return lhs;}
+
+// ----------------------------------------------------------------------------------------
+
+    inline simd8us operator>> (const simd8us& lhs, const int& rhs)
+    {
+#ifdef DLIB_HAVE_SSE2
+        return _mm_srl_epi16(lhs,_mm_cvtsi32_si128(rhs));
+#elif defined(DLIB_HAVE_NEON)
+        return vshlq_u16(lhs, vdupq_n_s16(-rhs));
+#else
+        simd8us temp;
+        for (int i = 0; i < 8; ++i)
+            temp[i] = lhs[i]>>rhs;
+        return temp;
+#endif
+    }
+    inline simd8us& operator>>= (simd8us& lhs, const int& rhs)
+    { return lhs = lhs >> rhs; return lhs;}
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // DLIB_sIMD8US_Hh_
+
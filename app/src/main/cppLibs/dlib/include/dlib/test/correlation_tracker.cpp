@@ -16,6 +16,162 @@ namespace
     using namespace std;
     dlib::logger dlog("test.correlation_tracker");
 
+// ----------------------------------------------------------------------------------------
+
+    // Makes a frame with a textured patch at each of the given rectangles on top of a
+    // noisy background.
+    void make_multi_target_frame (
+        array2d<unsigned char>& img,
+        const std::vector<rectangle>& boxes
+    )
+    {
+        dlib::rand rnd(0);
+        img.set_size(240,320);
+        for (long r = 0; r < img.nr(); ++r)
+            for (long c = 0; c < img.nc(); ++c)
+                img[r][c] = 60 + rnd.get_random_8bit_number()/4 + 30*std::sin(c*0.05)*std::cos(r*0.07);
+
+        for (unsigned long i = 0; i < boxes.size(); ++i)
+        {
+            const rectangle area = boxes[i].intersect(get_rect(img));
+            for (long r = area.top(); r <= area.bottom(); ++r)
+            {
+                for (long c = area.left(); c <= area.right(); ++c)
+                {
+                    const long y = r-boxes[i].top();
+                    const long x = c-boxes[i].left();
+                    img[r][c] = ((y/(5+i) + x/(4+i))%2) ? 230 : 20;
+                }
+            }
+        }
+    }
+
+    std::vector<rectangle> multi_target_boxes (
+        int frame,
+        bool with_third
+    )
+    {
+        std::vector<rectangle> boxes;
+        boxes.push_back(translate_rect(rectangle(0,0,39,49), point(30+2*frame, 40+frame)));
+        boxes.push_back(translate_rect(rectangle(0,0,44,54), point(240-2*frame, 150-frame)));
+        if (with_third)
+            boxes.push_back(translate_rect(rectangle(0,0,39,39), point(150, 20+frame)));
+        return boxes;
+    }
+
+    void test_multi_target_tracker (
+    )
+    {
+        print_spinner();
+        multi_target_tracker mtt, mtt_par;
+        thread_pool tp(2);
+        DLIB_TEST(mtt.num_targets() == 0);
+        DLIB_TEST(mtt.get_max_missed_detections() == 1);
+
+        array2d<unsigned char> img;
+        std::vector<rectangle> boxes = multi_target_boxes(0, false);
+        make_multi_target_frame(img, boxes);
+        mtt.add_detections(img, boxes);
+        mtt_par.add_detections(img, boxes, get_rect(img), tp);
+        DLIB_TEST(mtt.num_targets() == 2);
+        DLIB_TEST(mtt.get_targets()[0].id == 0);
+        DLIB_TEST(mtt.get_targets()[1].id == 1);
+
+        for (int frame = 1; frame < 10; ++frame)
+        {
+            boxes = multi_target_boxes(frame, false);
+            make_multi_target_frame(img, boxes);
+            mtt.update(img);
+            mtt_par.update(img, tp);
+            DLIB_TEST(mtt.num_targets() == 2);
+            DLIB_TEST(mtt_par.num_targets() == 2);
+            for (unsigned long i = 0; i < 2; ++i)
+            {
+                const tracked_target& t = mtt.get_targets()[i];
+                dlog << LINFO << "frame " << frame << " target " << t.id << " conf: " << t.confidence
+                     << " overlap: " << box_intersection_over_union(t.rect, drectangle(boxes[i]));
+                DLIB_TEST(box_intersection_over_union(t.rect, drectangle(boxes[i])) > 0.7);
+                DLIB_TEST(t.confidence > 5);
+                DLIB_TEST(t.age == (unsigned long)frame);
+                DLIB_TEST(t.frames_since_detection == (unsigned long)frame);
+                DLIB_TEST(t.rect == mtt_par.get_targets()[i].rect);
+                DLIB_TEST(t.confidence == mtt_par.get_targets()[i].confidence);
+            }
+        }
+        print_spinner();
+
+        // A new object shows up.  The old targets keep their ids and a new one is made.
+        boxes = multi_target_boxes(10, true);
+        make_multi_target_frame(img, boxes);
+        std::vector<rectangle> dets;
+        dets.push_back(boxes[2]);
+        dets.push_back(boxes[1]);
+        dets.push_back(boxes[0]);
+        mtt.add_detections(img, dets);
+        DLIB_TEST(mtt.num_targets() == 3);
+        for (unsigned long i = 0; i < 3; ++i)
+        {
+            DLIB_TEST(mtt.get_targets()[i].id == i);
+            DLIB_TEST(mtt.get_targets()[i].rect == drectangle(boxes[i]));
+            DLIB_TEST(mtt.get_targets()[i].frames_since_detection == 0);
+        }
+        DLIB_TEST(mtt.get_targets()[0].age == 9);
+        DLIB_TEST(mtt.get_targets()[2].age == 0);
+
+        boxes = multi_target_boxes(11, true);
+        make_multi_target_frame(img, boxes);
+        mtt.update(img);
+        DLIB_TEST(mtt.num_targets() == 3);
+        for (unsigned long i = 0; i < 3; ++i)
+            DLIB_TEST(box_intersection_over_union(mtt.get_targets()[i].rect, drectangle(boxes[i])) > 0.7);
+        DLIB_TEST(mtt.get_low_confidence_targets(1e10).size() == 3);
+        DLIB_TEST(mtt.get_low_confidence_targets(-1e10).size() == 0);
+
+        // The detector stops seeing object 1.  It's dropped on the second miss, but misses
+        // outside the searched area don't count.
+        dets.clear();
+        dets.push_back(boxes[0]);
+        dets.push_back(boxes[2]);
+        mtt.add_detections(img, dets);
+        DLIB_TEST(mtt.num_targets() == 3);
+        DLIB_TEST(mtt.get_targets()[1].missed_detections == 1);
+        mtt.add_detections(img, dets, rectangle(0,0,140,100));
+        DLIB_TEST(mtt.num_targets() == 3);
+        DLIB_TEST(mtt.get_targets()[1].missed_detections == 1);
+        mtt.add_detections(img, dets);
+        DLIB_TEST(mtt.num_targets() == 2);
+        DLIB_TEST(mtt.get_targets()[0].id == 0);
+        DLIB_TEST(mtt.get_targets()[1].id == 2);
+        print_spinner();
+
+        // Two detections of the same object give two targets, but they converge and the
+        // younger one is removed by update().
+        dets.clear();
+        dets.push_back(boxes[0]);
+        dets.push_back(boxes[2]);
+        dets.push_back(translate_rect(boxes[0], point(6,4)));
+        mtt.add_detections(img, dets);
+        DLIB_TEST(mtt.num_targets() == 3);
+        DLIB_TEST(mtt.get_targets()[2].id == 3);
+        mtt.update(img);
+        DLIB_TEST(mtt.num_targets() == 2);
+        DLIB_TEST(mtt.get_targets()[0].id == 0);
+        DLIB_TEST(mtt.get_targets()[1].id == 2);
+
+        // Targets the tracker loses are removed.
+        mtt.set_min_confidence(1e10);
+        mtt.update(img);
+        DLIB_TEST(mtt.num_targets() == 0);
+
+        mtt.set_min_confidence(0);
+        mtt.add_detections(img, dets);
+        DLIB_TEST(mtt.get_targets()[0].id == 4);
+        mtt.clear();
+        DLIB_TEST(mtt.num_targets() == 0);
+    }
+
+// ----------------------------------------------------------------------------------------
+
 
     class correlation_tracker_tester : public tester
     {
@@ -80,6 +236,8 @@ namespace
                 DLIB_TEST(rect_confidence >= 0.97);
                 print_spinner();
             }
+
+            test_multi_target_tracker();
         }
 
     // ------------------------------------------------------------------------------------
@@ -7,6 +7,7 @@
 #include <cstdlib>
 #include <ctime>
 #include <vector>
+#include <list>
 #include <random>
 #include <numeric>
 #include "../dnn.h"
@@ -1495,6 +1496,332 @@ namespace
 
 #endif // DLIB_USE_CUDA
 
+// ----------------------------------------------------------------------------------------
+
+    void conv_reference (
+        resizable_tensor& output,
+        const tensor& data,
+        const tensor& filters,
+        const int stride_y,
+        const int stride_x,
+        const int padding_y,
+        const int padding_x
+    )
+    {
+        // A plain loop over every output element.
+        output.set_size(data.num_samples(), filters.num_samples(),
+            1+(data.nr()+2*padding_y-filters.nr())/stride_y,
+            1+(data.nc()+2*padding_x-filters.nc())/stride_x);
+        const float* d = data.host();
+        const float* f = filters.host();
+        float* e = output.host();
+        for (long n = 0; n < output.num_samples(); ++n)
+        {
+            for (long m = 0; m < output.k(); ++m)
+            {
+                for (long r = 0; r < output.nr(); ++r)
+                {
+                    for (long c = 0; c < output.nc(); ++c)
+                    {
+                        double sum = 0;
+                        for (long k = 0; k < data.k(); ++k)
+                        {
+                            for (long y = 0; y < filters.nr(); ++y)
+                            {
+                                for (long x = 0; x < filters.nc(); ++x)
+                                {
+                                    const long yy = r*stride_y - padding_y + y;
+                                    const long xx = c*stride_x - padding_x + x;
+                                    if (yy < 0 || yy >= data.nr() || xx < 0 || xx >= data.nc())
+                                        continue;
+                                    sum += d[((n*data.k() + k)*data.nr() + yy)*data.nc() + xx]*
+                                           f[((m*data.k() + k)*filters.nr() + y)*filters.nc() + x];
+                                }
+                            }
+                        }
+                        e[((n*output.k() + m)*output.nr() + r)*output.nc() + c] = sum;
+                    }
+                }
+            }
+        }
+    }
+
+    void test_conv_cpu()
+    {
+        cpu::tensor_conv conv;
+
+        dlib::rand prnd;
+        for (int iter = 0; iter < 200; ++iter)
+        {
+            print_spinner();
+
+            resizable_tensor data(prnd.get_random_32bit_number()%3+1,
+                prnd.get_random_32bit_number()%5+1,
+                prnd.get_random_32bit_number()%25+1,
+                prnd.get_random_32bit_number()%25+1
+            );
+            // Cover both the few filter and many filter cases, which are computed
+            // differently.
+            resizable_tensor filters(
+                iter%2 == 0 ? prnd.get_random_32bit_number()%2+1 : prnd.get_random_32bit_number()%20+1,
+                data.k(),
+                prnd.get_random_32bit_number()%6+1,
+                prnd.get_random_32bit_number()%6+1
+            );
+
+            tt::tensor_rand rnd(iter);
+            rnd.fill_uniform(data);
+            rnd.fill_uniform(filters);
+
+            const int stride_y = prnd.get_random_32bit_number()%3+1;
+            const int stride_x = iter%3 == 0 ? 1 : prnd.get_random_32bit_number()%3+1;
+            int padding_y = prnd.get_random_32bit_number()%(filters.nr()/2+1);
+            int padding_x = prnd.get_random_32bit_number()%(filters.nc()/2+1);
+            if (!(filters.nr() <= data.nr() + 2*padding_y))
+                padding_y = (filters.nr()-data.nr()+1)/2;
+            if (!(filters.nc() <= data.nc() + 2*padding_x))
+                padding_x = (filters.nc()-data.nc()+1)/2;
+
+            resizable_tensor output, expected;
+            conv.setup(data,filters,stride_y,stride_x,padding_y,padding_x);
+            conv(false, output, data, filters);
+            conv_reference(expected, data, filters, stride_y, stride_x, padding_y, padding_x);
+            DLIB_TEST_MSG(max(abs(mat(output)-mat(expected))) < 1e-4, max(abs(mat(output)-mat(expected)))
+                 <<"\n\t padding_y: "<< padding_y
+                 <<"\n\t padding_x: "<< padding_x
+                 );
+
+            resizable_tensor output2 = output;
+            conv(true, output2, data, filters);
+            DLIB_TEST_MSG(max(abs(mat(output2)-2*mat(expected))) < 1e-4, max(abs(mat(output2)-2*mat(expected))));
+
+            // Check the version that also adds biases and applies relu.
+            resizable_tensor biases(1, filters.num_samples());
+            rnd.fill_uniform(biases);
+            tt::affine_transform(biases, biases, 2, -1);
+            conv(output2, data, filters, biases, iter%4 < 2);
+            tt::add(1, expected, 1, biases);
+            if (iter%4 < 2)
+                tt::relu(expected, expected);
+            DLIB_TEST_MSG(max(abs(mat(output2)-mat(expected))) < 1e-4, max(abs(mat(output2)-mat(expected))));
+        }
+    }
+
+    void test_conv_cpu_winograd()
+    {
+        // 3x3 filters with a stride of 1 use the Winograd algorithm, which rounds
+        // differently, so check its relative error on bigger inputs too.
+        cpu::tensor_conv conv;
+
+        dlib::rand prnd;
+        for (int iter = 0; iter < 60; ++iter)
+        {
+            print_spinner();
+
+            resizable_tensor data(prnd.get_random_32bit_number()%2+1,
+                prnd.get_random_32bit_number()%40+1,
+                prnd.get_random_32bit_number()%30+3,
+                prnd.get_random_32bit_number()%30+3
+            );
+            resizable_tensor filters(prnd.get_random_32bit_number()%20+3, data.k(), 3, 3);
+
+            tt::tensor_rand rnd(iter);
+            // Centered values make the outputs sums of terms that cancel, which is the
+            // hard case for the rounding.
+            rnd.fill_uniform(data);
+            rnd.fill_uniform(filters);
+            tt::affine_transform(data, data, 2, -1);
+            tt::affine_transform(filters, filters, 2, -1);
+
+            const int padding_y = prnd.get_random_32bit_number()%3;
+            const int padding_x = prnd.get_random_32bit_number()%3;
+
+            resizable_tensor output, expected;
+            conv.setup(data,filters,1,1,padding_y,padding_x);
+            conv(false, output, data, filters);
+            conv_reference(expected, data, filters, 1, 1, padding_y, padding_x);
+            const double scale = max(abs(mat(expected)));
+            DLIB_TEST_MSG(max(abs(mat(output)-mat(expected)))/scale < 1e-5, max(abs(mat(output)-mat(expected)))/scale);
+
+            resizable_tensor output2 = output;
+            conv(true, output2, data, filters);
+            DLIB_TEST(max(abs(mat(output2)-2*mat(expected)))/scale < 1e-5);
+
+            resizable_tensor biases(1, filters.num_samples());
+            rnd.fill_uniform(biases);
+            conv(output2, data, filters, biases, true);
+            resizable_tensor expected2 = expected;
+            tt::add(1, expected2, 1, biases);
+            tt::relu(expected2, expected2);
+            DLIB_TEST(max(abs(mat(output2)-mat(expected2)))/scale < 1e-5);
+
+            // The transformed filters are reused between calls and keyed on the filters'
+            // version().  Reading the filters must not change it, and changing them in
+            // place must be noticed.
+            const uint64 version = filters.version();
+            const tensor& const_filters = filters;
+            const_filters.host();
+            DLIB_TEST(filters.version() == version);
+            filters.host()[filters.size()/2] += 1;
+            conv(false, output, data, filters);
+            conv_reference(expected, data, filters, 1, 1, padding_y, padding_x);
+            DLIB_TEST(max(abs(mat(output)-mat(expected)))/scale < 1e-5);
+        }
+    }
+
+    float round_like_int8 (
+        float v,
+        const float qmin,
+        const float qmax
+    )
+    {
+        v = std::min(std::max(v, qmin), qmax);
+        return static_cast<int>(v >= 0 ? v+0.5f : v-0.5f);
+    }
+
+    void round_rows_like_int8 (
+        float* p,
+        const long rows,
+        const long cols,
+        const long row_stride,
+        const long col_stride
+    )
+    {
+        for (long i = 0; i < rows; ++i)
+        {
+            float biggest = 0;
+            for (long j = 0; j < cols; ++j)
+                biggest = std::max(biggest, std::abs(p[i*row_stride + j*col_stride]));
+            const float scale = biggest > 0 ? biggest/127 : 1;
+            for (long j = 0; j < cols; ++j)
+            {
+                float& v = p[i*row_stride + j*col_stride];
+                v = round_like_int8(v/scale, -127, 127)*scale;
+            }
+        }
+    }
+
+    void round_data_like_int8 (
+        tensor& t,
+        const float data_min,
+        const float data_max
+    )
+    {
+        const float qmin = data_min >= 0 ? 0 : -127;
+        const float qmax = data_min >= 0 ? 255 : 127;
+        const float scale = data_min >= 0 ? data_max/qmax : std::max(-data_min, data_max)/qmax;
+        for (auto& v : t)
+            v = round_like_int8(v*(1/scale), qmin, qmax)*scale;
+    }
+
+    void test_conv_cpu_int8()
+    {
+        // The integer sums are exact, so forward_int8() should give the float
+        // convolution of the rounded data and filters.
+        cpu::tensor_conv conv;
+
+        dlib::rand prnd;
+        for (int iter = 0; iter < 60; ++iter)
+        {
+            print_spinner();
+
+            resizable_tensor data(prnd.get_random_32bit_number()%2+1,
+                prnd.get_random_32bit_number()%30+1,
+                prnd.get_random_32bit_number()%25+6,
+                prnd.get_random_32bit_number()%25+6
+            );
+            resizable_tensor filters(prnd.get_random_32bit_number()%20+1,
+                data.k(),
+                prnd.get_random_32bit_number()%6+1,
+                prnd.get_random_32bit_number()%6+1
+            );
+
+            tt::tensor_rand rnd(iter);
+            rnd.fill_uniform(data);
+            rnd.fill_uniform(filters);
+            tt::affine_transform(filters, filters, 2, -1);
+            // Cover both signed data and data that is never negative, which are rounded
+            // differently.
+            if (iter%2 == 0)
+                tt::affine_transform(data, data, 2, -1);
+            // A range a bit smaller than the data so some of it gets clamped.
+            const float data_min = 0.9*min(mat(data));
+            const float data_max = 0.9*max(mat(data));
+
+            const int stride_y = prnd.get_random_32bit_number()%3+1;
+            const int stride_x = prnd.get_random_32bit_number()%3+1;
+            const int padding_y = prnd.get_random_32bit_number()%(filters.nr()/2+1);
+            const int padding_x = prnd.get_random_32bit_number()%(filters.nc()/2+1);
+            const bool use_relu = iter%3 == 0;
+
+            resizable_tensor biases(1, filters.num_samples());
+            rnd.fill_uniform(biases);
+
+            cpu::int8_weights qweights;
+            qweights.quantize(filters, false);
+            DLIB_TEST(qweights.size() == filters.size());
+            resizable_tensor output, expected;
+            conv.setup(data,qweights,stride_y,stride_x,padding_y,padding_x);
+            conv.forward_int8(output, data, qweights, biases, use_relu, data_min, data_max);
+
+            resizable_tensor qdata = data, qfilters = filters;
+            const long filter_size = filters.size()/filters.num_samples();
+            round_data_like_int8(qdata, data_min, data_max);
+            round_rows_like_int8(qfilters.host(), filters.num_samples(), filter_size, filter_size, 1);
+            resizable_tensor dequantized(filters.num_samples(), filters.k(), filters.nr(), filters.nc());
+            qweights.dequantize(dequantized);
+            DLIB_TEST(max(abs(mat(dequantized)-mat(qfilters))) <= 1e-6*max(abs(mat(filters))));
+            conv_reference(expected, qdata, qfilters, stride_y, stride_x, padding_y, padding_x);
+            tt::add(1, expected, 1, biases);
+            if (use_relu)
+                tt::relu(expected, expected);
+            const double scale = max(abs(mat(expected)));
+            DLIB_TEST_MSG(max(abs(mat(output)-mat(expected)))/scale < 1e-5, max(abs(mat(output)-mat(expected)))/scale);
+
+            // The scratch memory is reused between calls, make sure new filters and a
+            // serialized copy of them are used as they are.
+            filters.host()[filters.size()/2] += 1;
+            qweights.quantize(filters, false);
+            std::ostringstream sout;
+            serialize(qweights, sout);
+            std::istringstream sin(sout.str());
+            cpu::int8_weights qweights2;
+            deserialize(qweights2, sin);
+            conv.forward_int8(output, data, qweights2, biases, false, data_min, data_max);
+            qfilters = filters;
+            round_rows_like_int8(qfilters.host(), filters.num_samples(), filter_size, filter_size, 1);
+            conv_reference(expected, qdata, qfilters, stride_y, stride_x, padding_y, padding_x);
+            tt::add(1, expected, 1, biases);
+            DLIB_TEST(max(abs(mat(output)-mat(expected)))/max(abs(mat(expected))) < 1e-5);
+        }
+
+        cpu::gemm_int8 gemm;
+        for (int iter = 0; iter < 20; ++iter)
+        {
+            print_spinner();
+
+            resizable_tensor lhs(prnd.get_random_32bit_number()%20+1, prnd.get_random_32bit_number()%300+1);
+            resizable_tensor rhs(lhs.k(), prnd.get_random_32bit_number()%30+1);
+            tt::tensor_rand rnd(iter);
+            rnd.fill_uniform(lhs);
+            rnd.fill_uniform(rhs);
+            tt::affine_transform(lhs, lhs, 2, -1);
+            tt::affine_transform(rhs, rhs, 2, -1);
+
+            cpu::int8_weights qweights;
+            qweights.quantize(rhs, true);
+            resizable_tensor dest(lhs.num_samples(), rhs.k());
+            gemm(dest, lhs, qweights, min(mat(lhs)), max(mat(lhs)));
+
+            resizable_tensor qlhs = lhs, qrhs = rhs;
+            round_data_like_int8(qlhs, min(mat(lhs)), max(mat(lhs)));
+            // Each column of rhs is rounded on its own.
+            round_rows_like_int8(qrhs.host(), rhs.k(), rhs.num_samples(), 1, rhs.k());
+            const matrix<float> expected = mat(qlhs)*mat(qrhs);
+            DLIB_TEST_MSG(max(abs(mat(dest)-expected))/max(abs(expected)) < 1e-5, max(abs(mat(dest)-expected))/max(abs(expected)));
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     void test_max_pool(
@@ -3058,6 +3385,335 @@ namespace
     }
 
 
+    template <typename T>
+    std::string serialized_tag(const T& item)
+    {
+        std::ostringstream sout;
+        serialize(item, sout);
+        std::istringstream sin(sout.str());
+        std::string tag;
+        deserialize(tag, sin);
+        return tag;
+    }
+
+    void test_fuse_layers()
+    {
+        print_spinner();
+
+        // The relu<affine<con>>> blocks get fused completely.  The affine<con> blocks in
+        // the residual blocks only get their affine fused, since their relu comes after
+        // the add_prev.
+        using bn_net_type = fc<5,relu<bn_con<con<6,3,3,1,1,res<res_down<relu<bn_con<con<8,5,5,2,2,input<matrix<float>>>>>>>>>>>;
+        using net_type    = fc<5,relu<affine<con<6,3,3,1,1,ares<ares_down<relu<affine<con<8,5,5,2,2,input<matrix<float>>>>>>>>>>>;
+
+        std::vector<matrix<float>> samples;
+        for (int i = 0; i < 4; ++i)
+            samples.push_back(matrix_cast<float>(randm(24,27)*2-1));
+
+        // Give the network random parameters and let the bn_ layers learn some running
+        // statistics so the affine_ layers aren't identity transformations.
+        bn_net_type bnet;
+        bnet(samples.begin(), samples.end());
+        tt::tensor_rand rnd(0);
+        visit_layer_parameters(bnet, [&](size_t, tensor& t)
+        {
+            rnd.fill_uniform(t);
+            tt::affine_transform(t, t, 2, -1);
+        });
+        for (int i = 0; i < 3; ++i)
+            bnet(samples.begin(), samples.end());
+
+        net_type net = bnet;
+        resizable_tensor x;
+        net.to_tensor(samples.begin(), samples.end(), x);
+        const matrix<float> expected = mat(net.forward(x));
+
+        // Layers that aren't fused are saved in the old formats, so older code can
+        // still read them.
+        DLIB_TEST(serialized_tag(layer<1>(net).layer_details()) == "relu_");
+        DLIB_TEST(serialized_tag(layer<2>(net).layer_details()) == "affine_");
+        DLIB_TEST(serialized_tag(layer<3>(net).layer_details()) == "con_4");
+
+        fuse_layers(net);
+        DLIB_TEST(layer<1>(net).layer_details().is_disabled());
+        DLIB_TEST(layer<2>(net).layer_details().is_disabled());
+        DLIB_TEST(layer<3>(net).layer_details().relu_is_enabled());
+        const matrix<float> fused = mat(net.forward(x));
+        DLIB_TEST_MSG(max(abs(fused-expected)) < 1e-5*max(abs(expected)), max(abs(fused-expected)));
+
+        // Fusing again doesn't change anything.
+        fuse_layers(net);
+        DLIB_TEST(max(abs(mat(net.forward(x))-fused)) == 0);
+
+        std::ostringstream sout;
+        serialize(net, sout);
+        std::istringstream sin(sout.str());
+        net_type net2;
+        deserialize(net2, sin);
+        DLIB_TEST(layer<1>(net2).layer_details().is_disabled());
+        DLIB_TEST(layer<3>(net2).layer_details().relu_is_enabled());
+        DLIB_TEST(max(abs(mat(net2.forward(x))-fused)) == 0);
+
+        DLIB_TEST(serialized_tag(layer<1>(net).layer_details()) == "relu_2");
+        DLIB_TEST(serialized_tag(layer<2>(net).layer_details()) == "affine_2");
+        DLIB_TEST(serialized_tag(layer<3>(net).layer_details()) == "con_5");
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    template <typename net_type>
+    void check_activation_reuse(
+        net_type& net
+    )
+    {
+        // Change the input size between passes so the buffers have to grow and shrink.
+        std::vector<std::vector<matrix<float>>> samples(4);
+        for (int pass = 0; pass < 4; ++pass)
+        {
+            for (int i = 0; i < 3; ++i)
+                samples[pass].push_back(matrix_cast<float>(randm(20+pass%2*6, 23+pass%2*3)*2-1));
+        }
+
+        // Run the network once so the copy gets the same parameters.
+        net(samples[0].begin(), samples[0].end());
+        net_type plain = net;
+        enable_activation_reuse(net);
+        for (int pass = 0; pass < 4; ++pass)
+        {
+            const matrix<float> expected = mat(plain(samples[pass].begin(), samples[pass].end()));
+            DLIB_TEST(max(abs(mat(net(samples[pass].begin(), samples[pass].end()))-expected)) == 0);
+        }
+    }
+
+    void test_activation_reuse()
+    {
+        print_spinner();
+
+        using chain_net_type = fc<3,avg_pool_everything<relu<con<6,3,3,1,1,max_pool<2,2,2,2,relu<bn_con<con<8,5,5,1,1,input<matrix<float>>>>>>>>>>;
+        chain_net_type chain;
+        check_activation_reuse(chain);
+        // The max_pool output was released once the con above it ran, only the output of
+        // the network is kept.
+        DLIB_TEST(layer<4>(chain).get_output().size() == 0);
+        DLIB_TEST(chain.get_output().size() != 0);
+        // Once the sizes are known each output gets the smallest buffer that fits it,
+        // rather than one the size of the biggest activation.
+        const size_t output_capacity = dynamic_cast<const resizable_tensor&>(chain.get_output()).capacity();
+        DLIB_TEST_MSG(output_capacity < 100, output_capacity);
+
+        disable_activation_reuse(chain);
+        resizable_tensor x;
+        matrix<float> img = matrix_cast<float>(randm(20,20));
+        chain.to_tensor(&img, &img+1, x);
+        chain.forward(x);
+        DLIB_TEST(layer<4>(chain).get_output().size() != 0);
+
+        // Networks whose outputs are also read through tags, skips and concats, with the
+        // residual blocks inside a repeat layer.
+        using res_net_type = fc<5,avg_pool_everything<repeat<2,res,res_down<relu<con<8,3,3,1,1,input<matrix<float>>>>>>>>;
+        res_net_type res_net;
+        check_activation_reuse(res_net);
+        using incept_net_type = fc<4,avg_pool_everything<concat_incept<relu<con<6,3,3,1,1,input<matrix<float>>>>>>>;
+        incept_net_type incept_net;
+        check_activation_reuse(incept_net);
+
+        // The loss layer reads the output of the network after the pass is over.
+        using loss_net_type = loss_multiclass_log<chain_net_type>;
+        std::vector<matrix<float>> samples;
+        for (int i = 0; i < 5; ++i)
+            samples.push_back(matrix_cast<float>(randm(22,22)));
+        loss_net_type net;
+        net(samples);
+        loss_net_type plain = net;
+        enable_activation_reuse(net);
+        for (int pass = 0; pass < 2; ++pass)
+            DLIB_TEST(net(samples) == plain(samples));
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_quantize_layers()
+    {
+        print_spinner();
+
+        using net_type = fc<5,relu<con<6,3,3,1,1,max_pool<2,2,2,2,relu<con<8,5,5,2,2,input<matrix<float>>>>>>>>;
+        std::vector<matrix<float>> samples;
+        for (int i = 0; i < 8; ++i)
+            samples.push_back(matrix_cast<float>(randm(30,33)));
+
+        net_type net;
+        net(samples.begin(), samples.end());
+        net_type qnet = net;
+        quantize_layers(qnet, samples.begin(), samples.end());
+        DLIB_TEST(layer<0>(qnet).layer_details().is_quantized());
+        // 3x3 filters with a stride of 1 are faster in float.
+        DLIB_TEST(!layer<2>(qnet).layer_details().is_quantized());
+        DLIB_TEST(layer<5>(qnet).layer_details().is_quantized());
+        DLIB_TEST(!layer<0>(net).layer_details().is_quantized());
+
+        // Quantized layers keep only their biases as floats.
+        DLIB_TEST(layer<0>(qnet).layer_details().get_layer_params().size() == 5);
+        DLIB_TEST(layer<5>(qnet).layer_details().get_layer_params().size() == 8);
+        DLIB_TEST(layer<2>(qnet).layer_details().get_layer_params().size() == layer<2>(net).layer_details().get_layer_params().size());
+
+        // The input range of the first layer is the range of the samples, the other
+        // layers get the output of a relu.
+        float lo = min(samples[0]), hi = max(samples[0]);
+        for (auto& s : samples)
+        {
+            lo = std::min(lo, min(s));
+            hi = std::max(hi, max(s));
+        }
+        DLIB_TEST(layer<5>(qnet).layer_details().get_quantized_input_min() == lo);
+        DLIB_TEST(layer<5>(qnet).layer_details().get_quantized_input_max() == hi);
+        DLIB_TEST(layer<0>(qnet).layer_details().get_quantized_input_min() >= 0);
+
+        const matrix<double,1,3> err = test_quantization(net, qnet, samples.begin(), samples.end());
+        DLIB_TEST_MSG(0 < err(0) && err(0) < 0.02, err);
+        DLIB_TEST(err(0) <= err(1));
+
+        // Only the quantized layers need the newer formats.
+        DLIB_TEST(serialized_tag(layer<0>(net).layer_details()) == "fc_2");
+        DLIB_TEST(serialized_tag(layer<5>(net).layer_details()) == "con_4");
+        DLIB_TEST(serialized_tag(layer<0>(qnet).layer_details()) == "fc_3");
+        DLIB_TEST(serialized_tag(layer<5>(qnet).layer_details()) == "con_6");
+
+        // A weight takes one byte on disk instead of four.
+        std::ostringstream qout, fout;
+        serialize(layer<0>(qnet).layer_details(), qout);
+        serialize(layer<0>(net).layer_details(), fout);
+        DLIB_TEST_MSG(qout.str().size() < fout.str().size()/3, qout.str().size() << " " << fout.str().size());
+
+        std::ostringstream sout;
+        serialize(qnet, sout);
+        std::istringstream sin(sout.str());
+        net_type net2;
+        deserialize(net2, sin);
+        DLIB_TEST(layer<5>(net2).layer_details().is_quantized());
+        DLIB_TEST(layer<5>(net2).layer_details().get_quantized_input_max() == layer<5>(qnet).layer_details().get_quantized_input_max());
+        resizable_tensor x;
+        qnet.to_tensor(samples.begin(), samples.end(), x);
+        const matrix<float> quantized = mat(qnet.forward(x));
+        DLIB_TEST(max(abs(mat(net2.forward(x))-quantized)) == 0);
+
+        // Calibrating a quantized network again starts from its rounded weights.  They
+        // round to themselves, but the input ranges are measured with them, so the
+        // outputs move by about as much as quantizing does.
+        quantize_layers(qnet, samples.begin(), samples.end());
+        DLIB_TEST_MSG(max(abs(mat(qnet.forward(x))-quantized)) <= 0.02*max(abs(quantized)),
+            max(abs(mat(qnet.forward(x))-quantized))/max(abs(quantized)));
+
+        // Putting a layer back to float gives its rounded weights.
+        auto fc_layer = layer<0>(qnet).layer_details();
+        fc_layer.disable_quantization();
+        DLIB_TEST(fc_layer.get_layer_params().size() == layer<0>(net).layer_details().get_layer_params().size());
+        const matrix<float> w = mat(layer<0>(net).layer_details().get_weights());
+        DLIB_TEST(max(abs(mat(fc_layer.get_weights())-w)) <= max(abs(w))/254*1.0001);
+        DLIB_TEST(mat(fc_layer.get_biases()) == mat(layer<0>(net).layer_details().get_biases()));
+
+        // A network with a loss layer and residual blocks inside a repeat layer.
+        using res_net_type = loss_multiclass_log<fc<5,avg_pool_everything<repeat<2,res,res_down<relu<con<8,3,3,1,1,input<matrix<float>>>>>>>>>;
+        res_net_type rnet;
+        rnet(samples);
+        res_net_type rqnet = rnet;
+        quantize_layers(rqnet, samples.begin(), samples.end());
+        const matrix<double,1,3> rerr = test_quantization(rnet, rqnet, samples.begin(), samples.end());
+        DLIB_TEST_MSG(0 < rerr(0) && rerr(0) < 0.05, rerr);
+
+        // A con_ layer with a single filter is left in float.
+        using small_net_type = con<1,5,5,1,1,relu<con<4,5,5,1,1,input<matrix<float>>>>>;
+        small_net_type snet;
+        snet(samples.begin(), samples.end());
+        quantize_layers(snet, samples.begin(), samples.end());
+        DLIB_TEST(!layer<0>(snet).layer_details().is_quantized());
+        DLIB_TEST(layer<2>(snet).layer_details().is_quantized());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_tiled_detector()
+    {
+        print_spinner();
+
+        using net_type = loss_mmod<con<1,5,5,1,1,relu<con<4,3,3,1,1,relu<con<4,5,5,2,2,relu<con<4,3,3,2,2,
+            input_rgb_image_pyramid<pyramid_down<2>>>>>>>>>>;
+        mmod_options opts;
+        opts.detector_windows.push_back(mmod_options::detector_window_details(40,40));
+        net_type net(opts);
+
+        dlib::rand rnd;
+        matrix<rgb_pixel> img(130,170);
+        for (auto& p : img)
+            p = rgb_pixel(rnd.get_random_8bit_number(), rnd.get_random_8bit_number(), rnd.get_random_8bit_number());
+
+        // A low threshold so the untrained network finds lots of detections.
+        const double adjust_threshold = -1000;
+        const std::vector<mmod_rect> expected = net.process(img, adjust_threshold);
+        DLIB_TEST(expected.size() > 5);
+
+        thread_pool tp(2);
+        thread_pool inline_tp(0);
+        tiled_detector<net_type> detector(net);
+        for (long tile_size : {4, 13, 32, 100, 512})
+        {
+            detector.set_tile_size(tile_size);
+            DLIB_TEST(detector.get_tile_size() == tile_size);
+            DLIB_TEST(detector(img, tp, adjust_threshold) == expected);
+            DLIB_TEST(detector(img, inline_tp, adjust_threshold) == expected);
+        }
+
+        // Quantized networks give the same answer in tiles too.
+        std::vector<matrix<rgb_pixel>> samples(1, img);
+        quantize_layers(net, samples.begin(), samples.end());
+        tiled_detector<net_type> qdetector(net, 32);
+        DLIB_TEST(qdetector(img, tp, adjust_threshold) == net.process(img, adjust_threshold));
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_embedding_extractor()
+    {
+        print_spinner();
+
+        using net_type = loss_metric<fc_no_bias<8,avg_pool_everything<relu<con<6,3,3,2,2,
+            relu<con<5,3,3,1,1,input_rgb_image_sized<16>>>>>>>>;
+        net_type net;
+
+        dlib::rand rnd;
+        std::vector<matrix<rgb_pixel>> chips(37, matrix<rgb_pixel>(16,16));
+        for (auto& chip : chips)
+        {
+            for (auto& p : chip)
+                p = rgb_pixel(rnd.get_random_8bit_number(), rnd.get_random_8bit_number(), rnd.get_random_8bit_number());
+        }
+        const std::vector<matrix<float,0,1>> expected = net(chips);
+
+        embedding_extractor<net_type> extractor(net, 5);
+        DLIB_TEST(extractor.get_batch_size() == 5);
+        auto check = [&](const std::vector<matrix<float,0,1>>& embeddings)
+        {
+            DLIB_TEST(embeddings.size() == expected.size());
+            for (size_t i = 0; i < expected.size() && i < embeddings.size(); ++i)
+                DLIB_TEST(max(abs(embeddings[i]-expected[i])) < 1e-5);
+        };
+        for (unsigned long batch_size : {1, 5, 8, 37, 100})
+        {
+            extractor.set_batch_size(batch_size);
+            check(extractor(chips));
+        }
+
+        // The inputs and outputs can be streamed through any iterators.
+        const std::list<matrix<rgb_pixel>> chip_list(chips.begin(), chips.end());
+        std::vector<matrix<float,0,1>> embeddings;
+        extractor.set_batch_size(16);
+        extractor(chip_list.begin(), chip_list.end(), std::back_inserter(embeddings));
+        check(embeddings);
+
+        DLIB_TEST(extractor(std::vector<matrix<rgb_pixel>>()).size() == 0);
+    }
+
+// ----------------------------------------------------------------------------------------
+
     void test_serialization()
     {
         print_spinner();
@@ -3208,6 +3864,9 @@ namespace
             test_copy_tensor_add_to_gpu();
             test_scale_channels();
 #endif
+            test_conv_cpu();
+            test_conv_cpu_winograd();
+            test_conv_cpu_int8();
             test_tensor_resize_bilinear(2, 3, 6,6, 11, 11);
             test_tensor_resize_bilinear(2, 3, 6,6, 3, 4);
             test_tensor_resize_bilinear(2, 3, 5,6, 12, 21);
@@ -3258,6 +3917,11 @@ namespace
             test_loss_multiclass_per_pixel_with_noise_and_pixels_to_ignore();
             test_loss_multiclass_per_pixel_weighted();
             test_serialization();
+            test_fuse_layers();
+            test_activation_reuse();
+            test_quantize_layers();
+            test_tiled_detector();
+            test_embedding_extractor();
             test_loss_dot();
             test_loss_multimulticlass_log();
         }
@@ -4,15 +4,21 @@
 #include "tester.h"
 #include <dlib/image_processing/frontal_face_detector.h>
 #include <dlib/image_processing.h>
+#include <dlib/image_processing/fixed_point_fhog.h>
 #include <vector>
 #include <sstream>
 #include <dlib/compress_stream.h>
 #include <dlib/base64.h>
 #include <dlib/image_io.h>
+#include <fstream>
+#include <cstdlib>
+#ifdef __GLIBC__
+#include <mcheck.h>
+#include <unistd.h>
+#endif
 
 //#include <dlib/gui_widgets.h>
 //#include <dlib/image_processing/render_face_detections.h>
-
 namespace  
 {
     using namespace test;
@@ -48,8 +54,915 @@ namespace
             deserialize(objects[0], sin);
         }
 
+        double max_part_distance (
+            const full_object_detection& a,
+            const full_object_detection& b
+        )
+        {
+            DLIB_TEST(a.num_parts() == b.num_parts());
+            double dist = 0;
+            for (unsigned long k = 0; k < a.num_parts(); ++k)
+                dist = std::max(dist, length(a.part(k) - b.part(k)));
+            return dist;
+        }
+
+        template <typename image_type>
+        void test_packed_feature_extraction (
+            const image_type& img,
+            dlib::rand& rnd
+        )
+        {
+            print_spinner();
+            using namespace dlib::impl;
+            // 5 parts so the anchors get exercised, 403 pixels so the SIMD loop has a
+            // scalar tail.
+            matrix<float,0,1> reference_shape(10), current_shape(10);
+            std::vector<dlib::vector<float,2> > pixel_coordinates(403);
+            unsigned long num_zero = 0;
+            for (long trial = 0; trial < 20; ++trial)
+            {
+                for (long i = 0; i < reference_shape.size(); ++i)
+                {
+                    reference_shape(i) = rnd.get_random_float();
+                    current_shape(i) = reference_shape(i) + 0.2*rnd.get_random_gaussian();
+                }
+                // Spread the pixels well beyond the face box so some land outside the image.
+                for (unsigned long i = 0; i < pixel_coordinates.size(); ++i)
+                    pixel_coordinates[i] = dlib::vector<float,2>(3*rnd.get_random_float()-1, 3*rnd.get_random_float()-1);
+
+                std::vector<unsigned long> anchor_idx;
+                std::vector<dlib::vector<float,2> > deltas;
+                create_shape_relative_encoding(reference_shape, pixel_coordinates, anchor_idx, deltas);
+                packed_pixel_encoding packed;
+                pack_shape_relative_encoding(anchor_idx, deltas, packed);
+
+                const rectangle rect = centered_rect(get_rect(img), num_columns(img)/2, num_rows(img)/2);
+                std::vector<float> truth, vals;
+                extract_feature_pixel_values(img, rect, current_shape, reference_shape, anchor_idx, deltas, truth);
+                extract_feature_pixel_values(img, rect, current_shape, reference_shape, packed, vals);
+                DLIB_TEST(vals.size() == truth.size());
+                for (unsigned long i = 0; i < vals.size(); ++i)
+                {
+                    DLIB_TEST_MSG(vals[i] == truth[i], i << ": " << vals[i] << " " << truth[i]);
+                    if (truth[i] == 0)
+                        ++num_zero;
+                }
+            }
+            // make sure we really did sample outside the image
+            DLIB_TEST(num_zero > 0);
+        }
+
+        void test_packed_feature_extraction (
+        )
+        {
+            dlib::rand rnd;
+            array2d<unsigned char> gray(61, 77);
+            array2d<rgb_pixel> color(gray.nr(), gray.nc());
+            for (long r = 0; r < gray.nr(); ++r)
+            {
+                for (long c = 0; c < gray.nc(); ++c)
+                {
+                    // keep pixels non-zero so out of image reads are easy to spot
+                    gray[r][c] = 1 + rnd.get_random_8bit_number()%255;
+                    assign_pixel(color[r][c], gray[r][c]);
+                }
+            }
+            test_packed_feature_extraction(gray, rnd);
+            test_packed_feature_extraction(color, rnd);
+        }
+
+        template <typename image_type>
+        full_object_detection double_precision_shape_predictor (
+            const matrix<float,0,1>& initial_shape,
+            const std::vector<std::vector<impl::regression_tree> >& forests,
+            const std::vector<std::vector<unsigned long> >& anchor_idx,
+            const std::vector<std::vector<dlib::vector<float,2> > >& deltas,
+            const image_type& img,
+            const rectangle& rect
+        )
+        /*!
+            ensures
+                - runs a shape_predictor with the feature pixel extraction it had before
+                  it was vectorized, which maps every pixel to the image with a double
+                  precision point_transform_affine.
+        !*/
+        {
+            using namespace impl;
+            const point_transform_affine tform_to_img = unnormalizing_tform(rect);
+            const rectangle area = get_rect(img);
+            matrix<float,0,1> current_shape = initial_shape;
+            std::vector<float> feature_pixel_values;
+            for (unsigned long iter = 0; iter < forests.size(); ++iter)
+            {
+                const matrix<float,2,2> tform = matrix_cast<float>(find_tform_between_shapes(initial_shape, current_shape).get_m());
+                feature_pixel_values.resize(deltas[iter].size());
+                for (unsigned long i = 0; i < feature_pixel_values.size(); ++i)
+                {
+                    point p = tform_to_img(tform*deltas[iter][i] + location(current_shape, anchor_idx[iter][i]));
+                    if (area.contains(p))
+                        feature_pixel_values[i] = get_pixel_intensity(img[p.y()][p.x()]);
+                    else
+                        feature_pixel_values[i] = 0;
+                }
+                unsigned long leaf_idx;
+                for (unsigned long i = 0; i < forests[iter].size(); ++i)
+                    current_shape += forests[iter][i](feature_pixel_values, leaf_idx);
+            }
+
+            std::vector<point> parts(current_shape.size()/2);
+            for (unsigned long i = 0; i < parts.size(); ++i)
+                parts[i] = tform_to_img(location(current_shape, i));
+            return full_object_detection(rect, parts);
+        }
+
+        void test_against_double_precision_reference (
+            const shape_predictor& sp,
+            const dlib::array<array2d<unsigned char> >& images,
+            const std::vector<std::vector<full_object_detection> >& objects
+        )
+        {
+            print_spinner();
+            // Version 1 of the file format is just the predictor's members, so read them
+            // back out of it.
+            ostringstream sout;
+            serialize(sp, sout);
+            istringstream sin(sout.str());
+            int version;
+            matrix<float,0,1> initial_shape;
+            std::vector<std::vector<impl::regression_tree> > forests;
+            std::vector<std::vector<unsigned long> > anchor_idx;
+            std::vector<std::vector<dlib::vector<float,2> > > deltas;
+            deserialize(version, sin);
+            deserialize(initial_shape, sin);
+            deserialize(forests, sin);
+            deserialize(anchor_idx, sin);
+            deserialize(deltas, sin);
+            DLIB_TEST(version == 1);
+
+            // The float pixel mapping rounds differently from the double one when a
+            // feature pixel lands within a rounding error of a pixel boundary.  That can
+            // send a tree down the other branch now and then, so the landmarks must
+            // agree to within a pixel on average and 3 pixels at worst.
+            array2d<rgb_pixel> color;
+            assign_image(color, images[0]);
+            dlib::rand rnd;
+            running_stats<double> rs;
+            double max_dist = 0;
+            for (long trial = 0; trial < 50; ++trial)
+            {
+                const rectangle truth = objects[0][trial%objects[0].size()].get_rect();
+                // jitter the boxes so the faces aren't always where training put them
+                const rectangle rect = centered_rect(center(truth) + point(rnd.get_integer_in_range(-5,6), rnd.get_integer_in_range(-5,6)),
+                                                     truth.width() + rnd.get_integer_in_range(-8,9),
+                                                     truth.height() + rnd.get_integer_in_range(-8,9));
+                const full_object_detection a = sp(images[0], rect);
+                const full_object_detection b = double_precision_shape_predictor(initial_shape, forests, anchor_idx, deltas, images[0], rect);
+                const full_object_detection c = sp(color, rect);
+                const full_object_detection d = double_precision_shape_predictor(initial_shape, forests, anchor_idx, deltas, color, rect);
+                DLIB_TEST(max_part_distance(a, c) == 0);
+                DLIB_TEST(max_part_distance(b, d) == 0);
+                for (unsigned long k = 0; k < a.num_parts(); ++k)
+                {
+                    const double dist = length(a.part(k) - b.part(k));
+                    rs.add(dist);
+                    max_dist = std::max(max_dist, dist);
+                }
+            }
+            dlog << LINFO << "float vs double landmarks, mean distance: " << rs.mean() << "  max distance: " << max_dist;
+            DLIB_TEST_MSG(rs.mean() < 1, rs.mean());
+            DLIB_TEST_MSG(max_dist <= 3, max_dist);
+        }
+
+        void test_threaded_shape_predictor (
+            const shape_predictor& sp,
+            const dlib::array<array2d<unsigned char> >& images,
+            const std::vector<std::vector<full_object_detection> >& objects
+        )
+        {
+            print_spinner();
+            thread_pool tp(3);
+            for (unsigned long i = 0; i < objects.size(); ++i)
+            {
+                for (unsigned long j = 0; j < objects[i].size(); ++j)
+                {
+                    const rectangle rect = objects[i][j].get_rect();
+                    const full_object_detection serial = sp(images[i], rect);
+                    // min_trees_per_thread of 1 forces every level to be split
+                    const full_object_detection threaded = sp(images[i], rect, tp, 1);
+                    DLIB_TEST(threaded.get_rect() == rect);
+                    // Only the order of the float additions changes, so at most a point
+                    // can round to a neighboring pixel.
+                    DLIB_TEST(max_part_distance(serial, threaded) <= 1.5);
+
+                    // A threshold larger than any level runs everything serially.
+                    const full_object_detection unsplit = sp(images[i], rect, tp, 1000000);
+                    DLIB_TEST(max_part_distance(serial, unsplit) == 0);
+                }
+            }
+        }
+
+        void test_extract_part_subset (
+            const shape_predictor& sp,
+            const dlib::array<array2d<unsigned char> >& images,
+            const std::vector<std::vector<full_object_detection> >& objects
+        )
+        {
+            print_spinner();
+            std::vector<unsigned long> all_parts, some_parts;
+            for (unsigned long k = 0; k < sp.num_parts(); ++k)
+            {
+                all_parts.push_back(k);
+                if (k%3 != 0)
+                    some_parts.push_back(k);
+            }
+
+            // Keeping everything must not change anything.
+            const shape_predictor same = extract_part_subset(sp, all_parts);
+            DLIB_TEST(same.num_parts() == sp.num_parts());
+            DLIB_TEST(same.num_features() <= sp.num_features());
+            // Keeping a subset means carrying less.
+            const shape_predictor sub = extract_part_subset(sp, some_parts);
+            DLIB_TEST(sub.num_parts() == some_parts.size());
+            ostringstream sout1, sout2;
+            serialize(sp, sout1);
+            serialize(sub, sout2);
+            DLIB_TEST(sout2.str().size() < sout1.str().size());
+
+            running_stats<double> rs;
+            for (unsigned long i = 0; i < objects.size(); ++i)
+            {
+                for (unsigned long j = 0; j < objects[i].size(); ++j)
+                {
+                    const rectangle rect = objects[i][j].get_rect();
+                    const full_object_detection full = sp(images[i], rect);
+                    DLIB_TEST(max_part_distance(full, same(images[i], rect)) == 0);
+
+                    const full_object_detection part_det = sub(images[i], rect);
+                    DLIB_TEST(part_det.num_parts() == some_parts.size());
+                    for (unsigned long k = 0; k < some_parts.size(); ++k)
+                        rs.add(length(part_det.part(k) - full.part(some_parts[k])));
+                }
+            }
+            dlog << LINFO << "extract_part_subset() mean part error: " << rs.mean();
+            DLIB_TEST_MSG(rs.mean() < 0.05*objects[0][0].get_rect().width(), rs.mean());
+        }
+
+        void test_shape_predictor_pruning (
+            const shape_predictor& sp,
+            const dlib::array<array2d<unsigned char> >& images,
+            const std::vector<std::vector<full_object_detection> >& objects
+        )
+        {
+            print_spinner();
+            // Keeping everything or cutting to the full depth is a no-op.
+            const shape_predictor same = prune_shape_predictor_trees(truncate_shape_predictor_trees(sp, 2), 1);
+            DLIB_TEST(same.num_trees() == sp.num_trees());
+            DLIB_TEST(same.num_features() == sp.num_features());
+            DLIB_TEST(test_shape_predictor(same, images, objects) == 0);
+
+            const shape_predictor half = prune_shape_predictor_trees(sp, 0.5);
+            DLIB_TEST(half.num_trees() == (sp.num_trees()+1)/2);
+            DLIB_TEST(half.num_parts() == sp.num_parts());
+
+            const shape_predictor shallow = truncate_shape_predictor_trees(sp, 1);
+            DLIB_TEST(shallow.num_trees() == sp.num_trees());
+            DLIB_TEST(shallow.num_features() == sp.num_features()/2);
+
+            const shape_predictor none = prune_shape_predictor_trees(sp, 0);
+            DLIB_TEST(none.num_trees() == 0);
+            DLIB_TEST(none.num_parts() == sp.num_parts());
+
+            // The trees we keep are the biggest ones.
+            const std::vector<std::vector<double> > contrib = shape_predictor_tree_contributions(sp);
+            const std::vector<std::vector<double> > half_contrib = shape_predictor_tree_contributions(half);
+            running_stats<double> rs_all, rs_kept;
+            for (unsigned long i = 0; i < contrib.size(); ++i)
+                for (unsigned long j = 0; j < contrib[i].size(); ++j)
+                    rs_all.add(contrib[i][j]);
+            for (unsigned long i = 0; i < half_contrib.size(); ++i)
+                for (unsigned long j = 0; j < half_contrib[i].size(); ++j)
+                    rs_kept.add(half_contrib[i][j]);
+            DLIB_TEST(rs_kept.mean() >= rs_all.mean());
+
+            std::vector<double> fractions = {1, 0.5, 0.1};
+            std::vector<unsigned long> depths = {2, 1};
+            const std::vector<shape_predictor_pruning_result> results =
+                evaluate_shape_predictor_pruning(sp, images, objects, fractions, depths);
+            DLIB_TEST(results.size() == 6);
+            bool found_pareto = false;
+            for (unsigned long i = 0; i < results.size(); ++i)
+            {
+                if (results[i].pareto_optimal)
+                    found_pareto = true;
+                if (results[i].fraction_kept == 1 && results[i].tree_depth == 2)
+                {
+                    DLIB_TEST(results[i].mean_error == 0);
+                    DLIB_TEST(results[i].num_trees == sp.num_trees());
+                }
+                if (i > 0 && results[i].tree_depth == results[i-1].tree_depth)
+                    DLIB_TEST(results[i].model_bytes < results[i-1].model_bytes);
+            }
+            DLIB_TEST(found_pareto);
+
+            ostringstream sout;
+            print_shape_predictor_pruning_report(results, sout);
+            const std::string report = sout.str();
+            dlog << LINFO << "pruning report:\n" << report;
+            DLIB_TEST(std::count(report.begin(), report.end(), '\n') == 7);
+        }
+
+        void test_shape_predictor_serialization (
+            const shape_predictor& sp,
+            const dlib::array<array2d<unsigned char> >& images,
+            const std::vector<std::vector<full_object_detection> >& objects
+        )
+        {
+            print_spinner();
+            ostringstream sout;
+            serialize(sp, sout);
+            istringstream sin(sout.str());
+            shape_predictor sp2;
+            deserialize(sp2, sin);
+            DLIB_TEST(sp2.num_parts() == sp.num_parts());
+            DLIB_TEST(sp2.num_features() == sp.num_features());
+            DLIB_TEST(sp2.num_trees() == sp.num_trees());
+            for (unsigned long i = 0; i < objects[0].size(); ++i)
+            {
+                const rectangle rect = objects[0][i].get_rect();
+                DLIB_TEST(max_part_distance(sp(images[0], rect), sp2(images[0], rect)) == 0);
+            }
+
+            // Version 1 files must still load.  Build a random predictor and write it out
+            // in the old element by element format by hand.
+            dlib::rand rnd;
+            const unsigned long num_parts = 7;
+            matrix<float,0,1> initial_shape(num_parts*2);
+            for (long i = 0; i < initial_shape.size(); ++i)
+                initial_shape(i) = rnd.get_random_float();
+            std::vector<std::vector<impl::regression_tree> > forests(3);
+            std::vector<std::vector<dlib::vector<float,2> > > pixel_coordinates(forests.size());
+            std::vector<std::vector<unsigned long> > anchor_idx(forests.size());
+            std::vector<std::vector<dlib::vector<float,2> > > deltas(forests.size());
+            for (unsigned long iter = 0; iter < forests.size(); ++iter)
+            {
+                pixel_coordinates[iter].resize(30);
+                for (unsigned long i = 0; i < pixel_coordinates[iter].size(); ++i)
+                    pixel_coordinates[iter][i] = dlib::vector<float,2>(rnd.get_random_float(), rnd.get_random_float());
+                forests[iter].resize(5);
+                for (unsigned long t = 0; t < forests[iter].size(); ++t)
+                {
+                    impl::regression_tree& tree = forests[iter][t];
+                    tree.splits.resize(3);
+                    for (unsigned long i = 0; i < tree.splits.size(); ++i)
+                    {
+                        tree.splits[i].idx1 = rnd.get_random_32bit_number()%pixel_coordinates[iter].size();
+                        tree.splits[i].idx2 = rnd.get_random_32bit_number()%pixel_coordinates[iter].size();
+                        tree.splits[i].thresh = 50*rnd.get_random_gaussian();
+                    }
+                    tree.leaf_values.resize(4);
+                    for (unsigned long i = 0; i < tree.leaf_values.size(); ++i)
+                        tree.leaf_values[i] = matrix_cast<float>(0.01*randm(num_parts*2,1,rnd));
+                }
+                impl::create_shape_relative_encoding(initial_shape, pixel_coordinates[iter], anchor_idx[iter], deltas[iter]);
+            }
+            const shape_predictor sp3(initial_shape, forests, pixel_coordinates);
+
+            // 3 levels of 5 trees, each with 3 splits and 4 leaves of 14 floats, plus 30
+            // pixels per level stored both as (anchor, delta) and packed.
+            const size_t payload = 3*5*(3*sizeof(impl::split_feature) + 4*14*sizeof(float)) +
+                                   3*30*(sizeof(unsigned long) + 2*sizeof(float) + sizeof(int32) + 2*sizeof(float));
+            const size_t usage = shape_predictor_memory_usage(sp3);
+            DLIB_TEST_MSG(payload <= usage && usage < 2*payload, usage << " " << payload);
+            DLIB_TEST(shape_predictor_memory_usage(truncate_shape_predictor_trees(sp3, 1)) < usage);
+
+            sout.str("");
+            serialize(1, sout);
+            serialize(initial_shape, sout);
+            serialize(forests, sout);
+            serialize(anchor_idx, sout);
+            serialize(deltas, sout);
+            const std::string v1 = sout.str();
+            sin.clear();
+            sin.str(v1);
+            shape_predictor sp4;
+            deserialize(sp4, sin);
+
+            // serialize() keeps writing the format stock dlib reads
+            sout.str("");
+            serialize(sp4, sout);
+            DLIB_TEST(sout.str() == v1);
+
+            // Version 2 stored each tree as its own pod blocks.
+            sout.str("");
+            serialize(2, sout);
+            serialize(initial_shape, sout);
+            serialize(forests.size(), sout);
+            for (unsigned long iter = 0; iter < forests.size(); ++iter)
+            {
+                serialize(forests[iter].size(), sout);
+                for (unsigned long t = 0; t < forests[iter].size(); ++t)
+                {
+                    serialize_pod_block<uint32>(forests[iter][t].splits, sout);
+                    serialize(forests[iter][t].leaf_values.size(), sout);
+                    for (unsigned long i = 0; i < forests[iter][t].leaf_values.size(); ++i)
+                        serialize_pod_block(&forests[iter][t].leaf_values[i](0), num_parts*2, sout);
+                }
+                serialize_pod_block(std::vector<uint32>(anchor_idx[iter].begin(), anchor_idx[iter].end()), sout);
+                std::vector<float> flat;
+                for (unsigned long i = 0; i < deltas[iter].size(); ++i)
+                {
+                    flat.push_back(deltas[iter][i].x());
+                    flat.push_back(deltas[iter][i].y());
+                }
+                serialize_pod_block(flat, sout);
+            }
+            sin.clear();
+            sin.str(sout.str());
+            shape_predictor sp6;
+            deserialize(sp6, sin);
+
+            sout.str("");
+            serialize_bulk(sp4, sout);
+            const std::string v3 = sout.str();
+            dlog << LINFO << "version 1 bytes: " << v1.size() << "  version 3 bytes: " << v3.size();
+            sin.clear();
+            sin.str(v3);
+            shape_predictor sp5;
+            deserialize(sp5, sin);
+
+            const rectangle rect = centered_rect(get_rect(images[0]), 100, 100);
+            const full_object_detection det = sp3(images[0], rect);
+            DLIB_TEST(max_part_distance(det, sp4(images[0], rect)) == 0);
+            DLIB_TEST(max_part_distance(det, sp5(images[0], rect)) == 0);
+            DLIB_TEST(max_part_distance(det, sp6(images[0], rect)) == 0);
+
+            // a truncated version 3 stream is an error, not a half loaded model
+            sin.clear();
+            sin.str(v3.substr(0, v3.size()/2));
+            bool threw = false;
+            try { deserialize(sp5, sin); } catch (serialization_error&) { threw = true; }
+            DLIB_TEST(threw);
+
+            // So are split features that point past the feature pixels and trees with
+            // the wrong number of leaves.
+            std::vector<std::vector<impl::regression_tree> > bad_forests = forests;
+            bad_forests[2][4].splits[1].idx2 = pixel_coordinates[2].size();
+            DLIB_TEST(!deserializes_cleanly(shape_predictor(initial_shape, bad_forests, pixel_coordinates)));
+            bad_forests = forests;
+            bad_forests[1][0].leaf_values.pop_back();
+            DLIB_TEST(!deserializes_cleanly(shape_predictor(initial_shape, bad_forests, pixel_coordinates)));
+            bad_forests = forests;
+            bad_forests[1][0].splits.push_back(bad_forests[1][0].splits.back());
+            bad_forests[1][0].leaf_values.push_back(bad_forests[1][0].leaf_values.back());
+            DLIB_TEST(!deserializes_cleanly(shape_predictor(initial_shape, bad_forests, pixel_coordinates)));
+            DLIB_TEST(deserializes_cleanly(sp3));
+        }
+
+        bool deserializes_cleanly (
+            const shape_predictor& sp
+        )
+        {
+            ostringstream sout;
+            serialize_bulk(sp, sout);
+            istringstream sin(sout.str());
+            shape_predictor temp;
+            try { deserialize(temp, sin); } catch (serialization_error&) { return false; }
+            return true;
+        }
+
+        void test_incremental_detection (
+            frontal_face_detector& detector,
+            const array2d<unsigned char>& img,
+            const std::vector<rectangle>& dets
+        )
+        {
+            print_spinner();
+            thread_pool tp(3);
+
+            // Shift the frame a little, the way a face moves between two video frames.
+            const long dx = 9, dy = -6;
+            array2d<unsigned char> moved(img.nr(), img.nc());
+            assign_all_pixels(moved, 0);
+            for (long r = std::max(0L,dy); r < std::min(img.nr(), img.nr()+dy); ++r)
+            {
+                for (long c = std::max(0L,dx); c < std::min(img.nc(), img.nc()+dx); ++c)
+                    moved[r][c] = img[r-dy][c-dx];
+            }
+            const std::vector<rectangle> moved_dets = detector(moved);
+            DLIB_TEST(moved_dets.size() == dets.size());
+
+            for (unsigned long i = 0; i < dets.size(); ++i)
+            {
+                // Searching around each face has to find it again, and nothing else.
+                std::vector<rect_detection> near, near_threaded;
+                detect_near(detector, img, dets[i], 0.5, 1, near);
+                detect_near(detector, img, dets[i], 0.5, 1, near_threaded, tp);
+                DLIB_TEST(near.size() == 1);
+                DLIB_TEST(box_intersection_over_union(near[0].rect, dets[i]) > 0.7);
+                DLIB_TEST(near_threaded.size() == near.size());
+                for (unsigned long j = 0; j < near.size(); ++j)
+                {
+                    DLIB_TEST(near_threaded[j].rect == near[j].rect);
+                    DLIB_TEST(near_threaded[j].detection_confidence == near[j].detection_confidence);
+                }
+
+                // and follow it after it has moved.
+                detect_near(detector, moved, dets[i], 0.5, 1, near);
+                DLIB_TEST(near.size() == 1);
+                DLIB_TEST(box_intersection_over_union(near[0].rect, translate_rect(dets[i], point(dx,dy))) > 0.7);
+
+                // With no room to move, a face whose center is elsewhere isn't found.
+                detect_near(detector, moved, translate_rect(dets[i], point(60,0)), 0, 1, near);
+                DLIB_TEST(near.size() == 0);
+            }
+
+            incremental_object_detector<pyramid_down<6> > inc(detector);
+            inc.set_full_scan_interval(3);
+            DLIB_TEST(!inc.has_prior());
+
+            std::vector<rectangle> found = inc(img);
+            DLIB_TEST(inc.last_was_full_scan());
+            DLIB_TEST(found == dets);
+            DLIB_TEST(inc.has_prior() && inc.get_prior() == dets[0]);
+
+            // the next two frames only look around the strongest face
+            found = inc(moved);
+            DLIB_TEST(!inc.last_was_full_scan());
+            DLIB_TEST(found.size() == 1);
+            DLIB_TEST(box_intersection_over_union(found[0], translate_rect(dets[0], point(dx,dy))) > 0.7);
+            found = inc(img);
+            DLIB_TEST(!inc.last_was_full_scan());
+            DLIB_TEST(found.size() == 1);
+
+            // then the interval forces a full scan
+            found = inc(moved);
+            DLIB_TEST(inc.last_was_full_scan());
+            DLIB_TEST(found == moved_dets);
+
+            // A miss falls back to scanning the whole frame right away.
+            array2d<unsigned char> blank(img.nr(), img.nc());
+            assign_all_pixels(blank, 128);
+            found = inc(img);
+            DLIB_TEST(!inc.last_was_full_scan());
+            found = inc(blank);
+            DLIB_TEST(inc.last_was_full_scan());
+            DLIB_TEST(found.size() == 0);
+            DLIB_TEST(!inc.has_prior());
+            found = inc(img);
+            DLIB_TEST(inc.last_was_full_scan());
+            DLIB_TEST(found == dets);
+
+            inc.reset();
+            DLIB_TEST(!inc.has_prior());
+            inc(img);
+            DLIB_TEST(inc.last_was_full_scan());
+        }
+
+        void test_cascaded_detection (
+            frontal_face_detector& detector,
+            const dlib::array<array2d<unsigned char> >& images
+        )
+        {
+            print_spinner();
+            std::vector<rect_detection> plain, cascaded;
+
+            // Until it is calibrated the cascade is off and must match the detector.
+            cascaded_fhog_detector<pyramid_down<6> > cascade(detector);
+            DLIB_TEST(cascade.num_detectors() == detector.num_detectors());
+            detector(images[0], plain, -0.3);
+            cascade(images[0], cascaded, -0.3);
+            DLIB_TEST(plain.size() == cascaded.size());
+            for (unsigned long i = 0; i < plain.size(); ++i)
+            {
+                DLIB_TEST(cascaded[i].rect == plain[i].rect);
+                DLIB_TEST(cascaded[i].detection_confidence == plain[i].detection_confidence);
+            }
+
+            // Once calibrated it rejects most windows early but still finds the same
+            // faces, with the same scores.
+            const fhog_cascade_report report = cascade.calibrate(images, -0.3);
+            DLIB_TEST(report.num_images == images.size());
+            DLIB_TEST(report.num_positive_windows > 0);
+            DLIB_TEST(report.fraction_of_windows_scored < 0.5);
+            dlog << LINFO << "cascade passes " << report.fraction_of_windows_scored << " of the windows, seconds per image: "
+                 << report.seconds_per_image_without_cascade << " without and " << report.seconds_per_image_with_cascade << " with it";
+            for (unsigned long i = 0; i < images.size(); ++i)
+            {
+                detector(images[i], plain, -0.3);
+                cascade(images[i], cascaded, -0.3);
+                DLIB_TEST(plain.size() == cascaded.size());
+                for (unsigned long j = 0; j < plain.size() && j < cascaded.size(); ++j)
+                {
+                    DLIB_TEST(cascaded[j].rect == plain[j].rect);
+                    DLIB_TEST(cascaded[j].detection_confidence == plain[j].detection_confidence);
+                }
+            }
+            DLIB_TEST(cascade(images[0]) == detector(images[0]));
+
+            // A stage that rejects nothing sends every row through the bands, which must
+            // score each window exactly like filtering the whole level does.
+            typedef scan_fhog_pyramid<pyramid_down<6> > scanner_type;
+            scanner_type scanner;
+            scanner.copy_configuration(detector.get_scanner());
+            scanner_type::fhog_filterbank fb = detector.get_processed_w(0).get_detect_argument();
+            fb.set_cascade(3, -1e30);
+            DLIB_TEST(fb.uses_cascade());
+            DLIB_TEST(fb.get_num_cascade_components() == 3);
+            std::vector<std::pair<double, rectangle> > plain_dets, banded_dets;
+            for (unsigned long i = 0; i < images.size(); ++i)
+            {
+                scanner.load(images[i]);
+                scanner.detect(detector.get_processed_w(0).get_detect_argument(), plain_dets, -1);
+                scanner.detect(fb, banded_dets, -1);
+                DLIB_TEST(plain_dets.size() > 0);
+                DLIB_TEST(banded_dets == plain_dets);
+            }
+            fb.disable_cascade();
+            DLIB_TEST(!fb.uses_cascade());
+
+            std::ostringstream sout;
+            serialize(cascade, sout);
+            cascaded_fhog_detector<pyramid_down<6> > cascade2;
+            std::istringstream sin(sout.str());
+            deserialize(cascade2, sin);
+            DLIB_TEST(cascade2.get_num_stage_components() == cascade.get_num_stage_components());
+            for (unsigned long d = 0; d < cascade.num_detectors(); ++d)
+                DLIB_TEST(cascade2.get_rejection_threshold(d) == cascade.get_rejection_threshold(d));
+            DLIB_TEST(cascade2(images[0]) == cascade(images[0]));
+        }
+
+        void test_detection_reuses_memory (
+            frontal_face_detector& detector,
+            const dlib::array<array2d<unsigned char> >& images
+        )
+        {
+            print_spinner();
+            std::vector<rect_detection> dets, dets2;
+            // The first calls size the buffers for this image and for dets.  Going
+            // through an image of another size in between must not break anything.
+            array2d<unsigned char> small_img(images[0].nr()/2, images[0].nc()/2);
+            resize_image(images[0], small_img);
+            detector(images[0], dets);
+            detector(small_img, dets2);
+            detector(images[0], dets2);
+            DLIB_TEST(dets2.size() == dets.size());
+
+            detector(images[0], dets2);
+            DLIB_TEST(dets2.size() == dets.size());
+            for (unsigned long i = 0; i < dets.size(); ++i)
+            {
+                DLIB_TEST(dets2[i].rect == dets[i].rect);
+                DLIB_TEST(dets2[i].detection_confidence == dets[i].detection_confidence);
+                DLIB_TEST(dets2[i].weight_index == dets[i].weight_index);
+            }
+
+            // Scanning another image of the same size must work in the memory left by
+            // the previous one, so none of the buffers may move.
+            typedef frontal_face_detector::image_scanner_type scanner_type;
+            const scanner_type& scanner = detector.get_scanner();
+            const scanner_type::fhog_filterbank fb = scanner.build_fhog_filterbank(detector.get_w(0));
+            const long height = scanner.get_fhog_window_height();
+            const long width = scanner.get_fhog_window_width();
+            dlib::array<dlib::array<array2d<float> > > feats;
+            impl::fhog_pyramid_buffers buffers;
+            std::vector<std::pair<double, rectangle> > raw_dets;
+            std::vector<const void*> ptrs, ptrs2;
+            for (int iter = 0; iter < 2; ++iter)
+            {
+                impl::create_fhog_pyramid<pyramid_down<6> >(images[0], default_fhog_feature_extractor(),
+                    feats, scanner.get_cell_size(), height, width, scanner.get_min_pyramid_layer_width(),
+                    scanner.get_min_pyramid_layer_height(), scanner.get_max_pyramid_levels(), 0, buffers);
+                impl::detect_from_fhog_pyramid<pyramid_down<6> >(feats, default_fhog_feature_extractor(),
+                    fb, -0.5, height-2*scanner.get_padding(), width-2*scanner.get_padding(),
+                    scanner.get_cell_size(), height, width, raw_dets, buffers);
+
+                std::vector<const void*>& p = (iter == 0) ? ptrs : ptrs2;
+                const dlib::array<array2d<unsigned char> >& level_images = buffers.images<unsigned char>();
+                for (unsigned long l = 0; l < feats.size(); ++l)
+                {
+                    if (l > 0)
+                        p.push_back(&level_images[l][0][0]);
+                    p.push_back(&feats[l][0][0][0]);
+                    p.push_back(&buffers.extractor_scratch[l].hist[0][0]);
+                    p.push_back(&buffers.saliency_images[l][0][0]);
+                }
+            }
+            DLIB_TEST(ptrs.size() > 0);
+            DLIB_TEST(ptrs == ptrs2);
+
+            // The const detect() works in its own memory but must find the same windows.
+            scanner_type scanner2;
+            scanner2.copy_configuration(scanner);
+            scanner2.load(images[0]);
+            std::vector<std::pair<double, rectangle> > const_dets;
+            scanner2.detect(fb, raw_dets, -0.5);
+            static_cast<const scanner_type&>(scanner2).detect(fb, const_dets, -0.5);
+            DLIB_TEST(raw_dets.size() > 0);
+            DLIB_TEST(const_dets == raw_dets);
+        }
+
+#ifdef __GLIBC__
+        // mtrace() logs every malloc() to the file named by the MALLOC_TRACE environment
+        // variable, which lets us count allocations without replacing operator new.
+        // Since glibc 2.34 it only does so when libc_malloc_debug.so is preloaded.
+        unsigned long count_traced_allocations (
+        )
+        {
+            std::ifstream fin(getenv("MALLOC_TRACE"));
+            std::string line;
+            unsigned long num = 0;
+            while (std::getline(fin, line))
+            {
+                if (line.find(" + ") != std::string::npos)
+                    ++num;
+            }
+            return num;
+        }
+
+        bool malloc_tracing_works (
+        )
+        {
+            if (getenv("MALLOC_TRACE") == 0)
+                return false;
+            mtrace();
+            void* volatile ptr = malloc(16);
+            free(ptr);
+            muntrace();
+            return count_traced_allocations() > 0;
+        }
+
+        template <typename detector_type, typename image_type>
+        unsigned long count_detection_allocations (
+            detector_type& detector,
+            const image_type& img,
+            thread_pool* tp
+        )
+        {
+            std::vector<rect_detection> dets;
+            // The first call sizes the buffers and dets, the second must reuse them.
+            if (tp) detector(img, dets, *tp); else detector(img, dets);
+            mtrace();
+            if (tp) detector(img, dets, *tp); else detector(img, dets);
+            muntrace();
+            return count_traced_allocations();
+        }
+
+        void test_detection_allocations (
+            const frontal_face_detector& face_detector
+        )
+        {
+            print_spinner();
+            array2d<unsigned char> img(240, 320);
+            dlib::rand rnd;
+            for (long r = 0; r < img.nr(); ++r)
+            {
+                for (long c = 0; c < img.nc(); ++c)
+                    img[r][c] = rnd.get_random_8bit_number();
+            }
+            array2d<rgb_pixel> rgb_img;
+            assign_image(rgb_img, img);
+            thread_pool tp(3);
+
+            frontal_face_detector detector6 = face_detector;
+            DLIB_TEST(count_detection_allocations(detector6, img, 0) == 0);
+            DLIB_TEST(count_detection_allocations(detector6, rgb_img, 0) == 0);
+            DLIB_TEST(count_detection_allocations(detector6, img, &tp) == 0);
+
+            typedef scan_fhog_pyramid<pyramid_down<3> > scanner3_type;
+            scanner3_type scanner3;
+            scanner3.set_detection_window_size(80, 80);
+            object_detector<scanner3_type> detector3(scanner3, face_detector.get_overlap_tester(), face_detector.get_w());
+            DLIB_TEST(count_detection_allocations(detector3, img, 0) == 0);
+            DLIB_TEST(count_detection_allocations(detector3, rgb_img, 0) == 0);
+            DLIB_TEST(count_detection_allocations(detector3, img, &tp) == 0);
+
+            // pyramid_down<2> only runs without allocating on unsigned char images.
+            typedef scan_fhog_pyramid<pyramid_down<2> > scanner2_type;
+            scanner2_type scanner2;
+            scanner2.set_detection_window_size(80, 80);
+            object_detector<scanner2_type> detector2(scanner2, face_detector.get_overlap_tester(), face_detector.get_w());
+            DLIB_TEST(count_detection_allocations(detector2, img, 0) == 0);
+            DLIB_TEST(count_detection_allocations(detector2, img, &tp) == 0);
+        }
+
+        void check_detection_allocations (
+            const frontal_face_detector& detector
+        )
+        {
+            if (malloc_tracing_works())
+            {
+                test_detection_allocations(detector);
+                return;
+            }
+
+            // Run the check in a copy of this program that has malloc tracing switched
+            // on.  The copy only runs test_detection_allocations().
+            const char* debug_lib = "/lib/x86_64-linux-gnu/libc_malloc_debug.so.0";
+            char exe[4096];
+            const ssize_t exe_length = readlink("/proc/self/exe", exe, sizeof(exe)-1);
+            if (!std::ifstream(debug_lib) || exe_length <= 0)
+            {
+                dlog << LINFO << "malloc tracing isn't available, skipping the detection allocation check";
+                return;
+            }
+            exe[exe_length] = 0;
+            print_spinner();
+            const std::string command = std::string("DLIB_TEST_FACE_ALLOCATIONS=1 MALLOC_TRACE=face_malloc_trace.txt ") +
+                "LD_PRELOAD=" + debug_lib + " '" + exe + "' --test_face > /dev/null 2>&1";
+            DLIB_TEST_MSG(system(command.c_str()) == 0, command);
+            remove("face_malloc_trace.txt");
+        }
+#endif
+
+        void test_fixed_point_detection (
+            frontal_face_detector& detector,
+            const dlib::array<array2d<unsigned char> >& images
+        )
+        {
+            print_spinner();
+            typedef frontal_face_detector::image_scanner_type scanner_type;
+
+            // The int16 planes hold the features to 12 fractional bits.
+            dlib::array<array2d<float> > feats;
+            dlib::array<array2d<int16> > qfeats;
+            extract_fhog_features(images[0], feats, 8, 10, 10);
+            impl::quantize_fhog_level(feats, qfeats);
+            DLIB_TEST(qfeats.size() == feats.size());
+            for (unsigned long i = 0; i < feats.size(); ++i)
+                DLIB_TEST(max(abs(matrix_cast<float>(mat(qfeats[i]))/4096 - mat(feats[i]))) <= 0.5/4096 + 1e-7);
+
+            // Both the separable filters the face detector uses, and full filters of a
+            // random detector, have to match the float scores.
+            scanner_type scanner;
+            scanner.copy_configuration(detector.get_scanner());
+            dlib::rand rnd;
+            matrix<double,0,1> random_w(scanner.get_num_dimensions());
+            for (long i = 0; i < random_w.size(); ++i)
+                random_w(i) = rnd.get_random_gaussian()*0.1;
+            std::vector<scanner_type::fhog_filterbank> banks;
+            banks.push_back(detector.get_processed_w(0).get_detect_argument());
+            banks.push_back(scanner.build_fhog_filterbank(random_w));
+            for (unsigned long b = 0; b < banks.size(); ++b)
+            {
+                const impl::fixed_point_fhog_filterbank fb = impl::make_fixed_point_fhog_filterbank(banks[b]);
+                DLIB_TEST(fb.use_separable_filters == (b == 0));
+                array2d<float> saliency, fixed_saliency, scratch;
+                const rectangle area = impl::apply_filters_to_fhog(banks[b], feats, saliency);
+                const rectangle fixed_area = impl::apply_fixed_point_filters_to_fhog(fb, qfeats, fixed_saliency, scratch);
+                DLIB_TEST(area == fixed_area);
+                DLIB_TEST_MSG(max(abs(mat(saliency) - mat(fixed_saliency))) < 0.01,
+                    max(abs(mat(saliency) - mat(fixed_saliency))));
+            }
+
+            fixed_point_fhog_detector<pyramid_down<6> > fixed(detector);
+            const double adjustment = fixed.calibrate(images);
+            DLIB_TEST(adjustment > 0 && adjustment < 0.01);
+            DLIB_TEST(fixed.get_threshold_adjustment() == adjustment);
+
+            std::vector<rect_detection> plain, dets;
+            detector(images[0], plain);
+            fixed(images[0], dets);
+            DLIB_TEST(plain.size() == dets.size());
+            for (unsigned long i = 0; i < plain.size() && i < dets.size(); ++i)
+            {
+                DLIB_TEST(dets[i].rect == plain[i].rect);
+                DLIB_TEST(std::abs(dets[i].detection_confidence - plain[i].detection_confidence) <= adjustment);
+            }
+
+            // A second call reuses the kept buffers and must give the same answer as the
+            // const version, which works in its own memory.
+            std::vector<rect_detection> dets2, const_dets;
+            fixed(images[0], dets2);
+            static_cast<const fixed_point_fhog_detector<pyramid_down<6> >&>(fixed)(images[0], const_dets);
+            DLIB_TEST(dets2.size() == dets.size() && const_dets.size() == dets.size());
+            for (unsigned long i = 0; i < dets.size() && i < dets2.size() && i < const_dets.size(); ++i)
+            {
+                DLIB_TEST(dets2[i].rect == dets[i].rect);
+                DLIB_TEST(dets2[i].detection_confidence == dets[i].detection_confidence);
+                DLIB_TEST(const_dets[i].rect == dets[i].rect);
+                DLIB_TEST(const_dets[i].detection_confidence == dets[i].detection_confidence);
+            }
+
+            std::ostringstream sout;
+            serialize(fixed, sout);
+            fixed_point_fhog_detector<pyramid_down<6> > fixed2;
+            std::istringstream sin(sout.str());
+            deserialize(fixed2, sin);
+            DLIB_TEST(fixed2.get_threshold_adjustment() == adjustment);
+            DLIB_TEST(fixed2(images[0]) == fixed(images[0]));
+        }
+
         void perform_test()
         {
+#ifdef __GLIBC__
+            if (getenv("DLIB_TEST_FACE_ALLOCATIONS"))
+            {
+                test_detection_allocations(get_frontal_face_detector());
+                return;
+            }
+#endif
+            test_packed_feature_extraction();
+
             print_spinner();
             dlib::array<array2d<unsigned char> > images;
             std::vector<std::vector<full_object_detection> > objects;
@@ -70,12 +983,58 @@ namespace
             // It should have been able to perfectly fit the data
             DLIB_TEST(test_shape_predictor(sp, images, objects) == 0);
 
+            test_against_double_precision_reference(sp, images, objects);
+            test_threaded_shape_predictor(sp, images, objects);
+            test_extract_part_subset(sp, images, objects);
+            test_shape_predictor_pruning(sp, images, objects);
+            test_shape_predictor_serialization(sp, images, objects);
+
             print_spinner();
 
             // While we are here, make sure the default face detector works
             std::vector<rectangle> dets = detector(images[0]);
             DLIB_TEST(dets.size() == 3);
 
+            // The big levels of this image get split into bands, and the threaded scanner
+            // has to match the single threaded one exactly, before and after non-max
+            // suppression.
+            thread_pool tp(3);
+            DLIB_TEST(detector(images[0], tp) == dets);
+            typedef frontal_face_detector::image_scanner_type scanner_type;
+            scanner_type scanner1, scanner2;
+            scanner1.copy_configuration(detector.get_scanner());
+            scanner2.copy_configuration(detector.get_scanner());
+            scanner1.load(images[0]);
+            // scanner2 goes through a smaller image first, so the second load runs in
+            // reused buffers.
+            array2d<unsigned char> small;
+            pyramid_down<2>()(images[0], small);
+            scanner2.load(small, tp);
+            scanner2.load(images[0], tp);
+            for (unsigned long d = 0; d < detector.num_detectors(); ++d)
+            {
+                std::vector<std::pair<double, rectangle> > dets1, dets2;
+                scanner1.detect(detector.get_processed_w(d).get_detect_argument(), dets1, -0.5);
+                scanner2.detect(detector.get_processed_w(d).get_detect_argument(), dets2, -0.5, tp);
+                DLIB_TEST(dets1.size() > 3);
+                DLIB_TEST(dets1 == dets2);
+                // The second call reuses the jobs of the first, and the const version
+                // works in its own memory.  Both have to find the same windows.
+                std::vector<std::pair<double, rectangle> > dets3;
+                scanner2.detect(detector.get_processed_w(d).get_detect_argument(), dets2, -0.5, tp);
+                static_cast<const scanner_type&>(scanner2).detect(detector.get_processed_w(d).get_detect_argument(), dets3, -0.5, tp);
+                DLIB_TEST(dets1 == dets2);
+                DLIB_TEST(dets1 == dets3);
+            }
+
+            test_incremental_detection(detector, images[0], dets);
+            test_cascaded_detection(detector, images);
+            test_fixed_point_detection(detector, images);
+            test_detection_reuses_memory(detector, images);
+#ifdef __GLIBC__
+            check_detection_allocations(detector);
+#endif
+
 
             /*
             // visualize the detections
@@ -154,6 +154,65 @@ namespace
         test_real_compile_time_sized_ffts<1,16>();
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename T>
+    void test_real_fft_plan(double eps)
+    {
+        dlib::rand rnd;
+        for (int nr = 1; nr <= 64; nr*=2)
+        {
+            print_spinner();
+            for (int nc = 2; nc <= 128; nc *= 2)
+            {
+                real_fft_plan<T> plan(nr,nc);
+                DLIB_TEST(plan.nr() == nr);
+                DLIB_TEST(plan.nc() == nc);
+
+                // Run the same plan several times to make sure its state doesn't leak
+                // from one call to the next.
+                for (int iter = 0; iter < 3; ++iter)
+                {
+                    matrix<T> m(nr,nc);
+                    for (long r = 0; r < m.nr(); ++r)
+                        for (long c = 0; c < m.nc(); ++c)
+                            m(r,c) = rnd.get_random_gaussian()*10;
+
+                    const matrix<complex<double> > full = fft(complex_matrix(matrix_cast<double>(m)));
+                    const double scale = max(abs(full));
+
+                    matrix<complex<T> > half;
+                    plan.fftr(m, half);
+                    DLIB_TEST(half.nr() == nr);
+                    DLIB_TEST(half.nc() == nc/2+1);
+                    DLIB_TEST_MSG(max(abs(matrix_cast<complex<double> >(half)-colm(full,range(0,nc/2)))) < eps*scale,
+                        nr << " " << nc << " " << max(abs(matrix_cast<complex<double> >(half)-colm(full,range(0,nc/2)))));
+                    DLIB_TEST(max(abs(fftr(m)-half)) == 0);
+
+                    matrix<T> m2;
+                    plan.ifftr(half, m2);
+                    DLIB_TEST(m2.nr() == nr);
+                    DLIB_TEST(m2.nc() == nc);
+                    DLIB_TEST(max(abs(m2-m)) < eps*max(abs(m)));
+                    DLIB_TEST(max(abs(ifftr(half)-m2)) == 0);
+
+                    // ifftr() of any half spectrum should be the real part of the ifft of
+                    // the full Hermitian matrix it stands for.
+                    matrix<complex<double> > spec = full;
+                    for (long r = 0; r < nr; ++r)
+                        for (long c = 1; c < nc/2; ++c)
+                            spec(r,c) *= complex<double>(std::cos(0.3*c), std::sin(0.3*c));
+                    for (long r = 0; r < nr; ++r)
+                        for (long c = nc/2+1; c < nc; ++c)
+                            spec(r,c) = conj(spec((nr-r)%nr, nc-c));
+                    matrix<complex<T> > hspec = matrix_cast<complex<T> >(colm(spec,range(0,nc/2)));
+                    plan.ifftr(hspec, m2);
+                    DLIB_TEST(max(abs(matrix_cast<double>(m2)-real(ifft(spec)))) < eps*max(abs(m)));
+                }
+            }
+        }
+    }
+
 // ----------------------------------------------------------------------------------------
 
     class test_fft : public tester
@@ -171,6 +230,8 @@ namespace
             test_against_saved_good_ffts();
             test_random_ffts();
             test_random_real_ffts();
+            test_real_fft_plan<double>(1e-12);
+            test_real_fft_plan<float>(1e-5);
         }
     } a;
 
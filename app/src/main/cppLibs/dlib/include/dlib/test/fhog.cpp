@@ -117,6 +117,62 @@ namespace
             }
         }
 
+        void test_8bit_grayscale_matches_generic()
+        {
+            // 8-bit grayscale images go through a specialized code path.  Make sure it
+            // produces exactly the same features as the generic one does for the same
+            // pixel values stored in a wider type.
+            dlib::rand rnd;
+            array2d<unsigned char> img;
+            array2d<unsigned short> wimg;
+            dlib::array<array2d<float> > hog, whog;
+            array2d<matrix<float,31,1> > vhog, wvhog;
+            for (int iter = 0; iter < 60; ++iter)
+            {
+                print_spinner();
+                img.set_size(rnd.get_random_32bit_number()%90, rnd.get_random_32bit_number()%90);
+                for (long r = 0; r < img.nr(); ++r)
+                {
+                    for (long c = 0; c < img.nc(); ++c)
+                    {
+                        // mix smooth regions with noise and saturated pixels so that all
+                        // the gradient values, including the extreme ones, show up.
+                        if (iter%3 == 0)
+                            img[r][c] = rnd.get_random_8bit_number();
+                        else if (iter%3 == 1)
+                            img[r][c] = (rnd.get_random_8bit_number()&1)*255;
+                        else
+                            img[r][c] = (unsigned char)(r*7 + c*3 + rnd.get_random_8bit_number()%4);
+                    }
+                }
+                assign_image(wimg, img);
+
+                const int cell_size = 2 + rnd.get_random_32bit_number()%7;
+                const int rpad = 1 + rnd.get_random_32bit_number()%4;
+                const int cpad = 1 + rnd.get_random_32bit_number()%4;
+
+                extract_fhog_features(img, hog, cell_size, rpad, cpad);
+                extract_fhog_features(wimg, whog, cell_size, rpad, cpad);
+                DLIB_TEST(hog.size() == whog.size());
+                for (unsigned long i = 0; i < hog.size(); ++i)
+                {
+                    DLIB_TEST(hog[i].nr() == whog[i].nr());
+                    DLIB_TEST(hog[i].nc() == whog[i].nc());
+                    DLIB_TEST(mat(hog[i]) == mat(whog[i]));
+                }
+
+                extract_fhog_features(img, vhog, cell_size, rpad, cpad);
+                extract_fhog_features(wimg, wvhog, cell_size, rpad, cpad);
+                DLIB_TEST(vhog.nr() == wvhog.nr());
+                DLIB_TEST(vhog.nc() == wvhog.nc());
+                for (long r = 0; r < vhog.nr(); ++r)
+                {
+                    for (long c = 0; c < vhog.nc(); ++c)
+                        DLIB_TEST(vhog[r][c] == wvhog[r][c]);
+                }
+            }
+        }
+
         void test_point_transforms()
         {
             dlib::rand rnd;
@@ -158,6 +214,7 @@ namespace
         {
             test_point_transforms();
             test_on_small();
+            test_8bit_grayscale_matches_generic();
 
             print_spinner();
             // load the testing data
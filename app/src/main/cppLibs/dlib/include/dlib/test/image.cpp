@@ -1812,6 +1812,96 @@ namespace
 
     }
 
+// ----------------------------------------------------------------------------------------
+
+    template <typename pixel_type>
+    void test_extract_image_chips_batched (
+        thread_pool& tp
+    )
+    {
+        dlib::rand rnd;
+        const long K = pixel_traits<pixel_type>::num;
+        array2d<pixel_type> img(480,640);
+        for (long r = 0; r < img.nr(); ++r)
+        {
+            for (long c = 0; c < img.nc(); ++c)
+            {
+                unsigned char* p = reinterpret_cast<unsigned char*>(&img[r][c]);
+                for (long k = 0; k < K; ++k)
+                    p[k] = rnd.get_random_8bit_number();
+            }
+        }
+
+        for (int iter = 0; iter < 20; ++iter)
+        {
+            print_spinner();
+            // Chips of all kinds: rotated, scaled up and down (some far enough to use the
+            // image pyramid), hanging off the edge of the image, and plain copies.
+            std::vector<chip_details> dets;
+            for (int i = 0; i < 10; ++i)
+            {
+                const point cent(rnd.get_random_32bit_number()%700 - 30, rnd.get_random_32bit_number()%540 - 30);
+                const long size = rnd.get_random_32bit_number()%300 + 10;
+                const double angle = rnd.get_random_double()*2*pi - pi;
+                dets.push_back(chip_details(centered_rect(cent, size, size), chip_dims(37,41), angle));
+            }
+            dets.push_back(chip_details(rectangle(10,20,50,56), chip_dims(37,41)));
+            dets.push_back(chip_details(centered_rect(point(320,240),400,400), chip_dims(37,41), 0.3));
+
+            dlib::array<array2d<pixel_type> > chips, chips2;
+            extract_image_chips(img, dets, chips);
+            extract_image_chips(img, dets, chips2, tp);
+            DLIB_TEST(chips2.size() == dets.size());
+
+            const std::vector<float> offsets = K == 3 ? std::vector<float>{122.782, 117.001, 104.298} :
+                                                        std::vector<float>{128};
+            std::vector<float> planes(dets.size()*K*37*41);
+            extract_image_chip_planes(img, dets, planes.data(), tp, offsets, 1/256.0f);
+
+            for (unsigned long i = 0; i < dets.size(); ++i)
+            {
+                DLIB_TEST(chips2[i].nr() == 37 && chips2[i].nc() == 41);
+                for (long r = 0; r < 37; ++r)
+                {
+                    for (long c = 0; c < 41; ++c)
+                    {
+                        const unsigned char* p = reinterpret_cast<const unsigned char*>(&chips[i][r][c]);
+                        const unsigned char* p2 = reinterpret_cast<const unsigned char*>(&chips2[i][r][c]);
+                        for (long k = 0; k < K; ++k)
+                        {
+                            DLIB_TEST_MSG(std::abs((int)p[k] - (int)p2[k]) <= 1,
+                                "i: " << i << " r: " << r << " c: " << c << " k: " << k
+                                << " " << (int)p[k] << " " << (int)p2[k]);
+                            DLIB_TEST(planes[((i*K+k)*37 + r)*41 + c] == (p2[k]-offsets[k])*(1/256.0f));
+                        }
+                    }
+                }
+            }
+        }
+
+        // Other kinds of pixels are done by transform_image(), so they come out the same.
+        array2d<float> fimg;
+        assign_image(fimg, img);
+        std::vector<chip_details> dets;
+        dets.push_back(chip_details(centered_rect(point(200,100),90,90), chip_dims(30,30), 1));
+        dets.push_back(chip_details(centered_rect(point(300,300),400,400), chip_dims(30,30), 2));
+        dlib::array<array2d<float> > fchips, fchips2;
+        extract_image_chips(fimg, dets, fchips);
+        extract_image_chips(fimg, dets, fchips2, tp);
+        for (unsigned long i = 0; i < dets.size(); ++i)
+            DLIB_TEST(mat(fchips[i]) == mat(fchips2[i]));
+    }
+
+    void test_extract_image_chips_batched (
+    )
+    {
+        thread_pool tp0(0), tp2(2);
+        test_extract_image_chips_batched<unsigned char>(tp0);
+        test_extract_image_chips_batched<unsigned char>(tp2);
+        test_extract_image_chips_batched<rgb_pixel>(tp0);
+        test_extract_image_chips_batched<rgb_pixel>(tp2);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     template <
@@ -2004,6 +2094,7 @@ namespace
             image_test();
             run_hough_test();
             test_extract_image_chips();
+            test_extract_image_chips_batched();
             test_integral_image<long, unsigned char>();
             test_integral_image<double, int>();
             test_integral_image<long, unsigned char>();
@@ -0,0 +1,214 @@
+// License: Boost Software License   See LICENSE.txt for the full license.
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dlib/lsh.h>
+#include <dlib/rand.h>
+#include <dlib/matrix.h>
+
+#include "tester.h"
+
+namespace  
+{
+    using namespace test;
+    using namespace dlib;
+    using namespace std;
+
+    logger dlog("test.lsh_index");
+
+// ----------------------------------------------------------------------------------------
+
+    std::vector<matrix<float,0,1>> make_clustered_samples (
+        dlib::rand& rnd,
+        const std::vector<matrix<float,0,1>>& centers,
+        unsigned long per_center
+    )
+    {
+        std::vector<matrix<float,0,1>> samples;
+        for (unsigned long i = 0; i < per_center; ++i)
+        {
+            for (auto& c : centers)
+            {
+                matrix<float,0,1> s = c;
+                for (long j = 0; j < s.size(); ++j)
+                    s(j) += 0.1*rnd.get_random_gaussian();
+                samples.push_back(s);
+            }
+        }
+        return samples;
+    }
+
+    std::vector<std::pair<double,unsigned long>> find_nearest_brute_force (
+        const std::vector<matrix<float,0,1>>& samples,
+        const matrix<float,0,1>& query,
+        unsigned long k
+    )
+    {
+        std::vector<std::pair<double,unsigned long>> results;
+        for (unsigned long i = 0; i < samples.size(); ++i)
+            results.push_back(std::make_pair(length(query-samples[i]), i));
+        std::sort(results.begin(), results.end());
+        results.resize(k);
+        return results;
+    }
+
+    double recall (
+        const lsh_index& index,
+        const std::vector<matrix<float,0,1>>& samples,
+        const std::vector<matrix<float,0,1>>& queries,
+        unsigned long k
+    )
+    {
+        unsigned long found = 0;
+        std::vector<std::pair<double,unsigned long>> results;
+        for (auto& q : queries)
+        {
+            index.find_nearest(q, k, results);
+            DLIB_TEST(results.size() == k);
+            for (unsigned long i = 0; i < results.size(); ++i)
+            {
+                DLIB_TEST(std::abs(results[i].first - length(q-samples[results[i].second])) < 1e-4);
+                if (i > 0)
+                    DLIB_TEST(results[i-1].first <= results[i].first);
+            }
+
+            const auto truth = find_nearest_brute_force(samples, q, k);
+            for (auto& t : truth)
+            {
+                for (auto& r : results)
+                {
+                    if (r.second == t.second)
+                    {
+                        ++found;
+                        break;
+                    }
+                }
+            }
+        }
+        return found/(double)(queries.size()*k);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void test_lsh_index()
+    {
+        print_spinner();
+        dlib::rand rnd;
+
+        // Clusters of samples, like the descriptors of the faces of different people.
+        std::vector<matrix<float,0,1>> centers(300);
+        for (auto& c : centers)
+            c = normalize(matrix_cast<float>(gaussian_randm(40,1,rnd.get_random_32bit_number())));
+        std::vector<matrix<float,0,1>> samples = make_clustered_samples(rnd, centers, 15);
+        const std::vector<matrix<float,0,1>> queries = make_clustered_samples(rnd, centers, 1);
+
+        lsh_index index;
+        DLIB_TEST(index.size() == 0);
+        index.build(samples);
+        DLIB_TEST(index.size() == samples.size());
+        DLIB_TEST(index.dimensions() == 40);
+        DLIB_TEST(index.num_tables() == 8);
+        DLIB_TEST(index.num_bits() == 9);
+        DLIB_TEST(index.get_num_probes() == 64);
+        DLIB_TEST(index.get_sample(17) == samples[17]);
+
+        const double r = recall(index, samples, queries, 5);
+        dlog << LINFO << "recall@5: " << r;
+        DLIB_TEST_MSG(r > 0.9, r);
+
+        // Looking in every bucket finds the true nearest neighbors.
+        lsh_index exhaustive = index;
+        exhaustive.set_num_probes(exhaustive.num_tables() << exhaustive.num_bits());
+        DLIB_TEST(recall(exhaustive, samples, queries, 5) == 1);
+
+        // Samples added later are found whether or not they have been put in the buckets
+        // yet.
+        const std::vector<matrix<float,0,1>> more = make_clustered_samples(rnd, centers, 2);
+        for (unsigned long i = 0; i < more.size(); ++i)
+        {
+            DLIB_TEST(index.add(more[i]) == samples.size());
+            samples.push_back(more[i]);
+            if (i == 100 || i+1 == more.size())
+            {
+                const double r2 = recall(index, samples, queries, 5);
+                DLIB_TEST_MSG(r2 > 0.9, r2);
+            }
+        }
+
+        // Serializing puts all the samples in the buckets, so an index that is
+        // deserialized or attached to its serialized form gives the same results.
+        std::ostringstream sout;
+        serialize(index, sout);
+        const std::string buffer = sout.str();
+        std::istringstream sin(buffer);
+        lsh_index index2;
+        deserialize(index2, sin);
+        lsh_index attached;
+        attached.attach(buffer.data(), buffer.size());
+        DLIB_TEST(!index2.is_attached());
+        DLIB_TEST(attached.is_attached());
+        DLIB_TEST(attached.size() == samples.size() && index2.size() == samples.size());
+        DLIB_TEST(recall(index2, samples, queries, 5) > 0.9);
+        std::vector<std::pair<double,unsigned long>> results, results2;
+        for (auto& q : queries)
+        {
+            index2.find_nearest(q, 10, results);
+            attached.find_nearest(q, 10, results2);
+            DLIB_TEST(results == results2);
+        }
+
+        // Adding to an attached index copies it first.
+        DLIB_TEST(attached.add(queries[0]) == samples.size());
+        DLIB_TEST(!attached.is_attached());
+        attached.find_nearest(queries[0], 1, results);
+        DLIB_TEST(results[0].second == samples.size() && results[0].first == 0);
+
+        DLIB_TEST(sin.tellg() == (std::streamoff)buffer.size());
+        std::istringstream bad("this is not an lsh_index, not even close to one, but it is long enough");
+        lsh_index index3;
+        bool threw = false;
+        try { deserialize(index3, bad); } catch (serialization_error&) { threw = true; }
+        DLIB_TEST(threw);
+
+        // Damaged indexes are rejected rather than read out of bounds.  attach() does
+        // the same checks with DLIB_CASSERT, which isn't tested here since a second
+        // fatal_error aborts the program.
+        const size_t starts_offset = 64 + sizeof(float)*(index2.num_tables()*index2.num_bits()*(index2.dimensions()+1) +
+            index2.size()*index2.dimensions());
+        const uint32 num_bits = 40;
+        const uint32 big = 0xFFFFFFFF;
+        std::vector<std::string> damaged(4, buffer);
+        std::memcpy(&damaged[0][32], &num_bits, sizeof(num_bits));
+        std::memcpy(&damaged[1][starts_offset+sizeof(uint32)], &big, sizeof(big));
+        std::memcpy(&damaged[2][damaged[2].size()-sizeof(uint32)], &big, sizeof(big));
+        damaged[3].resize(buffer.size()-1);
+        for (unsigned long i = 0; i < damaged.size(); ++i)
+        {
+            std::istringstream din(damaged[i]);
+            threw = false;
+            try { deserialize(index3, din); } catch (serialization_error&) { threw = true; }
+            DLIB_TEST(threw);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    class test_lsh_index_class : public tester
+    {
+    public:
+        test_lsh_index_class (
+        ) :
+            tester ("test_lsh_index",
+                    "Runs tests on the lsh_index object.")
+        {}
+
+        void perform_test (
+        )
+        {
+            test_lsh_index();
+        }
+    } a;
+
+}
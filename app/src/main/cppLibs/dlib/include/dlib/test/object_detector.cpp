@@ -429,6 +429,27 @@ namespace
             }
             DLIB_TEST(d1.size() == d2.size());
             DLIB_TEST(set_intersection_size(d1,d2) == d1.size());
+
+            // The threaded versions must find exactly the same detections, in the same
+            // order.  A pool without threads runs everything inline.  (dets1 was emptied by
+            // the set insertions above, so compare against fresh results.)
+            for (unsigned long num_threads = 0; num_threads < 4; num_threads += 3)
+            {
+                thread_pool tp(num_threads);
+                DLIB_TEST(evaluate_detectors(detectors, images[0], tp) == evaluate_detectors(detectors, images[0]));
+                for (unsigned long i = 0; i < images.size(); ++i)
+                {
+                    std::vector<rect_detection> dets3, dets4;
+                    detector(images[i], dets3, -1);
+                    detector(images[i], dets4, tp, -1);
+                    DLIB_TEST(dets3.size() == dets4.size());
+                    for (unsigned long j = 0; j < dets3.size(); ++j)
+                    {
+                        DLIB_TEST(dets3[j].rect == dets4[j].rect);
+                        DLIB_TEST(dets3[j].detection_confidence == dets4[j].detection_confidence);
+                    }
+                }
+            }
         }
     }
 
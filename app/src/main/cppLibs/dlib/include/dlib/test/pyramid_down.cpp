@@ -329,6 +329,81 @@ void test_pyramid_down_small_sizes()
     }
 }
 
+// ----------------------------------------------------------------------------------------
+
+matrix<double> bilinear_resize_reference (
+    const array2d<unsigned char>& img,
+    long nr,
+    long nc
+)
+{
+    // Computes what resize_image() outputs, using double precision everywhere.
+    matrix<double> out(nr, nc);
+    const double x_scale = (img.nc()-1)/(double)std::max<long>(nc-1,1);
+    const double y_scale = (img.nr()-1)/(double)std::max<long>(nr-1,1);
+    double y = -y_scale;
+    for (long r = 0; r < nr; ++r)
+    {
+        y += y_scale;
+        const long top = static_cast<long>(std::floor(y));
+        const long bottom = std::min(top+1, img.nr()-1);
+        const double tb_frac = y - top;
+        double x = -x_scale;
+        for (long c = 0; c < nc; ++c)
+        {
+            x += x_scale;
+            const long left = static_cast<long>(std::floor(x));
+            const long right = std::min(left+1, img.nc()-1);
+            const double lr_frac = x - left;
+            out(r,c) = (1-tb_frac)*((1-lr_frac)*img[top][left] + lr_frac*img[top][right]) + 
+                tb_frac*((1-lr_frac)*img[bottom][left] + lr_frac*img[bottom][right]);
+        }
+    }
+    return out;
+}
+
+void test_8bit_grayscale_paths()
+{
+    // pyramid_down<2> and resize_image() have separate fixed point code for 8 bit
+    // grayscale images.  Check them against exact results, using wide enough images to
+    // span several of the strips they work in.
+    dlib::rand rnd;
+    for (int iter = 0; iter < 12; ++iter)
+    {
+        print_spinner();
+        const long nr = rnd.get_random_32bit_number()%100+9;
+        const long nc = rnd.get_random_32bit_number()%2500+9;
+        array2d<unsigned char> img(nr,nc);
+        for (long r = 0; r < nr; ++r)
+        {
+            for (long c = 0; c < nc; ++c)
+                img[r][c] = rnd.get_random_8bit_number();
+        }
+
+        // The 5x5 filter of pyramid_down<2> is exact in both versions.
+        pyramid_down<2> pyr2;
+        array2d<unsigned char> down;
+        array2d<uint16> down16;
+        pyr2(img, down);
+        pyr2(img, down16);
+        DLIB_TEST(down.nr() == down16.nr() && down.nc() == down16.nc());
+        DLIB_TEST(mat(down) == matrix_cast<unsigned char>(mat(down16)));
+
+        // Bilinear resizing may be off by 1 because of the fixed point weights.
+        const long out_nr = rnd.get_random_32bit_number()%(2*nr)+1;
+        const long out_nc = rnd.get_random_32bit_number()%(2*nc)+1;
+        array2d<unsigned char> out(out_nr, out_nc);
+        resize_image(img, out);
+        DLIB_TEST(max(abs(matrix_cast<double>(mat(out)) - 
+                          floor(bilinear_resize_reference(img, out_nr, out_nc)))) <= 1);
+
+        pyramid_down<6> pyr6;
+        pyr6(img, down);
+        DLIB_TEST(max(abs(matrix_cast<double>(mat(down)) - 
+                          floor(bilinear_resize_reference(img, down.nr(), down.nc())))) <= 1);
+    }
+}
+
 // ----------------------------------------------------------------------------------------
 
 
@@ -414,6 +489,8 @@ void test_pyramid_down_small_sizes()
             test_pyr_sizes<pyramid_down<7>>();
             test_pyr_sizes<pyramid_down<8>>();
             test_pyr_sizes<pyramid_down<28>>();
+
+            test_8bit_grayscale_paths();
         }
     } a;
 
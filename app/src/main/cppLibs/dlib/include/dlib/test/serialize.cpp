@@ -10,6 +10,7 @@
 #include <string>
 #include <cstdlib>
 #include <ctime>
+#include <cstring>
 #include <dlib/serialize.h>
 #include <dlib/image_transforms.h>
 
@@ -645,6 +646,66 @@ namespace
         DLIB_TEST(bb.size() == 0);
     }
 
+    void test_pod_block (
+    )
+    {
+        std::vector<float> a, b;
+        for (int i = -10; i < 30; ++i)
+            a.push_back(i/3.0f);
+        a.push_back(std::numeric_limits<float>::infinity());
+        a.push_back(-0.0f);
+
+        struct triple { uint32 i, j; float f; };
+        std::vector<triple> c(3), d;
+        for (unsigned long i = 0; i < c.size(); ++i)
+        {
+            c[i].i = i;
+            c[i].j = 0xFFFFFFFF-i;
+            c[i].f = i*1.5f;
+        }
+
+        ostringstream sout;
+        dlib::serialize_pod_block(a, sout);
+        dlib::serialize_pod_block<uint32>(c, sout);
+        dlib::serialize_pod_block(&a[0], 4, sout);
+        dlib::serialize_pod_block(std::vector<int16>(), sout);
+        istringstream sin(sout.str());
+
+        dlib::deserialize_pod_block(b, sin);
+        DLIB_TEST(a.size() == b.size());
+        for (unsigned long i = 0; i < a.size(); ++i)
+            DLIB_TEST(std::memcmp(&a[i], &b[i], sizeof(float)) == 0);
+
+        dlib::deserialize_pod_block<uint32>(d, sin);
+        DLIB_TEST(d.size() == c.size());
+        for (unsigned long i = 0; i < c.size(); ++i)
+            DLIB_TEST(d[i].i == c[i].i && d[i].j == c[i].j && d[i].f == c[i].f);
+
+        float e[4];
+        dlib::deserialize_pod_block(e, 4, sin);
+        for (int i = 0; i < 4; ++i)
+            DLIB_TEST(e[i] == a[i]);
+
+        std::vector<int16> f(10);
+        dlib::deserialize_pod_block(f, sin);
+        DLIB_TEST(f.size() == 0);
+
+        // The size stored in the stream must match when reading into a fixed buffer.
+        sin.clear();
+        sin.str(sout.str());
+        float g[3];
+        bool threw = false;
+        try { dlib::deserialize_pod_block(g, 3, sin); } catch (serialization_error&) { threw = true; }
+        DLIB_TEST(threw);
+
+        // Truncated streams are reported as errors rather than silently returning garbage.
+        sin.clear();
+        sin.str(sout.str().substr(0, 20));
+        threw = false;
+        try { dlib::deserialize_pod_block(b, sin); } catch (serialization_error&) { threw = true; }
+        DLIB_TEST(threw);
+    }
+
     void test_vector_bool (
     )
     {
@@ -1078,6 +1139,7 @@ namespace
             test_array2d_and_matrix_serialization();
             test_strings();
             test_std_array();
+            test_pod_block();
         }
     } a;
 
@@ -2,6 +2,8 @@ package com.dev.anzalone.luca.facelandmarks;
 
 import android.graphics.Rect;
 
+import java.security.MessageDigest;
+
 /**
  * Native:  act as an interface between Kotlin and C++
  * Created by Luca on 12/04/2018.
@@ -18,8 +20,30 @@ public final class Native {
         );
     }
 
-    /** load the specified landmark model (for dlib) */
-    public static native void loadModel(final String path);
+    /**
+     * load the specified landmark model (for dlib), keeping it resident under the given key
+     * (model id and content hash). The model becomes the active one if activate is true.
+     * A model whose crc32 doesn't match expectedCrc is rejected (pass -1 to skip the check),
+     * verified models are read from a bulk-readable copy kept next to the model file.
+     */
+    public static native boolean loadModel(final String key, final String path, final long expectedCrc, final boolean activate);
+
+    /**
+     * load a raw, bzip2, gzip or zlib compressed model from the file descriptor in a single pass,
+     * returns the crc32 of the (uncompressed) model bytes or -1 on failure (or if it doesn't match
+     * expectedCrc, pass -1 to skip the check). The model bytes are also fed to digest, if not null.
+     */
+    public static native long loadModelFromFd(final String key, final int fd, final long expectedCrc, final MessageDigest digest, final boolean activate);
+
+    /** switch to an already resident model, returns false if it has to be loaded */
+    public static native boolean activateModel(final String key);
+    public static native boolean isModelResident(final String key);
+
+    /** drop a resident model, e.g. one that failed verification */
+    public static native void unloadModel(final String key);
+
+    /** memory (in bytes) that resident models may take, least recently used ones are evicted */
+    public static native void setModelCacheBudget(final long bytes);
     public static native void setImageFormat(final int format);
     private static native long[] detectLandmarks(final byte[] yuv, int rotation, int width, int height, int left, int top, int right, int bottom);
 }
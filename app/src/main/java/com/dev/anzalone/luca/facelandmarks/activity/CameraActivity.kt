@@ -4,6 +4,7 @@ package com.dev.anzalone.luca.facelandmarks.activity
 
 import android.Manifest
 import android.app.Activity
+import android.app.ActivityManager
 import android.content.pm.PackageManager
 import android.graphics.*
 import android.hardware.Camera
@@ -59,6 +60,12 @@ class CameraActivity : Activity(), Camera.PreviewCallback, Camera.FaceDetectionL
 
         askPermission()
 
+        // keep extra models resident within a quarter of the app memory class: the native heap
+        // shares the device memory with the java heap and the camera buffers (the active model
+        // always stays, whatever its size)
+        val activityManager = getSystemService(ACTIVITY_SERVICE) as ActivityManager
+        Native.setModelCacheBudget(activityManager.memoryClass * 1024L * 1024L / 4)
+
         // private model directory, and models.json file
         modelDir = getDir("models", MODE_PRIVATE)
         modelsJson = File(getDir("models", MODE_PRIVATE), "models.json")
@@ -267,7 +274,8 @@ class CameraActivity : Activity(), Camera.PreviewCallback, Camera.FaceDetectionL
                     model.delete(modelDir)
                     return model.askToUser(this@CameraActivity, modelDir,
                             "Model corrupted",
-                            "Do you want to download the model again?") == Unit
+                            "Do you want to download the model again?",
+                            onInstalled = { onModelInstalled(id) }) == Unit
                 }
 
                 launch(UI) {
@@ -280,11 +288,12 @@ class CameraActivity : Activity(), Camera.PreviewCallback, Camera.FaceDetectionL
                         val loaded = model.loadAsync(modelDir).await()
 
                         currentModelId = when (loaded) {
-                            true -> { imageTaken = false; id }
+                            true -> { imageTaken = false; prefetchNextModel(id); id }
                             else -> {
                                 model.askToUser(this@CameraActivity, modelDir,
                                         "Something goes wrong :(",
-                                        "Do you want to download the model again?")
+                                        "Do you want to download the model again?",
+                                        onInstalled = { onModelInstalled(id) })
                                 -1
                             }
                         }
@@ -298,12 +307,27 @@ class CameraActivity : Activity(), Camera.PreviewCallback, Camera.FaceDetectionL
 
         } else {
             // try downloading...
-            model.askToUser(this, modelDir, "Model not Found", "Do you want to download the model?")
+            model.askToUser(this, modelDir, "Model not Found", "Do you want to download the model?",
+                    onInstalled = { onModelInstalled(id) })
         }
 
         return true
     }
 
+    /** a freshly installed model is loaded while it's extracted: just make it the current one */
+    private fun onModelInstalled(id: Int) {
+        currentModelId = id
+        imageTaken = false
+        debugText.text = "Loaded: ${models[id]?.name}"
+        prefetchNextModel(id)
+    }
+
+    /** keep the other downloaded model resident too: users mostly toggle between two models */
+    private fun prefetchNextModel(id: Int) {
+        val next = models.firstOrNull { it.id != id && it.exists(modelDir) } ?: return
+        next.prefetchAsync(modelDir)
+    }
+
     private fun showPopupMenu(v: View) {
         val popup = PopupMenu(this, v)
         val menu  = popup.menu
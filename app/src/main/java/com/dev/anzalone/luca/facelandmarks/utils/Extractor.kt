@@ -7,23 +7,29 @@ import android.app.Activity
 import android.app.ProgressDialog
 import android.os.AsyncTask
 import android.os.Looper
+import android.os.ParcelFileDescriptor
 import android.util.Log
-import org.apache.commons.compress.compressors.bzip2.BZip2CompressorInputStream
-import java.io.BufferedInputStream
+import com.dev.anzalone.luca.facelandmarks.Native
 import java.io.File
-import java.io.FileOutputStream
+import java.io.IOException
+import java.security.MessageDigest
 
 /**
- * Class used to extract bzip2 files (models)
+ * Class used to extract bzip2 files (models): the native side decompresses, hashes and loads the
+ * model in a single pass, without an uncompressed copy on disk. Once it matches [expectedHash]
+ * (md5 of the uncompressed model) the compressed file is stored at [destination] and the model
+ * becomes the active one. [onSuccess] receives the crc32 of the uncompressed model, to check it
+ * cheaply on the next loads.
  */
-class Extractor(activity: Activity, val destination: File,
-                 val onError: (File) -> Unit = {},
-                 val onSuccess: (File) -> Unit = {})
+class Extractor(activity: Activity, val destination: File, val modelKey: String,
+                val expectedHash: String,
+                val onError: (File) -> Unit = {},
+                val onSuccess: (File, Long) -> Unit = { _, _ -> })
 {
     private val progressDialog: ProgressDialog = ProgressDialog(activity)
 
     init {
-        progressDialog.setProgressStyle(ProgressDialog.STYLE_HORIZONTAL)
+        progressDialog.isIndeterminate = true
         progressDialog.setCancelable(false)
         progressDialog.setTitle("Extracting model...")
     }
@@ -44,37 +50,39 @@ class Extractor(activity: Activity, val destination: File,
         override fun doInBackground(vararg files: File): File {
             val temp = files[0]
             try {
-                val stream = temp.inputStream()
-                val fileLength = (temp.length() * 1.558).toInt()  // approximate extracted size
-                val reader = BZip2CompressorInputStream(BufferedInputStream(stream, buffer_size))
-                val writer = FileOutputStream(destination)
-
-                val data  = ByteArray(buffer_size)
-                var count = reader.read(data)
-                var total = count
+                val md5 = MessageDigest.getInstance("MD5")
 
                 Log.d(tag, "extraction started for: ${destination.name}")
 
-                while (count != -1) {
-                    total += count
-                    publishProgress(total * 100 / fileLength)
-                    writer.write(data, 0, count)
-                    count = reader.read(data)
+                val crc = ParcelFileDescriptor.open(temp, ParcelFileDescriptor.MODE_READ_ONLY).use {
+                    Native.loadModelFromFd(modelKey, it.fd, -1, md5, false)
                 }
 
-                writer.flush()
-                writer.close()
-                reader.close()
+                val hash = Model.toHex(md5.digest())
+                if (crc < 0 || hash != expectedHash)
+                    throw IOException("invalid model (hash $hash, expected $expectedHash)")
+
+                if (!temp.renameTo(destination))
+                    throw IOException("unable to store the model at ${destination.path}")
+
+                // only a verified model becomes the active one (it's loaded again from the file
+                // if the memory budget didn't keep it resident)
+                if (!Native.activateModel(modelKey) &&
+                        !Native.loadModel(modelKey, destination.path, crc, true))
+                    throw IOException("unable to load the extracted model")
 
                 Log.d(tag, "File extacted at ${destination.path}")
 
                 Looper.prepare()
-                onSuccess(destination)
+                onSuccess(destination, crc)
 
             } catch (e: Exception) {
                 Log.w(tag, "Error occurred! --> $e")
                 e.printStackTrace()
 
+                // don't keep an unverified model resident
+                Native.unloadModel(modelKey)
+
                 Looper.prepare()
                 onError(destination)
             }
@@ -82,18 +90,12 @@ class Extractor(activity: Activity, val destination: File,
             return destination
         }
 
-        override fun onProgressUpdate(values: Array<Int>) {
-            super.onProgressUpdate(*values)
-            progressDialog.progress = values[0]
-        }
-
         override fun onPostExecute(result: File?) {
             progressDialog.dismiss()
         }
     }
 
     companion object {
-        const val buffer_size = 4096 * 2
         const val tag = "Extractor"
     }
-}
\ No newline at end of file
+}
@@ -1,6 +1,7 @@
 package com.dev.anzalone.luca.facelandmarks.utils
 
 import android.app.Activity
+import android.os.ParcelFileDescriptor
 import com.dev.anzalone.luca.facelandmarks.Native
 import kotlinx.coroutines.async
 import org.json.JSONObject
@@ -20,11 +21,27 @@ import java.security.MessageDigest
 class Model(val url: String, val name: String, val hash: String,
             val id: Int, val version: Float, val file: String) {
 
+    /** key of the model among the resident ones: a new version (hash) is a different model */
+    val key get() = "$id:$hash"
+
     /** check if the model exists */
     fun exists(dir: File) = File(dir, file).exists()
 
-    /** download and extract the model to the given directory */
-    private fun storeTo(activity: Activity, saveDir: File) {
+    /** file holding the crc32 of the verified model, used to check it while it's loaded */
+    private fun crcFile(dir: File) = File(dir, "$file.crc")
+
+    /** bulk-readable copy of the model written by the native loader */
+    private fun cacheFile(dir: File) = File(dir, "$file.bulk")
+
+    private fun storedCrc(dir: File) = try {
+        crcFile(dir).readText().trim().toLong()
+    } catch (e: Exception) {
+        null
+    }
+
+    /** download and extract the model to the given directory, [onInstalled] is called once the
+     *  model is stored and loaded */
+    private fun storeTo(activity: Activity, saveDir: File, onInstalled: () -> Unit) {
         val temp = File(saveDir, "temp")
         val dest = File(saveDir, file)
 
@@ -33,11 +50,17 @@ class Model(val url: String, val name: String, val hash: String,
                 onError = { if (it.exists()) it.delete() },
                 onSuccess = { it ->
                     activity.runOnUiThread {
-                        Extractor(activity, dest,
-                                onSuccess = { if (temp.exists()) temp.delete() },
+                        Extractor(activity, dest, key, hash,
+                                onSuccess = { _, crc ->
+                                    if (temp.exists()) temp.delete()
+                                    crcFile(saveDir).writeText(crc.toString())
+                                    activity.runOnUiThread(onInstalled)
+                                },
                                 onError = {
                                     if (dest.exists()) dest.delete()
                                     if (temp.exists()) temp.delete()
+                                    crcFile(saveDir).delete()
+                                    cacheFile(saveDir).delete()
                                 }
                         ).start(it)
                     }
@@ -46,17 +69,21 @@ class Model(val url: String, val name: String, val hash: String,
     }
 
     /** ask the user to download the missing model */
-    fun askToUser(activity: Activity, saveDir: File, title: String, message: String) {
+    fun askToUser(activity: Activity, saveDir: File, title: String, message: String,
+                  onInstalled: () -> Unit = {}) {
         UserDialog(activity, title, message,
-                onPositive = { storeTo(activity, saveDir) })
+                onPositive = { storeTo(activity, saveDir, onInstalled) })
                 .show()
     }
 
-    /** try to load the model, returns true on success */
-    private fun loadFrom(dir: File): Boolean {
+    /** try to load (or just activate, when resident) the model, returns true on success */
+    private fun loadFrom(dir: File, activate: Boolean = true): Boolean {
         return try {
-            Native.loadModel(File(dir, file).path)
-            true
+            if (if (activate) Native.activateModel(key) else Native.isModelResident(key))
+                return true
+
+            // a verified model is read from its bulk copy, otherwise it's checksummed while loaded
+            Native.loadModel(key, File(dir, file).path, storedCrc(dir) ?: -1, activate)
         } catch (e: Exception) {
             e.printStackTrace()
             false
@@ -68,13 +95,43 @@ class Model(val url: String, val name: String, val hash: String,
         loadFrom(dir)
     }
 
+    /** load the model in background without activating it, so switching to it is instant; a
+     *  model that fails the integrity check isn't loaded (it's reported when the user picks it) */
+    fun prefetchAsync(dir: File) = async {
+        !isCorrupted(dir) && loadFrom(dir, activate = false)
+    }
+
     /** check if the downloaded and then extracted model is corrupted */
     fun isCorrupted(dir: File): Boolean {
+        // models with a stored crc32 are checked against it while they're loaded
+        if (storedCrc(dir) != null)
+            return false
+
+        // the stored file may be compressed, so hash the model bytes the native loader reads; the
+        // model stays resident (but inactive) when it's fine, so it isn't read twice
         val file = File(dir, file)
-        val hash = digest(file)
+        if (!file.exists())
+            return true
+
+        val md5 = MessageDigest.getInstance("MD5")
+        val crc = try {
+            ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY).use {
+                Native.loadModelFromFd(key, it.fd, -1, md5, false)
+            }
+        } catch (e: Exception) {
+            e.printStackTrace()
+            -1L
+        }
+        val hash = toHex(md5.digest())
         println("hash ${this.hash} == $hash: ${this.hash == hash}")
 
-        return this.hash != hash
+        if (crc < 0 || this.hash != hash) {
+            Native.unloadModel(key)
+            return true
+        }
+
+        crcFile(dir).writeText(crc.toString())
+        return false
     }
 
     /** delete the model file */
@@ -83,40 +140,18 @@ class Model(val url: String, val name: String, val hash: String,
 
         if (file.exists())
             file.delete()
+
+        crcFile(dir).delete()
+        cacheFile(dir).delete()
     }
 
     companion object {
 
-        /**
-         * compute the hash of the model file
-         * source: [https://stackoverflow.com/a/14922433/423105]
-         */
-        fun digest(file: File): String {
-            if (!file.exists())
-                return ""
-
-            return try {
-                val md5 = MessageDigest.getInstance("MD5")
-                val buffer = ByteArray(8192)
-                val stream = file.inputStream()
-                var read = stream.read(buffer)
-
-                while (read > 0) {
-                    md5.update(buffer, 0, read)
-                    read = stream.read(buffer)
-                }
-
-                val bigInt = BigInteger(1, md5.digest())
-                val output = bigInt.toString(16)
-
-                String.format("%32s", output).replace(' ', '0')
+        /** hex string of an md5 digest */
+        fun toHex(digest: ByteArray): String {
+            val output = BigInteger(1, digest).toString(16)
 
-            } catch (e: Exception) {
-                println("Error: somothing goes wrong -> ${e.message}")
-                e.printStackTrace()
-
-                ""
-            }
+            return String.format("%32s", output).replace(' ', '0')
         }
 
         /** create a model from a json object */